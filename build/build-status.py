@@ -0,0 +1,8 @@
+#! /usr/bin/env python
+
+# Programs that are runnable.
+ns3_runnable_programs = ['build/src/bridge/examples/ns3.25-csma-bridge-optimized', 'build/src/bridge/examples/ns3.25-csma-bridge-one-hop-optimized', 'build/src/config-store/examples/ns3.25-config-store-save-optimized', 'build/src/core/examples/ns3.25-main-callback-optimized', 'build/src/core/examples/ns3.25-sample-simulator-optimized', 'build/src/core/examples/ns3.25-main-ptr-optimized', 'build/src/core/examples/ns3.25-main-random-variable-optimized', 'build/src/core/examples/ns3.25-main-random-variable-stream-optimized', 'build/src/core/examples/ns3.25-sample-random-variable-optimized', 'build/src/core/examples/ns3.25-sample-random-variable-stream-optimized', 'build/src/core/examples/ns3.25-command-line-example-optimized', 'build/src/core/examples/ns3.25-hash-example-optimized', 'build/src/core/examples/ns3.25-main-test-sync-optimized', 'build/src/csma/examples/ns3.25-csma-one-subnet-optimized', 'build/src/csma/examples/ns3.25-csma-broadcast-optimized', 'build/src/csma/examples/ns3.25-csma-packet-socket-optimized', 'build/src/csma/examples/ns3.25-csma-multicast-optimized', 'build/src/internet/examples/ns3.25-main-simple-optimized', 'build/src/network/examples/ns3.25-main-packet-header-optimized', 'build/src/network/examples/ns3.25-main-packet-tag-optimized', 'build/src/network/examples/ns3.25-packet-socket-apps-optimized', 'build/src/point-to-point/examples/ns3.25-main-attribute-value-optimized', 'build/src/stats/examples/ns3.25-gnuplot-example-optimized', 'build/src/stats/examples/ns3.25-double-probe-example-optimized', 'build/src/stats/examples/ns3.25-time-probe-example-optimized', 'build/src/stats/examples/ns3.25-gnuplot-aggregator-example-optimized', 'build/src/stats/examples/ns3.25-gnuplot-helper-example-optimized', 'build/src/stats/examples/ns3.25-file-aggregator-example-optimized', 'build/src/stats/examples/ns3.25-file-helper-example-optimized', 'build/src/traffic-control/examples/ns3.25-codel-vs-pfifo-basic-test-optimized', 'build/src/traffic-control/examples/ns3.25-codel-vs-pfifo-asymmetric-optimized', 'build/examples/tcp/ns3.25-tcp-large-transfer-optimized', 'build/examples/tcp/ns3.25-tcp-nsc-lfn-optimized', 'build/examples/tcp/ns3.25-tcp-nsc-zoo-optimized', 'build/examples/tcp/ns3.25-tcp-star-server-optimized', 'build/examples/tcp/ns3.25-tcp-bulk-send-optimized', 'build/examples/tcp/ns3.25-tcp-pcap-nanosec-example-optimized', 'build/examples/routing/ns3.25-dynamic-global-routing-optimized', 'build/examples/routing/ns3.25-static-routing-slash32-optimized', 'build/examples/routing/ns3.25-global-routing-slash32-optimized', 'build/examples/routing/ns3.25-global-injection-slash32-optimized', 'build/examples/routing/ns3.25-simple-alternate-routing-optimized', 'build/examples/routing/ns3.25-mixed-global-routing-optimized', 'build/examples/routing/ns3.25-global-routing-multi-switch-plus-router-optimized', 'build/examples/udp-client-server/ns3.25-udp-client-server-optimized', 'build/examples/udp-client-server/ns3.25-udp-trace-client-server-optimized', 'build/examples/error-model/ns3.25-simple-error-model-optimized', 'build/examples/atomic-memory/ns3.25-am-abd-optimized', 'build/examples/atomic-memory/ns3.25-am-abd-star-optimized', 'build/examples/atomic-memory/ns3.25-am-abd-spike-optimized', 'build/examples/atomic-memory/ns3.25-am-abd-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-abd-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-abd-mwmr-optimized', 'build/examples/atomic-memory/ns3.25-am-abd-mwmr-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-abd-mwmr-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-coded-abd-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohMam-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohMam-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohMamEX-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohMamEX-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohSam-optimized', 'build/examples/atomic-memory/ns3.25-am-ohSam-star-optimized', 'build/examples/atomic-memory/ns3.25-am-ohSam-spike-optimized', 'build/examples/atomic-memory/ns3.25-am-ohSam-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohSamEX-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohSamEX-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohSam-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohfast-optimized', 'build/examples/atomic-memory/ns3.25-am-ohfast-star-optimized', 'build/examples/atomic-memory/ns3.25-am-ohfast-spike-optimized', 'build/examples/atomic-memory/ns3.25-am-ohfast-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-ohfast-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-cchybrid-optimized', 'build/examples/atomic-memory/ns3.25-am-cchybrid-star-optimized', 'build/examples/atomic-memory/ns3.25-am-cchybrid-spike-optimized', 'build/examples/atomic-memory/ns3.25-am-cchybrid-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-cchybrid-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-semifast-optimized', 'build/examples/atomic-memory/ns3.25-am-semifast-star-optimized', 'build/examples/atomic-memory/ns3.25-am-semifast-spike-optimized', 'build/examples/atomic-memory/ns3.25-am-semifast-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-semifast-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-MwImp-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-MwImp-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-SwImp-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-SwImp-star-p2p-optimized', 'build/examples/atomic-memory/ns3.25-am-sweep-optimized', 'build/examples/tutorial/ns3.25-hello-simulator-optimized', 'build/examples/tutorial/ns3.25-first-optimized', 'build/examples/tutorial/ns3.25-second-optimized', 'build/examples/tutorial/ns3.25-fourth-optimized', 'build/examples/tutorial/ns3.25-fifth-optimized', 'build/examples/tutorial/ns3.25-sixth-optimized', 'build/examples/tutorial/ns3.25-seventh-optimized', 'build/examples/udp/ns3.25-udp-echo-optimized', 'build/examples/socket/ns3.25-socket-bound-static-routing-optimized', 'build/examples/socket/ns3.25-socket-bound-tcp-static-routing-optimized', 'build/examples/socket/ns3.25-socket-options-ipv4-optimized', 'build/examples/socket/ns3.25-socket-options-ipv6-optimized', 'build/examples/realtime/ns3.25-realtime-udp-echo-optimized', 'build/examples/naming/ns3.25-object-names-optimized', 'build/examples/ipv6/ns3.25-test-ipv6-optimized', 'build/examples/traffic-control/ns3.25-traffic-control-optimized', 'build/scratch/ns3.25-myfirst-optimized', 'build/scratch/subdir/ns3.25-subdir-optimized', 'build/scratch/ns3.25-scratch-simulator-optimized']
+
+# Scripts that are runnable.
+ns3_runnable_scripts = ['csma-bridge.py', 'sample-simulator.py', 'first.py', 'second.py', 'realtime-udp-echo.py']
+
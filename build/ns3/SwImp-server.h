@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright 2007 University of Washington
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_SWIMP_SERVER_H
+#define AM_SWIMP_SERVER_H
+
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/packet.h"
+#include "ns3/traced-callback.h"
+#include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-service-queue.h"
+#include "am-register-store.h"
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+
+/**
+ * \ingroup applications 
+ * \defgroup SwImp SwImp
+ */
+
+/**
+ * \ingroup SwImp
+ * \brief A Udp Echo server
+ *
+ * Every packet received is sent back.
+ */
+class SwImpServer : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SwImpServer ();
+  virtual ~SwImpServer ();
+
+  /**
+   * \brief Get the number of messages this server has sent
+   * \returns the #sentMsgs of the LOG line
+   */
+  uint32_t GetSentMessages (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  //string stream for ease of output
+  void LogInfo(std::stringstream& s);
+  /**
+   * \brief Handle a packet reception.
+   *
+   * This function is called by lower layers.
+   *
+   * \param socket the socket the packet was received to.
+   */
+  void HandleRead (Ptr<Socket> socket);
+  /**
+   * \brief Start or end a fault of the server
+   * \param fault the fault
+   */
+  void SetFault (AmServiceQueue::Fault fault);
+  /**
+   * \returns the fault of the server
+   */
+  AmServiceQueue::Fault GetFault (void) const;
+  /**
+   * \param delay the time every message received waits before it is processed
+   */
+  void SetSlowdown (Time delay);
+  /**
+   * \returns the time every message received waits before it is processed
+   */
+  Time GetSlowdown (void) const;
+  /**
+   * \brief Handle an incoming connection
+   * \param socket the incoming connection socket
+   * \param from the address the connection is from
+   */
+  void HandleAccept (Ptr<Socket> socket, const Address& from);
+  /**
+   * \brief Handle an connection close
+   * \param socket the connected socket
+   */
+  void HandlePeerClose (Ptr<Socket> socket);
+  /**
+   * \brief Handle an connection error
+   * \param socket the connected socket
+   */
+  void HandlePeerError (Ptr<Socket> socket);
+
+  uint16_t m_port; //!< Port on which we listen for incoming packets.
+  uint32_t m_size; //!< The size of the packet
+  Ptr<Socket> m_socket; //!< IPv4 Socket
+  std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
+  AmMessageFramer m_framer; //!< reassembles the messages of each socket
+  AmServiceQueue m_service; //!< processing time of the messages
+  uint32_t m_serviceCores; //!< cores of the server, 0 for no processing time
+  Ptr<RandomVariableStream> m_serviceTime; //!< processing time of a message (s)
+  Address m_local; //!< local multicast address
+  Address m_myAddress; //!< ip address
+  uint32_t m_personalID;        //My Personal ID
+
+  // SwImp variables
+  /// State of a single register (key)
+  struct Register
+  {
+    uint32_t ts;     //!< latest timestamp
+    uint32_t value;  //!< value associated with ts
+    Ptr<Packet> payload; //!< bytes of value, as received
+  };
+  AmRegisterStore<Register> m_registers; //!< register state per key
+  uint32_t m_sent;     //!< sent messages counter
+  /// Callbacks for tracing the handled messages
+  TracedCallback<uint32_t, uint32_t> m_handledTrace;
+  uint16_t m_verbose;   //!< Debug mode
+};
+
+} // namespace ns3
+
+#endif /* AM_SWIMP_SERVER_H */
+
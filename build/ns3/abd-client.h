@@ -0,0 +1,394 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright 2007 University of Washington
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_ABD_CLIENT_H
+#define AM_ABD_CLIENT_H
+
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/traced-callback.h"
+#include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-register-store.h"
+#include "am-key-selector.h"
+#include "am-workload.h"
+#include "am-op-table.h"
+#include "am-quorum-selector.h"
+#include "am-connection-manager.h"
+#include "am-write-batcher.h"
+#include "am-lease-table.h"
+#include <list>
+#include <map>
+#include <chrono>
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+
+/**
+ * \ingroup Abd
+ * \brief A Abd client
+ *
+ * Every packet sent should be returned by the server and received here.
+ */
+class AbdClient : public Application
+{
+public:
+	/**
+	 * \brief Get the type ID.
+	 * \return the object TypeId
+	 */
+	static TypeId GetTypeId (void);
+
+	AbdClient ();
+
+	virtual ~AbdClient ();
+
+	/**
+	 * \brief set the remote address and port
+	 * \param ip remote IP address
+	 * \param port remote port
+	 */
+	void SetRemote (Address ip, uint16_t port);
+
+	/**
+	 * Set the data size of the packet (the number of bytes that are sent as data
+	 * to the server).  The contents of the data are set to unspecified (don't
+	 * care) by this call.
+	 *
+	 * \warning If you have set the fill data for the client using one of the
+	 * SetFill calls, this will undo those effects.
+	 *
+	 * \param dataSize The size of the data you want to sent.
+	 */
+	void SetDataSize (uint32_t dataSize);
+
+	/**
+	 * Get the number of data bytes that will be sent to the server.
+	 *
+	 * \warning The number of bytes may be modified by calling any one of the
+	 * SetFill methods.  If you have called SetFill, then the number of
+	 * data bytes will correspond to the size of an initialized data buffer.
+	 * If you have not called a SetFill method, the number of data bytes will
+	 * correspond to the number of don't care bytes that will be sent.
+	 *
+	 * \returns The number of data bytes.
+	 */
+	uint32_t GetDataSize (void) const;
+
+	/**
+	 * \brief Get the totals of the operations of this client
+	 * \returns the counters reported in the LOG line
+	 */
+	AmClientStats GetStats (void) const;
+
+	/**
+	 * Set the data fill of the packet (what is sent as data to the server) to
+	 * the zero-terminated contents of the fill string string.
+	 *
+	 * \warning The size of resulting echo packets will be automatically adjusted
+	 * to reflect the size of the fill string -- this means that the PacketSize
+	 * attribute may be changed as a result of this call.
+	 *
+	 * \param fill The string to use as the actual echo data bytes. Format: "<msgtype, tag, value, sent>"
+	 */
+	void SetFill (std::string fill);
+
+	/**
+	 * Set the data fill of the packet (what is sent as data to the server) to
+	 * the contents of the fill buffer, repeated as many times as is required.
+	 *
+	 * Initializing the packet to the contents of a provided single buffer is
+	 * accomplished by setting the fillSize set to your desired dataSize
+	 * (and providing an appropriate buffer).
+	 *
+	 * \warning The size of resulting echo packets will be automatically adjusted
+	 * to reflect the dataSize parameter -- this means that the PacketSize
+	 * attribute of the Application may be changed as a result of this call.
+	 *
+	 * \param fill The fill pattern to use when constructing packets.
+	 * \param fillSize The number of bytes in the provided fill pattern.
+	 * \param dataSize The desired size of the final echo data.
+	 */
+	void SetFill (uint8_t *fill, uint32_t fillSize, uint32_t dataSize);
+
+	void SetServers (std::vector<Address> ip);
+
+	/**
+	 * \brief Assign fixed random variable stream numbers to the random
+	 * variables used by this client
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned
+	 */
+	int64_t AssignStreams (int64_t stream);
+
+protected:
+	virtual void DoDispose (void);
+
+private:
+
+	virtual void StartApplication (void);
+	virtual void StopApplication (void);
+
+	/**
+	 * \bief logging helper to record address and time
+	 * \param string stream to be printed on the output
+	 */
+	void LogInfo(std::stringstream& s);
+	/**
+	 * \brief clear the string stream
+	 */
+	//void Reset(stringstream& s);
+	/**
+	 * \brief Read operation handler
+	 */
+	void InvokeRead (void);
+	/**
+	 * \brief Write operation handler
+	 */
+	void InvokeWrite (void);
+	/**
+	 * \brief Send the round of the writes waiting on a key
+	 * \param key the key
+	 */
+	void CommitBatch (uint32_t key);
+	/**
+	 * \brief Record the completion of a write
+	 * \param start the invocation time of the write
+	 * \param ts the timestamp of the write
+	 */
+	void CompleteWrite (Time start, uint32_t ts);
+	/**
+	 * \brief Record the completion of the current read, and renew the read
+	 * lease of its key if its quorum granted one
+	 * \param exchanges the message exchanges of the read, 0 for a lease hit
+	 */
+	void CompleteRead (uint32_t exchanges);
+	/**
+	 * \brief Pick the key of the next operation and load its register state
+	 */
+	void SelectKey (void);
+	/**
+	 * \brief Make an outstanding operation the one being processed
+	 * \param id the op id
+	 */
+	void LoadOperation (uint32_t id);
+	/**
+	 * \brief Store the operation being processed back to the table of
+	 * outstanding operations, or drop it once it completed
+	 */
+	void SaveOperation (void);
+
+	/**
+	 * \brief Send a packet
+	 */
+	void HandleSend (void);
+	/**
+	 * \brief Send the message of the current round of an operation again, to
+	 * the servers that did not reply (UDP transport)
+	 * \param id the op id
+	 * \param counter the counter of the round
+	 * \param timeout the time waited for the replies
+	 */
+	void Retransmit (uint32_t id, uint32_t counter, Time timeout);
+	/**
+	 * \brief Send the message of the current round of an operation to the
+	 * servers left out of its thrifty quorum, once the timer expired
+	 * \param id the op id
+	 * \param counter the counter of the round
+	 */
+	void Fallback (uint32_t id, uint32_t counter);
+	/**
+	 * \param counter the counter of the round
+	 * \return the framed message of the current round
+	 */
+	Ptr<Packet> BuildMessage (uint32_t counter);
+	/**
+	 * \param socket the socket a reply was received on
+	 * \param from the address of the sender
+	 * \return the index of the server that sent the reply
+	 */
+	uint32_t FindServer (Ptr<Socket> socket, const Address &from) const;
+
+	/**
+	 * \brief Handle a packet reception.
+	 *
+	 * This function is called by lower layers.
+	 *
+	 * \param socket the socket the packet was received to.
+	 */
+	void HandleRecv (Ptr<Socket> socket);
+	/**
+	 * \brief Handle a received message
+	 * \param socket the socket the message was received on
+	 * \param packet the message, header included
+	 * \param from the address of the sender
+	 */
+	void HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, const Address &from);
+	/**
+	 * \brief process the received replies
+	 * \param type the type of the received message
+	 * \param ts the received timestamp
+	 * \param val the value associate with ts
+	 * \param payload the bytes of val
+	 * \param leased whether the server granted a read lease on the key
+	 */
+	void ProcessReply(uint32_t type, uint32_t ts, uint32_t val, Ptr<Packet> payload, bool leased);
+	/**
+	 * \brief Handle a Connection Succeed event
+	 * \param socket the connected socket
+	 */
+	void ConnectionSucceeded (Ptr<Socket> socket);
+	/**
+	 * \brief Handle a Connection Failed event
+	 * \param socket the not connected socket
+	 */
+	void ConnectionFailed (Ptr<Socket> socket);
+
+	uint32_t m_size; 		//!< Size of the values written, in bytes
+	uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
+	uint8_t *m_data; 		//!< packet payload data
+
+	std::vector< Ptr<Socket> > m_socket; //!< Socket
+	AmMessageFramer m_framer; //!< reassembles the messages of each socket
+	Transport m_transport;		//!< transport of the messages
+	Address m_group;			//!< multicast group of the servers (UDP), none if not multicast
+	Ptr<Socket> m_groupSocket;	//!< socket sending to m_group
+	Time m_rto;					//!< initial retransmission timeout (UDP)
+	std::map<uint32_t, EventId> m_retransmit; //!< retransmission timer of each operation (UDP)
+	uint32_t m_retransmits;		//!< messages sent again
+	AmQuorumSelector m_quorum;	//!< picks the servers a round is sent to first
+	AmQuorumSelector::Mode m_quorumMode;	//!< all the servers, or a thrifty quorum
+	Time m_thriftyTimeout;		//!< time a thrifty round waits before it goes to all the servers
+	std::map<uint32_t, EventId> m_fallback; //!< thrifty timer of each operation
+	uint32_t m_fallbacks;		//!< thrifty rounds sent to all the servers
+	uint32_t m_serverMsgs;		//!< messages sent to the servers, without the retransmissions
+	bool m_multiplex;			//!< whether the sockets are shared with the other clients of the node
+	Ptr<AmConnectionManager> m_mux;	//!< shares the sockets, if multiplexed
+	uint32_t m_muxId;			//!< id of the client in m_mux, carried in the sender field
+	std::vector<Address> m_serverAddress; //!< Remote server adresses
+	Address m_peerAddress; //!< Remote peer address
+	Address m_myAddress; //!< Remote peer address
+	uint16_t m_peerPort; //!< Remote peer port
+
+	uint16_t m_serversConnected;
+	uint32_t m_personalID; 				//My Personal ID
+
+	// ABD variables
+	uint32_t m_ts; 				//!< latest timestamp
+	uint32_t m_value;			//!< value associated with m_ts
+	Ptr<Packet> m_payload;		//!< bytes of m_value
+
+	// Key-value store
+	/// Local state of a single register (key)
+	struct Register
+	{
+		uint32_t ts;      //!< latest timestamp
+		uint32_t value;   //!< value associated with ts
+		Ptr<Packet> payload; //!< bytes of value
+		AmReadLease lease;   //!< the read lease held on the key
+	};
+	AmRegisterStore<Register> m_registers; //!< register state of the keys not currently accessed
+	AmKeySelector m_keys;		//!< picks the key of each operation
+	uint32_t m_key;				//!< key accessed by the current operation
+	uint32_t m_numKeys;			//!< number of keys
+	AmKeySelector::Distribution m_keyDist; //!< distribution of the accessed keys
+	double m_zipfAlpha;			//!< exponent of the zipf key distribution
+
+	// Workload
+	AmWorkload m_workload;		//!< schedules the invocations of the operations
+	AmWorkload::Arrival m_arrival;	//!< arrival process of the operations
+	double m_arrivalRate;		//!< rate of the Poisson arrivals (ops/s)
+	std::string m_traceFile;	//!< file of the arrival times to replay
+
+	// Outstanding operations
+	/// State of a single operation
+	struct Operation
+	{
+		Status status;		//!< operation status
+		MessageType msgType;	//!< type of the messages of the current phase
+		uint32_t key;		//!< key accessed by the operation
+		uint32_t ts;		//!< timestamp of the operation
+		uint32_t value;		//!< value associated with the tag
+		Ptr<Packet> payload;	//!< bytes of value
+		uint32_t replies;	//!< replies received in the current phase
+		Time start;		//!< invocation time
+		std::chrono::time_point<std::chrono::system_clock> real_start; //!< wall clock invocation time
+		AmSeenSet contacted;	//!< servers the current round was sent to
+		Time roundStart;	//!< sending time of the current round
+		uint32_t confirmed;	//!< replies of the query carrying the greatest tag
+		uint32_t leased;	//!< replies of the query granting a read lease
+		Time leaseEnd;		//!< end of the read lease of the quorum, if all of it granted one
+	};
+	AmOpTable<Operation> m_ops;	//!< outstanding operations
+	uint32_t m_opId;			//!< id of the operation being processed
+	uint32_t m_maxInFlight;		//!< maximum number of outstanding operations
+	uint32_t m_writeBatch;		//!< writes committed by a round at most
+	Time m_leaseTime;			//!< duration of the read leases of the servers, 0 for none
+	uint32_t m_confirmed;		//!< replies of the query carrying the greatest tag
+	uint32_t m_leased;			//!< replies of the query granting a read lease
+	Time m_leaseEnd;			//!< end of the read lease of the quorum of the current read
+	uint32_t m_leaseReads;		//!< reads answered by a read lease
+	uint32_t m_fastReads;		//!< reads completed in one round
+	AmWriteBatcher m_batcher;	//!< the writes waiting for a round
+
+	uint32_t m_numServers;		//!< number of servers
+	uint32_t m_fail;			//!< max number of failures supported
+
+	Status m_opStatus;			//!< operation status
+	MessageType m_msgType; 		//!< type of a message send/received
+	ProcessType m_prType;		//!< indicate if the client is a writer or a reader
+
+	//timers
+	Time m_interval; 		//!< Operation invocation interval
+	Time m_opStart;
+	Time m_opEnd;
+	Time m_opAve;
+
+	//counters
+	uint32_t m_opCount;
+	uint32_t m_completeOps;
+	uint32_t m_numClients;
+	uint32_t m_replies;
+	AmSeenSet m_contacted;		//!< servers the current round was sent to
+	Time m_roundStart;			//!< sending time of the current round
+	uint32_t m_sent; 		//!< Counter for sent packets
+	uint32_t m_count; 		//!< Maximum number of packets the application will send
+
+	//randomness
+	uint16_t m_randInt;		//!< Flag indicating the choose of a random interval for each op invocation
+	uint16_t m_seed;		//!< Randomness seed
+	uint16_t m_verbose;		//!< Debug mode
+	std::chrono::time_point<std::chrono::system_clock> m_real_start;
+	std::chrono::time_point<std::chrono::system_clock> m_real_end;
+	std::chrono::duration<double> m_real_opAve;
+
+	/// Callbacks for tracing the packet Tx events
+	TracedCallback<Ptr<const Packet> > m_txTrace;
+
+	/// Callbacks for tracing the completed operations
+	TracedCallback<uint32_t, uint32_t, Time, uint32_t, uint32_t, uint32_t> m_opCompletedTrace;
+};
+
+} // namespace ns3
+
+#endif /* AM_ABD_CLIENT_H */
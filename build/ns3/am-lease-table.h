@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_LEASE_TABLE_H
+#define AM_LEASE_TABLE_H
+
+#include "ns3/nstime.h"
+#include "ns3/address.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include <stdint.h>
+#include <map>
+#include <utility>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmLeaseTable
+ * \brief The read leases a server granted, per key.
+ *
+ * A server grants a lease on a key to the client of a query: until the
+ * lease ends, the server does not change the register of the key for the
+ * other clients. A message that would raise the tag of the register waits
+ * until the leases the other clients hold on the key end, and no lease is
+ * granted on a key while such a message waits, so a write waits one lease
+ * at most. The lease of the client of the message does not hold it back:
+ * the second round of a read propagates the tag the read leased.
+ *
+ * A client that holds a lease from a quorum, taken by a read that returned
+ * the greatest tag of the quorum, knows that no operation completes with a
+ * greater tag before the lease ends, and answers the reads of the key with
+ * that tag at once (see AmReadLease). The client counts the lease from the
+ * sending of its query, before the server granted it.
+ */
+class AmLeaseTable
+{
+public:
+  /// A client: the address of its socket and the sender field of its messages
+  typedef std::pair<Address, uint32_t> Holder;
+
+  AmLeaseTable ();
+
+  /**
+   * \param time the duration of the leases, 0 to grant none
+   */
+  void SetLeaseTime (Time time);
+
+  /**
+   * \returns whether leases are granted
+   */
+  bool IsEnabled (void) const;
+
+  /**
+   * \brief grant a lease on a key, unless a message waits on it
+   * \param key the key
+   * \param holder the client
+   * \returns whether the lease was granted
+   */
+  bool Grant (uint32_t key, const Holder &holder);
+
+  /**
+   * \param key the key
+   * \param holder the client of a message that raises the tag of the key
+   * \returns the time until the leases of the other clients on the key end,
+   *          0 if the message can be processed now
+   */
+  Time GetWait (uint32_t key, const Holder &holder);
+
+  /**
+   * \brief note a message that waits on a key
+   * \param key the key
+   */
+  void Hold (uint32_t key);
+
+  /**
+   * \brief note the end of the wait of a message
+   * \param key the key
+   * \param waited the time the message waited
+   */
+  void Release (uint32_t key, Time waited);
+
+  /**
+   * \brief drop the leases
+   */
+  void Clear (void);
+
+  /**
+   * \returns the leases granted
+   */
+  uint64_t GetGranted (void) const;
+
+  /**
+   * \returns the messages that waited for leases to end
+   */
+  uint64_t GetHeld (void) const;
+
+  /**
+   * \returns the total time the messages waited
+   */
+  Time GetHoldTime (void) const;
+
+private:
+  /// The leases of a key
+  struct Key
+  {
+    Key () : held (0) {}
+    std::map<Holder, Time> leases;  //!< end of the lease of each client
+    uint32_t held;                  //!< messages waiting for the leases to end
+  };
+
+  /**
+   * \brief forget the leases of a key that ended
+   * \param key the leases of the key
+   */
+  void Expire (Key &key);
+
+  Time m_leaseTime;                 //!< duration of the leases
+  std::map<uint32_t, Key> m_keys;   //!< the keys with leases or waiting messages
+  uint64_t m_granted;               //!< leases granted
+  uint64_t m_held;                  //!< messages that waited
+  Time m_holdTime;                  //!< total time the messages waited
+};
+
+/**
+ * \ingroup applications
+ * \brief The read lease a client holds on a key.
+ *
+ * A read that got a lease from each server of its quorum and returned the
+ * greatest tag they replied renews the lease, from the sending of its query
+ * (see AmLeaseTable). While the lease is valid, the reads of the key return
+ * the tag of the lease without a round.
+ *
+ * Every other read of the client raises the tag of the lease to the one it
+ * returned, without extending it: with several reads in flight, a read that
+ * wrote back a greater tag may complete after the lease of its own quorum
+ * ended, while the lease of a later read on the older tag is still valid.
+ */
+struct AmReadLease
+{
+  AmReadLease () : ts (0), id (0), value (0) {}
+
+  /**
+   * \returns whether the lease has not ended
+   */
+  bool IsValid (void) const;
+
+  /**
+   * \brief extend the lease, and keep the greater of its tag and the one read
+   * \param leaseEnd the end of the lease taken by the read, 0 if it took none
+   * \param leaseTs the timestamp read
+   * \param leaseId the writer id read
+   * \param leaseValue the value read
+   * \param leasePayload the bytes of the value read
+   */
+  void Renew (Time leaseEnd, uint32_t leaseTs, uint32_t leaseId, uint32_t leaseValue, Ptr<Packet> leasePayload);
+
+  Time end;             //!< end of the lease
+  uint32_t ts;          //!< timestamp of the tag
+  uint32_t id;          //!< writer id of the tag
+  uint32_t value;       //!< value of the tag
+  Ptr<Packet> payload;  //!< bytes of the value
+};
+
+} // namespace ns3
+
+#endif /* AM_LEASE_TABLE_H */
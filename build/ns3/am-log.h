@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_LOG_H
+#define AM_LOG_H
+
+#include "ns3/log.h"
+#include <sstream>
+
+/**
+ * \ingroup applications
+ * \file
+ * Logging macros of the atomic-memory clients and servers.
+ *
+ * The message is a stream expression, as for NS_LOG_INFO, handed to the
+ * LogInfo/LogDebug helper of the application that prefixes it with the
+ * address and the time. The level of the log component (g_log) is checked
+ * before the message is formatted, so a disabled log costs a single test.
+ * When logging is compiled out (optimized builds, NS3_LOG_ENABLE undefined)
+ * the macros expand to dead code: the message is still type-checked but
+ * never evaluated.
+ */
+
+#ifdef NS3_LOG_ENABLE
+
+/**
+ * \brief format msg and pass it to sink if level is enabled in g_log
+ * \param level the ns3::LogLevel of the message
+ * \param sink the member function taking the std::stringstream
+ * \param msg the message, as a stream expression
+ */
+#define AM_LOG(level, sink, msg)                                \
+  do                                                            \
+    {                                                           \
+      if (g_log.IsEnabled (level))                              \
+        {                                                       \
+          std::stringstream amLogStream;                        \
+          amLogStream << msg;                                   \
+          sink (amLogStream);                                   \
+        }                                                       \
+    }                                                           \
+  while (false)
+
+#else /* NS3_LOG_ENABLE */
+
+#define AM_LOG(level, sink, msg)                                \
+  do                                                            \
+    {                                                           \
+      if (false)                                                \
+        {                                                       \
+          std::stringstream amLogStream;                        \
+          amLogStream << msg;                                   \
+        }                                                       \
+    }                                                           \
+  while (false)
+
+#endif /* NS3_LOG_ENABLE */
+
+/// Log msg at the info level through LogInfo
+#define AM_LOG_INFO(msg) AM_LOG (ns3::LOG_INFO, LogInfo, msg)
+
+/// Log msg at the debug level through LogDebug
+#define AM_LOG_DEBUG(msg) AM_LOG (ns3::LOG_DEBUG, LogDebug, msg)
+
+#endif /* AM_LOG_H */
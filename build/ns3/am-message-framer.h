@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_MESSAGE_FRAMER_H
+#define AM_MESSAGE_FRAMER_H
+
+#include "ns3/header.h"
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/buffer.h"
+#include <list>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+
+/**
+ * \ingroup applications
+ * \class AmFrameHeader
+ * \brief Length prefix placed in front of every atomic memory message.
+ */
+class AmFrameHeader : public Header
+{
+public:
+  AmFrameHeader ();
+
+  /**
+   * \param length the size in bytes of the message that follows
+   */
+  void SetLength (uint32_t length);
+  /**
+   * \return the size in bytes of the message that follows
+   */
+  uint32_t GetLength (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  uint32_t m_length; //!< message length
+};
+
+/**
+ * \ingroup applications
+ * \class AmMessageFramer
+ * \brief Splits a TCP byte stream back into atomic memory messages.
+ *
+ * A stream socket may deliver several messages in one segment, or a message
+ * split over several segments. The sender frames every message with Frame ()
+ * and the receiver replaces socket->RecvFrom (from) with Recv (socket, from):
+ * the framer keeps a reassembly buffer per socket and hands out one complete
+ * message per call, reading more segments from the socket only when the
+ * buffer does not hold a complete message. Recv returns 0 once the socket is
+ * drained, so the usual receive loop consumes every complete message of the
+ * callback.
+ *
+ * Build () serializes a message and its length prefix straight into a new
+ * packet, so no bytes are copied; every message still costs a Packet and a
+ * buffer, the latter recycled by the ns-3 Buffer free list. The packets are
+ * not pooled, as the sockets keep references to the packets they are given.
+ * A message that carries a value is built around the value packet: the
+ * value bytes are shared with the caller (copy-on-write), so a value created
+ * as virtual zero bytes is never materialized on the sending side.
+ *
+ * The received segments are queued as they are and a message is cut out of
+ * them only once it is complete: a message that lies in a single segment is
+ * a fragment of it. A larger one is joined from fragments of its segments
+ * when they hold virtual zero bytes, which keeps a zero-filled value
+ * virtual, and is otherwise copied once, whatever the number of segments
+ * it arrived in.
+ */
+class AmMessageFramer
+{
+public:
+  AmMessageFramer ();
+
+  /**
+   * \brief prepend the length prefix to a message
+   * \param p the packet holding a single message
+   */
+  static void Frame (Ptr<Packet> p);
+
+  /**
+   * \brief build the framed packet of a message
+   * \param msg the header holding the message
+   * \return a packet holding the length prefix followed by the message
+   */
+  static Ptr<Packet> Build (const Header &msg);
+
+  /**
+   * \brief build the framed packet of a message carrying a value
+   * \param msg the header holding the message
+   * \param payload the value placed after the header, shared and not copied
+   * \return a packet holding the length prefix, the message and the value
+   */
+  static Ptr<Packet> Build (const Header &msg, Ptr<const Packet> payload);
+
+  /**
+   * \brief get the next complete message received on a socket
+   * \param socket the socket to read from
+   * \param from set to the address of the peer
+   * \return the next message (without its length prefix), 0 if none is complete
+   */
+  Ptr<Packet> Recv (Ptr<Socket> socket, Address &from);
+
+  /**
+   * \brief drop the reassembly buffer of a socket
+   * \param socket the socket
+   */
+  void Remove (Ptr<Socket> socket);
+
+  /**
+   * \brief drop all the reassembly buffers
+   */
+  void Clear (void);
+
+private:
+  /// Reassembly state of a socket
+  struct Stream
+  {
+    Stream () : size (0) {}
+    std::list<Ptr<Packet> > segments; //!< received segments not yet handed out
+    uint32_t size;                    //!< bytes in the segments
+    Address from;                     //!< peer address
+  };
+
+  /**
+   * \brief remove the next complete message from a stream
+   * \param s the stream
+   * \return the message, 0 if the stream does not hold a complete one
+   */
+  Ptr<Packet> Extract (Stream &s);
+  /**
+   * \brief remove bytes from the front of a stream
+   * \param s the stream, holding at least size bytes
+   * \param size the number of bytes
+   * \return the bytes
+   */
+  Ptr<Packet> Take (Stream &s, uint32_t size);
+  /**
+   * \param p a packet
+   * \return true if the buffer of the packet holds virtual zero bytes
+   */
+  static bool IsVirtual (Ptr<const Packet> p);
+  /**
+   * \param p a packet
+   * \return true if all the bytes of the packet are zero
+   */
+  bool IsZero (Ptr<const Packet> p);
+
+  std::map<Ptr<Socket>, Stream> m_streams; //!< reassembly buffer per socket
+  std::vector<uint8_t> m_assembly;         //!< copy area of the segments of a message
+};
+
+} // namespace ns3
+
+#endif /* AM_MESSAGE_FRAMER_H */
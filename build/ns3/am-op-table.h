@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_OP_TABLE_H
+#define AM_OP_TABLE_H
+
+#include "am-seen-set.h"
+#include <stdint.h>
+#include <map>
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmOpTable
+ * \brief Table of the outstanding operations of a client, keyed by op id.
+ *
+ * Each client defines the state it keeps for a single operation (Op). The
+ * messages of an operation carry a counter that the servers echo back; the
+ * table remembers the counter of the current round of every operation, so a
+ * reply is matched to its operation with a single lookup and replies to an
+ * older round no longer match. The table also remembers the servers that
+ * replied to the current round, so a duplicate reply (e.g. to a
+ * retransmitted datagram) is not counted twice.
+ */
+template <typename Op>
+class AmOpTable
+{
+public:
+  /**
+   * \brief get the state of an operation, creating it if needed
+   * \param id the op id
+   * \return the state of the operation
+   */
+  Op& Get (uint32_t id)
+  {
+    return m_ops[id].op;
+  }
+
+  /**
+   * \brief set the counter carried by the messages of the current round
+   * \param id the op id
+   * \param counter the message counter
+   */
+  void SetCounter (uint32_t id, uint32_t counter)
+  {
+    Entry &e = m_ops[id];
+    if (e.tracked)
+      {
+        m_rounds.erase (e.counter);
+      }
+    e.counter = counter;
+    e.tracked = true;
+    e.replied.Clear ();
+    m_rounds[counter] = id;
+  }
+
+  /**
+   * \brief record the reply of a server to the current round of an operation
+   * \param id the op id
+   * \param server the index of the server
+   * \return false if the server already replied to the round
+   */
+  bool AddReply (uint32_t id, uint32_t server)
+  {
+    Entry &e = m_ops[id];
+    if (e.replied.Contains (server))
+      {
+        return false;
+      }
+    e.replied.Insert (server);
+    return true;
+  }
+
+  /**
+   * \param id the op id
+   * \return the servers that replied to the current round of the operation
+   */
+  const AmSeenSet& GetReplies (uint32_t id)
+  {
+    return m_ops[id].replied;
+  }
+
+  /**
+   * \brief find the operation a reply belongs to
+   * \param counter the counter carried by the reply
+   * \param id set to the op id when found
+   * \return true if an outstanding operation is waiting for the counter
+   */
+  bool Lookup (uint32_t counter, uint32_t &id) const
+  {
+    std::unordered_map<uint32_t, uint32_t>::const_iterator it = m_rounds.find (counter);
+    if (it == m_rounds.end ())
+      {
+        return false;
+      }
+    id = it->second;
+    return true;
+  }
+
+  /**
+   * \brief drop a completed operation
+   * \param id the op id
+   */
+  void Remove (uint32_t id)
+  {
+    typename std::map<uint32_t, Entry>::iterator it = m_ops.find (id);
+    if (it == m_ops.end ())
+      {
+        return;
+      }
+    if (it->second.tracked)
+      {
+        m_rounds.erase (it->second.counter);
+      }
+    m_ops.erase (it);
+  }
+
+  /**
+   * \return the number of outstanding operations
+   */
+  uint32_t GetSize (void) const
+  {
+    return m_ops.size ();
+  }
+
+  /**
+   * \brief drop all the operations
+   */
+  void Clear (void)
+  {
+    m_ops.clear ();
+    m_rounds.clear ();
+  }
+
+private:
+  /// An operation and the counter of its current round
+  struct Entry
+  {
+    Entry () : op (), counter (0), tracked (false) {}
+    Op op;              //!< state of the operation
+    uint32_t counter;   //!< counter of the current round
+    bool tracked;       //!< true once a round was sent
+    AmSeenSet replied;  //!< servers that replied to the current round
+  };
+
+  std::map<uint32_t, Entry> m_ops;                  //!< operations per op id
+  std::unordered_map<uint32_t, uint32_t> m_rounds;  //!< op id per message counter
+};
+
+} // namespace ns3
+
+#endif /* AM_OP_TABLE_H */
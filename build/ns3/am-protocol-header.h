@@ -0,0 +1,231 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_PROTOCOL_HEADER_H
+#define AM_PROTOCOL_HEADER_H
+
+#include "ns3/header.h"
+#include "asm-common.h"
+#include "am-seen-set.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmProtocolHeader
+ * \brief Common message header of the atomic memory protocols.
+ *
+ * Every client/server pair in atomic-memory exchanges this header. The
+ * layout is fixed, independently of the message type:
+ *
+ * \verbatim
+   | type (1) | flags (1) | key (4) | counter (4) | ts (4) | id (4) | value (4) |
+   | pvalue (4) | sender (4) | views (4) | postit (4) |
+   | #seen words (2) | seen bitmap (4 * #seen words) |
+   \endverbatim
+ *
+ * Fields that a protocol does not use are carried as zero. The seen set is
+ * encoded as a bitmap indexed by process id, so its size grows with the
+ * largest id in the set and not with the number of its members.
+ */
+class AmProtocolHeader : public Header
+{
+public:
+  AmProtocolHeader ();
+
+  /**
+   * \param type the message type
+   */
+  void SetType (MessageType type);
+  /**
+   * \return the message type
+   */
+  MessageType GetType (void) const;
+
+  /**
+   * \param key the register (object) the message refers to
+   */
+  void SetKey (uint32_t key);
+  /**
+   * \return the register (object) the message refers to
+   */
+  uint32_t GetKey (void) const;
+
+  /**
+   * \param counter the operation (or message) counter of the sender
+   */
+  void SetCounter (uint32_t counter);
+  /**
+   * \return the operation (or message) counter of the sender
+   */
+  uint32_t GetCounter (void) const;
+
+  /**
+   * \brief set the tag <ts, id> carried by the message
+   * \param ts the timestamp
+   * \param id the id of the writer that generated ts
+   */
+  void SetTag (uint32_t ts, uint32_t id);
+  /**
+   * \param ts the timestamp of the tag
+   */
+  void SetTs (uint32_t ts);
+  /**
+   * \return the timestamp of the tag
+   */
+  uint32_t GetTs (void) const;
+  /**
+   * \param id the writer id of the tag
+   */
+  void SetId (uint32_t id);
+  /**
+   * \return the writer id of the tag
+   */
+  uint32_t GetId (void) const;
+
+  /**
+   * \param value the value associated with the tag
+   */
+  void SetValue (uint32_t value);
+  /**
+   * \return the value associated with the tag
+   */
+  uint32_t GetValue (void) const;
+  /**
+   * \param pvalue the value associated with the previous tag
+   */
+  void SetPvalue (uint32_t pvalue);
+  /**
+   * \return the value associated with the previous tag
+   */
+  uint32_t GetPvalue (void) const;
+
+  /**
+   * \param sender the id of the process the message refers to
+   * (relay initiator, virtual id, writer id)
+   */
+  void SetSender (uint32_t sender);
+  /**
+   * \return the id of the process the message refers to
+   */
+  uint32_t GetSender (void) const;
+
+  /**
+   * \param views the number of processes that have seen the tag
+   */
+  void SetViews (uint32_t views);
+  /**
+   * \return the number of processes that have seen the tag
+   */
+  uint32_t GetViews (void) const;
+  /**
+   * \param postit the highest timestamp propagated by a reader
+   */
+  void SetPostit (uint32_t postit);
+  /**
+   * \return the highest timestamp propagated by a reader
+   */
+  uint32_t GetPostit (void) const;
+
+  /**
+   * \param secured true if the timestamp is secured by a majority
+   */
+  void SetSecured (bool secured);
+  /**
+   * \return true if the timestamp is secured by a majority
+   */
+  bool IsSecured (void) const;
+  /**
+   * \param initiator true if the reply concludes a relay round
+   */
+  void SetInitiator (bool initiator);
+  /**
+   * \return true if the reply concludes a relay round
+   */
+  bool IsInitiator (void) const;
+  /**
+   * \param propagated true if the tag was already propagated by a reader
+   */
+  void SetPropagated (bool propagated);
+  /**
+   * \return true if the tag was already propagated by a reader
+   */
+  bool IsPropagated (void) const;
+  /**
+   * \param leased true if the reply grants a read lease on the key
+   */
+  void SetLeased (bool leased);
+  /**
+   * \return true if the reply grants a read lease on the key
+   */
+  bool IsLeased (void) const;
+
+  /**
+   * \param seen the ids of the processes that have seen the tag
+   */
+  void SetSeen (const AmSeenSet &seen);
+  /**
+   * \return the ids of the processes that have seen the tag
+   */
+  AmSeenSet GetSeen (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  /// Flags carried in the flags byte
+  enum Flags
+  {
+    SECURED = 0x01,
+    INITIATOR = 0x02,
+    PROPAGATED = 0x04,
+    LEASED = 0x08
+  };
+
+  /**
+   * \brief set or clear a flag
+   * \param flag the flag
+   * \param on true to set the flag
+   */
+  void SetFlag (uint8_t flag, bool on);
+
+  uint8_t m_type;     //!< message type
+  uint8_t m_flags;    //!< secured/initiator/propagated/leased flags
+  uint32_t m_key;     //!< register key
+  uint32_t m_counter; //!< operation counter
+  uint32_t m_ts;      //!< tag timestamp
+  uint32_t m_id;      //!< tag writer id
+  uint32_t m_value;   //!< value of the tag
+  uint32_t m_pvalue;  //!< value of the previous tag
+  uint32_t m_sender;  //!< process the message refers to
+  uint32_t m_views;   //!< |seen|
+  uint32_t m_postit;  //!< propagated timestamp
+  std::vector<uint32_t> m_seen; //!< seen set bitmap
+};
+
+} // namespace ns3
+
+#endif /* AM_PROTOCOL_HEADER_H */
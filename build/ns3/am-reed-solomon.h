@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_REED_SOLOMON_H
+#define AM_REED_SOLOMON_H
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmReedSolomon
+ * \brief Systematic [n, k] Reed-Solomon code over GF(2^8).
+ *
+ * A value is split into k data fragments of equal size (the last one is
+ * padded with zeros) and n - k parity fragments are added, so that any k of
+ * the n fragments give the value back. The generator matrix is the identity
+ * on top of a Cauchy matrix, every k x k submatrix of which is invertible;
+ * fragment i of a value is always computed by row i, so the fragments can be
+ * decoded from whichever k of them are received. n is at most 256.
+ */
+class AmReedSolomon
+{
+public:
+  AmReedSolomon ();
+
+  /**
+   * \brief set the parameters of the code
+   * \param n the number of fragments
+   * \param k the number of fragments needed to decode
+   */
+  void SetCode (uint32_t n, uint32_t k);
+  /**
+   * \return the number of fragments
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \return the number of fragments needed to decode
+   */
+  uint32_t GetK (void) const;
+
+  /**
+   * \param valueSize the size of a value in bytes
+   * \return the size of each fragment of the value
+   */
+  uint32_t GetFragmentSize (uint32_t valueSize) const;
+
+  /**
+   * \brief split a value into n fragments
+   * \param value the value
+   * \param fragments set to the n fragments, fragment i at index i
+   */
+  void Encode (const std::vector<uint8_t> &value, std::vector<std::vector<uint8_t> > &fragments) const;
+
+  /**
+   * \brief rebuild a value from k of its fragments
+   * \param fragments the received fragments, keyed by fragment index
+   * \param value set to the value, padded to k times the fragment size
+   * \return false if there are fewer than k fragments of the same size
+   */
+  bool Decode (const std::map<uint32_t, std::vector<uint8_t> > &fragments, std::vector<uint8_t> &value) const;
+
+private:
+  /**
+   * \param row the row (fragment index)
+   * \param col the column (data fragment index)
+   * \return the coefficient of the generator matrix
+   */
+  uint8_t GetCoefficient (uint32_t row, uint32_t col) const;
+  /**
+   * \brief add c times src to dst, byte per byte
+   * \param dst the destination
+   * \param src the source
+   * \param size the number of bytes
+   * \param c the coefficient
+   */
+  static void MulAdd (uint8_t *dst, const uint8_t *src, uint32_t size, uint8_t c);
+  /**
+   * \return the product of a and b in GF(2^8)
+   */
+  static uint8_t Mul (uint8_t a, uint8_t b);
+  /**
+   * \return the inverse of a (not zero) in GF(2^8)
+   */
+  static uint8_t Inv (uint8_t a);
+
+  uint32_t m_n; //!< number of fragments
+  uint32_t m_k; //!< fragments needed to decode
+};
+
+} // namespace ns3
+
+#endif /* AM_REED_SOLOMON_H */
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_SEEN_SET_H
+#define AM_SEEN_SET_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmSeenSet
+ * \brief Set of the ids of the processes that have seen a tag.
+ *
+ * The ids are small integers (client or virtual node ids), so the set is a
+ * dense bitmap of 32-bit words indexed by id, the same layout the seen set
+ * has in AmProtocolHeader. Clearing the set keeps its words allocated, the
+ * size is maintained with popcounts and intersections are word-wise ANDs.
+ * Trailing zero words are never kept, so two equal sets have equal words.
+ */
+class AmSeenSet
+{
+public:
+  AmSeenSet ();
+
+  /**
+   * \brief add an id to the set
+   * \param id the id
+   */
+  void Insert (uint32_t id);
+  /**
+   * \param id the id
+   * \return true if the id is in the set
+   */
+  bool Contains (uint32_t id) const;
+  /**
+   * \brief remove all the ids
+   */
+  void Clear (void);
+  /**
+   * \return the number of ids in the set
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \return true if the set is empty
+   */
+  bool IsEmpty (void) const;
+  /**
+   * \return an upper bound (exclusive) of the ids in the set
+   */
+  uint32_t GetBound (void) const;
+
+  /**
+   * \brief keep only the ids that are also in other
+   * \param other the set to intersect with
+   */
+  void IntersectWith (const AmSeenSet &other);
+  /**
+   * \param other a set
+   * \return true if all the ids of this set are in other
+   */
+  bool IsSubsetOf (const AmSeenSet &other) const;
+
+  /**
+   * \return the bitmap words
+   */
+  const std::vector<uint32_t>& GetWords (void) const;
+  /**
+   * \param words the bitmap words
+   */
+  void SetWords (const std::vector<uint32_t> &words);
+
+  /**
+   * \brief print the ids of the set
+   * \param os the output stream
+   * \param prefix printed before each id
+   */
+  void Print (std::ostream &os, std::string prefix = "") const;
+
+  /**
+   * \param other a set
+   * \return true if the sets have the same ids
+   */
+  bool operator== (const AmSeenSet &other) const;
+  /**
+   * \param other a set
+   * \return an arbitrary strict order of the sets, to keep them in std::set
+   */
+  bool operator< (const AmSeenSet &other) const;
+
+private:
+  /**
+   * \brief drop the trailing zero words and recount the ids
+   */
+  void Normalize (void);
+
+  std::vector<uint32_t> m_words; //!< bitmap of the ids
+  uint32_t m_size;               //!< number of ids in the set
+};
+
+/**
+ * \brief print the ids of a seen set
+ * \param os the output stream
+ * \param seen the set
+ * \return the output stream
+ */
+std::ostream& operator<< (std::ostream &os, const AmSeenSet &seen);
+
+} // namespace ns3
+
+#endif /* AM_SEEN_SET_H */
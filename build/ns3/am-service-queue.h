@@ -0,0 +1,241 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_SERVICE_QUEUE_H
+#define AM_SERVICE_QUEUE_H
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/address.h"
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+class AmMessageFramer;
+class AmProtocolHeader;
+
+/**
+ * \ingroup applications
+ * \class AmServiceQueue
+ * \brief Processing time of the messages of a server.
+ *
+ * Models the CPU of a server as Cores identical cores fed by a single FIFO
+ * queue. The server replaces m_framer.Recv (socket, from) with
+ * Recv (m_framer, socket, from): the complete messages of the socket are
+ * queued, each with a service time drawn from the distribution of its
+ * MessageType plus PerItem times the items the server reports for it (the
+ * entries of the seen set of its register, the servers a read is relayed
+ * to), and Recv
+ * only hands out the messages whose service is over. When a service ends
+ * the queue calls the served callback, the server's receive handler, with
+ * the socket of the message, so the usual receive loop gets it.
+ *
+ * The times are drawn from ns-3 random variables, so the processing delays,
+ * the queueing they cause and the resulting latencies are reproducible.
+ * With zero cores, the default, Recv is the framer's Recv and the messages
+ * are handled on arrival.
+ *
+ * The queue also injects the faults of its server (see AmFaultInjector): a
+ * crashed server loses the messages it receives along with those waiting
+ * for a core, a paused one holds them until the pause ends, and a slowdown
+ * delays every message before it reaches the queue.
+ */
+class AmServiceQueue
+{
+public:
+  /// Fault of a server
+  enum Fault
+  {
+    NONE,   //!< the messages are handled
+    CRASH,  //!< the messages are lost
+    PAUSE   //!< the messages are held until the fault ends
+  };
+
+  AmServiceQueue ();
+
+  /**
+   * \param cores the messages served at the same time, 0 to disable
+   */
+  void SetCores (uint32_t cores);
+
+  /**
+   * \returns the cores, 0 if disabled
+   */
+  uint32_t GetCores (void) const;
+
+  /**
+   * \param time the service time (s) of the messages of any type
+   */
+  void SetServiceTime (Ptr<RandomVariableStream> time);
+
+  /**
+   * \param type a MessageType
+   * \param time the service time (s) of the messages of type, 0 to use
+   *        the one of any type
+   */
+  void SetServiceTime (uint32_t type, Ptr<RandomVariableStream> time);
+
+  /**
+   * \param perItem the service time added per item of a message
+   */
+  void SetPerItem (Time perItem);
+
+  /**
+   * \param items returns the items the server goes through to handle a
+   *        message, charged PerItem each
+   */
+  void SetItemsCallback (Callback<uint32_t, const AmProtocolHeader &> items);
+
+  /**
+   * \brief start or end a fault
+   * \param fault the fault of the server from now on
+   */
+  void SetFault (Fault fault);
+
+  /**
+   * \returns the fault of the server
+   */
+  Fault GetFault (void) const;
+
+  /**
+   * \param delay the time every message waits before it is queued, 0 for
+   *        none
+   */
+  void SetSlowdown (Time delay);
+
+  /**
+   * \returns the time every message waits before it is queued
+   */
+  Time GetSlowdown (void) const;
+
+  /**
+   * \param served the handler called with the socket of a served message
+   */
+  void SetServedCallback (Callback<void, Ptr<Socket> > served);
+
+  /**
+   * \brief get the next served message received on a socket
+   * \param framer the framer of the server
+   * \param socket the socket to read from
+   * \param from set to the address of the peer
+   * \return the next served message, 0 if none
+   */
+  Ptr<Packet> Recv (AmMessageFramer &framer, Ptr<Socket> socket, Address &from);
+
+  /**
+   * \brief drop the queued and the pending services
+   */
+  void Clear (void);
+
+  /**
+   * \returns the messages served
+   */
+  uint32_t GetServed (void) const;
+
+  /**
+   * \returns the total time the cores were busy
+   */
+  Time GetBusyTime (void) const;
+
+  /**
+   * \returns the total time the served messages waited for a core
+   */
+  Time GetWaitTime (void) const;
+
+  /**
+   * \returns the longest the queue has been
+   */
+  uint32_t GetMaxQueue (void) const;
+
+  /**
+   * \returns the messages lost to crashes
+   */
+  uint32_t GetDropped (void) const;
+
+  /**
+   * \returns the messages held by pauses
+   */
+  uint32_t GetHeld (void) const;
+
+private:
+  /// A received message
+  struct Message
+  {
+    Ptr<Socket> socket;   //!< the socket it was received on
+    Ptr<Packet> packet;   //!< the message, without its length prefix
+    Address from;         //!< the address of the peer
+    Time service;         //!< its service time
+    Time arrival;         //!< its arrival
+  };
+
+  /**
+   * \param p a message
+   * \returns the service time of p
+   */
+  Time GetServiceTime (Ptr<Packet> p);
+
+  /**
+   * \brief hand a received message to the fault, the cores or the receive
+   * loop
+   * \param m the message
+   * \param notify whether to call the served callback, i.e. the message
+   *        did not arrive in Recv
+   */
+  void Arrive (Message m, bool notify);
+
+  /**
+   * \brief start serving the queued messages on the idle cores
+   */
+  void Serve (void);
+
+  /**
+   * \brief end the service of a message
+   * \param m the message
+   */
+  void Served (Message m);
+
+  uint32_t m_cores;                                         //!< number of cores
+  Ptr<RandomVariableStream> m_time;                         //!< service time of any type
+  std::map<uint32_t, Ptr<RandomVariableStream> > m_typeTime; //!< service time per type
+  Time m_perItem;                                           //!< service time per item
+  Callback<uint32_t, const AmProtocolHeader &> m_items;     //!< items of a message
+  Callback<void, Ptr<Socket> > m_servedCallback;            //!< receive handler
+  std::deque<Message> m_queue;                              //!< messages waiting for a core
+  std::map<Ptr<Socket>, std::deque<Message> > m_served;     //!< served messages per socket
+  std::vector<EventId> m_services;                          //!< services in progress
+  uint32_t m_busy;                                          //!< busy cores
+  uint32_t m_servedMessages;                                //!< messages served
+  Time m_busyTime;                                          //!< time the cores were busy
+  Time m_waitTime;                                          //!< time waited for a core
+  uint32_t m_maxQueue;                                      //!< longest queue
+  Fault m_fault;                                            //!< current fault
+  Time m_slowdown;                                          //!< delay of every message
+  std::deque<Message> m_held;                               //!< messages held by a pause
+  std::vector<EventId> m_delayed;                           //!< slowed down messages
+  uint32_t m_dropped;                                       //!< messages lost to crashes
+  uint32_t m_heldMessages;                                  //!< messages held by pauses
+};
+
+} // namespace ns3
+
+#endif /* AM_SERVICE_QUEUE_H */
@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef AM_TOPOLOGY_HELPER_H
+#define AM_TOPOLOGY_HELPER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ns3/address.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/csma-helper.h"
+#include "ns3/traffic-control-helper.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \brief Build the topologies of the atomic memory examples in bulk.
+ *
+ * The examples hang the servers and the clients off a few routers:
+ *
+ *  - P2P: a chain of one router per server, server i and its share of the
+ *    clients on router i, over point-to-point links;
+ *  - STAR_P2P: every server on router 0, the clients on the routers 1 to
+ *    servers of the chain;
+ *  - SPIKE and STAR: as P2P and STAR_P2P, with the clients of a router on
+ *    a single CSMA LAN;
+ *  - WAN: one router per site of a latency matrix, the routers of every
+ *    two sites joined by a link with the delay between them, server i on
+ *    site i modulo the sites and the clients shared by the sites.
+ *
+ * The clients are shared by the routers in blocks, as in the examples:
+ * client j is on the client router j / ceil (clients / client routers).
+ *
+ * Instead of one Ipv4AddressHelper subnet per link and the global routing
+ * SPF, every router owns the prefix 10.<router+1>.0.0/16: its server and
+ * client links are the /30 subnets from the bottom of the prefix, and its
+ * LAN the upper /17. The routers are joined by /30 subnets of
+ * 172.16.0.0/12. The addresses are computed, not drawn from the global
+ * Ipv4AddressGenerator, and the routes are static: the servers and the
+ * clients have a default route through their router, and a router has one
+ * route per other router prefix, through its neighbor on a shortest path
+ * (in hops, as the global routing). Building ten thousand clients takes
+ * seconds.
+ *
+ * The links are returned by GetLinks in the order AmFaultInjector indexes
+ * them: the router links, then the server links, then the client links
+ * (one per LAN in SPIKE and STAR).
+ */
+class AmTopologyHelper
+{
+public:
+  /// Shape of a topology
+  enum Shape
+  {
+    P2P,       //!< a chain of routers, one per server
+    STAR_P2P,  //!< the servers on the first router of the chain
+    SPIKE,     //!< P2P with one CSMA LAN of clients per router
+    STAR,      //!< STAR_P2P with one CSMA LAN of clients per router
+    WAN        //!< a full mesh of the sites of a latency matrix
+  };
+
+  AmTopologyHelper ();
+
+  /**
+   * \param name p2p, star-p2p, spike, star or wan
+   * \param shape set to the shape of name
+   * \returns whether name is a shape
+   */
+  static bool ParseShape (std::string name, Shape &shape);
+
+  /**
+   * \param rate the data rate of the links between the routers
+   * \param delay their delay, but in WAN
+   */
+  void SetRouterLink (DataRate rate, Time delay);
+
+  /**
+   * \param rate the data rate of the links of the servers
+   * \param delay their delay
+   */
+  void SetServerLink (DataRate rate, Time delay);
+
+  /**
+   * \param rate the data rate of the links, or of the LANs, of the clients
+   * \param delay their delay
+   */
+  void SetClientLink (DataRate rate, Time delay);
+
+  /**
+   * \param packets the size of the queues of the point-to-point devices
+   */
+  void SetQueueSize (uint32_t packets);
+
+  /**
+   * \param delays the one-way delay between every two sites of WAN, the
+   *        link of sites a < b having delays[a][b]
+   */
+  void SetLatencyMatrix (const std::vector<std::vector<Time> > &delays);
+
+  /**
+   * \brief read the latency matrix of WAN from a file, one row of delays
+   * (e.g. 40ms) per line, '#' starting a comment
+   * \param fileName the file
+   */
+  void LoadLatencyMatrix (std::string fileName);
+
+  /**
+   * \brief create the nodes, the links, the addresses and the routes
+   * \param shape the shape of the topology
+   * \param servers the number of servers
+   * \param clients the number of clients
+   */
+  void Build (Shape shape, uint32_t servers, uint32_t clients);
+
+  /**
+   * \returns the routers
+   */
+  NodeContainer GetRouters (void) const;
+
+  /**
+   * \returns the servers
+   */
+  NodeContainer GetServers (void) const;
+
+  /**
+   * \returns the clients
+   */
+  NodeContainer GetClients (void) const;
+
+  /**
+   * \param i the index of a server
+   * \returns its address
+   */
+  Ipv4Address GetServerAddress (uint32_t i) const;
+
+  /**
+   * \returns the addresses of the servers, as the clients take them
+   */
+  std::vector<Address> GetServerAddresses (void) const;
+
+  /**
+   * \param i the index of a client
+   * \returns its address
+   */
+  Ipv4Address GetClientAddress (uint32_t i) const;
+
+  /**
+   * \returns the router links, then the server links, then the client
+   *          links or LANs
+   */
+  std::vector<NetDeviceContainer> GetLinks (void) const;
+
+private:
+  /// A link of a router to another router
+  struct Adjacency
+  {
+    uint32_t router;      //!< the other router
+    uint32_t interface;   //!< the interface of the link
+    Ipv4Address gateway;  //!< the address of the other router on the link
+  };
+
+  /**
+   * \brief add a device to the IPv4 stack of its node, as
+   * Ipv4AddressHelper::Assign does
+   * \param device the device
+   * \param address its address
+   * \param mask the mask of its subnet
+   * \returns its interface
+   */
+  uint32_t AddInterface (Ptr<NetDevice> device, Ipv4Address address, Ipv4Mask mask);
+
+  /**
+   * \brief join two routers
+   * \param a a router
+   * \param b the other router
+   */
+  void ConnectRouters (uint32_t a, uint32_t b);
+
+  /**
+   * \brief join a server or a client to a router with a /30 subnet of the
+   * router, and route it through the router
+   * \param link the helper of the link
+   * \param router the router
+   * \param node the server or the client
+   * \param links the links the devices are added to
+   * \returns the address of node
+   */
+  Ipv4Address ConnectLeaf (PointToPointHelper &link, uint32_t router, Ptr<Node> node,
+                           std::vector<NetDeviceContainer> &links);
+
+  /**
+   * \brief join the clients of a router on a LAN of the router, and route
+   * them through the router
+   * \param router the router
+   * \param begin the first client
+   * \param end the client after the last one
+   */
+  void ConnectLan (uint32_t router, uint32_t begin, uint32_t end);
+
+  /**
+   * \brief add to every router a route to the prefix of each other router
+   */
+  void PopulateRoutes (void);
+
+  /**
+   * \param router a router
+   * \returns the first address of its prefix
+   */
+  static uint32_t Prefix (uint32_t router);
+
+  PointToPointHelper m_routerLink;                   //!< links between routers
+  PointToPointHelper m_serverLink;                   //!< links of the servers
+  PointToPointHelper m_clientLink;                   //!< links of the clients
+  CsmaHelper m_lan;                                  //!< LANs of the clients
+  TrafficControlHelper m_tc;                         //!< default queue discs
+  std::vector<std::vector<Time> > m_latencies;       //!< delays between the sites
+  NodeContainer m_routers;                           //!< the routers
+  NodeContainer m_servers;                           //!< the servers
+  NodeContainer m_clients;                           //!< the clients
+  std::vector<Ipv4Address> m_serverAddresses;        //!< addresses of the servers
+  std::vector<Ipv4Address> m_clientAddresses;        //!< addresses of the clients
+  std::vector<NetDeviceContainer> m_routerLinks;     //!< devices of the router links
+  std::vector<NetDeviceContainer> m_serverLinks;     //!< devices of the server links
+  std::vector<NetDeviceContainer> m_clientLinks;     //!< devices of the client links or LANs
+  std::vector<std::vector<Adjacency> > m_adjacency;  //!< the links of each router
+  std::vector<uint32_t> m_leaves;                    //!< /30 subnets used per router
+};
+
+} // namespace ns3
+
+#endif /* AM_TOPOLOGY_HELPER_H */
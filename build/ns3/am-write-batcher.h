@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_WRITE_BATCHER_H
+#define AM_WRITE_BATCHER_H
+
+#include "ns3/nstime.h"
+#include <stdint.h>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmWriteBatcher
+ * \brief Groups the writes of a writer into rounds (group commit).
+ *
+ * A writer runs the rounds of a write, the query of the tag and the
+ * propagation of the value, once per write. With batching, a write invoked
+ * while a round is in flight on its key waits; once that round completes,
+ * the writes waiting on the key, up to MaxWrites, are committed together
+ * by the next round. A round of n writes takes the n tags following the
+ * greatest tag it found, one per write in the order of the invocations,
+ * and propagates the last one with its value: the first n - 1 writes are
+ * overwritten as soon as they take effect, so a round costs the messages
+ * of a single write. Every write still completes, with its own tag and its
+ * own latency, when its round does.
+ *
+ * The batcher only keeps the writes: the client opens a round with Add or
+ * Next, sends it, and hands the writes of the round back with Complete.
+ * With MaxWrites 1, the default, every write is its own round.
+ */
+class AmWriteBatcher
+{
+public:
+  /// A write of the client
+  struct Write
+  {
+    uint32_t op;       //!< number of the write among the operations of the client
+    Time start;        //!< invocation time
+    std::chrono::time_point<std::chrono::system_clock> realStart; //!< wall clock invocation time
+  };
+
+  AmWriteBatcher ();
+
+  /**
+   * \param max the writes a round commits at most, 1 to disable batching
+   */
+  void SetMaxWrites (uint32_t max);
+
+  /**
+   * \returns whether a round may commit several writes
+   */
+  bool IsEnabled (void) const;
+
+  /**
+   * \brief add a write, which opens a round on its key unless one is in
+   * flight
+   * \param key the key of the write
+   * \param write the write
+   * \returns true if the write opened a round, to be sent now, false if it
+   *          waits for the next round of its key
+   */
+  bool Add (uint32_t key, const Write &write);
+
+  /**
+   * \brief add a write that waits, whatever the rounds in flight
+   * \param key the key of the write
+   * \param write the write
+   */
+  void Queue (uint32_t key, const Write &write);
+
+  /**
+   * \brief end the round in flight on a key, and open the next one with
+   * the writes waiting on the key
+   * \param key the key of the round
+   * \param committed set to the writes of the round, in invocation order
+   * \returns true if a round was opened on the key, to be sent
+   */
+  bool Complete (uint32_t key, std::vector<Write> &committed);
+
+  /**
+   * \brief open a round with the writes of the key of the oldest waiting
+   * write
+   * \param key set to the key of the round
+   * \returns true if a round was opened, false if no write waits
+   */
+  bool Next (uint32_t &key);
+
+  /**
+   * \param key a key
+   * \returns whether a round is open on the key
+   */
+  bool IsOpen (uint32_t key) const;
+
+  /**
+   * \returns whether no round is open, on any key
+   */
+  bool IsIdle (void) const;
+
+  /**
+   * \param key a key
+   * \returns the writes of the round open on the key
+   */
+  const std::vector<Write> & GetRound (uint32_t key) const;
+
+  /**
+   * \brief drop the rounds and the waiting writes
+   */
+  void Clear (void);
+
+  /**
+   * \returns the rounds completed
+   */
+  uint32_t GetRounds (void) const;
+
+  /**
+   * \returns the writes committed by the rounds completed
+   */
+  uint32_t GetWrites (void) const;
+
+private:
+  /// The writes of a key
+  struct Key
+  {
+    Key () : open (false) {}
+    bool open;                  //!< whether a round is in flight
+    std::vector<Write> round;   //!< the writes of the round in flight
+    std::deque<Write> waiting;  //!< the writes waiting for the next round
+  };
+
+  /**
+   * \brief open a round with the writes waiting on a key, or forget the
+   * key if none waits
+   * \param it the key
+   * \returns whether a round was opened
+   */
+  bool Open (std::map<uint32_t, Key>::iterator it);
+
+  uint32_t m_maxWrites;             //!< writes committed by a round at most
+  std::map<uint32_t, Key> m_keys;   //!< the keys with writes
+  uint32_t m_rounds;                //!< rounds completed
+  uint32_t m_writes;                //!< writes committed
+};
+
+} // namespace ns3
+
+#endif /* AM_WRITE_BATCHER_H */
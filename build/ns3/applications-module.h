@@ -0,0 +1,84 @@
+
+#ifdef NS3_MODULE_COMPILATION
+# error "Do not include ns3 module aggregator headers from other modules; these are meant only for end user scripts."
+#endif
+
+#ifndef NS3_MODULE_APPLICATIONS
+    
+
+// Module headers:
+#include "MwImp-client.h"
+#include "MwImp-helper.h"
+#include "MwImp-server.h"
+#include "SwImp-client.h"
+#include "SwImp-helper.h"
+#include "SwImp-server.h"
+#include "abd-client-mwmr.h"
+#include "abd-client.h"
+#include "abd-helper-mwmr.h"
+#include "abd-helper.h"
+#include "abd-server-mwmr.h"
+#include "abd-server.h"
+#include "am-connection-manager.h"
+#include "am-fault-injector.h"
+#include "am-history-checker.h"
+#include "am-key-selector.h"
+#include "am-lease-table.h"
+#include "am-log.h"
+#include "am-message-framer.h"
+#include "am-op-table.h"
+#include "am-protocol-header.h"
+#include "am-quorum-selector.h"
+#include "am-reed-solomon.h"
+#include "am-register-store.h"
+#include "am-relay-batcher.h"
+#include "am-seen-set.h"
+#include "am-service-queue.h"
+#include "am-stats-collector.h"
+#include "am-trace-ring.h"
+#include "am-workload.h"
+#include "am-write-batcher.h"
+#include "application-packet-probe.h"
+#include "asm-common.h"
+#include "bulk-send-application.h"
+#include "bulk-send-helper.h"
+#include "cchybrid-client.h"
+#include "cchybrid-helper.h"
+#include "cchybrid-server.h"
+#include "coded-abd-client.h"
+#include "coded-abd-helper.h"
+#include "coded-abd-server.h"
+#include "ohMam-client.h"
+#include "ohMam-helper.h"
+#include "ohMam-server.h"
+#include "ohMamEX-client.h"
+#include "ohMamEX-helper.h"
+#include "ohMamEX-server.h"
+#include "ohSam-client.h"
+#include "ohSam-helper.h"
+#include "ohSam-server.h"
+#include "ohSamEX-client.h"
+#include "ohSamEX-helper.h"
+#include "ohSamEX-server.h"
+#include "ohfast-client.h"
+#include "ohfast-helper.h"
+#include "ohfast-server.h"
+#include "on-off-helper.h"
+#include "onoff-application.h"
+#include "packet-loss-counter.h"
+#include "packet-sink-helper.h"
+#include "packet-sink.h"
+#include "semifast-client.h"
+#include "semifast-helper.h"
+#include "semifast-server.h"
+#include "seq-ts-header.h"
+#include "set-operations.cc"
+#include "set-operations.h"
+#include "udp-client-server-helper.h"
+#include "udp-client.h"
+#include "udp-echo-client.h"
+#include "udp-echo-helper.h"
+#include "udp-echo-server.h"
+#include "udp-server.h"
+#include "udp-trace-client.h"
+#endif
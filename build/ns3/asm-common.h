@@ -0,0 +1,81 @@
+#ifndef AM_COMMON_H
+#define AM_COMMON_H
+
+#include <sstream>
+#include <stdint.h>
+
+// Process Types
+enum ProcessType{
+    READER,
+    WRITER,
+};
+
+// Statuses
+enum Status{
+    IDLE,
+    PHASE1,
+    PHASE2,
+    PHASE3,
+};
+
+// Message Types
+enum MessageType{
+    WRITE,
+    READ,
+    INFORM,
+    WRITEACK,
+    READACK,
+    INFORMACK,
+    TERMINATE,
+    CTRL_FSIZE,
+    CTRL_PKT,
+	READRELAY,
+	DISCOVER,
+	DISCOVERACK,
+    READ_DISCOVER,
+    READ_DISCOVER_ACK,
+    PRE_WRITE,
+    PRE_WRITE_ACK,
+    FINALIZE,
+    FINALIZE_ACK,
+    READ_FINALIZE,
+    READ_FINALIZE_ACK,
+};
+
+// Log message level
+enum logLevel_t{
+	INFO,
+	DEBUG
+};
+
+// Transports of the messages
+enum Transport{
+	TRANSPORT_TCP,	// one connection per client and server
+	TRANSPORT_UDP,	// datagrams, the clients retransmit
+};
+
+// Totals of a client, as reported in its LOG line
+struct AmClientStats
+{
+	AmClientStats () : sent (0), invoked (0), completed (0), slowReads (0), fastReads (0), commTime (0), compTime (0) {}
+
+	uint32_t sent;		//!< messages sent
+	uint32_t invoked;	//!< operations invoked
+	uint32_t completed;	//!< operations completed
+	uint32_t slowReads;	//!< completed reads logged as #4EXCH/#3EXCH
+	uint32_t fastReads;	//!< completed reads logged as #2EXCH
+	double commTime;	//!< simulated time per invoked operation, in seconds
+	double compTime;	//!< computation (wall-clock) time per invoked operation, in seconds
+};
+
+class AsmCommon
+{
+public:
+	static void Reset(std::stringstream& s)
+	{
+		s.str("");
+		s.clear();
+	}
+};
+
+#endif
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_CODED_ABD_SERVER_H
+#define AM_CODED_ABD_SERVER_H
+
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/packet.h"
+#include "ns3/traced-callback.h"
+#include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-service-queue.h"
+#include "am-register-store.h"
+#include <list>
+#include <map>
+
+namespace ns3 {
+
+class Socket;
+
+/**
+ * \ingroup applications
+ * \defgroup CodedAbd CodedAbd
+ */
+
+/**
+ * \ingroup CodedAbd
+ * \brief A coded atomic storage (CAS) server
+ *
+ * The server keeps, per key, the coded fragment of every version (tag)
+ * it received in a PRE_WRITE and a finalized label per version. It
+ * answers queries with its highest finalized tag and READ_FINALIZE
+ * messages with the fragment of the requested tag when it still has it.
+ * Only the fragments of the GcDepth + 1 highest finalized tags, and of
+ * the newer pre-written ones, are kept: older versions are garbage
+ * collected as soon as a newer one is finalized.
+ */
+class CodedAbdServer : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  CodedAbdServer ();
+  virtual ~CodedAbdServer ();
+
+  /**
+   * \brief Get the number of messages this server has sent
+   * \returns the #sentMsgs of the LOG line
+   */
+  uint32_t GetSentMessages (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  //string stream for ease of output
+  void LogInfo(std::stringstream& s);
+  /**
+   * \brief Handle a packet reception.
+   *
+   * This function is called by lower layers.
+   *
+   * \param socket the socket the packet was received to.
+   */
+  void HandleRead (Ptr<Socket> socket);
+  /**
+   * \brief Start or end a fault of the server
+   * \param fault the fault
+   */
+  void SetFault (AmServiceQueue::Fault fault);
+  /**
+   * \returns the fault of the server
+   */
+  AmServiceQueue::Fault GetFault (void) const;
+  /**
+   * \param delay the time every message received waits before it is processed
+   */
+  void SetSlowdown (Time delay);
+  /**
+   * \returns the time every message received waits before it is processed
+   */
+  Time GetSlowdown (void) const;
+  /**
+   * \brief Handle an incoming connection
+   * \param socket the incoming connection socket
+   * \param from the address the connection is from
+   */
+  void HandleAccept (Ptr<Socket> socket, const Address& from);
+  /**
+   * \brief Handle an connection close
+   * \param socket the connected socket
+   */
+  void HandlePeerClose (Ptr<Socket> socket);
+  /**
+   * \brief Handle an connection error
+   * \param socket the connected socket
+   */
+  void HandlePeerError (Ptr<Socket> socket);
+
+  /// A tag <ts, id>
+  typedef std::pair<uint32_t, uint32_t> Tag;
+
+  /// A version of a register
+  struct Element
+  {
+    Element () : index (0), finalized (false) {}
+    Ptr<Packet> fragment; //!< coded fragment, 0 if not received or collected
+    uint32_t index;       //!< index of the fragment in the code
+    bool finalized;       //!< the tag was finalized
+  };
+
+  /// State of a single register (key)
+  struct Register
+  {
+    std::map<Tag, Element> elements; //!< versions per tag
+    Tag finalized;                   //!< highest finalized tag
+  };
+
+  /**
+   * \brief mark a tag of a register as finalized
+   * \param reg the register
+   * \param tag the tag
+   * \return the version of the tag
+   */
+  Element& Finalize (Register &reg, const Tag &tag);
+  /**
+   * \brief drop the versions older than the GcDepth + 1 highest finalized tags
+   * \param reg the register
+   */
+  void CollectGarbage (Register &reg);
+
+  uint16_t m_port; //!< Port on which we listen for incoming packets.
+  uint32_t m_size; //!< The size of the packet
+  Ptr<Socket> m_socket; //!< IPv4 Socket
+  std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
+  AmMessageFramer m_framer; //!< reassembles the messages of each socket
+  AmServiceQueue m_service; //!< processing time of the messages
+  uint32_t m_serviceCores; //!< cores of the server, 0 for no processing time
+  Ptr<RandomVariableStream> m_serviceTime; //!< processing time of a message (s)
+  Address m_myAddress; //!< ip address
+  uint32_t m_personalID;        //My Personal ID
+
+  AmRegisterStore<Register> m_registers; //!< register state per key
+  uint32_t m_gcDepth;       //!< finalized versions kept besides the highest one
+  uint64_t m_storedBytes;   //!< bytes of the fragments currently stored
+  uint64_t m_maxStoredBytes; //!< highest value of m_storedBytes
+  uint32_t m_sent;     //!< sent messages counter
+  /// Callbacks for tracing the handled messages
+  TracedCallback<uint32_t, uint32_t> m_handledTrace;
+  uint16_t m_verbose;   //!< Debug mode
+
+};
+
+} // namespace ns3
+
+#endif /* AM_CODED_ABD_SERVER_H */
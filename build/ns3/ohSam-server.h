@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright 2007 University of Washington
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_OHSAM_SERVER_H
+#define AM_OHSAM_SERVER_H
+
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/address.h"
+#include "ns3/packet.h"
+#include "ns3/traced-callback.h"
+#include "ns3/ipv4-address.h"
+#include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-service-queue.h"
+#include "am-relay-batcher.h"
+#include "am-register-store.h"
+#include <unordered_map>
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+class AmProtocolHeader;
+
+/**
+ * \ingroup applications 
+ * \defgroup ohSam ohSam
+ */
+
+/**
+ * \ingroup ohSam
+ * \brief A Udp Echo server
+ *
+ * Every packet received is sent back.
+ */
+class ohSamServer : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ohSamServer ();
+  virtual ~ohSamServer ();
+
+  /**
+   * \brief Get the number of messages this server has sent
+   * \returns the #sentMsgs of the LOG line
+   */
+  uint32_t GetSentMessages (void) const;
+
+  void SetServers (std::vector<Address> ip);
+
+  //void SetClients (std::vector<Address> ip);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  //string stream for ease of output
+  void LogInfo(std::stringstream& s);
+  /**
+   * \brief Handle a packet reception.
+   *
+   * This function is called by lower layers.
+   *
+   * \param socket the socket the packet was received to.
+   */
+  
+  void HandleRead (Ptr<Socket> socket);
+  /**
+   * \brief Start or end a fault of the server
+   * \param fault the fault
+   */
+  void SetFault (AmServiceQueue::Fault fault);
+  /**
+   * \returns the fault of the server
+   */
+  AmServiceQueue::Fault GetFault (void) const;
+  /**
+   * \param hdr a message
+   * \returns the servers the message is relayed to, each charged
+   *          ServiceTimePerItem
+   */
+  uint32_t GetServiceItems (const AmProtocolHeader &hdr) const;
+  /**
+   * \param delay the time every message received waits before it is processed
+   */
+  void SetSlowdown (Time delay);
+  /**
+   * \returns the time every message received waits before it is processed
+   */
+  Time GetSlowdown (void) const;
+
+  void HandleRecvMsg(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket, MessageType msgT);
+
+  void HandleRelay(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket);
+
+  /**
+   * \brief find the slot of a client
+   * \param ip the IPv4 address of the client
+   * \return the index of the client in m_clntAddress, or -1 if the client is unknown
+   */
+  int FindClient (Ipv4Address ip) const;
+
+    /**
+   * \brief Handle an incoming connection
+   * \param socket the incoming connection socket
+   * \param from the address the connection is from
+   */
+  void HandleAccept (Ptr<Socket> socket, const Address& from);
+  /**
+   * \brief Handle an connection close
+   * \param socket the connected socket
+   */
+  void HandlePeerClose (Ptr<Socket> socket);
+  /**
+   * \brief Handle an connection error
+   * \param socket the connected socket
+   */
+  void HandlePeerError (Ptr<Socket> socket);
+  /**
+   * \brief Handle a Connection Succeed event
+   * \param socket the connected socket
+   */
+  void ConnectionSucceeded (Ptr<Socket> socket);
+  /**
+   * \brief Handle a Connection Failed event
+   * \param socket the not connected socket
+   */
+  void ConnectionFailed (Ptr<Socket> socket);
+  
+
+  uint16_t m_port; //!< Port on which we listen for incoming packets.
+  uint32_t m_size; //!< The size of the packet
+  Ptr<Socket> m_socket; //!< IPv4 Socket
+  //std::vector< Ptr<Socket> > m_socket; //!< Socket
+  std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
+  AmMessageFramer m_framer; //!< reassembles the messages of each socket
+  AmServiceQueue m_service; //!< processing time of the messages
+  uint32_t m_serviceCores; //!< cores of the server, 0 for no processing time
+  Ptr<RandomVariableStream> m_serviceTime; //!< processing time of a message (s)
+  Ptr<RandomVariableStream> m_relayServiceTime; //!< processing time of a relay (s), 0 for m_serviceTime
+  Time m_servicePerItem; //!< processing time per server a message is relayed to
+  AmRelayBatcher m_relayBatcher; //!< coalesces the relays sent to the other servers
+  Time m_relayWindow; //!< time a relay may wait for others to the same server
+  uint32_t m_relayBatch; //!< relays that close a batch
+  Address m_local; //!< local multicast address
+  Address m_myAddress; //!< ip address
+  uint32_t m_personalID;  //My Personal ID
+
+  uint16_t m_serversConnected;
+
+  std::vector<Address> m_serverAddress; //!< Remote server adresses
+  std::vector< Ptr<Socket> > m_srvSocket;
+
+  std::vector< std::pair< Address, Ptr<Socket> > > m_clntAddress; //!< Remote client adresses
+  std::unordered_map<uint32_t, uint32_t> m_clntSlot; //!< index in m_clntAddress of each client IPv4 address
+  std::vector< Ptr<Socket> > m_clntSocket;
+  uint32_t m_numServers;    //!< number of servers
+  uint32_t m_numClients;    //!< number of clients
+
+  uint32_t m_fail;      //!< max number of failures supported
+
+  // ohSam variables
+  /// State of a single register (key)
+  struct Register
+  {
+    // Together <ts,id> = tag
+    uint32_t id;     //!< id of latest value
+    uint32_t ts;     //!< latest timestamp
+    uint32_t value;  //!< value associated with ts
+    Ptr<Packet> payload; //!< bytes of value, as received
+  };
+  AmRegisterStore<Register> m_registers; //!< register state per key
+  uint32_t m_sent;    //!< Counter for sent msgs
+  /// Callbacks for tracing the handled messages
+  TracedCallback<uint32_t, uint32_t> m_handledTrace;
+  uint16_t m_verbose;   //!< Debug mode
+  //std::vector<uint32_t> m_writeop;     // Now its a single writer! just check ts
+  std::vector<uint32_t> m_operations;
+  std::vector<uint32_t> m_relays;
+};
+
+} // namespace ns3
+
+#endif /* AM_OHSAM_SERVER_H */
+
@@ -40,6 +40,7 @@
 // - DropTail queues 
 
 
+#include <algorithm>
 #include <fstream>
 #include "ns3/core-module.h"
 #include "ns3/csma-module.h"
@@ -65,6 +66,7 @@ main (int argc, char *argv[])
 	int version=0;
 	int seed = 0;
 	int verbose=0;
+	uint32_t packetSize = 1024;
 
 	//
 	// Users may find it convenient to turn on explicit debugging
@@ -84,6 +86,7 @@ main (int argc, char *argv[])
 	cmd.AddValue ("servers", "Number of servers", numServers);
 	cmd.AddValue ("readers", "Number of readers", numReaders);
     cmd.AddValue ("writers", "Number of writers", numWriters);
+    cmd.AddValue ("size", "Size of the values in bytes", packetSize);
 	cmd.AddValue ("failures", "Number of server Failures", numFail);
 	cmd.AddValue ("rInterval", "Read interval in seconds", readInterval);
 	cmd.AddValue ("wInterval", "Write interval in seconds", writeInterval);
@@ -92,6 +95,9 @@ main (int argc, char *argv[])
 	cmd.AddValue ("verbose", "Debug Mode", verbose);
 	cmd.Parse (argc, argv);
 
+	// Leave room in the TCP send buffers for a few values, or the larger ones would not fit
+	Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (std::max<uint32_t> (131072, 8 * packetSize)));
+
 	// By default set the failures equal to the minority
 	if ( numFail < 0 || numFail > numServers/2 )
 	{
@@ -285,7 +291,6 @@ main (int argc, char *argv[])
 	// node one.
 	//
 	Time interPacketInterval;
-	uint32_t packetSize = 1024;
 	uint32_t maxPacketCount = 10;
 	ApplicationContainer c_apps;
 
@@ -40,6 +40,7 @@
 // - DropTail queues 
 
 
+#include <algorithm>
 #include <fstream>
 #include "ns3/core-module.h"
 #include "ns3/csma-module.h"
@@ -66,6 +67,17 @@ main (int argc, char *argv[])
 	int version=0;
 	int seed = 0;
   int verbose=0;
+  uint32_t packetSize = 1024;
+  int numKeys = 1;	//number of keys (registers)
+  double zipfAlpha = 0;	//zipf exponent of the key distribution (0 for uniform)
+  double arrivalRate = 0;	//Poisson arrivals per second per client (0 for closed loop)
+  std::string traceFile = "";	//file of arrival times to replay
+  int64_t streamIndex = 0;	//next random stream of the clients
+  int maxInFlight = 1;	//outstanding operations per client
+  std::string quorum = "All";	//servers a round is sent to first: All, Random or Nearest
+  double thriftyTimeout = 100;	//time in ms a thrifty round waits before it goes to all the servers
+  uint32_t writeBatch = 1;	//writes a round of a writer commits at most
+  double lease = 0;	//time in ms of the read leases of the servers (0 for none)
 
 //
 // Users may find it convenient to turn on explicit debugging
@@ -91,8 +103,32 @@ main (int argc, char *argv[])
   cmd.AddValue ("version", "Version 0 for FixInt, 1 for randInt", version);
   cmd.AddValue ("seed", "Randomness Seed", seed);
   cmd.AddValue ("verbose", "Debug Mode", verbose);
+  cmd.AddValue ("keys", "Number of keys", numKeys);
+  cmd.AddValue ("zipf", "Zipf exponent of the key distribution (0 for uniform)", zipfAlpha);
+  cmd.AddValue ("rate", "Poisson arrival rate of the operations of each client (0 for closed loop)", arrivalRate);
+  cmd.AddValue ("trace", "File with the arrival times (in seconds) to replay", traceFile);
+  cmd.AddValue ("inflight", "Maximum outstanding operations per client", maxInFlight);
+  cmd.AddValue ("size", "Size of the values in bytes", packetSize);
+  cmd.AddValue ("quorum", "Servers a round is sent to first: All, or a thrifty quorum chosen at Random or by the Nearest", quorum);
+  cmd.AddValue ("thriftyTimeout", "Time in ms a thrifty round waits before it is sent to the other servers", thriftyTimeout);
+  cmd.AddValue ("writeBatch", "Writes a round of a writer commits at most, the ones invoked while a round is in flight (1 for none)", writeBatch);
+  cmd.AddValue ("lease", "Time in ms of the read leases the servers grant, which answer the reads without a round (0 for none)", lease);
   cmd.Parse (argc, argv);
 
+  // Leave room in the TCP send buffers for a few values, or the larger ones would not fit
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (std::max<uint32_t> (131072, 8 * packetSize)));
+
+  // Thrifty rounds, sent to #servers-#failures servers first
+  Config::SetDefault ("ns3::AbdClientMWMR::QuorumSelection", StringValue (quorum));
+  Config::SetDefault ("ns3::AbdClientMWMR::ThriftyTimeout", TimeValue (Seconds (thriftyTimeout / 1000)));
+
+  // Group commit of the writes
+  Config::SetDefault ("ns3::AbdClientMWMR::WriteBatch", UintegerValue (writeBatch));
+
+  // Read leases, held by the servers and the clients alike
+  Config::SetDefault ("ns3::AbdServerMWMR::LeaseTime", TimeValue (MilliSeconds (lease)));
+  Config::SetDefault ("ns3::AbdClientMWMR::LeaseTime", TimeValue (MilliSeconds (lease)));
+
   // By default set the failures equal to the minority
   if ( numFail < 0 || numFail > numServers/2 )
   {
@@ -272,7 +308,6 @@ main (int argc, char *argv[])
 // node one.
 //
   Time interPacketInterval;
-  uint32_t packetSize = 1024;
   uint32_t maxPacketCount = 10;
   ApplicationContainer c_apps;
 
@@ -307,7 +342,14 @@ main (int argc, char *argv[])
 	  client.SetAttribute("RandomInterval", UintegerValue (version));
 	  client.SetAttribute("Seed", UintegerValue (seed));
     client.SetAttribute ("Verbose", UintegerValue (verbose));
+    client.SetKeyDistribution (numKeys, zipfAlpha > 0 ? AmKeySelector::ZIPF : AmKeySelector::UNIFORM, zipfAlpha);
+    if (!traceFile.empty ())
+    	client.SetWorkload (AmWorkload::TRACE, arrivalRate, traceFile);
+    else if (arrivalRate > 0)
+    	client.SetWorkload (AmWorkload::POISSON, arrivalRate);
+    client.SetAttribute ("MaxInFlight", UintegerValue (maxInFlight));
 	  Ptr<Application> app = (client.Install (clientNodes.Get (i))).Get(0);
+	  streamIndex += client.AssignStreams (clientNodes.Get (i), streamIndex);
 	  client.SetServers(app, serverAddress);
 	  c_apps.Add(app);
   }
@@ -25,6 +25,7 @@
 // - DropTail queues 
 // - Tracing of queues and packet receptions to file "udp-echo.tr"
 
+#include <algorithm>
 #include <fstream>
 #include "ns3/core-module.h"
 #include "ns3/csma-module.h"
@@ -62,6 +63,7 @@ main (int argc, char *argv[])
 // Allow the user to override any of the defaults and the above Bind() at
 // run-time, via command-line arguments
 //
+  uint32_t packetSize = 1024;
   CommandLine cmd;
   //cmd.AddValue ("useIpv6", "Use Ipv6", useV6);
   cmd.AddValue ("servers", "Number of servers", numServers);
@@ -71,8 +73,12 @@ main (int argc, char *argv[])
   cmd.AddValue ("rInterval", "Read interval in seconds", readInterval);
   cmd.AddValue ("wInterval", "Write interval in seconds", writeInterval);
   cmd.AddValue ("version", "Version 1 for FixInt, 2 for randInt", version);
+  cmd.AddValue ("size", "Size of the values in bytes", packetSize);
   cmd.Parse (argc, argv);
 
+  // Leave room in the TCP send buffers for a few values, or the larger ones would not fit
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (std::max<uint32_t> (131072, 8 * packetSize)));
+
   // By default set the failures equal to the minority
   if ( numFail < 0 || numFail > numServers/2 )
   {
@@ -149,7 +155,6 @@ main (int argc, char *argv[])
 // node one.
 //
   Time interPacketInterval;
-  uint32_t packetSize = 1024;
   uint32_t maxPacketCount = 10;
   ApplicationContainer c_apps;
 
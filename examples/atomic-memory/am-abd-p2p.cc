@@ -40,13 +40,16 @@
 // - DropTail queues 
 
 
+#include <algorithm>
 #include <fstream>
+#include <sstream>
 #include "ns3/core-module.h"
 #include "ns3/csma-module.h"
 #include "ns3/network-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/internet-module.h"
+#include "ns3/stats-module.h"
 #include "ns3/asm-common.h"
 
 using namespace ns3;
@@ -65,6 +68,30 @@ main (int argc, char *argv[])
 	int version=0;
 	int seed = 0;
 	int verbose=0;
+	uint32_t packetSize = 1024;
+	int numKeys = 1;	//number of keys (registers)
+	double zipfAlpha = 0;	//zipf exponent of the key distribution (0 for uniform)
+	double arrivalRate = 0;	//Poisson arrivals per second per client (0 for closed loop)
+	std::string traceFile = "";	//file of arrival times to replay
+	int64_t streamIndex = 0;	//next random stream of the clients
+	int maxInFlight = 1;	//outstanding operations per client
+	std::string statsPrefix = "";	//prefix of the metric files (none if empty)
+	std::string statsFormat = "csv";	//csv, omnet or db
+	uint32_t ringSize = 0;	//records of the trace ring (none if 0)
+	std::string ringFile = "am-abd-ring.txt";	//file the trace ring is dumped to
+	std::string transport = "Tcp";	//Tcp or Udp
+	uint32_t serviceCores = 0;	//cores of each server (0 for no processing time)
+	double serviceTime = 0;	//mean processing time of a message in ms (exponential)
+	std::string quorum = "All";	//servers a round is sent to first: All, Random or Nearest
+	double thriftyTimeout = 100;	//time in ms a thrifty round waits before it goes to all the servers
+	uint32_t writeBatch = 1;	//writes a round of a writer commits at most
+	double lease = 0;	//time in ms of the read leases of the servers (0 for none)
+	uint32_t crashes = 0;	//servers that crash, from the first one
+	double crashAt = 10;	//time in seconds the servers crash
+	double recoverAt = 0;	//time in seconds the servers recover (0 for never)
+	std::string faults = "";	//file of the faults to schedule (none if empty)
+	bool check = false;	//check the atomicity of the operations
+	std::string history = "";	//file the checked operations are streamed to (none if empty)
 
 	//
 	// Users may find it convenient to turn on explicit debugging
@@ -90,8 +117,53 @@ main (int argc, char *argv[])
 	cmd.AddValue ("version", "Version 0 for FixInt, 1 for randInt", version);
 	cmd.AddValue ("seed", "Randomness Seed", seed);
 	cmd.AddValue ("verbose", "Debug Mode", verbose);
+	cmd.AddValue ("keys", "Number of keys", numKeys);
+	cmd.AddValue ("zipf", "Zipf exponent of the key distribution (0 for uniform)", zipfAlpha);
+	cmd.AddValue ("rate", "Poisson arrival rate of the operations of each client (0 for closed loop)", arrivalRate);
+	cmd.AddValue ("trace", "File with the arrival times (in seconds) to replay", traceFile);
+	cmd.AddValue ("inflight", "Maximum outstanding operations per client", maxInFlight);
+	cmd.AddValue ("size", "Size of the values in bytes", packetSize);
+	cmd.AddValue ("stats", "Prefix of the files the latency histograms and the metrics are written to", statsPrefix);
+	cmd.AddValue ("statsFormat", "Format of the metrics: csv, omnet or db (sqlite)", statsFormat);
+	cmd.AddValue ("ring", "Last events kept in the binary trace ring (0 for none)", ringSize);
+	cmd.AddValue ("ringFile", "File the trace ring is dumped to, at the end or on a fatal error", ringFile);
+	cmd.AddValue ("transport", "Transport of the messages: Tcp or Udp (with retransmissions)", transport);
+	cmd.AddValue ("cores", "Cores of each server (0 to process every message on arrival)", serviceCores);
+	cmd.AddValue ("serviceTime", "Mean processing time of a message in ms (exponential)", serviceTime);
+	cmd.AddValue ("quorum", "Servers a round is sent to first: All, or a thrifty quorum chosen at Random or by the Nearest", quorum);
+	cmd.AddValue ("thriftyTimeout", "Time in ms a thrifty round waits before it is sent to the other servers", thriftyTimeout);
+	cmd.AddValue ("writeBatch", "Writes a round of a writer commits at most, the ones invoked while a round is in flight (1 for none)", writeBatch);
+	cmd.AddValue ("lease", "Time in ms of the read leases the servers grant, which answer the reads without a round (0 for none)", lease);
+	cmd.AddValue ("crashes", "Servers that crash, from the first one", crashes);
+	cmd.AddValue ("crashAt", "Time in seconds the servers crash", crashAt);
+	cmd.AddValue ("recoverAt", "Time in seconds the servers recover (0 for never)", recoverAt);
+	cmd.AddValue ("faults", "File of the faults to schedule: link i joins routers i and i+1, link servers-1+i joins server i (see AmFaultInjector)", faults);
+	cmd.AddValue ("check", "Check the atomicity of the operations as they complete", check);
+	cmd.AddValue ("history", "File the checked operations are streamed to (implies --check)", history);
 	cmd.Parse (argc, argv);
 
+	// Leave room in the TCP send buffers for a few values, or the larger ones would not fit
+	Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (std::max<uint32_t> (131072, 8 * packetSize)));
+	Config::SetDefault ("ns3::AbdClient::Transport", StringValue (transport));
+	Config::SetDefault ("ns3::AbdServer::Transport", StringValue (transport));
+
+	// Deterministic processing times of the servers, drawn from ns-3 random variables
+	std::ostringstream serviceDist;
+	serviceDist << "ns3::ExponentialRandomVariable[Mean=" << serviceTime / 1000 << "]";
+	Config::SetDefault ("ns3::AbdServer::ServiceCores", UintegerValue (serviceCores));
+	Config::SetDefault ("ns3::AbdServer::ServiceTime", StringValue (serviceDist.str ()));
+
+	// Thrifty rounds, sent to #servers-#failures servers first
+	Config::SetDefault ("ns3::AbdClient::QuorumSelection", StringValue (quorum));
+	Config::SetDefault ("ns3::AbdClient::ThriftyTimeout", TimeValue (Seconds (thriftyTimeout / 1000)));
+
+	// Group commit of the writes
+	Config::SetDefault ("ns3::AbdClient::WriteBatch", UintegerValue (writeBatch));
+
+	// Read leases, held by the servers and the clients alike
+	Config::SetDefault ("ns3::AbdServer::LeaseTime", TimeValue (MilliSeconds (lease)));
+	Config::SetDefault ("ns3::AbdClient::LeaseTime", TimeValue (MilliSeconds (lease)));
+
 	// By default set the failures equal to the minority
 	if ( numFail < 0 || numFail > numServers/2 )
 	{
@@ -274,7 +346,6 @@ main (int argc, char *argv[])
 	// node one.
 	//
 	Time interPacketInterval;
-	uint32_t packetSize = 1024;
 	uint32_t maxPacketCount = 10;
 	ApplicationContainer c_apps;
 
@@ -308,7 +379,14 @@ main (int argc, char *argv[])
 		client.SetAttribute ("RandomInterval", UintegerValue (version));
 		client.SetAttribute ("Seed", UintegerValue (seed));
 		client.SetAttribute ("Verbose", UintegerValue (verbose));
+		client.SetKeyDistribution (numKeys, zipfAlpha > 0 ? AmKeySelector::ZIPF : AmKeySelector::UNIFORM, zipfAlpha);
+		if (!traceFile.empty ())
+			client.SetWorkload (AmWorkload::TRACE, arrivalRate, traceFile);
+		else if (arrivalRate > 0)
+			client.SetWorkload (AmWorkload::POISSON, arrivalRate);
+		client.SetAttribute ("MaxInFlight", UintegerValue (maxInFlight));
 		Ptr<Application> app = (client.Install (clientNodes.Get (i))).Get(0);
+		streamIndex += client.AssignStreams (clientNodes.Get (i), streamIndex);
 		client.SetServers(app, serverAddress);
 		c_apps.Add(app);
 	}
@@ -326,9 +404,94 @@ main (int argc, char *argv[])
 	//
 	// Now, do the actual simulation.
 	//
+	// Collect the latencies and the messages of the run
+	Ptr<AmStatsCollector> stats;
+	if (!statsPrefix.empty ())
+	{
+		stats = CreateObject<AmStatsCollector> ();
+		stats->AddServers (s_apps);
+		stats->AddClients (c_apps);
+	}
+
+	// Crash, pause and slow down the servers and the links
+	Ptr<AmFaultInjector> injector;
+	if (crashes > 0 || !faults.empty ())
+	{
+		injector = CreateObject<AmFaultInjector> ();
+		injector->SetAttribute ("Crashes", UintegerValue (crashes));
+		injector->SetAttribute ("CrashTime", TimeValue (Seconds (crashAt)));
+		injector->SetAttribute ("RecoveryTime", TimeValue (Seconds (recoverAt)));
+		injector->SetAttribute ("ScheduleFile", StringValue (faults));
+		injector->AddServers (s_apps);
+		for (uint32_t i = 0; i < p2pDeviceAdjacencyList.size (); i++)
+		{
+			injector->AddLink (p2pDeviceAdjacencyList[i]);
+		}
+		for (uint32_t i = 0; i < p2pServersDeviceAdjacencyList.size (); i++)
+		{
+			injector->AddLink (p2pServersDeviceAdjacencyList[i]);
+		}
+		injector->ScheduleFaults ();
+	}
+
+	// Keep the last events, to be dumped even if the run aborts
+	Ptr<AmTraceRing> ring;
+	if (ringSize > 0)
+	{
+		ring = CreateObjectWithAttributes<AmTraceRing> ("Capacity", UintegerValue (ringSize));
+		ring->AddServers (s_apps);
+		ring->AddClients (c_apps);
+		ring->DumpOnTerminate (ringFile);
+	}
+
+	// Check the atomicity of the history of the operations
+	Ptr<AmHistoryChecker> checker;
+	if (check || !history.empty ())
+	{
+		checker = CreateObjectWithAttributes<AmHistoryChecker> ("HistoryFile", StringValue (history));
+		checker->AddClients (c_apps);
+	}
+
 	NS_LOG_INFO ("Run Simulation: ABD P2P SWMR");
 	//std::cout<<"Run Simulation: ABD P2P."<<std::endl;
 	Simulator::Run ();
+
+	if (stats && statsFormat == "csv")
+	{
+		stats->WriteCsv (statsPrefix);
+	}
+	else if (stats)
+	{
+		std::stringstream input, run;
+		input << "servers=" << numServers << ",readers=" << numReaders;
+		run << seed;
+		DataCollector data;
+		data.DescribeRun ("am-abd-p2p", "abd", input.str (), run.str ());
+		stats->AddToCollector (data, "abd");
+
+		Ptr<DataOutputInterface> output;
+		if (statsFormat == "omnet")
+			output = CreateObject<OmnetDataOutput> ();
+#ifdef STATS_HAS_SQLITE3
+		else if (statsFormat == "db")
+			output = CreateObject<SqliteDataOutput> ();
+#endif
+		else
+			NS_FATAL_ERROR ("Unsupported metrics format " << statsFormat);
+		output->SetFilePrefix (statsPrefix);
+		output->Output (data);
+	}
+	if (checker)
+	{
+		checker->Finish ();
+		checker->Report (std::cout);
+		checker->Dispose ();
+	}
+	if (ring)
+	{
+		ring->Dump (ringFile);
+		ring->Dispose ();
+	}
 	Simulator::Destroy ();
 	NS_LOG_INFO (">>>> ABD SWMR Scenario - Servers:"<<numServers<<", Readers:"<<numReaders<<", Writers:1, Failures:"<<numFail<<", ReadInterval:"<<readInterval<<", WriteInterval:"<<writeInterval<<", <<<<");
 	NS_LOG_INFO ("Scenario Succesfully completed.");
@@ -49,6 +49,7 @@
 // - DropTail queues 
 
 
+#include <algorithm>
 #include <fstream>
 #include "ns3/core-module.h"
 #include "ns3/csma-module.h"
@@ -73,6 +74,8 @@ main (int argc, char *argv[])
 	int version=0;
 	int seed = 0;
 	int verbose=0;
+	uint32_t packetSize = 1024;
+	bool multicast = false;
 
 	//
 	// Users may find it convenient to turn on explicit debugging
@@ -97,8 +100,13 @@ main (int argc, char *argv[])
 	cmd.AddValue ("version", "Version 0 for FixInt, 1 for randInt", version);
 	cmd.AddValue ("seed", "Randomness Seed", seed);
 	cmd.AddValue ("verbose", "Debug Mode", verbose);
+	cmd.AddValue ("size", "Size of the values in bytes", packetSize);
+	cmd.AddValue ("multicast", "Send the rounds of the clients to a multicast group of the servers (Udp)", multicast);
 	cmd.Parse (argc, argv);
 
+	// Leave room in the TCP send buffers for a few values, or the larger ones would not fit
+	Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (std::max<uint32_t> (131072, 8 * packetSize)));
+
 	// By default set the failures equal to the minority
 	if ( numFail < 0 || numFail > numServers/2 )
 	{
@@ -240,6 +248,40 @@ main (int argc, char *argv[])
 	Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
 
+	// Multicast routes from the LANs, along the router chain, to the servers
+	Ipv4Address multicastGroup ("225.1.2.4");
+	if (multicast)
+	{
+		Ipv4StaticRoutingHelper multicastRouting;
+
+		for (int i=0; i<numClients; i++)
+		{
+			int lan = (int) (i/clientsPerLan);
+			multicastRouting.SetDefaultMulticastRoute (clientNodes.Get (i), csmaDeviceAdjacencyList[lan].Get ((i%clientsPerLan)+1));
+		}
+
+		// router k forwards what comes from its LAN and from router k+1 to router k-1
+		for (int k=1; k<=numServers; k++)
+		{
+			multicastRouting.AddMulticastRoute (routers.Get (k), Ipv4Address::GetAny (), multicastGroup,
+					csmaDeviceAdjacencyList[k-1].Get (0), NetDeviceContainer (p2pDeviceAdjacencyList[k-1].Get (1)));
+			if (k < numServers)
+			{
+				multicastRouting.AddMulticastRoute (routers.Get (k), Ipv4Address::GetAny (), multicastGroup,
+						p2pDeviceAdjacencyList[k].Get (0), NetDeviceContainer (p2pDeviceAdjacencyList[k-1].Get (1)));
+			}
+		}
+
+		// router 0 copies the rounds to every server
+		NetDeviceContainer serverLinks;
+		for (int i=0; i<numServers; i++)
+		{
+			serverLinks.Add (p2pServersDeviceAdjacencyList[i].Get (0));
+		}
+		multicastRouting.AddMulticastRoute (routers.Get (0), Ipv4Address::GetAny (), multicastGroup,
+				p2pDeviceAdjacencyList[0].Get (0), serverLinks);
+	}
+
 	//collect the server adresses
 	std::vector<Address> serverAddress;
 	for(uint32_t i=0; i<p2pServersInterfaceAdjacencyList.size (); ++i)
@@ -271,6 +313,10 @@ main (int argc, char *argv[])
 		server.SetAttribute ("ID", UintegerValue (i+numReaders+1));
 		server.SetAttribute ("Verbose", UintegerValue (verbose));
 		server.SetAttribute("LocalAddress", AddressValue (InetSocketAddress (p2pServersInterfaceAdjacencyList[i].GetAddress(1), port)));
+		if (multicast)
+		{
+			server.SetMulticastGroup (multicastGroup);
+		}
 		s_apps.Add ((server.Install(serverNodes.Get (i))).Get(0));
 	}
 
@@ -283,7 +329,6 @@ main (int argc, char *argv[])
 	// node one.
 	//
 	Time interPacketInterval;
-	uint32_t packetSize = 1024;
 	uint32_t maxPacketCount = 10;
 	ApplicationContainer c_apps;
 
@@ -317,6 +362,10 @@ main (int argc, char *argv[])
 		client.SetAttribute ("RandomInterval", UintegerValue (version));
 		client.SetAttribute ("Seed", UintegerValue (seed));
 		client.SetAttribute ("Verbose", UintegerValue (verbose));
+		if (multicast)
+		{
+			client.SetMulticastGroup (multicastGroup);
+		}
 		Ptr<Application> app = (client.Install (clientNodes.Get (i))).Get(0);
 		client.SetServers(app, serverAddress);
 		c_apps.Add(app);
@@ -40,6 +40,7 @@
 // - DropTail queues 
 
 
+#include <algorithm>
 #include <fstream>
 #include "ns3/core-module.h"
 #include "ns3/csma-module.h"
@@ -66,6 +67,7 @@ main (int argc, char *argv[])
 	int version=0;
 	int seed = 0;
 	int verbose=0;
+	uint32_t packetSize = 1024;
 
 //
 // Users may find it convenient to turn on explicit debugging
@@ -91,8 +93,12 @@ main (int argc, char *argv[])
   cmd.AddValue ("version", "Version 0 for FixInt, 1 for randInt", version);
   cmd.AddValue ("seed", "Randomness Seed", seed);
   cmd.AddValue ("verbose", "Debug Mode", verbose);
+  cmd.AddValue ("size", "Size of the values in bytes", packetSize);
   cmd.Parse (argc, argv);
 
+  // Leave room in the TCP send buffers for a few values, or the larger ones would not fit
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (std::max<uint32_t> (131072, 8 * packetSize)));
+
   // By default set the failures equal to the minority
   if ( numFail < 0 || numFail > numServers/2 )
   {
@@ -280,7 +286,6 @@ main (int argc, char *argv[])
 // node one.
 //
   Time interPacketInterval;
-  uint32_t packetSize = 1024;
   uint32_t maxPacketCount = 10;
   ApplicationContainer c_apps;
 
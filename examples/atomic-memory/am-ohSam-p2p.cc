@@ -40,6 +40,7 @@
 // - DropTail queues 
 
 
+#include <algorithm>
 #include <fstream>
 #include "ns3/core-module.h"
 #include "ns3/csma-module.h"
@@ -66,6 +67,18 @@ main (int argc, char *argv[])
 	int version=0;
 	int seed = 0;
   int verbose=0;
+  uint32_t packetSize = 1024;
+  double relayWindow = 0;	//window in ms the servers batch their relays in (0 for none)
+  uint32_t serviceCores = 0;	//cores of each server (0 for no processing time)
+  double serviceTime = 0;	//mean processing time of a message in ms (exponential)
+  double relayServiceTime = -1;	//mean processing time of a relay in ms (negative for serviceTime)
+  std::string quorum = "All";	//servers an operation is sent to first: All, Random or Nearest
+  double thriftyTimeout = 100;	//time in ms a thrifty operation waits before it goes to all the servers
+  int numKeys = 1;	//number of keys (registers)
+  double zipfAlpha = 0;	//zipf exponent of the key distribution (0 for uniform)
+  double arrivalRate = 0;	//Poisson arrivals per second per client (0 for closed loop)
+  std::string traceFile = "";	//file of arrival times to replay
+  int64_t streamIndex = 0;	//next random stream of the clients
 
 //
 // Users may find it convenient to turn on explicit debugging
@@ -91,8 +104,39 @@ main (int argc, char *argv[])
   cmd.AddValue ("version", "Version 0 for FixInt, 1 for randInt", version);
   cmd.AddValue ("seed", "Randomness Seed", seed);
   cmd.AddValue ("verbose", "Debug Mode", verbose);
+  cmd.AddValue ("keys", "Number of keys", numKeys);
+  cmd.AddValue ("zipf", "Zipf exponent of the key distribution (0 for uniform)", zipfAlpha);
+  cmd.AddValue ("rate", "Poisson arrival rate of the operations of each client (0 for closed loop)", arrivalRate);
+  cmd.AddValue ("trace", "File with the arrival times (in seconds) to replay", traceFile);
+  cmd.AddValue ("size", "Size of the values in bytes", packetSize);
+  cmd.AddValue ("relayWindow", "Window in ms the servers batch their relays to each other in (0 for none)", relayWindow);
+  cmd.AddValue ("cores", "Cores of each server (0 to process every message on arrival)", serviceCores);
+  cmd.AddValue ("serviceTime", "Mean processing time of a message in ms (exponential)", serviceTime);
+  cmd.AddValue ("relayServiceTime", "Mean processing time of a relay in ms (exponential, negative for serviceTime)", relayServiceTime);
+  cmd.AddValue ("quorum", "Servers an operation is sent to first: All, or a thrifty quorum chosen at Random or by the Nearest", quorum);
+  cmd.AddValue ("thriftyTimeout", "Time in ms a thrifty operation waits before it is sent to the other servers", thriftyTimeout);
   cmd.Parse (argc, argv);
 
+  // Leave room in the TCP send buffers for a few values, or the larger ones would not fit
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (std::max<uint32_t> (131072, 8 * packetSize)));
+  Config::SetDefault ("ns3::ohSamServer::RelayWindow", TimeValue (Seconds (relayWindow / 1000)));
+
+  // Deterministic processing times of the servers, drawn from ns-3 random variables
+  std::ostringstream serviceDist;
+  serviceDist << "ns3::ExponentialRandomVariable[Mean=" << serviceTime / 1000 << "]";
+  Config::SetDefault ("ns3::ohSamServer::ServiceCores", UintegerValue (serviceCores));
+  Config::SetDefault ("ns3::ohSamServer::ServiceTime", StringValue (serviceDist.str ()));
+  if (relayServiceTime >= 0)
+    {
+      std::ostringstream relayDist;
+      relayDist << "ns3::ExponentialRandomVariable[Mean=" << relayServiceTime / 1000 << "]";
+      Config::SetDefault ("ns3::ohSamServer::RelayServiceTime", StringValue (relayDist.str ()));
+    }
+
+  // Thrifty operations, sent to #servers-#failures servers first
+  Config::SetDefault ("ns3::ohSamClient::QuorumSelection", StringValue (quorum));
+  Config::SetDefault ("ns3::ohSamClient::ThriftyTimeout", TimeValue (Seconds (thriftyTimeout / 1000)));
+
   // By default set the failures equal to the minority
   if ( numFail < 0 || numFail > numServers/2 )
   {
@@ -277,7 +321,6 @@ main (int argc, char *argv[])
 // node one.
 //
   Time interPacketInterval;
-  uint32_t packetSize = 1024;
   uint32_t maxPacketCount = 10;
   ApplicationContainer c_apps;
 
@@ -312,7 +355,13 @@ main (int argc, char *argv[])
 	  client.SetAttribute("RandomInterval", UintegerValue (version));
 	  client.SetAttribute("Seed", UintegerValue (seed));
     client.SetAttribute ("Verbose", UintegerValue (verbose));
+    client.SetKeyDistribution (numKeys, zipfAlpha > 0 ? AmKeySelector::ZIPF : AmKeySelector::UNIFORM, zipfAlpha);
+    if (!traceFile.empty ())
+    	client.SetWorkload (AmWorkload::TRACE, arrivalRate, traceFile);
+    else if (arrivalRate > 0)
+    	client.SetWorkload (AmWorkload::POISSON, arrivalRate);
 	  Ptr<Application> app = (client.Install (clientNodes.Get (i))).Get(0);
+	  streamIndex += client.AssignStreams (clientNodes.Get (i), streamIndex);
 	  client.SetServers(app, serverAddress);
 	  c_apps.Add(app);
   }
@@ -39,6 +39,7 @@
 // - Links between nodes in LAN: CSMA 5Mpbs, 2ms delay
 // - DropTail queues 
 
+#include <algorithm>
 #include <fstream>
 #include "ns3/core-module.h"
 #include "ns3/csma-module.h"
@@ -65,6 +66,7 @@ main (int argc, char *argv[])
     int version=0;
     int seed = 0;
     int verbose=0;
+    uint32_t packetSize = 1024;
 
     //
     // Users may find it convenient to turn on explicit debugging
@@ -90,8 +92,12 @@ main (int argc, char *argv[])
     cmd.AddValue ("seed", "Randomness Seed", seed);
     cmd.AddValue ("optimize", "1: use propagation flag, 0: do not use prop flag", usePropagation);
     cmd.AddValue ("verbose", "Debug Mode", verbose);
+    cmd.AddValue ("size", "Size of the values in bytes", packetSize);
     cmd.Parse (argc, argv);
 
+    // Leave room in the TCP send buffers for a few values, or the larger ones would not fit
+    Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (std::max<uint32_t> (131072, 8 * packetSize)));
+
     //
     // But since this is a realtime script, don't allow the user to mess with
     // that.
@@ -231,7 +237,6 @@ main (int argc, char *argv[])
     // node one.
     //
     Time interPacketInterval;
-    uint32_t packetSize = 1024;
     uint32_t maxPacketCount = 10;
     ApplicationContainer c_apps;
     // Create the writer+reader processes
@@ -0,0 +1,703 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Parameter sweep over the topologies of the atomic memory examples.
+//
+// Every combination of --protocols x --servers x --readers x --failures x
+// --seeds is one run. The runs are simulated by up to --jobs forked worker
+// processes, one scenario per process, and each run adds one CSV row to
+// --out:
+//
+//   ./waf --run "am-sweep --protocols=abd,ohSam --servers=3,5,7 --readers=10,20 --seeds=1:10"
+//
+// Lists are comma separated and first:last stands for every integer in
+// between. As in the examples, a failure count of -1 (or more than a
+// minority) means a minority of the servers, and a run with seed s
+// reproduces the am-<protocol>-p2p example run with --seed=s.
+//
+// The runs use the p2p topology of these examples, or the --topology
+// star-p2p, spike, star, or wan with the sites of the --latencies matrix,
+// all built by AmTopologyHelper with static routes. With --clientsPerNode
+// k > 1 the clients share their nodes k by k, multiplexed over one
+// connection per server (see AmConnectionManager); only the ABD protocols,
+// whose servers tell the clients apart by the messages rather than by their
+// addresses, can share a node.
+//
+// --crashes servers, from the first one, crash at --crashAt and recover at
+// --recoverAt (never if 0) in every run; --faults schedules the faults of a
+// file instead (see AmFaultInjector), where link i < servers-1 joins routers
+// i and i+1 and link servers-1+i joins server i to its router (in p2p).
+//
+// writeLatency and readLatency are the means of the LOG lines (simulated plus
+// computation time); the P50/P99 columns are percentiles of the simulated
+// latencies, as traced by the OpCompleted sources of the clients.
+//
+// Every run is checked by AmHistoryChecker: violations counts the operations
+// that break atomicity, reported on stderr, and unmatched the reads of a
+// write that never completed.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/asm-common.h"
+#include "am-topology-helper.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("AmSweep");
+
+namespace {
+
+// Settings shared by all the runs of a sweep
+struct SweepSettings
+{
+  int writers;            // writers of the multi-writer protocols
+  double readInterval;    // in seconds
+  double writeInterval;   // in seconds
+  int version;            // 0 for fixed, 1 for random intervals
+  uint32_t maxOps;        // operations per client
+  uint32_t packetSize;    // size of the values in bytes
+  double stopTime;        // in seconds
+  uint32_t crashes;       // servers crashed in every run
+  double crashAt;         // in seconds
+  double recoverAt;       // in seconds, 0 for never
+  std::string faults;     // schedule file of the faults
+  AmTopologyHelper::Shape topology;
+  std::string latencies;  // latency matrix of the wan topology
+  uint32_t clientsPerNode;  // clients sharing a node, multiplexed
+};
+
+// One point of the grid
+struct SweepRun
+{
+  std::string protocol;
+  int servers;
+  int readers;
+  int failures;
+  int seed;
+};
+
+// Nodes and addresses of the p2p topology
+struct SweepNetwork
+{
+  NodeContainer serverNodes;
+  NodeContainer clientNodes;
+  std::vector<Ipv4Address> serverIps;
+  std::vector<Ipv4Address> clientIps;
+  std::vector<Address> serverAddress;
+  std::vector<NetDeviceContainer> links;  // router, server, then client links
+};
+
+// Totals of a run
+struct SweepTotals
+{
+  SweepTotals () : writes (0), completedWrites (0), reads (0), completedReads (0),
+                   slowReads (0), fastReads (0), clientMsgs (0), serverMsgs (0),
+                   writeTime (0), readTime (0), writeP50 (0), writeP99 (0),
+                   readP50 (0), readP99 (0), violations (0), unmatched (0) {}
+
+  uint64_t writes;
+  uint64_t completedWrites;
+  uint64_t reads;
+  uint64_t completedReads;
+  uint64_t slowReads;
+  uint64_t fastReads;
+  uint64_t clientMsgs;
+  uint64_t serverMsgs;
+  double writeTime;       // summed over the completed writes
+  double readTime;        // summed over the completed reads
+  double writeP50;        // percentiles of the simulated latencies
+  double writeP99;
+  double readP50;
+  double readP99;
+  uint64_t violations;    // of atomicity, found by AmHistoryChecker
+  uint64_t unmatched;     // reads of a write that never completed
+};
+
+struct SweepProtocol;
+
+typedef SweepTotals (*SweepRunner) (const SweepProtocol &p, const SweepRun &run, int writers,
+                                    const SweepSettings &settings, const SweepNetwork &net);
+
+// How the example of a protocol sets up its applications
+struct SweepProtocol
+{
+  const char *name;
+  bool mwmr;              // runs several writers
+  bool socketAddress;     // servers bind an InetSocketAddress rather than an Ipv4Address
+  bool clientPort;        // clients take the Port attribute
+  bool inFlight;          // clients take the MaxInFlight attribute
+  bool optimize;          // servers take the Optimize attribute
+  bool multiplex;         // clients take the Multiplex attribute
+  SweepRunner runner;
+};
+
+template <class ServerHelper>
+void
+SetPeers (ServerHelper &, Ptr<Application>, const std::vector<Address> &, std::false_type)
+{
+}
+
+template <class ServerHelper>
+void
+SetPeers (ServerHelper &server, Ptr<Application> app, const std::vector<Address> &peers, std::true_type)
+{
+  server.SetServers (app, peers);
+}
+
+// Installs the applications as the am-<protocol>-p2p example does, runs the
+// simulation and collects the totals of the clients and the servers.
+// Relay is set for the protocols whose servers talk to each other.
+template <class ServerHelper, class ClientHelper, class Server, class Client, bool Relay>
+SweepTotals
+RunProtocol (const SweepProtocol &p, const SweepRun &run, int writers,
+             const SweepSettings &settings, const SweepNetwork &net)
+{
+  uint16_t port = 44400;
+  int numClients = run.readers + writers;
+
+  ApplicationContainer s_apps;
+  for (int i = 0; i < run.servers; i++)
+    {
+      ServerHelper server (port);
+      server.SetAttribute ("ID", UintegerValue (i));
+      if (p.socketAddress)
+        server.SetAttribute ("LocalAddress", AddressValue (InetSocketAddress (net.serverIps[i], port)));
+      else
+        server.SetAttribute ("LocalAddress", AddressValue (net.serverIps[i]));
+      if (Relay)
+        server.SetAttribute ("MaxFailures", UintegerValue (run.failures));
+      if (p.optimize)
+        server.SetAttribute ("Optimize", UintegerValue (1));
+      Ptr<Application> app = (server.Install (net.serverNodes.Get (i))).Get (0);
+      SetPeers (server, app, net.serverAddress, std::integral_constant<bool, Relay> ());
+      s_apps.Add (app);
+    }
+  s_apps.Start (Seconds (1.0));
+  s_apps.Stop (Seconds (settings.stopTime));
+
+  Ptr<AmFaultInjector> injector = CreateObject<AmFaultInjector> ();
+  injector->SetAttribute ("Crashes", UintegerValue (settings.crashes));
+  injector->SetAttribute ("CrashTime", TimeValue (Seconds (settings.crashAt)));
+  injector->SetAttribute ("RecoveryTime", TimeValue (Seconds (settings.recoverAt)));
+  injector->SetAttribute ("ScheduleFile", StringValue (settings.faults));
+  injector->AddServers (s_apps);
+  for (uint32_t i = 0; i < net.links.size (); i++)
+    {
+      injector->AddLink (net.links[i]);
+    }
+  injector->ScheduleFaults ();
+
+  int64_t streamIndex = 0;
+  ApplicationContainer c_apps;
+  for (int i = 0; i < numClients; i++)
+    {
+      ClientHelper client (Address (net.clientIps[i]), port);
+      if (i < writers)
+        {
+          client.SetAttribute ("SetRole", UintegerValue (WRITER));
+          client.SetAttribute ("Interval", TimeValue (Seconds (settings.writeInterval)));
+        }
+      else
+        {
+          client.SetAttribute ("SetRole", UintegerValue (READER));
+          client.SetAttribute ("Interval", TimeValue (Seconds (settings.readInterval)));
+        }
+      client.SetAttribute ("MaxOperations", UintegerValue (settings.maxOps));
+      if (p.clientPort)
+        client.SetAttribute ("Port", UintegerValue (port));
+      client.SetAttribute ("ID", UintegerValue (i));
+      client.SetAttribute ("MaxFailures", UintegerValue (run.failures));
+      client.SetAttribute ("Clients", UintegerValue (numClients));
+      client.SetAttribute ("PacketSize", UintegerValue (settings.packetSize));
+      client.SetAttribute ("RandomInterval", UintegerValue (settings.version));
+      client.SetAttribute ("Seed", UintegerValue (run.seed));
+      if (p.inFlight)
+        client.SetAttribute ("MaxInFlight", UintegerValue (1));
+      if (settings.clientsPerNode > 1)
+        client.SetAttribute ("Multiplex", BooleanValue (true));
+      Ptr<Node> node = net.clientNodes.Get (i / settings.clientsPerNode);
+      Ptr<Application> app = (client.Install (node)).Get (0);
+      streamIndex += client.AssignStreams (node, streamIndex);
+      client.SetServers (app, net.serverAddress);
+      c_apps.Add (app);
+    }
+  c_apps.Start (Seconds (2.0));
+  c_apps.Stop (Seconds (settings.stopTime));
+
+  Ptr<AmStatsCollector> collector = CreateObject<AmStatsCollector> ();
+  collector->AddServers (s_apps);
+  collector->AddClients (c_apps);
+
+  Ptr<AmHistoryChecker> checker = CreateObject<AmHistoryChecker> ();
+  checker->AddClients (c_apps);
+
+  Simulator::Run ();
+  checker->Finish ();
+
+  SweepTotals totals;
+  for (int i = 0; i < numClients; i++)
+    {
+      AmClientStats stats = DynamicCast<Client> (c_apps.Get (i))->GetStats ();
+      // the LOG lines divide by the invoked operations, the time spent is
+      // that of the completed ones
+      double time = (stats.commTime + stats.compTime) * stats.invoked;
+      totals.clientMsgs += stats.sent;
+      if (i < writers)
+        {
+          totals.writes += stats.invoked;
+          totals.completedWrites += stats.completed;
+          totals.writeTime += time;
+        }
+      else
+        {
+          totals.reads += stats.invoked;
+          totals.completedReads += stats.completed;
+          totals.slowReads += stats.slowReads;
+          totals.fastReads += stats.fastReads;
+          totals.readTime += time;
+        }
+    }
+  for (int i = 0; i < run.servers; i++)
+    {
+      totals.serverMsgs += DynamicCast<Server> (s_apps.Get (i))->GetSentMessages ();
+    }
+  totals.writeP50 = collector->GetWriteLatency ()->GetPercentile (0.5).GetSeconds ();
+  totals.writeP99 = collector->GetWriteLatency ()->GetPercentile (0.99).GetSeconds ();
+  totals.readP50 = collector->GetReadLatency ()->GetPercentile (0.5).GetSeconds ();
+  totals.readP99 = collector->GetReadLatency ()->GetPercentile (0.99).GetSeconds ();
+  totals.violations = checker->GetViolations ();
+  totals.unmatched = checker->GetUnmatched ();
+  if (totals.violations > 0)
+    {
+      checker->Report (std::cerr);
+    }
+  return totals;
+}
+
+const SweepProtocol g_protocols[] = {
+  //  name        mwmr   sock   port   infl   opt    mux
+  { "abd",        false, true,  false, true,  false, true,
+    &RunProtocol<AbdServerHelper, AbdClientHelper, AbdServer, AbdClient, false> },
+  { "abd-mwmr",   true,  true,  true,  true,  false, true,
+    &RunProtocol<AbdServerHelperMWMR, AbdClientHelperMWMR, AbdServerMWMR, AbdClientMWMR, false> },
+  { "ohSam",      false, false, true,  false, false, false,
+    &RunProtocol<ohSamServerHelper, ohSamClientHelper, ohSamServer, ohSamClient, true> },
+  { "ohSamEX",    false, false, true,  false, false, false,
+    &RunProtocol<ohSamEXServerHelper, ohSamEXClientHelper, ohSamEXServer, ohSamEXClient, true> },
+  { "ohMam",      true,  false, true,  false, false, false,
+    &RunProtocol<OhMamServerHelper, OhMamClientHelper, OhMamServer, OhMamClient, true> },
+  { "ohMamEX",    true,  false, true,  false, false, false,
+    &RunProtocol<OhMamEXServerHelper, OhMamEXClientHelper, OhMamEXServer, OhMamEXClient, true> },
+  { "ohfast",     false, false, true,  false, false, false,
+    &RunProtocol<OhFastServerHelper, OhFastClientHelper, OhFastServer, OhFastClient, true> },
+  { "semifast",   false, false, false, false, true, false,
+    &RunProtocol<SemifastServerHelper, SemifastClientHelper, SemifastServer, SemifastClient, false> },
+  { "cchybrid",   false, false, false, false, true, false,
+    &RunProtocol<CCHybridServerHelper, CCHybridClientHelper, CCHybridServer, CCHybridClient, false> },
+  { "MwImp",      true,  false, true,  false, false, false,
+    &RunProtocol<MwImpServerHelper, MwImpClientHelper, MwImpServer, MwImpClient, true> },
+  { "SwImp",      false, true,  false, true,  false, false,
+    &RunProtocol<SwImpServerHelper, SwImpClientHelper, SwImpServer, SwImpClient, false> },
+  { "coded-abd",  true,  true,  false, true,  false, false,
+    &RunProtocol<CodedAbdServerHelper, CodedAbdClientHelper, CodedAbdServer, CodedAbdClient, false> },
+};
+
+const SweepProtocol *
+FindProtocol (const std::string &name)
+{
+  for (uint32_t i = 0; i < sizeof (g_protocols) / sizeof (g_protocols[0]); i++)
+    {
+      if (name == g_protocols[i].name)
+        {
+          return &g_protocols[i];
+        }
+    }
+  return 0;
+}
+
+// Builds the topology of the runs, the chain of routers of the p2p examples
+// by default: server i and its share of the clients hang off router i.
+// Client i runs on client node i / clientsPerNode.
+SweepNetwork
+BuildNetwork (int numServers, int numClients, const SweepSettings &settings)
+{
+  int numNodes = (numClients + settings.clientsPerNode - 1) / settings.clientsPerNode;
+  AmTopologyHelper topology;
+  if (!settings.latencies.empty ())
+    {
+      topology.LoadLatencyMatrix (settings.latencies);
+    }
+  topology.Build (settings.topology, numServers, numNodes);
+
+  SweepNetwork net;
+  net.serverNodes = topology.GetServers ();
+  net.clientNodes = topology.GetClients ();
+  for (int i = 0; i < numServers; i++)
+    {
+      net.serverIps.push_back (topology.GetServerAddress (i));
+    }
+  for (int i = 0; i < numClients; i++)
+    {
+      net.clientIps.push_back (topology.GetClientAddress (i / settings.clientsPerNode));
+    }
+  net.serverAddress = topology.GetServerAddresses ();
+  net.links = topology.GetLinks ();
+  return net;
+}
+
+const char *g_header = "protocol,servers,readers,writers,failures,seed,status,"
+  "writes,completedWrites,reads,completedReads,slowReads,fastReads,"
+  "writeLatency,readLatency,writeP50,writeP99,readP50,readP99,clientMsgs,serverMsgs,violations,unmatched,wallSeconds";
+
+// Returns the metric columns of a failed run, left empty: the columns of
+// the header between status and wallSeconds
+std::string
+EmptyMetrics (void)
+{
+  std::string header (g_header);
+  std::string::size_type first = header.find ("status,") + strlen ("status,");
+  std::string::size_type last = header.rfind (",wallSeconds");
+  uint32_t columns = std::count (header.begin () + first, header.begin () + last, ',') + 1;
+  return std::string (columns - 1, ',');
+}
+
+// Simulates one run in the calling process and returns the metric columns
+// of its row
+std::string
+SimulateRun (const SweepRun &run, const SweepProtocol &p, int writers, const SweepSettings &settings)
+{
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize",
+                      UintegerValue (std::max<uint32_t> (131072, 8 * settings.packetSize)));
+
+  SweepNetwork net = BuildNetwork (run.servers, run.readers + writers, settings);
+  SweepTotals t = p.runner (p, run, writers, settings, net);
+  Simulator::Destroy ();
+
+  std::ostringstream row;
+  row << t.writes << "," << t.completedWrites << "," << t.reads << "," << t.completedReads << ","
+      << t.slowReads << "," << t.fastReads << ","
+      << (t.completedWrites ? t.writeTime / t.completedWrites : 0) << ","
+      << (t.completedReads ? t.readTime / t.completedReads : 0) << ","
+      << t.writeP50 << "," << t.writeP99 << "," << t.readP50 << "," << t.readP99 << ","
+      << t.clientMsgs << "," << t.serverMsgs << "," << t.violations << "," << t.unmatched;
+  return row.str ();
+}
+
+// Parses a comma separated list of integers and first:last ranges
+bool
+ParseList (const std::string &s, std::vector<int> &values)
+{
+  std::istringstream in (s);
+  std::string item;
+  while (std::getline (in, item, ','))
+    {
+      int first, last;
+      char sep;
+      std::istringstream range (item);
+      if (!(range >> first))
+        {
+          return false;
+        }
+      if (range >> sep)
+        {
+          if (sep != ':' || !(range >> last) || last < first)
+            {
+              return false;
+            }
+        }
+      else
+        {
+          last = first;
+        }
+      for (int v = first; v <= last; v++)
+        {
+          values.push_back (v);
+        }
+    }
+  return !values.empty ();
+}
+
+// A worker process and the run it simulates
+struct SweepWorker
+{
+  uint32_t run;
+  int fd;                 // read end of the pipe of the row
+  double start;           // wall-clock start, in seconds
+};
+
+double
+WallSeconds (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string protocols = "abd";
+  std::string servers = "5";
+  std::string readers = "10";
+  std::string failures = "-1";
+  std::string seeds = "0";
+  std::string out = "am-sweep.csv";
+  uint32_t jobs = 0;
+  SweepSettings settings;
+  settings.writers = 1;
+  settings.readInterval = 2;
+  settings.writeInterval = 3;
+  settings.version = 0;
+  settings.maxOps = 10;
+  settings.packetSize = 1024;
+  settings.stopTime = 30;
+  settings.crashes = 0;
+  settings.crashAt = 0;
+  settings.recoverAt = 0;
+  settings.clientsPerNode = 1;
+  std::string topology = "p2p";
+
+  CommandLine cmd;
+  cmd.AddValue ("protocols", "Comma separated protocols (abd, abd-mwmr, ohSam, ohSamEX, ohMam, ohMamEX, ohfast, semifast, cchybrid, MwImp, SwImp, coded-abd)", protocols);
+  cmd.AddValue ("servers", "Numbers of servers", servers);
+  cmd.AddValue ("readers", "Numbers of readers", readers);
+  cmd.AddValue ("failures", "Numbers of server failures (-1 for a minority)", failures);
+  cmd.AddValue ("seeds", "Randomness seeds, one run each", seeds);
+  cmd.AddValue ("writers", "Number of writers of the multi-writer protocols", settings.writers);
+  cmd.AddValue ("rInterval", "Read interval in seconds", settings.readInterval);
+  cmd.AddValue ("wInterval", "Write interval in seconds", settings.writeInterval);
+  cmd.AddValue ("version", "Version 0 for FixInt, 1 for randInt", settings.version);
+  cmd.AddValue ("ops", "Operations per client", settings.maxOps);
+  cmd.AddValue ("size", "Size of the values in bytes", settings.packetSize);
+  cmd.AddValue ("stop", "Simulated seconds of each run", settings.stopTime);
+  cmd.AddValue ("crashes", "Servers that crash in every run", settings.crashes);
+  cmd.AddValue ("crashAt", "Time in seconds the servers crash", settings.crashAt);
+  cmd.AddValue ("recoverAt", "Time in seconds the servers recover (0 for never)", settings.recoverAt);
+  cmd.AddValue ("faults", "File of the faults of every run (see AmFaultInjector)", settings.faults);
+  cmd.AddValue ("topology", "Topology of the runs: p2p, star-p2p, spike, star or wan (see AmTopologyHelper)", topology);
+  cmd.AddValue ("latencies", "Latency matrix of the wan topology, one row of delays per line", settings.latencies);
+  cmd.AddValue ("clientsPerNode", "Clients sharing a node, multiplexed over one connection per server (abd, abd-mwmr)", settings.clientsPerNode);
+  cmd.AddValue ("jobs", "Worker processes (0 for one per core)", jobs);
+  cmd.AddValue ("out", "CSV file of the results, one row per run", out);
+  cmd.Parse (argc, argv);
+  if (!AmTopologyHelper::ParseShape (topology, settings.topology))
+    {
+      NS_FATAL_ERROR ("Unknown topology " << topology);
+    }
+  if (settings.clientsPerNode < 1)
+    {
+      NS_FATAL_ERROR ("--clientsPerNode must be at least 1");
+    }
+
+  std::vector<std::string> protocolList;
+  std::vector<int> serverList, readerList, failureList, seedList;
+  std::istringstream in (protocols);
+  std::string name;
+  while (std::getline (in, name, ','))
+    {
+      if (!FindProtocol (name))
+        {
+          NS_FATAL_ERROR ("Unknown protocol " << name);
+        }
+      if (settings.clientsPerNode > 1 && !FindProtocol (name)->multiplex)
+        {
+          NS_FATAL_ERROR ("The clients of " << name << " cannot share a node");
+        }
+      protocolList.push_back (name);
+    }
+  if (protocolList.empty () || !ParseList (servers, serverList) || !ParseList (readers, readerList)
+      || !ParseList (failures, failureList) || !ParseList (seeds, seedList))
+    {
+      NS_FATAL_ERROR ("Malformed sweep grid");
+    }
+
+  std::vector<SweepRun> runs;
+  for (uint32_t a = 0; a < protocolList.size (); a++)
+    for (uint32_t b = 0; b < serverList.size (); b++)
+      for (uint32_t c = 0; c < readerList.size (); c++)
+        for (uint32_t d = 0; d < failureList.size (); d++)
+          for (uint32_t e = 0; e < seedList.size (); e++)
+            {
+              if (serverList[b] < 1 || readerList[c] < 0)
+                {
+                  NS_FATAL_ERROR ("A run needs servers and a non-negative number of readers");
+                }
+              SweepRun run;
+              run.protocol = protocolList[a];
+              run.servers = serverList[b];
+              run.readers = readerList[c];
+              run.failures = failureList[d];
+              if (run.failures < 0 || run.failures > run.servers / 2)
+                {
+                  run.failures = (run.servers - 1) / 2;
+                }
+              run.seed = seedList[e];
+              runs.push_back (run);
+            }
+
+  if (jobs == 0)
+    {
+      jobs = std::max<long> (1, sysconf (_SC_NPROCESSORS_ONLN));
+    }
+
+  std::ofstream csv (out.c_str ());
+  if (!csv)
+    {
+      NS_FATAL_ERROR ("Cannot open " << out);
+    }
+  csv << g_header << std::endl;
+
+  std::cout << "Sweeping " << runs.size () << " runs with " << jobs << " workers into " << out << std::endl;
+
+  // The parent never touches the simulator: every run starts from the
+  // state the program had after parsing its arguments
+  std::map<pid_t, SweepWorker> workers;
+  uint32_t next = 0;
+  uint32_t done = 0;
+  uint32_t failed = 0;
+  double sweepStart = WallSeconds ();
+  while (next < runs.size () || !workers.empty ())
+    {
+      while (next < runs.size () && workers.size () < jobs)
+        {
+          const SweepRun &run = runs[next];
+          const SweepProtocol *p = FindProtocol (run.protocol);
+          int writers = p->mwmr ? settings.writers : 1;
+          int fds[2];
+          if (pipe (fds) != 0)
+            {
+              NS_FATAL_ERROR ("pipe: " << std::strerror (errno));
+            }
+          std::cout.flush ();
+          csv.flush ();
+          pid_t pid = fork ();
+          if (pid < 0)
+            {
+              NS_FATAL_ERROR ("fork: " << std::strerror (errno));
+            }
+          if (pid == 0)
+            {
+              close (fds[0]);
+              // the applications report on stdout, the row is all we want
+              int devNull = open ("/dev/null", O_WRONLY);
+              dup2 (devNull, STDOUT_FILENO);
+              std::string row = SimulateRun (run, *p, writers, settings);
+              const char *data = row.c_str ();
+              size_t left = row.size ();
+              while (left > 0)
+                {
+                  ssize_t n = write (fds[1], data, left);
+                  if (n <= 0)
+                    {
+                      _exit (1);
+                    }
+                  data += n;
+                  left -= n;
+                }
+              _exit (0);
+            }
+          close (fds[1]);
+          SweepWorker w;
+          w.run = next++;
+          w.fd = fds[0];
+          w.start = WallSeconds ();
+          workers[pid] = w;
+        }
+
+      // rows are far smaller than a pipe buffer, so a worker never blocks
+      // on its write and can be reaped before its row is read
+      int status;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid < 0)
+        {
+          NS_FATAL_ERROR ("waitpid: " << std::strerror (errno));
+        }
+      std::map<pid_t, SweepWorker>::iterator it = workers.find (pid);
+      if (it == workers.end ())
+        {
+          continue;
+        }
+      SweepWorker w = it->second;
+      workers.erase (it);
+
+      std::string metrics;
+      char buf[512];
+      ssize_t n;
+      while ((n = read (w.fd, buf, sizeof (buf))) > 0)
+        {
+          metrics.append (buf, n);
+        }
+      close (w.fd);
+
+      std::ostringstream st;
+      if (WIFSIGNALED (status))
+        {
+          st << "signal " << WTERMSIG (status);
+        }
+      else if (WEXITSTATUS (status) != 0 || metrics.empty ())
+        {
+          st << "exit " << WEXITSTATUS (status);
+        }
+      else
+        {
+          st << "ok";
+        }
+      if (st.str () != "ok")
+        {
+          // keep the columns of a failed run empty
+          metrics = EmptyMetrics ();
+          failed++;
+        }
+
+      const SweepRun &run = runs[w.run];
+      const SweepProtocol *p = FindProtocol (run.protocol);
+      csv << run.protocol << "," << run.servers << "," << run.readers << ","
+          << (p->mwmr ? settings.writers : 1) << "," << run.failures << "," << run.seed << ","
+          << st.str () << "," << metrics << "," << WallSeconds () - w.start << std::endl;
+      done++;
+      std::cout << "[" << done << "/" << runs.size () << "] " << run.protocol
+                << " servers=" << run.servers << " readers=" << run.readers
+                << " failures=" << run.failures << " seed=" << run.seed << ": " << st.str () << std::endl;
+    }
+
+  std::cout << "Sweep of " << runs.size () << " runs done in " << WallSeconds () - sweepStart << "s";
+  if (failed)
+    {
+      std::cout << ", " << failed << " failed";
+    }
+  std::cout << std::endl;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,432 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "am-topology-helper.h"
+
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/ipv4.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/traffic-control-layer.h"
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmTopologyHelper");
+
+namespace {
+
+const uint32_t ROUTER_LINKS = 0xac100000;  //!< 172.16.0.0/12, the router links
+const uint32_t LAN = 0x8000;               //!< offset of the LAN in a prefix
+
+} // anonymous namespace
+
+AmTopologyHelper::AmTopologyHelper ()
+  : m_tc (TrafficControlHelper::Default ())
+{
+  SetRouterLink (DataRate ("10Mbps"), MilliSeconds (4));
+  SetServerLink (DataRate ("10Mbps"), MilliSeconds (2));
+  SetClientLink (DataRate ("5Mbps"), MilliSeconds (2));
+  SetQueueSize (1000);
+  m_lan.SetDeviceAttribute ("Mtu", UintegerValue (1400));
+}
+
+bool
+AmTopologyHelper::ParseShape (std::string name, Shape &shape)
+{
+  static const char *names[] = { "p2p", "star-p2p", "spike", "star", "wan" };
+  for (uint32_t i = 0; i < sizeof (names) / sizeof (names[0]); i++)
+    {
+      if (name == names[i])
+        {
+          shape = (Shape) i;
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+AmTopologyHelper::SetRouterLink (DataRate rate, Time delay)
+{
+  m_routerLink.SetDeviceAttribute ("DataRate", DataRateValue (rate));
+  m_routerLink.SetChannelAttribute ("Delay", TimeValue (delay));
+}
+
+void
+AmTopologyHelper::SetServerLink (DataRate rate, Time delay)
+{
+  m_serverLink.SetDeviceAttribute ("DataRate", DataRateValue (rate));
+  m_serverLink.SetChannelAttribute ("Delay", TimeValue (delay));
+}
+
+void
+AmTopologyHelper::SetClientLink (DataRate rate, Time delay)
+{
+  m_clientLink.SetDeviceAttribute ("DataRate", DataRateValue (rate));
+  m_clientLink.SetChannelAttribute ("Delay", TimeValue (delay));
+  m_lan.SetChannelAttribute ("DataRate", DataRateValue (rate));
+  m_lan.SetChannelAttribute ("Delay", TimeValue (delay));
+}
+
+void
+AmTopologyHelper::SetQueueSize (uint32_t packets)
+{
+  m_routerLink.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (packets));
+  m_serverLink.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (packets));
+  m_clientLink.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (packets));
+}
+
+void
+AmTopologyHelper::SetLatencyMatrix (const std::vector<std::vector<Time> > &delays)
+{
+  for (uint32_t i = 0; i < delays.size (); i++)
+    {
+      if (delays[i].size () != delays.size ())
+        {
+          NS_FATAL_ERROR ("AmTopologyHelper: row " << i << " of the latency matrix has " << delays[i].size ()
+                          << " delays, not " << delays.size ());
+        }
+    }
+  m_latencies = delays;
+}
+
+void
+AmTopologyHelper::LoadLatencyMatrix (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  std::ifstream in (fileName.c_str ());
+  if (!in.is_open ())
+    {
+      NS_FATAL_ERROR ("AmTopologyHelper: cannot open the latency matrix " << fileName);
+    }
+
+  std::vector<std::vector<Time> > delays;
+  std::string line;
+  while (std::getline (in, line))
+    {
+      std::string::size_type comment = line.find ('#');
+      if (comment != std::string::npos)
+        {
+          line.erase (comment);
+        }
+      std::istringstream fields (line);
+      std::vector<Time> row;
+      std::string delay;
+      while (fields >> delay)
+        {
+          row.push_back (Time (delay));
+        }
+      if (!row.empty ())
+        {
+          delays.push_back (row);
+        }
+    }
+  SetLatencyMatrix (delays);
+}
+
+void
+AmTopologyHelper::Build (Shape shape, uint32_t servers, uint32_t clients)
+{
+  NS_LOG_FUNCTION (this << shape << servers << clients);
+  if (m_routers.GetN () > 0)
+    {
+      NS_FATAL_ERROR ("AmTopologyHelper: the topology is already built");
+    }
+  if (servers == 0)
+    {
+      NS_FATAL_ERROR ("AmTopologyHelper: a topology needs servers");
+    }
+
+  bool star = (shape == STAR_P2P || shape == STAR);
+  uint32_t routers = servers;
+  uint32_t firstClientRouter = 0;
+  if (star)
+    {
+      routers = servers + 1;
+      firstClientRouter = 1;
+    }
+  else if (shape == WAN)
+    {
+      if (m_latencies.empty ())
+        {
+          NS_FATAL_ERROR ("AmTopologyHelper: WAN needs a latency matrix");
+        }
+      routers = m_latencies.size ();
+    }
+  if (routers > 255)
+    {
+      NS_FATAL_ERROR ("AmTopologyHelper: " << routers << " routers, at most 255 have a prefix");
+    }
+
+  m_routers.Create (routers);
+  m_servers.Create (servers);
+  m_clients.Create (clients);
+  InternetStackHelper internet;
+  internet.Install (m_routers);
+  internet.Install (m_servers);
+  internet.Install (m_clients);
+  m_adjacency.resize (routers);
+  m_leaves.assign (routers, 0);
+
+  if (shape == WAN)
+    {
+      for (uint32_t a = 0; a < routers; a++)
+        {
+          for (uint32_t b = a + 1; b < routers; b++)
+            {
+              m_routerLink.SetChannelAttribute ("Delay", TimeValue (m_latencies[a][b]));
+              ConnectRouters (a, b);
+            }
+        }
+    }
+  else
+    {
+      for (uint32_t r = 0; r + 1 < routers; r++)
+        {
+          ConnectRouters (r, r + 1);
+        }
+    }
+
+  for (uint32_t i = 0; i < servers; i++)
+    {
+      uint32_t router = star ? 0 : i % routers;
+      m_serverAddresses.push_back (ConnectLeaf (m_serverLink, router, m_servers.Get (i), m_serverLinks));
+    }
+
+  uint32_t clientRouters = routers - firstClientRouter;
+  uint32_t perRouter = (clients + clientRouters - 1) / clientRouters;
+  for (uint32_t r = 0; r < clientRouters && r * perRouter < clients; r++)
+    {
+      uint32_t begin = r * perRouter;
+      uint32_t end = std::min (clients, begin + perRouter);
+      if (shape == SPIKE || shape == STAR)
+        {
+          ConnectLan (firstClientRouter + r, begin, end);
+          continue;
+        }
+      for (uint32_t j = begin; j < end; j++)
+        {
+          m_clientAddresses.push_back (ConnectLeaf (m_clientLink, firstClientRouter + r, m_clients.Get (j), m_clientLinks));
+        }
+    }
+
+  PopulateRoutes ();
+}
+
+uint32_t
+AmTopologyHelper::AddInterface (Ptr<NetDevice> device, Ipv4Address address, Ipv4Mask mask)
+{
+  Ptr<Node> node = device->GetNode ();
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, mask));
+  ipv4->SetMetric (interface, 1);
+  ipv4->SetUp (interface);
+
+  Ptr<TrafficControlLayer> tc = node->GetObject<TrafficControlLayer> ();
+  if (tc && tc->GetRootQueueDiscOnDevice (device) == 0)
+    {
+      m_tc.Install (device);
+    }
+  return interface;
+}
+
+void
+AmTopologyHelper::ConnectRouters (uint32_t a, uint32_t b)
+{
+  uint32_t subnet = ROUTER_LINKS + 4 * m_routerLinks.size ();
+  NetDeviceContainer devices = m_routerLink.Install (m_routers.Get (a), m_routers.Get (b));
+  m_routerLinks.push_back (devices);
+
+  Ipv4Mask mask ("/30");
+  Adjacency toB, toA;
+  toB.router = b;
+  toB.gateway = Ipv4Address (subnet + 2);
+  toB.interface = AddInterface (devices.Get (0), Ipv4Address (subnet + 1), mask);
+  toA.router = a;
+  toA.gateway = Ipv4Address (subnet + 1);
+  toA.interface = AddInterface (devices.Get (1), Ipv4Address (subnet + 2), mask);
+  m_adjacency[a].push_back (toB);
+  m_adjacency[b].push_back (toA);
+}
+
+Ipv4Address
+AmTopologyHelper::ConnectLeaf (PointToPointHelper &link, uint32_t router, Ptr<Node> node,
+                               std::vector<NetDeviceContainer> &links)
+{
+  // the LAN, if any, takes the upper half of the prefix
+  if (4 * (m_leaves[router] + 1) > 2 * LAN)
+    {
+      NS_FATAL_ERROR ("AmTopologyHelper: router " << router << " has no /30 subnet left");
+    }
+  uint32_t subnet = Prefix (router) + 4 * m_leaves[router]++;
+  NetDeviceContainer devices = link.Install (m_routers.Get (router), node);
+  links.push_back (devices);
+
+  Ipv4Mask mask ("/30");
+  Ipv4Address gateway (subnet + 1);
+  Ipv4Address address (subnet + 2);
+  AddInterface (devices.Get (0), gateway, mask);
+  uint32_t interface = AddInterface (devices.Get (1), address, mask);
+
+  Ipv4StaticRoutingHelper routing;
+  routing.GetStaticRouting (node->GetObject<Ipv4> ())->SetDefaultRoute (gateway, interface);
+  return address;
+}
+
+void
+AmTopologyHelper::ConnectLan (uint32_t router, uint32_t begin, uint32_t end)
+{
+  if (m_leaves[router] * 4 > LAN || end - begin + 2 > LAN)
+    {
+      NS_FATAL_ERROR ("AmTopologyHelper: the LAN of router " << router << " cannot hold " << end - begin << " clients");
+    }
+  NodeContainer nodes (m_routers.Get (router));
+  for (uint32_t j = begin; j < end; j++)
+    {
+      nodes.Add (m_clients.Get (j));
+    }
+  NetDeviceContainer devices = m_lan.Install (nodes);
+  m_clientLinks.push_back (devices);
+
+  Ipv4Mask mask ("/17");
+  uint32_t base = Prefix (router) + LAN;
+  Ipv4Address gateway (base + 1);
+  AddInterface (devices.Get (0), gateway, mask);
+  Ipv4StaticRoutingHelper routing;
+  for (uint32_t j = begin; j < end; j++)
+    {
+      Ipv4Address address (base + 2 + j - begin);
+      uint32_t interface = AddInterface (devices.Get (1 + j - begin), address, mask);
+      routing.GetStaticRouting (m_clients.Get (j)->GetObject<Ipv4> ())->SetDefaultRoute (gateway, interface);
+      m_clientAddresses.push_back (address);
+    }
+}
+
+void
+AmTopologyHelper::PopulateRoutes (void)
+{
+  Ipv4StaticRoutingHelper routing;
+  Ipv4Mask mask ("/16");
+  uint32_t routers = m_routers.GetN ();
+  for (uint32_t r = 0; r < routers; r++)
+    {
+      // breadth first from r, each router reached through the first hop
+      std::vector<int32_t> firstHop (routers, -1);
+      std::deque<uint32_t> next;
+      for (uint32_t i = 0; i < m_adjacency[r].size (); i++)
+        {
+          uint32_t n = m_adjacency[r][i].router;
+          if (firstHop[n] < 0)
+            {
+              firstHop[n] = i;
+              next.push_back (n);
+            }
+        }
+      firstHop[r] = 0;
+      while (!next.empty ())
+        {
+          uint32_t current = next.front ();
+          next.pop_front ();
+          for (uint32_t i = 0; i < m_adjacency[current].size (); i++)
+            {
+              uint32_t n = m_adjacency[current][i].router;
+              if (firstHop[n] < 0)
+                {
+                  firstHop[n] = firstHop[current];
+                  next.push_back (n);
+                }
+            }
+        }
+
+      Ptr<Ipv4StaticRouting> table = routing.GetStaticRouting (m_routers.Get (r)->GetObject<Ipv4> ());
+      for (uint32_t s = 0; s < routers; s++)
+        {
+          if (s == r || firstHop[s] < 0)
+            {
+              continue;
+            }
+          const Adjacency &hop = m_adjacency[r][firstHop[s]];
+          table->AddNetworkRouteTo (Ipv4Address (Prefix (s)), mask, hop.gateway, hop.interface);
+        }
+    }
+}
+
+uint32_t
+AmTopologyHelper::Prefix (uint32_t router)
+{
+  return (10 << 24) | ((router + 1) << 16);
+}
+
+NodeContainer
+AmTopologyHelper::GetRouters (void) const
+{
+  return m_routers;
+}
+
+NodeContainer
+AmTopologyHelper::GetServers (void) const
+{
+  return m_servers;
+}
+
+NodeContainer
+AmTopologyHelper::GetClients (void) const
+{
+  return m_clients;
+}
+
+Ipv4Address
+AmTopologyHelper::GetServerAddress (uint32_t i) const
+{
+  NS_ASSERT (i < m_serverAddresses.size ());
+  return m_serverAddresses[i];
+}
+
+std::vector<Address>
+AmTopologyHelper::GetServerAddresses (void) const
+{
+  std::vector<Address> addresses;
+  for (uint32_t i = 0; i < m_serverAddresses.size (); i++)
+    {
+      addresses.push_back (m_serverAddresses[i]);
+    }
+  return addresses;
+}
+
+Ipv4Address
+AmTopologyHelper::GetClientAddress (uint32_t i) const
+{
+  NS_ASSERT (i < m_clientAddresses.size ());
+  return m_clientAddresses[i];
+}
+
+std::vector<NetDeviceContainer>
+AmTopologyHelper::GetLinks (void) const
+{
+  std::vector<NetDeviceContainer> links (m_routerLinks);
+  links.insert (links.end (), m_serverLinks.begin (), m_serverLinks.end ());
+  links.insert (links.end (), m_clientLinks.begin (), m_clientLinks.end ());
+  return links;
+}
+
+} // namespace ns3
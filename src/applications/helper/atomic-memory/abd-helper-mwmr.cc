@@ -22,6 +22,9 @@
 #include "ns3/abd-server-mwmr.h"
 #include "ns3/abd-client-mwmr.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/names.h"
 
 namespace ns3 {
@@ -109,6 +112,41 @@ AbdClientHelperMWMR::SetServers (Ptr<Application> app, std::vector<Address> serv
   app->GetObject<AbdClientMWMR>()->SetServers (serverIps);
 }
 
+void
+AbdClientHelperMWMR::SetKeyDistribution (uint32_t numKeys, AmKeySelector::Distribution dist, double alpha)
+{
+  m_factory.Set ("NumKeys", UintegerValue (numKeys));
+  m_factory.Set ("KeyDistribution", EnumValue (dist));
+  m_factory.Set ("ZipfAlpha", DoubleValue (alpha));
+}
+
+void
+AbdClientHelperMWMR::SetWorkload (AmWorkload::Arrival arrival, double rate, std::string traceFile)
+{
+  m_factory.Set ("Workload", EnumValue (arrival));
+  m_factory.Set ("ArrivalRate", DoubleValue (rate));
+  m_factory.Set ("TraceFile", StringValue (traceFile));
+}
+
+int64_t
+AbdClientHelperMWMR::AssignStreams (NodeContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNApplications (); j++)
+        {
+          Ptr<AbdClientMWMR> client = DynamicCast<AbdClientMWMR> (node->GetApplication (j));
+          if (client)
+            {
+              currentStream += client->AssignStreams (currentStream);
+            }
+        }
+    }
+  return (currentStream - stream);
+}
+
 void
 AbdClientHelperMWMR::SetFill (Ptr<Application> app, std::string fill)
 {
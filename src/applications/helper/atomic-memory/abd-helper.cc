@@ -22,6 +22,9 @@
 #include "ns3/abd-server.h"
 #include "ns3/abd-client.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/names.h"
 
 namespace ns3 {
@@ -40,6 +43,13 @@ AbdServerHelper::SetAttribute (
   m_factory.Set (name, value);
 }
 
+void
+AbdServerHelper::SetMulticastGroup (Ipv4Address group)
+{
+  m_factory.Set ("Transport", EnumValue (TRANSPORT_UDP));
+  m_factory.Set ("MulticastGroup", AddressValue (group));
+}
+
 ApplicationContainer
 AbdServerHelper::Install (Ptr<Node> node) const
 {
@@ -103,6 +113,48 @@ AbdClientHelper::SetServers (Ptr<Application> app, std::vector<Address> serverIp
   app->GetObject<AbdClient>()->SetServers (serverIps);
 }
 
+void
+AbdClientHelper::SetMulticastGroup (Ipv4Address group)
+{
+  m_factory.Set ("Transport", EnumValue (TRANSPORT_UDP));
+  m_factory.Set ("MulticastGroup", AddressValue (group));
+}
+
+void
+AbdClientHelper::SetKeyDistribution (uint32_t numKeys, AmKeySelector::Distribution dist, double alpha)
+{
+  m_factory.Set ("NumKeys", UintegerValue (numKeys));
+  m_factory.Set ("KeyDistribution", EnumValue (dist));
+  m_factory.Set ("ZipfAlpha", DoubleValue (alpha));
+}
+
+void
+AbdClientHelper::SetWorkload (AmWorkload::Arrival arrival, double rate, std::string traceFile)
+{
+  m_factory.Set ("Workload", EnumValue (arrival));
+  m_factory.Set ("ArrivalRate", DoubleValue (rate));
+  m_factory.Set ("TraceFile", StringValue (traceFile));
+}
+
+int64_t
+AbdClientHelper::AssignStreams (NodeContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNApplications (); j++)
+        {
+          Ptr<AbdClient> client = DynamicCast<AbdClient> (node->GetApplication (j));
+          if (client)
+            {
+              currentStream += client->AssignStreams (currentStream);
+            }
+        }
+    }
+  return (currentStream - stream);
+}
+
 void
 AbdClientHelper::SetFill (Ptr<Application> app, std::string fill)
 {
@@ -26,6 +26,8 @@
 #include "ns3/object-factory.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
+#include "ns3/am-key-selector.h"
+#include "ns3/am-workload.h"
 
 namespace ns3 {
 
@@ -53,6 +55,15 @@ public:
    */
   void SetAttribute (std::string name, const AttributeValue &value);
 
+  /**
+   * Make the AbdServer applications join a multicast group, so that the
+   * clients can send each round once to the group. Switches the servers to
+   * the Udp transport; the multicast routes are left to the topology.
+   *
+   * \param group the IPv4 multicast group
+   */
+  void SetMulticastGroup (Ipv4Address group);
+
   /**
    * Create a AbdServerApplication on the specified Node.
    *
@@ -148,6 +159,47 @@ public:
    */
   void SetServers (Ptr<Application> app, std::vector<Address> serverIps);
 
+  /**
+   * Make the AbdClient applications send each round once to a multicast
+   * group the servers joined, instead of once per server. Switches the
+   * clients to the Udp transport; the replies and the retransmissions
+   * stay unicast.
+   *
+   * \param group the IPv4 multicast group
+   */
+  void SetMulticastGroup (Ipv4Address group);
+
+  /**
+   * Set the key space of the AbdClient applications and the distribution
+   * of the keys their operations access.
+   *
+   * \param numKeys the number of keys (registers)
+   * \param dist the distribution of the accessed keys
+   * \param alpha the exponent of the zipf distribution
+   */
+  void SetKeyDistribution (uint32_t numKeys, AmKeySelector::Distribution dist, double alpha = 1.0);
+
+  /**
+   * Set the arrival process of the operations of the AbdClient applications.
+   *
+   * \param arrival the arrival process
+   * \param rate the mean number of operations per second of Poisson arrivals
+   * \param traceFile the file of arrival times replayed by trace arrivals
+   */
+  void SetWorkload (AmWorkload::Arrival arrival, double rate = 1.0, std::string traceFile = "");
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by the AbdClient applications installed on the nodes, so that each
+   * client draws its keys and arrivals from its own stream.
+   *
+   * \param c NodeContainer of the set of nodes for which the AbdClient
+   *          should be modified to use a fixed stream
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this helper
+   */
+  int64_t AssignStreams (NodeContainer c, int64_t stream);
+
   /**
    * Given a pointer to a AbdClient application, set the data fill of the
    * packet (what is sent as data to the server) to the contents of the fill
@@ -22,6 +22,9 @@
 #include "ns3/cchybrid-server.h"
 #include "ns3/cchybrid-client.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/names.h"
 
 namespace ns3 {
@@ -103,6 +106,41 @@ CCHybridClientHelper::SetServers (Ptr<Application> app, std::vector<Address> ser
   app->GetObject<CCHybridClient>()->SetServers (serverIps);
 }
 
+void
+CCHybridClientHelper::SetKeyDistribution (uint32_t numKeys, AmKeySelector::Distribution dist, double alpha)
+{
+  m_factory.Set ("NumKeys", UintegerValue (numKeys));
+  m_factory.Set ("KeyDistribution", EnumValue (dist));
+  m_factory.Set ("ZipfAlpha", DoubleValue (alpha));
+}
+
+void
+CCHybridClientHelper::SetWorkload (AmWorkload::Arrival arrival, double rate, std::string traceFile)
+{
+  m_factory.Set ("Workload", EnumValue (arrival));
+  m_factory.Set ("ArrivalRate", DoubleValue (rate));
+  m_factory.Set ("TraceFile", StringValue (traceFile));
+}
+
+int64_t
+CCHybridClientHelper::AssignStreams (NodeContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNApplications (); j++)
+        {
+          Ptr<CCHybridClient> client = DynamicCast<CCHybridClient> (node->GetApplication (j));
+          if (client)
+            {
+              currentStream += client->AssignStreams (currentStream);
+            }
+        }
+    }
+  return (currentStream - stream);
+}
+
 void
 CCHybridClientHelper::SetFill (Ptr<Application> app, std::string fill)
 {
@@ -0,0 +1,184 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
+ */
+#include "coded-abd-helper.h"
+
+#include "ns3/coded-abd-server.h"
+#include "ns3/coded-abd-client.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/names.h"
+
+namespace ns3 {
+
+CodedAbdServerHelper::CodedAbdServerHelper (uint16_t port)
+{
+  m_factory.SetTypeId (CodedAbdServer::GetTypeId ());
+  SetAttribute ("Port", UintegerValue (port));
+}
+
+void 
+CodedAbdServerHelper::SetAttribute (
+  std::string name, 
+  const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+CodedAbdServerHelper::Install (Ptr<Node> node) const
+{
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+CodedAbdServerHelper::Install (std::string nodeName) const
+{
+  Ptr<Node> node = Names::Find<Node> (nodeName);
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+CodedAbdServerHelper::Install (NodeContainer c) const
+{
+  ApplicationContainer apps;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      apps.Add (InstallPriv (*i));
+    }
+
+  return apps;
+}
+
+Ptr<Application>
+CodedAbdServerHelper::InstallPriv (Ptr<Node> node) const
+{
+  Ptr<Application> app = m_factory.Create<CodedAbdServer> ();
+  node->AddApplication (app);
+
+  return app;
+}
+
+CodedAbdClientHelper::CodedAbdClientHelper (Address address, uint16_t port)
+{
+  m_factory.SetTypeId (CodedAbdClient::GetTypeId ());
+  SetAttribute ("LocalAddress", AddressValue (address));
+  SetAttribute ("RemotePort", UintegerValue (port) );
+}
+
+CodedAbdClientHelper::CodedAbdClientHelper (Ipv4Address address, uint16_t port)
+{
+  m_factory.SetTypeId (CodedAbdClient::GetTypeId ());
+  SetAttribute ("LocalAddress", AddressValue (Address(address)));
+  SetAttribute ("RemotePort", UintegerValue (port) );
+}
+
+
+void 
+CodedAbdClientHelper::SetAttribute (
+  std::string name, 
+  const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+void
+CodedAbdClientHelper::SetServers (Ptr<Application> app, std::vector<Address> serverIps)
+{
+  app->GetObject<CodedAbdClient>()->SetServers (serverIps);
+}
+
+void
+CodedAbdClientHelper::SetKeyDistribution (uint32_t numKeys, AmKeySelector::Distribution dist, double alpha)
+{
+  m_factory.Set ("NumKeys", UintegerValue (numKeys));
+  m_factory.Set ("KeyDistribution", EnumValue (dist));
+  m_factory.Set ("ZipfAlpha", DoubleValue (alpha));
+}
+
+void
+CodedAbdClientHelper::SetWorkload (AmWorkload::Arrival arrival, double rate, std::string traceFile)
+{
+  m_factory.Set ("Workload", EnumValue (arrival));
+  m_factory.Set ("ArrivalRate", DoubleValue (rate));
+  m_factory.Set ("TraceFile", StringValue (traceFile));
+}
+
+int64_t
+CodedAbdClientHelper::AssignStreams (NodeContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNApplications (); j++)
+        {
+          Ptr<CodedAbdClient> client = DynamicCast<CodedAbdClient> (node->GetApplication (j));
+          if (client)
+            {
+              currentStream += client->AssignStreams (currentStream);
+            }
+        }
+    }
+  return (currentStream - stream);
+}
+
+void
+CodedAbdClientHelper::SetFill (Ptr<Application> app, std::string fill)
+{
+  app->GetObject<CodedAbdClient>()->SetFill (fill);
+}
+
+ApplicationContainer
+CodedAbdClientHelper::Install (Ptr<Node> node) const
+{
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+CodedAbdClientHelper::Install (std::string nodeName) const
+{
+  Ptr<Node> node = Names::Find<Node> (nodeName);
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+CodedAbdClientHelper::Install (NodeContainer c) const
+{
+  ApplicationContainer apps;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      apps.Add (InstallPriv (*i));
+    }
+
+  return apps;
+}
+
+Ptr<Application>
+CodedAbdClientHelper::InstallPriv (Ptr<Node> node) const
+{
+  Ptr<Application> app = m_factory.Create<CodedAbdClient> ();
+  node->AddApplication (app);
+
+  return app;
+}
+
+} // namespace ns3
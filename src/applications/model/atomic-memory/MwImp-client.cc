@@ -29,8 +29,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
 #include "MwImp-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <string>
 #include <cstdlib>
 #include <iostream>
@@ -98,7 +103,7 @@ MwImpClient::GetTypeId (void)
 					UintegerValue (9),
 					MakeUintegerAccessor (&MwImpClient::m_port),
 					MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&MwImpClient::SetDataSize,
                                          &MwImpClient::GetDataSize),
@@ -106,6 +111,9 @@ MwImpClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&MwImpClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&MwImpClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -131,6 +139,39 @@ MwImpClient::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&MwImpClient::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&MwImpClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&MwImpClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&MwImpClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&MwImpClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&MwImpClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&MwImpClient::m_traceFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -142,7 +183,6 @@ MwImpClient::MwImpClient ()
 {
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -187,7 +227,32 @@ MwImpClient::StartApplication (void)
 {
 
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
+
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&MwImpClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&MwImpClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	m_workload.SetMaxInFlight (1);
 
 	// seed pseudo-randomness
 	srand(m_seed);
@@ -237,9 +302,7 @@ MwImpClient::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -259,19 +322,35 @@ MwImpClient::StartApplication (void)
 	}
 
 	
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
 
 }
 
+AmClientStats
+MwImpClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_completeOps;
+	if (m_prType == READER)
+	{
+		stats.slowReads = m_slowOpCount;
+		stats.fastReads = m_fastOpCount;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
+}
+
 void 
 MwImpClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
   if (m_insocket != 0)
 	{
 		m_insocket->Close ();
@@ -300,26 +379,23 @@ MwImpClient::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-  	  sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
-  if(m_personalID==m_numClients-1){
-  	exit(0);
-  }
-  Simulator::Cancel (m_sendEvent);
+  m_workload.Stop ();
 }
 
 void
 MwImpClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
   Application::DoDispose ();
 }
 
@@ -329,6 +405,7 @@ MwImpClient::DoDispose (void)
 void MwImpClient::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void MwImpClient::HandlePeerError (Ptr<Socket> socket)
@@ -356,24 +433,20 @@ void MwImpClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
 void MwImpClient::ConnectionFailed (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
-  std::stringstream sstm;
-  sstm << "Connection to SERVER Failed.";
-  LogInfo(sstm);
+  AM_LOG_INFO ("Connection to SERVER Failed.");
 }
 
 /**************************************************************************************
@@ -391,6 +464,14 @@ MwImpClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+MwImpClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  return streams + m_keys.AssignStreams (stream + streams);
+}
+
 void
 MwImpClient::SetRemote (Address ip, uint16_t port)
 {
@@ -434,57 +515,48 @@ MwImpClient::SetFill (std::string fill)
 
   if (dataSize != m_dataSize)
     {
+      delete [] m_data;
       m_data = new uint8_t [dataSize];
       m_dataSize = dataSize;
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
-  m_size = dataSize;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-MwImpClient::ScheduleOperation (Time dt)
+/**************************************************************************************
+ * MwImp Read/Write Handlers
+ **************************************************************************************/
+void
+MwImpClient::SelectKey (void)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this);
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+	// park the state of the current key and load the one of the next key
+	Register &reg = m_registers.Get (m_key);
+	reg.ts = m_ts;
+	reg.value = m_value;
+	reg.id = m_id;
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	m_key = m_keys.GetNext ();
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &MwImpClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &MwImpClient::InvokeWrite, this);
-  }
+	Register &next = m_registers.Get (m_key);
+	m_ts = next.ts;
+	m_value = next.value;
+	m_id = next.id;
 }
 
-/**************************************************************************************
- * MwImp Read/Write Handlers
- **************************************************************************************/
 void
 MwImpClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 	m_opStart = Now();
 	m_real_start = std::chrono::system_clock::now();
 
 	//check if we still have operations to perfrom
 	if ( m_opCount <  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
@@ -505,9 +577,7 @@ MwImpClient::InvokeRead (void)
 		//Send msg to all
 		m_replies = 0;		//reset replies
 		
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
 	}
 }
@@ -516,7 +586,6 @@ void
 MwImpClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -526,10 +595,13 @@ MwImpClient::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = WRITE;
 		m_readop ++;
+		m_payload = Create<Packet> (m_size);
 
 		m_MINts = 10000000;
 		m_MINId = 10000000;
@@ -545,9 +617,7 @@ MwImpClient::InvokeWrite (void)
 		//Send msg to all
 		m_replies = 0;		//reset replies
 		
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
 	}
 }
@@ -557,10 +627,9 @@ MwImpClient::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT (m_sendEvent.IsExpired ());
-
   // Prepare packet content
-  std::stringstream pkts;
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
   std::string message_type;
   
   // Serialize the appropriate message for READ or WRITE
@@ -568,29 +637,19 @@ MwImpClient::HandleSend (void)
   // serialize <msgType, ts, id, value, readop ,counter>
   if (m_msgType == READ)
     {	
-		pkts << READ << " " << m_readop;
+		hdr.SetType (READ);
+		hdr.SetCounter (m_readop);
 		message_type = "read";
     }
     else if (m_msgType == WRITE)
     {
-		pkts << WRITE << " " << m_readop;
+		hdr.SetType (WRITE);
+		hdr.SetCounter (m_readop);
 		message_type = "write";
     }
 
-  SetFill(pkts.str());
-
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "MwImpClient::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "MwImpClient::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // Create packet, the writes carry the bytes of the value
+  Ptr<Packet> p = m_framer.Build (hdr, m_msgType == WRITE ? m_payload : 0);
 
 	//random server to start from
   int current = rand()%m_serverAddress.size();
@@ -604,10 +663,8 @@ MwImpClient::HandleSend (void)
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
-		  << " port " << m_peerPort << " data " << pkts.str();
-		  LogInfo ( sstm );
+		  AM_LOG_INFO ("Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
+		  << " port " << m_peerPort << " data " << hdr);
 	  }
 	  // move to the next server
       current = (current+1)%m_serverAddress.size();
@@ -621,36 +678,32 @@ MwImpClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  uint32_t msgT, msgTs, msgId, msgV, msgOp;
+  AmProtocolHeader hdr;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
 	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgT; 
-	  std::stringstream sstm;
+	  packet->RemoveHeader (hdr);
+	  MessageType msgT = hdr.GetType ();
+	  uint32_t msgTs = hdr.GetTs ();
+	  uint32_t msgId = hdr.GetId ();
+	  uint32_t msgV = hdr.GetValue ();
+	  uint32_t msgOp = hdr.GetCounter ();
 	  std::string message_type;
 
 	  if (msgT==READACK){
 			message_type = "readAck";
-			istm >> msgTs >> msgId >> msgV >> msgOp;
 	  }else if (msgT==WRITEACK){
 			message_type = "writeAck";
-			istm >> msgTs >> msgId >> msgV >> msgOp;
 	  }
 	  
 
 	 
 	 if (m_verbose)
 	  {
-		  sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
+		  AM_LOG_INFO ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << buf;
-		  LogInfo (sstm);
+				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << hdr);
 	  }
 
       // check message freshness and if client is waiting
@@ -667,8 +720,6 @@ MwImpClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val,
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-
 	//increment the number of replies received
 	m_replies ++;
 
@@ -684,15 +735,14 @@ MwImpClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val,
 
       		m_opEnd = Now();
       		m_opAve += m_opEnd - m_opStart;
+      		m_opCompletedTrace (WRITE, 3, m_opEnd - m_opStart, m_ts, m_key, m_personalID);
       		m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 			m_real_opAve += elapsed_seconds;  //
 
    			m_opStatus = IDLE;
-			ScheduleOperation (m_interval);
-      		AsmCommon::Reset(sstm);
-			sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">) - @ 3 EXCH **";
-			LogInfo(sstm);
+			m_workload.OperationCompleted ();
+			AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">) - @ 3 EXCH **");
 			m_replies =0;
 		}
 	}
@@ -710,15 +760,14 @@ MwImpClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val,
 
       		m_opEnd = Now();
       		m_opAve += m_opEnd - m_opStart;
+      		m_opCompletedTrace (READ, 3, m_opEnd - m_opStart, m_MINts, m_key, m_MINId);
       		m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 			m_real_opAve += elapsed_seconds;  //
 
    			m_opStatus = IDLE;
-			ScheduleOperation (m_interval);
-      		AsmCommon::Reset(sstm);
-			sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">) - @ 3 EXCH **";
-			LogInfo(sstm);
+			m_workload.OperationCompleted ();
+			AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">) - @ 3 EXCH **");
 			m_replies =0;
 		}
 	}
@@ -30,7 +30,12 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/enum.h"
 #include "MwImp-server.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
  #include <algorithm>
 
 namespace ns3 {
@@ -81,6 +86,36 @@ MwImpServer::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&MwImpServer::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("ServiceCores",
+					 "Messages processed at the same time, 0 to process every message on arrival",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&MwImpServer::m_serviceCores),
+					 MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("ServiceTime",
+					 "The processing time of a message, in seconds",
+					 StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"),
+					 MakePointerAccessor (&MwImpServer::m_serviceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("ServiceTimePerItem",
+					 "The processing time added per server a message is relayed to",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&MwImpServer::m_servicePerItem),
+					 MakeTimeChecker ())
+					.AddAttribute ("Fault",
+					 "The fault of the server: None, Crash (the messages received are lost) or Pause (they are held until the fault ends)",
+					 EnumValue (AmServiceQueue::NONE),
+					 MakeEnumAccessor (&MwImpServer::SetFault, &MwImpServer::GetFault),
+					 MakeEnumChecker (AmServiceQueue::NONE, "None",
+					                  AmServiceQueue::CRASH, "Crash",
+					                  AmServiceQueue::PAUSE, "Pause"))
+					.AddAttribute ("Slowdown",
+					 "The time every message received waits before it is processed",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&MwImpServer::SetSlowdown, &MwImpServer::GetSlowdown),
+					 MakeTimeChecker ())
+					.AddTraceSource ("MessageHandled", "A message was received and answered",
+					 MakeTraceSourceAccessor (&MwImpServer::m_handledTrace),
+					 "ns3::AmStatsCollector::MessageHandledCallback")
 	;
 	return tid;
 }
@@ -88,9 +123,6 @@ MwImpServer::GetTypeId (void)
 MwImpServer::MwImpServer ()
 {
 	NS_LOG_FUNCTION (this);
-	m_id = 0;
-	m_ts = 0;
-	m_value = 0;
 	m_serversConnected =0;
 	m_sent = 0;
 	//m_writeop.resize(100);   ///
@@ -102,9 +134,6 @@ MwImpServer::MwImpServer ()
 MwImpServer::~MwImpServer()
 {
 	NS_LOG_FUNCTION (this);
-	m_id = 0;
-	m_ts = 0;
-	m_value = 0;
 	m_sent = 0;
 	m_serversConnected =0;
 	//m_writeop.resize(100);
@@ -132,10 +161,14 @@ void
 MwImpServer::StartApplication (void)
 {
 	NS_LOG_FUNCTION (this);
+
+	m_service.SetCores (m_serviceCores);
+	m_service.SetServiceTime (m_serviceTime);
+	m_service.SetPerItem (m_servicePerItem);
+	m_service.SetItemsCallback (MakeCallback (&MwImpServer::GetServiceItems, this));
+	m_service.SetServedCallback (MakeCallback (&MwImpServer::HandleRead, this));
 	
-	std::stringstream sstm;
-	sstm << "Debug Mode="<< m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Debug Mode="<< m_verbose);
 
 	if (m_socket == 0)
 	{
@@ -183,9 +216,7 @@ MwImpServer::StartApplication (void)
 		{
 			if ( m_verbose )
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -207,6 +238,12 @@ MwImpServer::StartApplication (void)
 }
 
 
+uint32_t
+MwImpServer::GetSentMessages (void) const
+{
+	return m_sent;
+}
+
 void 
 MwImpServer::StopApplication ()
 {
@@ -234,16 +271,25 @@ MwImpServer::StopApplication ()
 			m_clntSocket[i]->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
 		}
 	}
-	std::stringstream sstm;
-	sstm << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **";
-	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	LogInfo(sstm);
+	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	AM_LOG_INFO ("** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **");
+	if (m_serviceCores > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" CPU: #served="<<m_service.GetServed ()<<", busyTime="<<m_service.GetBusyTime ().GetSeconds ()<<"s, AveWait="<<(m_service.GetServed () > 0 ? m_service.GetWaitTime ().GetSeconds () / m_service.GetServed () : 0)<<"s, #maxQueue="<<m_service.GetMaxQueue ()<<" **"<<std::endl;
+	}
+	if (m_service.GetDropped () > 0 || m_service.GetHeld () > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" FAULTS: #dropped="<<m_service.GetDropped ()<<", #held="<<m_service.GetHeld ()<<" **"<<std::endl;
+	}
 }
 
 void
 MwImpServer::DoDispose (void)
 {
 	NS_LOG_FUNCTION (this);
+	m_framer.Clear ();
+	m_service.Clear ();
+	m_registers.Clear ();
 	Application::DoDispose ();
 }
 
@@ -254,6 +300,7 @@ MwImpServer::DoDispose (void)
 void MwImpServer::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void MwImpServer::HandlePeerError (Ptr<Socket> socket)
@@ -285,6 +332,7 @@ void MwImpServer::HandleAccept (Ptr<Socket> s, const Address& from)
 
 	if( !isServer )
 	{
+		m_clntSlot.insert (std::make_pair (InetSocketAddress::ConvertFrom (from).GetIpv4 ().Get (), m_clntAddress.size ()));
 		m_clntAddress.push_back(std::make_pair(from, s));
 		//m_clntSocket.push_back(s);
 		m_numClients++;
@@ -292,7 +340,6 @@ void MwImpServer::HandleAccept (Ptr<Socket> s, const Address& from)
 		m_operations.resize(m_numClients);
 		m_relays.resize(m_numClients);
 
-		std::sort(m_clntAddress.begin(), m_clntAddress.end());
 
 		if (m_verbose)
 		{
@@ -313,9 +360,7 @@ void MwImpServer::HandleAccept (Ptr<Socket> s, const Address& from)
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "ACCEPTED SERVER " << serverId << ": " << InetSocketAddress::ConvertFrom(from).GetIpv4();
-			LogInfo(sstm);
+			AM_LOG_INFO ("ACCEPTED SERVER " << serverId << ": " << InetSocketAddress::ConvertFrom(from).GetIpv4());
 		}
 	}
 }
@@ -325,14 +370,12 @@ void MwImpServer::HandleAccept (Ptr<Socket> s, const Address& from)
    NS_LOG_FUNCTION (this << socket);
    Address from;
    socket->GetPeerName (from);
-   std::stringstream sstm;
 
    m_serversConnected++;
 
    if (m_verbose)
    {
-	   sstm << "Connected to NODE (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	   LogInfo(sstm);
+	   AM_LOG_INFO ("Connected to NODE (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
    }
 
    // Check if connected to the all the servers start operations
@@ -341,9 +384,7 @@ void MwImpServer::HandleAccept (Ptr<Socket> s, const Address& from)
    {
 	   if (m_verbose)
 	   {
-		   AsmCommon::Reset(sstm);
-		   sstm << "Connected to all Nodes.";
-		   LogInfo(sstm);
+		   AM_LOG_INFO ("Connected to all Nodes.");
 	   }
    }
  }
@@ -354,28 +395,41 @@ void MwImpServer::HandleAccept (Ptr<Socket> s, const Address& from)
  }
 
 /**************************************************************************************
- * PACKET DATA Handler
+ * MwImp Rcv Handler
  **************************************************************************************/
 void
-MwImpServer::SetFill (std::string fill)
+MwImpServer::SetFault (AmServiceQueue::Fault fault)
+{
+	NS_LOG_FUNCTION (this << fault);
+	m_service.SetFault (fault);
+}
+
+AmServiceQueue::Fault
+MwImpServer::GetFault (void) const
 {
-  NS_LOG_FUNCTION (this << fill);
+	return m_service.GetFault ();
+}
 
-  uint32_t dataSize = fill.size () + 1;
+uint32_t
+MwImpServer::GetServiceItems (const AmProtocolHeader &hdr) const
+{
+	// the reads and the writes of the clients are relayed to every server
+	return (hdr.GetType () == READ || hdr.GetType () == WRITE)? m_serverAddress.size () : 0;
+}
 
-  if (dataSize != m_dataSize) 
-    {
-      m_data = new uint8_t [dataSize];
-      m_dataSize = dataSize;
-    }
+void
+MwImpServer::SetSlowdown (Time delay)
+{
+	NS_LOG_FUNCTION (this << delay);
+	m_service.SetSlowdown (delay);
+}
 
-  memcpy (m_data, fill.c_str (), dataSize);
-  m_size = dataSize;
+Time
+MwImpServer::GetSlowdown (void) const
+{
+	return m_service.GetSlowdown ();
 }
 
-/**************************************************************************************
- * MwImp Rcv Handler
- **************************************************************************************/
 void 
 MwImpServer::HandleRead (Ptr<Socket> socket)
 {
@@ -384,21 +438,17 @@ MwImpServer::HandleRead (Ptr<Socket> socket)
 
 	Ptr<Packet> packet;
 	Address from;
-	uint32_t msgT;
-	std::stringstream sstm;
+	AmProtocolHeader hdr;
 	std::string message_type = "";
 
 
-	while ((packet = socket->RecvFrom (from)))
+	while ((packet = m_service.Recv (m_framer, socket, from)))
 	{
 
 		//deserialize the contents of the packet
-		uint8_t buf[1024];
-		packet->CopyData(buf,1024);
-		std::stringbuf sb;
-		sb.str(std::string((char*) buf));
-		std::istream istm(&sb);
-		istm >> msgT;
+		packet->RemoveHeader (hdr);
+		uint32_t sent = m_sent;
+		MessageType msgT = hdr.GetType ();
 
 
 		if (msgT==WRITE){
@@ -411,54 +461,59 @@ MwImpServer::HandleRead (Ptr<Socket> socket)
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
+			AM_LOG_INFO ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-			LogInfo(sstm);
+					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 		}
 
 
 		if ( msgT == WRITE || msgT == READ || msgT==DISCOVER )
 		{
-			HandleRecvMsg(istm, socket, (MessageType) msgT);
+			HandleRecvMsg(hdr, packet, socket, msgT);
 		}
 		else if ( msgT == READRELAY)
 		{
-			HandleRelay(istm, socket);
+			HandleRelay(hdr, packet, socket);
 		}
 		else
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Invalid message type! Message from " << InetSocketAddress::ConvertFrom (from).GetIpv4 () << " dropped.";
-			LogInfo(sstm );
+			AM_LOG_INFO ("Invalid message type! Message from " << InetSocketAddress::ConvertFrom (from).GetIpv4 () << " dropped.");
 		}
+
+		m_handledTrace (msgT, m_sent - sent);
 	}
 }
 
 
+int
+MwImpServer::FindClient (Ipv4Address ip) const
+{
+	std::unordered_map<uint32_t, uint32_t>::const_iterator it = m_clntSlot.find (ip.Get ());
+	if (it == m_clntSlot.end ())
+	{
+		return -1;
+	}
+	return it->second;
+}
+
 void
-MwImpServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType msgT)
+MwImpServer::HandleRecvMsg(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket, MessageType msgT)
 {
 	Address from;
-	uint32_t msgTs, msgV, msgId, msgOp;
+	uint32_t msgTs = hdr.GetTs ();
+	uint32_t msgV = hdr.GetValue ();
+	uint32_t msgId = hdr.GetId ();
+	uint32_t msgOp = hdr.GetCounter ();
 	int msgSenderID = -1;
-	std::stringstream sstm;
 	std::string message_response_type = "";
-	std::stringstream pkts;
 	std::string reply_type = "";
 
 	socket->GetPeerName(from);
 
-	//find if the socket that client is connected to
-	for (uint32_t i=0; i < m_clntAddress.size(); i++)
-	{
-		if ( InetSocketAddress::ConvertFrom(from).GetIpv4() == InetSocketAddress::ConvertFrom(m_clntAddress[i].first).GetIpv4() )
-		{
-			msgSenderID = i;
-			break;	//stop at the first client we find
-		}
-	}
+	Register &reg = m_registers.Get (hdr.GetKey ());
+
+	//find the client that sent the message
+	msgSenderID = FindClient (InetSocketAddress::ConvertFrom(from).GetIpv4());
 
 	// if not sender detected - drop the package
 	if ( ( msgSenderID >= 0 && msgSenderID < (int) m_clntAddress.size() ))
@@ -466,42 +521,30 @@ MwImpServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 		//// CASE WRITER 1st PHASE
 		if (msgT==DISCOVER){
 
-			//Get the message
-			istm >> msgOp;
-
 			//AsmCommon::Reset(sstm);
-			//sstm << "GOT DISCOVER WITH MSGOP "<<msgOp << " my TS: "<<m_ts;
+			//sstm << "GOT DISCOVER WITH MSGOP "<<msgOp << " my TS: "<<reg.ts;
 			//LogInfo(sstm);
 
 			message_response_type = "discoverAck";
 			NS_LOG_LOGIC ("Updating Local Info");
 
-			AsmCommon::Reset(pkts);
-			pkts << DISCOVERACK << " " << m_ts << " "<<msgOp;
-			SetFill(pkts.str());
+			AmProtocolHeader reply;
 
-			Ptr<Packet> p;
-			if (m_dataSize)
-			{
-				NS_ASSERT_MSG (m_dataSize == m_size, "MwImpServer::HandleSend(): m_size and m_dataSize inconsistent");
-				NS_ASSERT_MSG (m_data, "MwImpServer::HandleSend(): m_dataSize but no m_data");
-				p = Create<Packet> (m_data, m_dataSize);
-			}
-			else
-			{
-				p = Create<Packet> (m_size);
-			}
+			reply.SetKey (hdr.GetKey ());
+			reply.SetType (DISCOVERACK);
+			reply.SetTs (reg.ts);
+			reply.SetCounter (msgOp);
+
+			Ptr<Packet> p = m_framer.Build (reply);
 
 			socket->Send (p);
 			m_sent++; //count the sent messages
 
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Sent "<< message_response_type <<" " << p->GetSize () << " bytes to " <<
+				AM_LOG_INFO ("Sent "<< message_response_type <<" " << p->GetSize () << " bytes to " <<
 						InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-						InetSocketAddress::ConvertFrom (from).GetPort ();
-				LogInfo(sstm);
+						InetSocketAddress::ConvertFrom (from).GetPort ());
 			}
 
 			p->RemoveAllPacketTags ();
@@ -509,49 +552,39 @@ MwImpServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 		}
 		else if (msgT==DISCOVER)
 		{
-			//Get the message
-			istm >> msgTs >> msgId >> msgV >> msgOp;
 			message_response_type = "writeAck";
 			
 
-			if (((m_ts < msgTs) || ((m_ts == msgTs)&&(m_id < msgId))))
+			if (((reg.ts < msgTs) || ((reg.ts == msgTs)&&(reg.id < msgId))))
 			{
 				NS_LOG_LOGIC ("Updating Local Info");
-				m_ts = msgTs;
-				m_value = msgV;
-				m_id = msgId;
+				reg.ts = msgTs;
+				reg.value = msgV;
+				reg.payload = payload;
+				reg.id = msgId;
 			}
 
 			NS_LOG_LOGIC ("Echoing packet");
 			// Prepare packet content
 			// serialize <msgType, ts, id, value, msgOp ,counter>
-			AsmCommon::Reset(pkts);
-			pkts << WRITEACK << " " << m_ts << " " << m_id << " " << m_value << " " << msgOp;
-			SetFill(pkts.str());
-
-
-			Ptr<Packet> p;
-		  		if (m_dataSize)
-		    	{
-		      		NS_ASSERT_MSG (m_dataSize == m_size, "MwImpServer::HandleSend(): m_size and m_dataSize inconsistent");
-		      		NS_ASSERT_MSG (m_data, "MwImpServer::HandleSend(): m_dataSize but no m_data");
-		      		p = Create<Packet> (m_data, m_dataSize);
-		    	}
-		  		else
-		   		{
-		    		p = Create<Packet> (m_size);
-		    	}
+			AmProtocolHeader reply;
+			reply.SetKey (hdr.GetKey ());
+			reply.SetType (WRITEACK);
+			reply.SetTs (reg.ts);
+			reply.SetId (reg.id);
+			reply.SetValue (reg.value);
+			reply.SetCounter (msgOp);
+
+			Ptr<Packet> p = m_framer.Build (reply);
 
 		  	socket->Send (p);
 		  	m_sent++;
 
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Sent "<< message_response_type <<" " << p->GetSize () << " bytes to " <<
+				AM_LOG_INFO ("Sent "<< message_response_type <<" " << p->GetSize () << " bytes to " <<
 						InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-						InetSocketAddress::ConvertFrom (from).GetPort ();
-				LogInfo(sstm);
+						InetSocketAddress::ConvertFrom (from).GetPort ());
 			}
 			p->RemoveAllPacketTags ();
 			p->RemoveAllByteTags ();
@@ -559,29 +592,23 @@ MwImpServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 		}
 		else if ((msgT==READ) || (msgT==WRITE))
 		{
-			istm >> msgOp;
 			message_response_type = "readRelay";
 
 			int ipSize = from.GetSerializedSize();
 			uint8_t ipBuffer[ipSize];
 			from.CopyTo(ipBuffer);
 
-			AsmCommon::Reset(pkts);
-			pkts << READRELAY << " " << m_ts << " " << m_id << " " << m_value << " " << msgSenderID << " " << msgOp;
+			AmProtocolHeader relay;
 
-			SetFill(pkts.str());
+			relay.SetKey (hdr.GetKey ());
+			relay.SetType (READRELAY);
+			relay.SetTs (reg.ts);
+			relay.SetId (reg.id);
+			relay.SetValue (reg.value);
+			relay.SetSender (InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4().Get());
+			relay.SetCounter (msgOp);
 
-			Ptr<Packet> pc;
-			if (m_dataSize)
-			{
-				NS_ASSERT_MSG (m_dataSize == m_size, "MwImpServer::HandleSend(): m_size and m_dataSize inconsistent");
-				NS_ASSERT_MSG (m_data, "MwImpServer::HandleSend(): m_dataSize but no m_data");
-				pc = Create<Packet> (m_data, m_dataSize);
-			}
-			else
-			{
-				pc = Create<Packet> (m_size);
-			}
+			Ptr<Packet> pc = m_framer.Build (relay, reg.payload);
 
 			//Send a single packet to each server
 			for (uint32_t i=0; i<m_serverAddress.size(); i++)
@@ -590,9 +617,7 @@ MwImpServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 
 				if (m_verbose)
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Sending ReadRelay to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << ", Read from: " << InetSocketAddress::ConvertFrom(from).GetIpv4();
-					LogInfo ( sstm );
+					AM_LOG_INFO ("Sending ReadRelay to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << ", Read from: " << InetSocketAddress::ConvertFrom(from).GetIpv4());
 				}
 
 				if (m_serverAddress[i] != m_myAddress)
@@ -601,9 +626,7 @@ MwImpServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 
 					if (m_verbose)
 					{
-						AsmCommon::Reset(sstm);
-						sstm << "Sent "<< message_response_type << " " << pc->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << " data " << pkts.str();
-						LogInfo ( sstm );
+						AM_LOG_INFO ("Sent "<< message_response_type << " " << pc->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << " data " << relay);
 					}
 				}
 			}
@@ -613,39 +636,39 @@ MwImpServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 
 
 void
-MwImpServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
+MwImpServer::HandleRelay(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket)
 {
-	uint32_t msgT, msgTs, msgId, msgV, msgOp; //, msgIpSize;
-	int msgSenderID = -1;
-	std::stringstream sstm;
+	uint32_t msgTs = hdr.GetTs ();
+	uint32_t msgId = hdr.GetId ();
+	uint32_t msgV = hdr.GetValue ();
+	uint32_t msgOp = hdr.GetCounter ();
+	int msgSenderID = FindClient (Ipv4Address (hdr.GetSender ()));
 	std::string message_type = "";
 	std::string message_response_type = "";
-	std::stringstream pkts;
 	Address from;
 
 	socket->GetPeerName(from);
 
-	istm >> msgTs >> msgId >> msgV >> msgSenderID >> msgOp;
+	Register &reg = m_registers.Get (hdr.GetKey ());
 
 	if (m_verbose)
 	{
-		AsmCommon::Reset(sstm);
-		sstm << "Processing ReadRelay from " << InetSocketAddress::ConvertFrom(from).GetIpv4() <<": InitiatorIp= "
-				<< InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4() << " InitiatorID=" << msgSenderID << ", msgOp=" << msgOp;
-		LogInfo(sstm );
+		AM_LOG_INFO ("Processing ReadRelay from " << InetSocketAddress::ConvertFrom(from).GetIpv4() <<": InitiatorIp= "
+				<< InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4() << " InitiatorID=" << msgSenderID << ", msgOp=" << msgOp);
 	}
 
 	//Drop the package if not valid
 	if ( msgSenderID >= 0 && msgSenderID < (int) m_clntAddress.size() )
 	{
 
-		if ((m_ts < msgTs) || ((m_ts == msgTs)&&(m_id<msgId)))
+		if ((reg.ts < msgTs) || ((reg.ts == msgTs)&&(reg.id<msgId)))
 		{
 			NS_LOG_LOGIC ("Updating Local Info");
 
-			m_ts = msgTs;
-			m_id =msgId; 
-			m_value = msgV;
+			reg.ts = msgTs;
+			reg.id =msgId; 
+			reg.value = msgV;
+			reg.payload = payload;
 		}
 
 		if (m_operations[msgSenderID] < msgOp)
@@ -661,31 +684,22 @@ MwImpServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Relays: " << m_relays[msgSenderID] << " Need:" << (m_numServers - m_fail) << ", RelayOp: " << m_operations[msgSenderID];
-			LogInfo(sstm );
+			AM_LOG_INFO ("Relays: " << m_relays[msgSenderID] << " Need:" << (m_numServers - m_fail) << ", RelayOp: " << m_operations[msgSenderID]);
 		}
 
 		if (m_relays[msgSenderID] == (m_numServers - m_fail))
 		{
 			// REPLY back to the reader
 			message_response_type = "readAck";
-			msgT = READACK;
-			AsmCommon::Reset(pkts);
-			pkts << READACK << " " << m_ts << " " << m_id << " " << m_value << " " << msgOp;
-			SetFill(pkts.str());
+			AmProtocolHeader reply;
+			reply.SetKey (hdr.GetKey ());
+			reply.SetType (READACK);
+			reply.SetTs (reg.ts);
+			reply.SetId (reg.id);
+			reply.SetValue (reg.value);
+			reply.SetCounter (msgOp);
 
-			Ptr<Packet> pk;
-			if (m_dataSize)
-			{
-				NS_ASSERT_MSG (m_dataSize == m_size, "MwImpServer::HandleSend(): m_size and m_dataSize inconsistent");
-				NS_ASSERT_MSG (m_data, "MwImpServer::HandleSend(): m_dataSize but no m_data");
-				pk = Create<Packet> (m_data, m_dataSize);
-			}
-			else
-			{
-				pk = Create<Packet> (m_size);
-			}
+			Ptr<Packet> pk = m_framer.Build (reply, reg.payload);
 
 			//Send to the corresponding client (from the info of the message is msgSenderId)
 			(m_clntAddress[msgSenderID].second)->Send(pk);
@@ -693,9 +707,7 @@ MwImpServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
 
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Sent " << message_response_type <<" "<< pk->GetSize () << " bytes to " << InetSocketAddress::ConvertFrom (m_clntAddress[msgSenderID].first).GetIpv4() << " data " << pkts.str();
-				LogInfo ( sstm );
+				AM_LOG_INFO ("Sent " << message_response_type <<" "<< pk->GetSize () << " bytes to " << InetSocketAddress::ConvertFrom (m_clntAddress[msgSenderID].first).GetIpv4() << " data " << reply);
 			}
 
 			//reset the replies for that reader to one (to count ours)
@@ -23,12 +23,20 @@
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
 #include "ns3/address.h"
+#include "ns3/packet.h"
+#include "ns3/traced-callback.h"
+#include "ns3/ipv4-address.h"
 #include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-service-queue.h"
+#include "am-register-store.h"
+#include <unordered_map>
 
 namespace ns3 {
 
 class Socket;
 class Packet;
+class AmProtocolHeader;
 
 /**
  * \ingroup applications 
@@ -52,6 +60,12 @@ public:
   MwImpServer ();
   virtual ~MwImpServer ();
 
+  /**
+   * \brief Get the number of messages this server has sent
+   * \returns the #sentMsgs of the LOG line
+   */
+  uint32_t GetSentMessages (void) const;
+
   void SetServers (std::vector<Address> ip);
 
   //void SetClients (std::vector<Address> ip);
@@ -66,10 +80,6 @@ private:
 
   //string stream for ease of output
   void LogInfo(std::stringstream& s);
-  /**
-   * \brief function to fill the packet with data
-   */
-  void SetFill (std::string fill);
   /**
    * \brief Handle a packet reception.
    *
@@ -79,10 +89,40 @@ private:
    */
   
   void HandleRead (Ptr<Socket> socket);
+  /**
+   * \brief Start or end a fault of the server
+   * \param fault the fault
+   */
+  void SetFault (AmServiceQueue::Fault fault);
+  /**
+   * \returns the fault of the server
+   */
+  AmServiceQueue::Fault GetFault (void) const;
+  /**
+   * \param hdr a message
+   * \returns the servers the message is relayed to, each charged
+   *          ServiceTimePerItem
+   */
+  uint32_t GetServiceItems (const AmProtocolHeader &hdr) const;
+  /**
+   * \param delay the time every message received waits before it is processed
+   */
+  void SetSlowdown (Time delay);
+  /**
+   * \returns the time every message received waits before it is processed
+   */
+  Time GetSlowdown (void) const;
 
-  void HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType msgT);
+  void HandleRecvMsg(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket, MessageType msgT);
 
-  void HandleRelay(std::istream& istm, Ptr<Socket> socket);
+  void HandleRelay(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket);
+
+  /**
+   * \brief find the slot of a client
+   * \param ip the IPv4 address of the client
+   * \return the index of the client in m_clntAddress, or -1 if the client is unknown
+   */
+  int FindClient (Ipv4Address ip) const;
 
     /**
    * \brief Handle an incoming connection
@@ -113,14 +153,16 @@ private:
 
   
 
-  uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
-  uint8_t *m_data; 		//!< packet payload data
-
   uint16_t m_port; //!< Port on which we listen for incoming packets.
   uint32_t m_size; //!< The size of the packet
   Ptr<Socket> m_socket; //!< IPv4 Socket
   //std::vector< Ptr<Socket> > m_socket; //!< Socket
   std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
+  AmMessageFramer m_framer; //!< reassembles the messages of each socket
+  AmServiceQueue m_service; //!< processing time of the messages
+  uint32_t m_serviceCores; //!< cores of the server, 0 for no processing time
+  Ptr<RandomVariableStream> m_serviceTime; //!< processing time of a message (s)
+  Time m_servicePerItem; //!< processing time per server a message is relayed to
   Address m_local; //!< local multicast address
   Address m_myAddress; //!< ip address
   uint32_t m_personalID;  //My Personal ID
@@ -131,6 +173,7 @@ private:
   std::vector< Ptr<Socket> > m_srvSocket;
 
   std::vector< std::pair< Address, Ptr<Socket> > > m_clntAddress; //!< Remote client adresses
+  std::unordered_map<uint32_t, uint32_t> m_clntSlot; //!< index in m_clntAddress of each client IPv4 address
   std::vector< Ptr<Socket> > m_clntSocket;
   uint32_t m_numServers;    //!< number of servers
   uint32_t m_numClients;    //!< number of clients
@@ -138,11 +181,19 @@ private:
   uint32_t m_fail;      //!< max number of failures supported
 
   // MwImp variables
-  // Together <m_ts,m_id> = tag
-  uint32_t m_id;        //!< id of latest value
-  uint32_t m_ts; 				//!< latest timestamp
-  uint32_t m_value;			//!< value associated with m_ts
+  /// State of a single register (key)
+  struct Register
+  {
+    // Together <ts,id> = tag
+    uint32_t id;     //!< id of latest value
+    uint32_t ts;     //!< latest timestamp
+    uint32_t value;  //!< value associated with ts
+    Ptr<Packet> payload; //!< bytes of value, as received
+  };
+  AmRegisterStore<Register> m_registers; //!< register state per key
   uint32_t m_sent;     //!< sent messages counter
+  /// Callbacks for tracing the handled messages
+  TracedCallback<uint32_t, uint32_t> m_handledTrace;
   uint16_t m_verbose;   //!< Debug mode
   std::vector<uint32_t> m_writeop;     //!< value associated with m_ts
   std::vector<uint32_t> m_operations;
@@ -26,8 +26,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
 #include "SwImp-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 
 namespace ns3 {
 
@@ -89,7 +94,7 @@ SwImpClient::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&SwImpClient::m_peerPort),
                    MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&SwImpClient::SetDataSize,
                                          &SwImpClient::GetDataSize),
@@ -97,6 +102,9 @@ SwImpClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&SwImpClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&SwImpClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -122,6 +130,44 @@ SwImpClient::GetTypeId (void)
                    	 UintegerValue (100),
                   	 MakeUintegerAccessor (&SwImpClient::m_numClients),
                   	 MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxInFlight",
+                   "The maximum number of outstanding operations of the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SwImpClient::m_maxInFlight),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SwImpClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&SwImpClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&SwImpClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&SwImpClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&SwImpClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&SwImpClient::m_traceFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -134,7 +180,6 @@ SwImpClient::SwImpClient ()
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
 	//m_socket = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -176,7 +221,31 @@ SwImpClient::StartApplication (void)
 
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&SwImpClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&SwImpClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	m_workload.SetMaxInFlight (m_maxInFlight);
 
 	// seed pseudo-randomness
 	srand(m_seed);
@@ -190,9 +259,7 @@ SwImpClient::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -210,10 +277,27 @@ SwImpClient::StartApplication (void)
 		}
 	}
 
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
+
+}
 
+AmClientStats
+SwImpClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_completeOps;
+	if (m_prType == READER)
+	{
+		stats.fastReads = m_completeOps;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
 }
 
 void 
@@ -221,8 +305,6 @@ SwImpClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
   if ( !m_socket.empty() )
     {
 	  for(uint32_t i=0; i< m_socket.size(); i++ )
@@ -245,22 +327,16 @@ SwImpClient::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-      sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #2EXCH_reads="<< m_completeOps <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
       std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #2EXCH_reads="<< m_completeOps <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #2EXCH_reads="<< m_completeOps <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
 
-  if(m_personalID==m_numClients-1){
-  	exit(0);
-  }
-  
-  Simulator::Cancel (m_sendEvent);
+  m_workload.Stop ();
 
 }
 
@@ -268,6 +344,9 @@ void
 SwImpClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
+  m_ops.Clear ();
   Application::DoDispose ();
 }
 
@@ -284,15 +363,13 @@ void SwImpClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
@@ -316,6 +393,14 @@ SwImpClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+SwImpClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  return streams + m_keys.AssignStreams (stream + streams);
+}
+
 void
 SwImpClient::SetRemote (Address ip, uint16_t port)
 {
@@ -359,56 +444,85 @@ SwImpClient::SetFill (std::string fill)
 
   if (dataSize != m_dataSize)
     {
-      //delete [] m_data;
+      delete [] m_data;
       m_data = new uint8_t [dataSize];
       m_dataSize = dataSize;
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
+}
 
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
+/**************************************************************************************
+ * SwImp Read/Write Handlers
+ **************************************************************************************/
+void
+SwImpClient::SelectKey (void)
+{
+	NS_LOG_FUNCTION (this);
+
+	// start from the latest tag known for the key
+	m_key = m_keys.GetNext ();
+
+	Register &reg = m_registers.Get (m_key);
+	m_ts = reg.ts;
+	m_value = reg.value;
+	m_payload = reg.payload;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-SwImpClient::ScheduleOperation (Time dt)
+void
+SwImpClient::LoadOperation (uint32_t id)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this << id);
+
+	Operation &op = m_ops.Get (id);
+	m_opId = id;
+	m_opStatus = op.status;
+	m_msgType = op.msgType;
+	m_key = op.key;
+	m_ts = op.ts;
+	m_value = op.value;
+	m_payload = op.payload;
+	m_replies = op.replies;
+	m_opStart = op.start;
+	m_real_start = op.real_start;
+}
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+void
+SwImpClient::SaveOperation (void)
+{
+	NS_LOG_FUNCTION (this << m_opId);
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	// keep the latest tag of the key for the operations that follow
+	Register &reg = m_registers.Get (m_key);
+	if ( m_ts >= reg.ts )
+	{
+		reg.ts = m_ts;
+		reg.value = m_value;
+		reg.payload = m_payload;
+	}
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &SwImpClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &SwImpClient::InvokeWrite, this);
-  }
+	if (m_opStatus == IDLE)
+	{
+		m_ops.Remove (m_opId);
+		return;
+	}
+
+	Operation &op = m_ops.Get (m_opId);
+	op.status = m_opStatus;
+	op.msgType = m_msgType;
+	op.key = m_key;
+	op.ts = m_ts;
+	op.value = m_value;
+	op.payload = m_payload;
+	op.replies = m_replies;
+	op.start = m_opStart;
+	op.real_start = m_real_start;
 }
 
-/**************************************************************************************
- * SwImp Read/Write Handlers
- **************************************************************************************/
 void
 SwImpClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -417,16 +531,19 @@ SwImpClient::InvokeRead (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+		m_opId = m_opCount;
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
 
 		//Send msg to all
 		m_replies = 0;		//reset replies
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
+
+		SaveOperation ();
 	}
 }
 
@@ -434,7 +551,6 @@ void
 SwImpClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -443,6 +559,9 @@ SwImpClient::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+		m_opId = m_opCount;
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = WRITE;
@@ -450,13 +569,14 @@ SwImpClient::InvokeWrite (void)
 		//increment the ts and generate a random value
 		m_ts ++;
 		m_value = rand()%1000;
+		m_payload = Create<Packet> (m_size);
 
 		//Send msg to all
 		m_replies = 0;		//reset replies
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
+
+		SaveOperation ();
 	}
 }
 
@@ -465,29 +585,19 @@ SwImpClient::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT (m_sendEvent.IsExpired ());
-
   ++m_sent;
+  m_ops.SetCounter (m_opId, m_sent);
 
-  // Prepare packet content
-  std::stringstream pkts;
-  // serialize <msgType, ts, value, counter>
-  pkts << m_msgType << " " << m_ts << " " << m_value << " " << m_sent;
-
-  SetFill(pkts.str());
+  // Prepare packet content <msgType, ts, value, counter>
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
+  hdr.SetType (m_msgType);
+  hdr.SetTs (m_ts);
+  hdr.SetValue (m_value);
+  hdr.SetCounter (m_sent);
 
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "SwImpClient::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "SwImpClient::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // Create packet, the writes carry the bytes of the value
+  Ptr<Packet> p = m_framer.Build (hdr, m_msgType == WRITE ? m_payload : 0);
 
   //random server to start from
   int current = rand()%m_serverAddress.size();
@@ -501,9 +611,7 @@ SwImpClient::HandleSend (void)
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << m_size << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current]) << " port " << m_peerPort;
-		  LogInfo ( sstm );
+		  AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current]) << " port " << m_peerPort);
 	  }
 
       // move to the next server
@@ -518,32 +626,27 @@ SwImpClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  uint32_t msgT, msgTs, msgV, msgC;
+  AmProtocolHeader hdr;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
 	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgT >> msgTs >> msgV >> msgC;
-
+	  packet->RemoveHeader (hdr);
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-		  sstm << "Received " << packet->GetSize () << " bytes from " <<
+		  AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-		  LogInfo (sstm);
+				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 	  }
 
-      // check message freshness and if client is waiting
-      if ( msgC == m_sent && m_opStatus != IDLE)
+      // match the reply to the round of an outstanding operation
+      uint32_t opId;
+      if ( m_ops.Lookup (hdr.GetCounter (), opId) )
       {
-    	  ProcessReply(msgT, msgTs, msgV);
+    	  LoadOperation (opId);
+    	  ProcessReply(hdr.GetType (), hdr.GetTs (), hdr.GetValue ());
+    	  SaveOperation ();
       }
     }
 }
@@ -553,8 +656,6 @@ SwImpClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-
 	//increment the number of replies received
 	m_replies ++;
 
@@ -568,19 +669,18 @@ SwImpClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 
 			m_opStatus = IDLE;
 			m_completeOps++;
-			ScheduleOperation (m_interval);
+			m_workload.OperationCompleted ();
 
 			m_opEnd = Now();
 			m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 			
-			AsmCommon::Reset(sstm);
-			sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **";
 			//std::cout << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **"<<std::endl;
-			LogInfo(sstm);
+			AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **");
 
 			m_real_opAve += elapsed_seconds;  //
 			m_opAve += m_opEnd - m_opStart;
+			m_opCompletedTrace (WRITE, 2, m_opEnd - m_opStart, m_ts, m_key, 0);
 		}
 		break;
 
@@ -592,17 +692,16 @@ SwImpClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 			{
 				m_opStatus = IDLE;
 				m_completeOps++;
-				ScheduleOperation (m_interval);
+				m_workload.OperationCompleted ();
 				m_opEnd = Now();
 				m_real_end = std::chrono::system_clock::now();
 				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 				
 
-				AsmCommon::Reset(sstm);
-				sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **";
-				LogInfo(sstm);
+				AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **");
 
 				m_opAve += m_opEnd - m_opStart;
+				m_opCompletedTrace (READ, 2, m_opEnd - m_opStart, m_ts, m_key, 0);
 				m_real_opAve += elapsed_seconds;  //
 			}
 			break;
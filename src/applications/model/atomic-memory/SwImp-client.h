@@ -22,9 +22,16 @@
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
+#include "ns3/packet.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
 #include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-register-store.h"
+#include "am-key-selector.h"
+#include "am-workload.h"
+#include "am-op-table.h"
+#include <list>
 #include <chrono>
 
 namespace ns3 {
@@ -83,6 +90,12 @@ public:
 	 */
 	uint32_t GetDataSize (void) const;
 
+	/**
+	 * \brief Get the totals of the operations of this client
+	 * \returns the counters reported in the LOG line
+	 */
+	AmClientStats GetStats (void) const;
+
 	/**
 	 * Set the data fill of the packet (what is sent as data to the server) to
 	 * the zero-terminated contents of the fill string string.
@@ -115,6 +128,14 @@ public:
 
 	void SetServers (std::vector<Address> ip);
 
+	/**
+	 * \brief Assign fixed random variable stream numbers to the random
+	 * variables used by this client
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned
+	 */
+	int64_t AssignStreams (int64_t stream);
+
 protected:
 	virtual void DoDispose (void);
 
@@ -132,12 +153,6 @@ private:
 	 * \brief clear the string stream
 	 */
 	//void Reset(stringstream& s);
-	/**
-	 * \brief Schedule the next packet transmission
-	 * \param dt time interval between packets.
-	 */
-	void ScheduleOperation (Time dt);
-
 	/**
 	 * \brief Read operation handler
 	 */
@@ -146,6 +161,20 @@ private:
 	 * \brief Write operation handler
 	 */
 	void InvokeWrite (void);
+	/**
+	 * \brief Pick the key of the next operation and load its register state
+	 */
+	void SelectKey (void);
+	/**
+	 * \brief Make an outstanding operation the one being processed
+	 * \param id the op id
+	 */
+	void LoadOperation (uint32_t id);
+	/**
+	 * \brief Store the operation being processed back to the table of
+	 * outstanding operations, or drop it once it completed
+	 */
+	void SaveOperation (void);
 
 	/**
 	 * \brief Send a packet
@@ -178,16 +207,16 @@ private:
 	 */
 	void ConnectionFailed (Ptr<Socket> socket);
 
-	uint32_t m_size; 		//!< Size of the sent packet
+	uint32_t m_size; 		//!< Size of the values written, in bytes
 	uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
 	uint8_t *m_data; 		//!< packet payload data
 
 	std::vector< Ptr<Socket> > m_socket; //!< Socket
+	AmMessageFramer m_framer; //!< reassembles the messages of each socket
 	std::vector<Address> m_serverAddress; //!< Remote server adresses
 	Address m_peerAddress; //!< Remote peer address
 	Address m_myAddress; //!< Remote peer address
 	uint16_t m_peerPort; //!< Remote peer port
-	EventId m_sendEvent;
 
 	uint16_t m_serversConnected;
 	uint32_t m_personalID; 				//My Personal ID
@@ -195,6 +224,46 @@ private:
 	// SwImp variables
 	uint32_t m_ts; 				//!< latest timestamp
 	uint32_t m_value;			//!< value associated with m_ts
+	Ptr<Packet> m_payload;		//!< bytes of m_value
+
+	// Key-value store
+	/// Local state of a single register (key)
+	struct Register
+	{
+		uint32_t ts;      //!< latest timestamp
+		uint32_t value;   //!< value associated with ts
+		Ptr<Packet> payload; //!< bytes of value
+	};
+	AmRegisterStore<Register> m_registers; //!< register state of the keys not currently accessed
+	AmKeySelector m_keys;		//!< picks the key of each operation
+	uint32_t m_key;				//!< key accessed by the current operation
+	uint32_t m_numKeys;			//!< number of keys
+	AmKeySelector::Distribution m_keyDist; //!< distribution of the accessed keys
+	double m_zipfAlpha;			//!< exponent of the zipf key distribution
+
+	// Workload
+	AmWorkload m_workload;		//!< schedules the invocations of the operations
+	AmWorkload::Arrival m_arrival;	//!< arrival process of the operations
+	double m_arrivalRate;		//!< rate of the Poisson arrivals (ops/s)
+	std::string m_traceFile;	//!< file of the arrival times to replay
+
+	// Outstanding operations
+	/// State of a single operation
+	struct Operation
+	{
+		Status status;		//!< operation status
+		MessageType msgType;	//!< type of the messages of the current phase
+		uint32_t key;		//!< key accessed by the operation
+		uint32_t ts;		//!< timestamp of the operation
+		uint32_t value;		//!< value associated with the tag
+		Ptr<Packet> payload;	//!< bytes of value
+		uint32_t replies;	//!< replies received in the current phase
+		Time start;		//!< invocation time
+		std::chrono::time_point<std::chrono::system_clock> real_start; //!< wall clock invocation time
+	};
+	AmOpTable<Operation> m_ops;	//!< outstanding operations
+	uint32_t m_opId;			//!< id of the operation being processed
+	uint32_t m_maxInFlight;		//!< maximum number of outstanding operations
 
 	uint32_t m_numServers;		//!< number of servers
 	uint32_t m_fail;			//!< max number of failures supported
@@ -227,6 +296,9 @@ private:
 
 	/// Callbacks for tracing the packet Tx events
 	TracedCallback<Ptr<const Packet> > m_txTrace;
+
+	/// Callbacks for tracing the completed operations
+	TracedCallback<uint32_t, uint32_t, Time, uint32_t, uint32_t, uint32_t> m_opCompletedTrace;
 };
 
 } // namespace ns3
@@ -30,8 +30,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/enum.h"
 
 #include "SwImp-server.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 
 namespace ns3 {
 
@@ -76,6 +81,31 @@ SwImpServer::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&SwImpServer::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("ServiceCores",
+					 "Messages processed at the same time, 0 to process every message on arrival",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&SwImpServer::m_serviceCores),
+					 MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("ServiceTime",
+					 "The processing time of a message, in seconds",
+					 StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"),
+					 MakePointerAccessor (&SwImpServer::m_serviceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("Fault",
+					 "The fault of the server: None, Crash (the messages received are lost) or Pause (they are held until the fault ends)",
+					 EnumValue (AmServiceQueue::NONE),
+					 MakeEnumAccessor (&SwImpServer::SetFault, &SwImpServer::GetFault),
+					 MakeEnumChecker (AmServiceQueue::NONE, "None",
+					                  AmServiceQueue::CRASH, "Crash",
+					                  AmServiceQueue::PAUSE, "Pause"))
+					.AddAttribute ("Slowdown",
+					 "The time every message received waits before it is processed",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&SwImpServer::SetSlowdown, &SwImpServer::GetSlowdown),
+					 MakeTimeChecker ())
+					.AddTraceSource ("MessageHandled", "A message was received and answered",
+					 MakeTraceSourceAccessor (&SwImpServer::m_handledTrace),
+					 "ns3::AmStatsCollector::MessageHandledCallback")
 		;
 	return tid;
 }
@@ -84,8 +114,6 @@ SwImpServer::SwImpServer ()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_ts = 0;
-	m_value = 0;
 	m_sent=0;     //!< sent messages counter
 }
 
@@ -93,8 +121,6 @@ SwImpServer::~SwImpServer()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_ts = 0;
-	m_value = 0;
 	m_sent=0;     //!< sent messages counter
 
 }
@@ -107,9 +133,11 @@ void
 SwImpServer::StartApplication (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
-	sstm << "Debug Mode="<<m_verbose;
-	LogInfo(sstm);
+
+	m_service.SetCores (m_serviceCores);
+	m_service.SetServiceTime (m_serviceTime);
+	m_service.SetServedCallback (MakeCallback (&SwImpServer::HandleRead, this));
+	AM_LOG_INFO ("Debug Mode="<<m_verbose);
 
 	if (m_socket == 0)
 	{
@@ -147,6 +175,12 @@ SwImpServer::StartApplication (void)
 
 }
 
+uint32_t
+SwImpServer::GetSentMessages (void) const
+{
+	return m_sent;
+}
+
 void 
 SwImpServer::StopApplication ()
 {
@@ -158,17 +192,26 @@ SwImpServer::StopApplication ()
 		m_socket->Close ();
 		m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
 	}
-	std::stringstream sstm;
-	sstm << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **";
-	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	LogInfo(sstm);
+	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	AM_LOG_INFO ("** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **");
+	if (m_serviceCores > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" CPU: #served="<<m_service.GetServed ()<<", busyTime="<<m_service.GetBusyTime ().GetSeconds ()<<"s, AveWait="<<(m_service.GetServed () > 0 ? m_service.GetWaitTime ().GetSeconds () / m_service.GetServed () : 0)<<"s, #maxQueue="<<m_service.GetMaxQueue ()<<" **"<<std::endl;
+	}
+	if (m_service.GetDropped () > 0 || m_service.GetHeld () > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" FAULTS: #dropped="<<m_service.GetDropped ()<<", #held="<<m_service.GetHeld ()<<" **"<<std::endl;
+	}
 }
 
 void
 SwImpServer::DoDispose (void)
 {
 	NS_LOG_FUNCTION (this);
+	m_framer.Clear ();
+	m_service.Clear ();
+	m_registers.Clear ();
 	Application::DoDispose ();
 }
 
@@ -179,6 +222,7 @@ SwImpServer::DoDispose (void)
 void SwImpServer::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void SwImpServer::HandlePeerError (Ptr<Socket> socket)
@@ -195,33 +239,34 @@ void SwImpServer::HandleAccept (Ptr<Socket> s, const Address& from)
 }
 
 /**************************************************************************************
- * PACKET DATA Handler
+ * SwImp Rcv Handler
  **************************************************************************************/
 void
-SwImpServer::SetFill (std::string fill)
+SwImpServer::SetFault (AmServiceQueue::Fault fault)
 {
-  NS_LOG_FUNCTION (this << fill);
-
-  uint32_t dataSize = fill.size () + 1;
+	NS_LOG_FUNCTION (this << fault);
+	m_service.SetFault (fault);
+}
 
-  if (dataSize != m_dataSize)
-    {
-      //delete [] m_data;
-      m_data = new uint8_t [dataSize];
-      m_dataSize = dataSize;
-    }
+AmServiceQueue::Fault
+SwImpServer::GetFault (void) const
+{
+	return m_service.GetFault ();
+}
 
-  memcpy (m_data, fill.c_str (), dataSize);
+void
+SwImpServer::SetSlowdown (Time delay)
+{
+	NS_LOG_FUNCTION (this << delay);
+	m_service.SetSlowdown (delay);
+}
 
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
+Time
+SwImpServer::GetSlowdown (void) const
+{
+	return m_service.GetSlowdown ();
 }
 
-/**************************************************************************************
- * SwImp Rcv Handler
- **************************************************************************************/
 void 
 SwImpServer::HandleRead (Ptr<Socket> socket)
 {
@@ -229,60 +274,39 @@ SwImpServer::HandleRead (Ptr<Socket> socket)
 
 	Ptr<Packet> packet;
 	Address from;
-	uint32_t msgT, msgTs, msgV, msgC;
-	std::stringstream sstm;
+	AmProtocolHeader hdr;
 
-	while ((packet = socket->RecvFrom (from)))
+	while ((packet = m_service.Recv (m_framer, socket, from)))
 	{
 		//deserialize the contents of the packet
-		uint8_t buf[1024];
-		packet->CopyData(buf,1024);
-		std::stringbuf sb;
-		sb.str(std::string((char*) buf));
-		std::istream istm(&sb);
-		istm >> msgT >> msgTs >> msgV >> msgC;
+		packet->RemoveHeader (hdr);
+		uint32_t sent = m_sent;
+		Register &reg = m_registers.Get (hdr.GetKey ());
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Received " << packet->GetSize () << " bytes from " <<
+			AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-			LogInfo(sstm);
+					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 		}
 
-
-		packet->RemoveAllPacketTags ();
-		packet->RemoveAllByteTags ();
-
 		NS_LOG_LOGIC ("Updating Local Info");
-		if ( m_ts < msgTs )
+		if ( reg.ts < hdr.GetTs () )
 		{
-			m_ts = msgTs;
-			m_value = msgV;
+			reg.ts = hdr.GetTs ();
+			reg.value = hdr.GetValue ();
+			reg.payload = packet;
 		}
 
 
 		NS_LOG_LOGIC ("Echoing packet");
 
-		 // Prepare packet content
-		  std::stringstream pkts;
-		  // serialize <msgType, ts, value, counter>
-		  pkts << msgT << " " << m_ts << " " << m_value << " " << msgC;
-
-		  SetFill(pkts.str());
-
-		Ptr<Packet> p;
-		  if (m_dataSize)
-		    {
-		      NS_ASSERT_MSG (m_dataSize == m_size, "SwImpClient::HandleSend(): m_size and m_dataSize inconsistent");
-		      NS_ASSERT_MSG (m_data, "SwImpClient::HandleSend(): m_dataSize but no m_data");
-		      p = Create<Packet> (m_data, m_dataSize);
-		    }
-		  else
-		    {
-		      p = Create<Packet> (m_size);
-		    }
+		// Prepare packet content <msgType, ts, value, counter>
+		hdr.SetTs (reg.ts);
+		hdr.SetValue (reg.value);
+
+		// the reads get the bytes of the value, the writes an ack
+		Ptr<Packet> p = m_framer.Build (hdr, hdr.GetType () == READ ? reg.payload : 0);
 
 		//socket->SendTo (p, 0, from);
 		socket->Send (p);
@@ -290,12 +314,12 @@ SwImpServer::HandleRead (Ptr<Socket> socket)
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Sent " << packet->GetSize () << " bytes to " <<
+			AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort ();
-			LogInfo(sstm);
+					InetSocketAddress::ConvertFrom (from).GetPort ());
 		}
+
+		m_handledTrace (hdr.GetType (), m_sent - sent);
 	}
 }
 
@@ -26,8 +26,15 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
 #include "ns3/trace-source-accessor.h"
 #include "abd-client-mwmr.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -93,7 +100,7 @@ AbdClientMWMR::GetTypeId (void)
 					UintegerValue (9),
 					MakeUintegerAccessor (&AbdClientMWMR::m_port),
 					MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&AbdClientMWMR::SetDataSize,
                                          &AbdClientMWMR::GetDataSize),
@@ -101,6 +108,9 @@ AbdClientMWMR::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&AbdClientMWMR::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&AbdClientMWMR::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -126,6 +136,71 @@ AbdClientMWMR::GetTypeId (void)
                    	 UintegerValue (100),
                   	 MakeUintegerAccessor (&AbdClientMWMR::m_numClients),
                   	 MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxInFlight",
+                   "The maximum number of outstanding operations of the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&AbdClientMWMR::m_maxInFlight),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&AbdClientMWMR::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&AbdClientMWMR::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&AbdClientMWMR::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&AbdClientMWMR::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&AbdClientMWMR::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&AbdClientMWMR::m_traceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("QuorumSelection",
+                   "The servers a round is sent to first: all of them, or a thrifty quorum of #servers-#failures",
+                   EnumValue (AmQuorumSelector::ALL),
+                   MakeEnumAccessor (&AbdClientMWMR::m_quorumMode),
+                   MakeEnumChecker (AmQuorumSelector::ALL, "All",
+                                    AmQuorumSelector::RANDOM, "Random",
+                                    AmQuorumSelector::NEAREST, "Nearest"))
+    .AddAttribute ("ThriftyTimeout",
+                   "The time a round sent to a thrifty quorum waits for its replies before it is sent to the other servers",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&AbdClientMWMR::m_thriftyTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("WriteBatch",
+                   "The writes a round commits at most: the writes invoked while a round is in flight on their key wait for the next one, 1 to disable batching",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&AbdClientMWMR::m_writeBatch),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Multiplex",
+                   "Whether the client shares one connection per server with the other multiplexed clients of its node (see AmConnectionManager)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&AbdClientMWMR::m_multiplex),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LeaseTime",
+                   "The read leases granted by the servers, to be the same as theirs: a read that got one from its whole quorum answers the reads of its key until it ends, 0 for none",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&AbdClientMWMR::m_leaseTime),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -138,7 +213,6 @@ AbdClientMWMR::AbdClientMWMR ()
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
 	//m_socket = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -149,6 +223,12 @@ AbdClientMWMR::AbdClientMWMR ()
 	m_fail = 0;
 	m_opCount = 0;
 	m_completeOps = 0;
+	m_fallbacks = 0;
+	m_serverMsgs = 0;
+	m_muxId = 0;
+	m_leased = 0;
+	m_leaseReads = 0;
+	m_fastReads = 0;
 }
 
 AbdClientMWMR::~AbdClientMWMR()
@@ -180,11 +260,48 @@ AbdClientMWMR::StartApplication (void)
 
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&AbdClientMWMR::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&AbdClientMWMR::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	// the writes waiting for a round hold a slot of the workload too
+	m_batcher.SetMaxWrites (m_prType == WRITER ? m_writeBatch : 1);
+	m_workload.SetMaxInFlight (m_maxInFlight * (m_prType == WRITER ? m_writeBatch : 1));
 
 	// seed pseudo-randomness
 	srand(m_seed);
 
+	// thrifty rounds go to a quorum first
+	m_quorum.SetMode (m_serverAddress.size (), m_quorumMode);
+
+	// the replies of the shared sockets come back through the manager of the node
+	if (m_multiplex && m_mux == 0)
+	{
+		m_mux = AmConnectionManager::GetManager (GetNode ());
+		m_muxId = m_mux->Register (MakeCallback (&AbdClientMWMR::HandleMessage, this),
+		                           MakeCallback (&AbdClientMWMR::ConnectionSucceeded, this));
+	}
+
 	if ( m_socket.empty() )
 	{
 		//Set the number of sockets we need
@@ -194,12 +311,15 @@ AbdClientMWMR::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
+			if (m_mux != 0)
+			{
+				m_socket[i] = m_mux->Connect (m_muxId, tid, InetSocketAddress (Ipv4Address::ConvertFrom(m_serverAddress[i]), m_peerPort));
+				continue;
+			}
 			m_socket[i] = Socket::CreateSocket (GetNode (), tid);
 
 			m_socket[i]->Bind();
@@ -214,10 +334,29 @@ AbdClientMWMR::StartApplication (void)
 		}
 	}
 
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
+
+}
 
+AmClientStats
+AbdClientMWMR::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_completeOps;
+	if (m_prType == READER)
+	{
+		// the reads answered by a lease or in one round are the fast ones
+		stats.slowReads = m_completeOps - m_leaseReads - m_fastReads;
+		stats.fastReads = m_leaseReads + m_fastReads;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
 }
 
 void 
@@ -225,9 +364,13 @@ AbdClientMWMR::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
-  if ( !m_socket.empty() )
+  // the shared sockets are closed by the manager, with their last client
+  if (m_mux != 0)
+    {
+	  m_mux->Unregister (m_muxId);
+	  m_mux = 0;
+    }
+  else if ( !m_socket.empty() )
     {
 	  for(uint32_t i=0; i< m_socket.size(); i++ )
 	  {
@@ -236,6 +379,12 @@ AbdClientMWMR::StopApplication ()
 	  }
     }
 
+  for (std::map<uint32_t, EventId>::iterator it = m_fallback.begin (); it != m_fallback.end (); ++it)
+    {
+      it->second.Cancel ();
+    }
+  m_fallback.clear ();
+
   float avg_time=0;
   float real_avg_time=0;
   if(m_opCount==0){
@@ -249,22 +398,32 @@ AbdClientMWMR::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-      sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #4EXCH_reads="<< m_completeOps <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
-      std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #4EXCH_reads="<< m_completeOps <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+      std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #4EXCH_reads="<< (m_completeOps - m_leaseReads - m_fastReads) <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #4EXCH_reads="<< (m_completeOps - m_leaseReads - m_fastReads) <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
 
-  if(m_personalID==m_numClients-1){
-  	exit(0);
-  }
-  
-  Simulator::Cancel (m_sendEvent);
+  if (m_batcher.IsEnabled ())
+    {
+      std::cout << "** CLIENT_"<<m_personalID <<" BATCH: #rounds="<<m_batcher.GetRounds ()<<", WritesPerRound="<<(m_batcher.GetRounds () > 0 ? (double) m_batcher.GetWrites () / m_batcher.GetRounds () : 0)<<" **"<<std::endl;
+    }
+  m_batcher.Clear ();
+
+  if (m_quorumMode != AmQuorumSelector::ALL)
+    {
+      std::cout << "** CLIENT_"<<m_personalID <<" THRIFTY: #serverMsgs="<<m_serverMsgs<<", MsgsPerOp="<<(m_completeOps > 0 ? (double) m_serverMsgs / m_completeOps : 0)<<", #fallbacks="<<m_fallbacks<<" **"<<std::endl;
+    }
+
+  if (m_leaseTime.IsStrictlyPositive () && m_prType == READER)
+    {
+      std::cout << "** CLIENT_"<<m_personalID <<" LEASE: #leaseReads="<<m_leaseReads<<", #fastReads="<<m_fastReads<<", LeaseHitRatio="<<(m_completeOps > 0 ? (double) m_leaseReads / m_completeOps : 0)<<", FastPathRatio="<<(m_completeOps > 0 ? (double) m_fastReads / m_completeOps : 0)<<" **"<<std::endl;
+    }
+
+  m_workload.Stop ();
 
 }
 
@@ -272,6 +431,9 @@ void
 AbdClientMWMR::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
+  m_ops.Clear ();
   Application::DoDispose ();
 }
 
@@ -288,15 +450,13 @@ void AbdClientMWMR::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
@@ -320,6 +480,19 @@ AbdClientMWMR::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+AbdClientMWMR::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  streams += m_keys.AssignStreams (stream + streams);
+  if (m_quorumMode == AmQuorumSelector::RANDOM)
+    {
+      streams += m_quorum.AssignStreams (stream + streams);
+    }
+  return streams;
+}
+
 void
 AbdClientMWMR::SetRemote (Address ip, uint16_t port)
 {
@@ -363,56 +536,109 @@ AbdClientMWMR::SetFill (std::string fill)
 
   if (dataSize != m_dataSize)
     {
-      //delete [] m_data;
+      delete [] m_data;
       m_data = new uint8_t [dataSize];
       m_dataSize = dataSize;
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
+}
 
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
+/**************************************************************************************
+ * ABD Read/Write Handlers
+ **************************************************************************************/
+void
+AbdClientMWMR::SelectKey (void)
+{
+	NS_LOG_FUNCTION (this);
+
+	// start from the latest tag known for the key
+	m_key = m_keys.GetNext ();
+
+	Register &reg = m_registers.Get (m_key);
+	m_ts = reg.ts;
+	m_id = reg.id;
+	m_value = reg.value;
+	m_payload = reg.payload;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-AbdClientMWMR::ScheduleOperation (Time dt)
+void
+AbdClientMWMR::LoadOperation (uint32_t id)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this << id);
+
+	Operation &op = m_ops.Get (id);
+	m_opId = id;
+	m_opStatus = op.status;
+	m_msgType = op.msgType;
+	m_key = op.key;
+	m_ts = op.ts;
+	m_id = op.id;
+	m_value = op.value;
+	m_payload = op.payload;
+	m_replies = op.replies;
+	m_opStart = op.start;
+	m_real_start = op.real_start;
+	ts_values = op.ts_values;
+	ts_ids = op.ts_ids;
+	ts_timestamps = op.ts_timestamps;
+	m_contacted = op.contacted;
+	m_roundStart = op.roundStart;
+	m_leased = op.leased;
+	m_leaseEnd = op.leaseEnd;
+}
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+void
+AbdClientMWMR::SaveOperation (void)
+{
+	NS_LOG_FUNCTION (this << m_opId);
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	// keep the latest tag of the key for the operations that follow
+	Register &reg = m_registers.Get (m_key);
+	if ( m_ts > reg.ts || ( m_ts == reg.ts && m_id >= reg.id ) )
+	{
+		reg.ts = m_ts;
+		reg.id = m_id;
+		reg.value = m_value;
+		reg.payload = m_payload;
+	}
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &AbdClientMWMR::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &AbdClientMWMR::InvokeWrite, this);
-  }
+	if (m_opStatus == IDLE)
+	{
+		std::map<uint32_t, EventId>::iterator it = m_fallback.find (m_opId);
+		if (it != m_fallback.end ())
+		{
+			it->second.Cancel ();
+			m_fallback.erase (it);
+		}
+		m_ops.Remove (m_opId);
+		return;
+	}
+
+	Operation &op = m_ops.Get (m_opId);
+	op.status = m_opStatus;
+	op.msgType = m_msgType;
+	op.key = m_key;
+	op.ts = m_ts;
+	op.id = m_id;
+	op.value = m_value;
+	op.payload = m_payload;
+	op.replies = m_replies;
+	op.start = m_opStart;
+	op.real_start = m_real_start;
+	op.ts_values = ts_values;
+	op.ts_ids = ts_ids;
+	op.ts_timestamps = ts_timestamps;
+	op.contacted = m_contacted;
+	op.roundStart = m_roundStart;
+	op.leased = m_leased;
+	op.leaseEnd = m_leaseEnd;
 }
 
-/**************************************************************************************
- * ABD Read/Write Handlers
- **************************************************************************************/
 void
 AbdClientMWMR::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	
@@ -420,8 +646,28 @@ AbdClientMWMR::InvokeRead (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+		m_opId = m_opCount;
+
 		m_opStart = Now();
     	m_real_start = std::chrono::system_clock::now();
+		m_leased = 0;
+		m_leaseEnd = Seconds (0);
+
+		// a read lease on the key answers the read without a round
+		Register &reg = m_registers.Get (m_key);
+		if (reg.lease.IsValid ())
+		{
+			m_ts = reg.lease.ts;
+			m_id = reg.lease.id;
+			m_value = reg.lease.value;
+			m_payload = reg.lease.payload;
+			m_leaseReads++;
+			AM_LOG_INFO ("** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s, under a read lease until "<< reg.lease.end.GetSeconds () <<"s");
+			CompleteRead (0);
+			return;
+		}
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ_DISCOVER;
@@ -431,10 +677,10 @@ AbdClientMWMR::InvokeRead (void)
 
 		//Send msg to all
 		m_replies = 0;		//reset replies
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
+
+		SaveOperation ();
 	}
 }
 
@@ -442,7 +688,6 @@ void
 AbdClientMWMR::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	
@@ -450,9 +695,27 @@ AbdClientMWMR::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+		m_opId = m_opCount;
+
 		//Phase 1
 		m_opStart = Now();
    		m_real_start = std::chrono::system_clock::now();
+
+		// a write of a key with a round in flight waits for the next round
+		if (m_batcher.IsEnabled ())
+		{
+			AmWriteBatcher::Write write;
+			write.op = m_opCount;
+			write.start = m_opStart;
+			write.realStart = m_real_start;
+			if (!m_batcher.Add (m_key, write))
+			{
+				AM_LOG_INFO ("** WRITE QUEUED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
+				return;
+			}
+		}
+
 		m_opStatus = PHASE1;
 		m_msgType = DISCOVER;
 		ts_values.clear();
@@ -466,11 +729,48 @@ AbdClientMWMR::InvokeWrite (void)
 		//Send msg to all
 		m_replies = 0;		//reset replies
 		HandleSend();
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		
+
+		SaveOperation ();
+	}
+}
+
+void
+AbdClientMWMR::CommitBatch (uint32_t key)
+{
+	NS_LOG_FUNCTION (this << key);
+
+	// the application stopped in between
+	if (!m_batcher.IsOpen (key))
+	{
+		return;
 	}
+
+	const std::vector<AmWriteBatcher::Write> &round = m_batcher.GetRound (key);
+	m_key = key;
+	Register &reg = m_registers.Get (m_key);
+	m_ts = reg.ts;
+	m_id = reg.id;
+	m_payload = reg.payload;
+	m_opId = round.front ().op;
+	m_opStart = round.front ().start;
+	m_real_start = round.front ().realStart;
+
+	//Phase 1
+	m_opStatus = PHASE1;
+	m_msgType = DISCOVER;
+	ts_values.clear();
+	ts_ids.clear();
+	ts_timestamps.clear();
+	m_value = rand()%1000;
+
+	//Send msg to all
+	m_replies = 0;		//reset replies
+	HandleSend();
+	AM_LOG_INFO ("** WRITES COMMITTED: " << round.size () << " from " << round.front ().op << " at "<< Now ().GetSeconds() <<"s");
+
+	SaveOperation ();
 }
 
 void 
@@ -478,49 +778,45 @@ AbdClientMWMR::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT (m_sendEvent.IsExpired ());
-
   ++m_sent;
 
   // Prepare packet content
-  std::stringstream pkts;
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
   std::string message_type;
 
+  hdr.SetType (m_msgType);
+  hdr.SetCounter (m_opId);
+  hdr.SetSender (m_muxId);
+  m_ops.SetCounter (m_opId, m_opId);
   if (m_msgType == DISCOVER)
   	{
-  		pkts << DISCOVER << " " << m_opCount;
   		message_type = "discover-write";
 	}
   else if (m_msgType == WRITE)
   	{
-  		pkts << WRITE << " " << m_ts << " " << m_personalID << " " << m_value << " " << m_opCount;
+  		hdr.SetTag (m_ts, m_personalID);
+  		hdr.SetValue (m_value);
   		message_type = "write";
 	}
   else if (m_msgType == READ_DISCOVER)
     {
-		pkts << READ_DISCOVER << " " << m_opCount;
 		message_type = "discover-read";
     }
   else if (m_msgType == READ)
   	{
-  		pkts << READ << " " << m_ts << " " << m_id << " " << m_value << " " << m_opCount;
+  		hdr.SetTag (m_ts, m_id);
+  		hdr.SetValue (m_value);
   		message_type = "read";
   	}
 
-  SetFill(pkts.str());
+  // Create packet, the writes (and the write-backs of the reads) carry the
+  // bytes of the value
+  Ptr<Packet> p = m_framer.Build (hdr, (m_msgType == WRITE || m_msgType == READ) ? m_payload : 0);
 
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "AbdClientMWMR::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "AbdClientMWMR::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // the servers of the round: all of them, or a thrifty quorum
+  m_quorum.Select (m_numServers - m_fail, m_contacted);
+  m_roundStart = Now ();
 
   //random server to start from
   int current = rand()%m_serverAddress.size();
@@ -528,21 +824,75 @@ AbdClientMWMR::HandleSend (void)
   //Send a single packet to each server
   for (uint32_t i=0; i<m_serverAddress.size(); i++)
   {
-	  // call to the trace sinks before the packet is actually sent
-	  m_txTrace (p);
-      m_socket[current]->Send (p);
-
-	  if (m_verbose)
+	  if (m_contacted.Contains (current))
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
-		  << " port " << m_peerPort << " data " << pkts.str();
-		  LogInfo ( sstm );
+		  // call to the trace sinks before the packet is actually sent
+		  m_txTrace (p);
+		  m_socket[current]->Send (p);
+		  m_serverMsgs++;
+
+		  if (m_verbose)
+		  {
+			  AM_LOG_INFO ("Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
+			  << " port " << m_peerPort << " data " << hdr);
+		  }
 	  }
 
       // move to the next server
       current = (current+1)%m_serverAddress.size();
   }
+
+  if (m_contacted.GetSize () < m_serverAddress.size ())
+  {
+	  m_fallback[m_opId].Cancel ();
+	  m_fallback[m_opId] = Simulator::Schedule (m_thriftyTimeout, &AbdClientMWMR::Fallback, this, m_opId, p);
+  }
+}
+
+void
+AbdClientMWMR::Fallback (uint32_t id, Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << id);
+
+  uint32_t opId;
+  if ( !m_ops.Lookup (id, opId) )
+  {
+	  return;
+  }
+
+  LoadOperation (id);
+  m_fallbacks++;
+
+  for (uint32_t i=0; i<m_serverAddress.size(); i++)
+  {
+	  if (!m_contacted.Contains (i))
+	  {
+		  m_txTrace (p);
+		  m_socket[i]->Send (p);
+		  m_serverMsgs++;
+		  m_contacted.Insert (i);
+
+		  if (m_verbose)
+		  {
+			  AM_LOG_INFO ("Sent " << p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << " port " << m_peerPort << " after the thrifty timeout");
+		  }
+	  }
+  }
+
+  SaveOperation ();
+}
+
+uint32_t
+AbdClientMWMR::FindServer (Ptr<Socket> socket) const
+{
+  for (uint32_t i=0; i<m_socket.size(); i++)
+  {
+	  if (m_socket[i] == socket)
+	  {
+		  return i;
+	  }
+  }
+  return m_socket.size ();
 }
 
 void
@@ -552,63 +902,63 @@ AbdClientMWMR::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  uint32_t msgT, msgTs, msgId, msgV, msgOp;
-  msgId=0;
-  msgV=0;
-
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
-	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgT; 
-	  std::stringstream sstm;
-	  std::string message_type;
-
-	  // What the servers send me back
-	  if (msgT==READACK){
-			message_type = "readAck";
-			istm >> msgTs >> msgId >> msgV >> msgOp;
-	  }else if (msgT==DISCOVERACK){
-			message_type = "write-discover-Ack";
-			istm >> msgTs >> msgOp;
-	  }else if (msgT==WRITEACK){
-			message_type = "writeAck";
-			istm >> msgTs >> msgId >> msgV >> msgOp;
-	  }else if (msgT==READ_DISCOVER_ACK){
-	  		message_type = "read-discover-Ack";
-			istm >> msgTs >> msgId >> msgV >> msgOp;
-	  }
+	  HandleMessage (socket, packet, from);
+    }
+}
 
+void
+AbdClientMWMR::HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, const Address &from)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  AmProtocolHeader hdr;
+
+  //deserialize the contents of the packet
+  packet->RemoveHeader (hdr);
+  MessageType msgT = hdr.GetType ();
+  std::string message_type;
+
+  // What the servers send me back
+  if (msgT==READACK){
+		message_type = "readAck";
+  }else if (msgT==DISCOVERACK){
+		message_type = "write-discover-Ack";
+  }else if (msgT==WRITEACK){
+		message_type = "writeAck";
+  }else if (msgT==READ_DISCOVER_ACK){
+		message_type = "read-discover-Ack";
+  }
 
-	  if (m_verbose)
+
+  if (m_verbose)
+  {
+	  AM_LOG_INFO ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
+			  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
+			  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << hdr.GetCounter () <<", opCount = " << m_opCount << " data " << hdr);
+  }
+
+  // check message freshness and if client is waiting
+  uint32_t opId;
+  if ( m_ops.Lookup (hdr.GetCounter (), opId) )
+  {
+	  LoadOperation (opId);
+	  if (m_quorumMode == AmQuorumSelector::NEAREST)
 	  {
-		  sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
-				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << buf;
-		  LogInfo (sstm);
+		  m_quorum.AddRtt (FindServer (socket), Now () - m_roundStart);
 	  }
-
-      // check message freshness and if client is waiting
-      //if ( msgC == m_sent && m_opStatus != IDLE)
-      if (msgOp==m_opCount && m_opStatus != IDLE)
-      {
-    	  ProcessReply(msgT, msgTs, msgId, msgV);
-      }
-    }
+	  ProcessReply(msgT, hdr.GetTs (), hdr.GetId (), hdr.GetValue (), packet, hdr.IsLeased ());
+	  SaveOperation ();
+  }
 }
 
 void
-AbdClientMWMR::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val)
+AbdClientMWMR::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val, Ptr<Packet> payload, bool leased)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-
 	//increment the number of replies received
 	m_replies ++;
 
@@ -630,9 +980,7 @@ AbdClientMWMR::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 
 			if (m_verbose)
 	  		{
-			AsmCommon::Reset(sstm);
-			sstm << "Waiting for " << (m_numServers-m_fail) << " write discover Ack replies, received " << m_replies;
-			LogInfo(sstm);
+			AM_LOG_INFO ("Waiting for " << (m_numServers-m_fail) << " write discover Ack replies, received " << m_replies);
 			}
 
 			//if we received enough replies go to the next phase
@@ -640,15 +988,16 @@ AbdClientMWMR::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 			{	
 				//Now we have to sort the vector 
 				
-				//Find the maximum ts
-				m_ts = ts_timestamps.back();
+				//Find the maximum ts, not below the one of an outstanding write
+				m_ts = std::max<uint32_t> (ts_timestamps.back(), m_registers.Get (m_key).ts);
 
 				//Phase 1
 				m_opStatus = PHASE2;
 				m_msgType = WRITE;
-				// Increase my timestamp, my writeop and generate a random value
-				m_ts ++; 
+				// Increase my timestamp, by one per write of the round, my writeop and generate a random value
+				m_ts += m_batcher.IsEnabled () ? m_batcher.GetRound (m_key).size () : 1;
 				m_value = m_opCount + 200;
+				m_payload = Create<Packet> (m_size);
 				
 				//Send msg to all
 				m_replies = 0;		//reset replies
@@ -662,19 +1011,27 @@ AbdClientMWMR::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 
 			if (m_replies >= (m_numServers - m_fail))
 			{
-				
-				m_completeOps++;
 				m_opStatus = IDLE;
-				ScheduleOperation (m_interval);
-				m_real_end = std::chrono::system_clock::now();
-				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
-				m_opEnd = Now();
-				m_opAve += m_opEnd - m_opStart;
-				m_real_opAve += elapsed_seconds; 
-
-				AsmCommon::Reset(sstm);
-				sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), < <ts,id> , value>: [<" << m_ts <<"," << m_personalID << "> ," << m_value << "], @ 4 EXCH **";
-				LogInfo(sstm);
+				if (m_batcher.IsEnabled ())
+				{
+					// every write of the round completes, with its ts
+					std::vector<AmWriteBatcher::Write> committed;
+					bool next = m_batcher.Complete (m_key, committed);
+					for (uint32_t i = 0; i < committed.size (); i++)
+					{
+						CompleteWrite (committed[i].start, committed[i].realStart, m_ts - committed.size () + 1 + i);
+					}
+
+					// the rounds of the waiting writes, once this one is saved
+					if (next)
+					{
+						Simulator::ScheduleNow (&AbdClientMWMR::CommitBatch, this, m_key);
+					}
+				}
+				else
+				{
+					CompleteWrite (m_opStart, m_real_start, m_ts);
+				}
 				m_replies = 0;
 			}
 		}
@@ -695,6 +1052,10 @@ AbdClientMWMR::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 			ts_values.push_back(val);
 			ts_ids.push_back(id);
 			ts_timestamps.push_back(ts);
+			if (leased)
+			{
+				m_leased++;
+			}
 
 			uint32_t found_max_value =0;
 			uint32_t found_max_index =0;
@@ -711,16 +1072,44 @@ AbdClientMWMR::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 			m_ts = found_max_value;
 			m_id = ts_ids[found_max_index];
 			m_value = ts_values[found_max_index];
+			if (found_max_index == ts_timestamps.size () - 1)
+			{
+				// the reply just received holds the max tag
+				m_payload = payload;
+			}
 
 			if (m_verbose)
 	  		{
-			AsmCommon::Reset(sstm);
-			sstm << "Waiting for " << (m_numServers-m_fail) << " write-discover-Ack replies, received " << m_replies;
-			LogInfo(sstm);
+			AM_LOG_INFO ("Waiting for " << (m_numServers-m_fail) << " write-discover-Ack replies, received " << m_replies);
 			}
 
+			// the replies with the tag read, and whether one has a greater id
+			uint32_t confirmed = 0;
+			bool greater = false;
+			for (uint32_t i = 0; i < ts_timestamps.size (); i++)
+			{
+				if ((uint32_t) ts_timestamps[i] == m_ts && (uint32_t) ts_ids[i] == m_id)
+				{
+					confirmed++;
+				}
+				greater = greater || ((uint32_t) ts_timestamps[i] == m_ts && (uint32_t) ts_ids[i] > m_id);
+			}
+
+			// the whole quorum granted a lease, counted from the sending of the
+			// query, and the tag read is the greatest one
+			if (m_replies >= (m_numServers - m_fail) && m_leased >= (m_numServers - m_fail) && !greater)
+			{
+				m_leaseEnd = m_roundStart + m_leaseTime;
+			}
+
+			// with leases, a tag the whole quorum holds already is not propagated
+			if (m_replies >= (m_numServers - m_fail) && m_leaseTime.IsStrictlyPositive () && confirmed >= (m_numServers - m_fail))
+			{
+				m_fastReads++;
+				CompleteRead (2);
+			}
 			//if we received enough replies go to the next phase
-			if (m_replies >= (m_numServers - m_fail))
+			else if (m_replies >= (m_numServers - m_fail))
 			{	
 				//Phase 1
 				m_opStatus = PHASE2;
@@ -738,24 +1127,56 @@ AbdClientMWMR::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 
 			if (m_replies >= (m_numServers - m_fail))
 			{
-				
-				m_completeOps++;
-				m_opStatus = IDLE;
-				ScheduleOperation (m_interval);
-				m_real_end = std::chrono::system_clock::now();
-				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
-				m_opEnd = Now();
-				m_opAve += m_opEnd - m_opStart;
-				m_real_opAve += elapsed_seconds; 
-
-				AsmCommon::Reset(sstm);
-				sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), < <ts,id> , value>: [<" << m_ts <<"," << m_id << "> ," << m_value << "], @ 4 EXCH **";
-				LogInfo(sstm);
+				CompleteRead (4);
 				m_replies = 0;
 			}
 		}
 	}
 }
 
+void
+AbdClientMWMR::CompleteRead (uint32_t exchanges)
+{
+	NS_LOG_FUNCTION (this << exchanges);
+
+	m_completeOps++;
+	m_opStatus = IDLE;
+	m_workload.OperationCompleted ();
+	m_real_end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
+	m_opEnd = Now();
+	m_opAve += m_opEnd - m_opStart;
+	m_opCompletedTrace (READ, exchanges, m_opEnd - m_opStart, m_ts, m_key, m_id);
+	m_real_opAve += elapsed_seconds; 
+
+	AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), < <ts,id> , value>: [<" << m_ts <<"," << m_id << "> ," << m_value << "], @ " << exchanges << " EXCH **");
+
+	// no operation completes with a greater tag until the lease of the quorum
+	// ends; a read that took none, or completed after it, still raises the
+	// lease of its client to the tag it returned, so that the reads the lease
+	// answers next do not return an older one
+	if (m_leaseTime.IsStrictlyPositive ())
+	{
+		m_registers.Get (m_key).lease.Renew (m_leaseEnd, m_ts, m_id, m_value, m_payload);
+	}
+}
+
+void
+AbdClientMWMR::CompleteWrite (Time start, std::chrono::time_point<std::chrono::system_clock> realStart, uint32_t ts)
+{
+	NS_LOG_FUNCTION (this << start << ts);
+
+	m_completeOps++;
+	m_workload.OperationCompleted ();
+	m_real_end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = m_real_end-realStart;
+	m_opEnd = Now();
+	m_opAve += m_opEnd - start;
+	m_opCompletedTrace (WRITE, 4, m_opEnd - start, ts, m_key, m_personalID);
+	m_real_opAve += elapsed_seconds; 
+
+	AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - start.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - start.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), < <ts,id> , value>: [<" << ts <<"," << m_personalID << "> ," << m_value << "], @ 4 EXCH **");
+}
+
 
 } // Namespace ns3
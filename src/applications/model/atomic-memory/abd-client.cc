@@ -26,8 +26,15 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/address-utils.h"
 #include "abd-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 
 namespace ns3 {
 
@@ -89,7 +96,7 @@ AbdClient::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&AbdClient::m_peerPort),
                    MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&AbdClient::SetDataSize,
                                          &AbdClient::GetDataSize),
@@ -97,6 +104,9 @@ AbdClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&AbdClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&AbdClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -122,6 +132,87 @@ AbdClient::GetTypeId (void)
                    	 UintegerValue (100),
                   	 MakeUintegerAccessor (&AbdClient::m_numClients),
                   	 MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxInFlight",
+                   "The maximum number of outstanding operations of the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&AbdClient::m_maxInFlight),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&AbdClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&AbdClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&AbdClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&AbdClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&AbdClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&AbdClient::m_traceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("Transport",
+                   "The transport of the messages, to be the same as the one of the servers",
+                   EnumValue (TRANSPORT_TCP),
+                   MakeEnumAccessor (&AbdClient::m_transport),
+                   MakeEnumChecker (TRANSPORT_TCP, "Tcp",
+                                    TRANSPORT_UDP, "Udp"))
+    .AddAttribute ("MulticastGroup",
+                   "The multicast group the servers listen to (UDP): every round is sent once to the group instead of once per server",
+                   AddressValue (),
+                   MakeAddressAccessor (&AbdClient::m_group),
+                   MakeAddressChecker ())
+    .AddAttribute ("QuorumSelection",
+                   "The servers a round is sent to first: all of them, or a thrifty quorum of #servers-#failures",
+                   EnumValue (AmQuorumSelector::ALL),
+                   MakeEnumAccessor (&AbdClient::m_quorumMode),
+                   MakeEnumChecker (AmQuorumSelector::ALL, "All",
+                                    AmQuorumSelector::RANDOM, "Random",
+                                    AmQuorumSelector::NEAREST, "Nearest"))
+    .AddAttribute ("ThriftyTimeout",
+                   "The time a round sent to a thrifty quorum waits for its replies before it is sent to the other servers",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&AbdClient::m_thriftyTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("RetransmitTimeout",
+                   "The time a round waits for its replies before it is sent again (UDP), doubled on every retransmission",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&AbdClient::m_rto),
+                   MakeTimeChecker ())
+    .AddAttribute ("WriteBatch",
+                   "The writes a round commits at most: the writes invoked while a round is in flight on their key wait for the next one, 1 to disable batching",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&AbdClient::m_writeBatch),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Multiplex",
+                   "Whether the client shares one connection per server with the other multiplexed clients of its node (see AmConnectionManager)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&AbdClient::m_multiplex),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LeaseTime",
+                   "The read leases granted by the servers, to be the same as theirs: a read that got one from its whole quorum answers the reads of its key until it ends, 0 for none",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&AbdClient::m_leaseTime),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -134,7 +225,6 @@ AbdClient::AbdClient ()
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
 	//m_socket = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -146,6 +236,14 @@ AbdClient::AbdClient ()
 	m_fail = 0;
 	m_opCount = 0;
 	m_completeOps = 0;
+	m_retransmits = 0;
+	m_fallbacks = 0;
+	m_serverMsgs = 0;
+	m_muxId = 0;
+	m_confirmed = 0;
+	m_leased = 0;
+	m_leaseReads = 0;
+	m_fastReads = 0;
 }
 
 AbdClient::~AbdClient()
@@ -176,11 +274,70 @@ AbdClient::StartApplication (void)
 
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&AbdClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&AbdClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	// the writes waiting for a round hold a slot of the workload too
+	m_batcher.SetMaxWrites (m_prType == WRITER ? m_writeBatch : 1);
+	m_workload.SetMaxInFlight (m_maxInFlight * (m_prType == WRITER ? m_writeBatch : 1));
 
 	// seed pseudo-randomness
 	srand(m_seed);
 
+	// a message has to fit in a single datagram
+	if (m_transport == TRANSPORT_UDP && m_size > 65000)
+	{
+		NS_FATAL_ERROR ("Values of " << m_size << " bytes do not fit in a UDP datagram");
+	}
+
+	// thrifty rounds go to a quorum first
+	m_quorum.SetMode (m_serverAddress.size (), m_quorumMode);
+
+	// the rounds go to the group, the replies and the retransmissions stay unicast
+	if (addressUtils::IsMulticast (m_group) && m_groupSocket == 0)
+	{
+		if (m_quorumMode != AmQuorumSelector::ALL)
+		{
+			NS_FATAL_ERROR ("Error: a thrifty quorum cannot be sent to a multicast group");
+		}
+		if (m_transport != TRANSPORT_UDP)
+		{
+			NS_FATAL_ERROR ("Error: the multicast group needs the Udp transport");
+		}
+		m_groupSocket = Socket::CreateSocket (GetNode (), TypeId::LookupByName ("ns3::UdpSocketFactory"));
+		m_groupSocket->Bind ();
+		m_groupSocket->SetRecvCallback (MakeCallback (&AbdClient::HandleRecv, this));
+	}
+
+	// the replies of the shared sockets come back through the manager of the node
+	if (m_multiplex && m_mux == 0)
+	{
+		m_mux = AmConnectionManager::GetManager (GetNode ());
+		m_muxId = m_mux->Register (MakeCallback (&AbdClient::HandleMessage, this),
+		                           MakeCallback (&AbdClient::ConnectionSucceeded, this));
+	}
+
 	if ( m_socket.empty() )
 	{
 		//Set the number of sockets we need
@@ -190,30 +347,53 @@ AbdClient::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
-			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
+			TypeId tid = TypeId::LookupByName (m_transport == TRANSPORT_UDP ? "ns3::UdpSocketFactory" : "ns3::TcpSocketFactory");
+			if (m_mux != 0)
+			{
+				m_socket[i] = m_mux->Connect (m_muxId, tid, InetSocketAddress (Ipv4Address::ConvertFrom(m_serverAddress[i]), m_peerPort));
+				continue;
+			}
 			m_socket[i] = Socket::CreateSocket (GetNode (), tid);
 
+			// a UDP socket is connected at once, from within Connect
+			m_socket[i]->SetConnectCallback (
+				        MakeCallback (&AbdClient::ConnectionSucceeded, this),
+				        MakeCallback (&AbdClient::ConnectionFailed, this));
+
 			m_socket[i]->Bind();
 			m_socket[i]->Connect (InetSocketAddress (Ipv4Address::ConvertFrom(m_serverAddress[i]), m_peerPort));
 
 			m_socket[i]->SetRecvCallback (MakeCallback (&AbdClient::HandleRecv, this));
 			m_socket[i]->SetAllowBroadcast (false);
-
-			m_socket[i]->SetConnectCallback (
-				        MakeCallback (&AbdClient::ConnectionSucceeded, this),
-				        MakeCallback (&AbdClient::ConnectionFailed, this));
 		}
 	}
 
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
+
+}
 
+AmClientStats
+AbdClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_completeOps;
+	if (m_prType == READER)
+	{
+		// the reads answered by a lease or in one round are the fast ones
+		stats.slowReads = m_completeOps - m_leaseReads - m_fastReads;
+		stats.fastReads = m_leaseReads + m_fastReads;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
 }
 
 void 
@@ -221,9 +401,13 @@ AbdClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
-  if ( !m_socket.empty() )
+  // the shared sockets are closed by the manager, with their last client
+  if (m_mux != 0)
+    {
+	  m_mux->Unregister (m_muxId);
+	  m_mux = 0;
+    }
+  else if ( !m_socket.empty() )
     {
 	  for(uint32_t i=0; i< m_socket.size(); i++ )
 	  {
@@ -232,6 +416,24 @@ AbdClient::StopApplication ()
 	  }
     }
 
+  if (m_groupSocket != 0)
+    {
+      m_groupSocket->Close ();
+      m_groupSocket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+    }
+
+  for (std::map<uint32_t, EventId>::iterator it = m_retransmit.begin (); it != m_retransmit.end (); ++it)
+    {
+      it->second.Cancel ();
+    }
+  m_retransmit.clear ();
+
+  for (std::map<uint32_t, EventId>::iterator it = m_fallback.begin (); it != m_fallback.end (); ++it)
+    {
+      it->second.Cancel ();
+    }
+  m_fallback.clear ();
+
   float avg_time=0;
   float real_avg_time=0;
   if(m_opCount==0){
@@ -245,22 +447,37 @@ AbdClient::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-      sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #4EXCH_reads="<< m_completeOps <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
-      std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #4EXCH_reads="<< m_completeOps <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+      std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #4EXCH_reads="<< (m_completeOps - m_leaseReads - m_fastReads) <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", #4EXCH_reads="<< (m_completeOps - m_leaseReads - m_fastReads) <<", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
 
-  if(m_personalID==m_numClients-1){
-  	exit(0);
-  }
-  
-  Simulator::Cancel (m_sendEvent);
+  if (m_transport == TRANSPORT_UDP)
+    {
+      std::cout << "** CLIENT_"<<m_personalID <<" UDP: #retransmits="<<m_retransmits<<" **"<<std::endl;
+    }
+
+  if (m_batcher.IsEnabled ())
+    {
+      std::cout << "** CLIENT_"<<m_personalID <<" BATCH: #rounds="<<m_batcher.GetRounds ()<<", WritesPerRound="<<(m_batcher.GetRounds () > 0 ? (double) m_batcher.GetWrites () / m_batcher.GetRounds () : 0)<<" **"<<std::endl;
+    }
+  m_batcher.Clear ();
+
+  if (m_quorumMode != AmQuorumSelector::ALL)
+    {
+      std::cout << "** CLIENT_"<<m_personalID <<" THRIFTY: #serverMsgs="<<m_serverMsgs<<", MsgsPerOp="<<(m_completeOps > 0 ? (double) m_serverMsgs / m_completeOps : 0)<<", #fallbacks="<<m_fallbacks<<" **"<<std::endl;
+    }
+
+  if (m_leaseTime.IsStrictlyPositive () && m_prType == READER)
+    {
+      std::cout << "** CLIENT_"<<m_personalID <<" LEASE: #leaseReads="<<m_leaseReads<<", #fastReads="<<m_fastReads<<", LeaseHitRatio="<<(m_completeOps > 0 ? (double) m_leaseReads / m_completeOps : 0)<<", FastPathRatio="<<(m_completeOps > 0 ? (double) m_fastReads / m_completeOps : 0)<<" **"<<std::endl;
+    }
+
+  m_workload.Stop ();
 
 }
 
@@ -268,6 +485,9 @@ void
 AbdClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
+  m_ops.Clear ();
   Application::DoDispose ();
 }
 
@@ -284,15 +504,13 @@ void AbdClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
@@ -316,6 +534,19 @@ AbdClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+AbdClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  streams += m_keys.AssignStreams (stream + streams);
+  if (m_quorumMode == AmQuorumSelector::RANDOM)
+    {
+      streams += m_quorum.AssignStreams (stream + streams);
+    }
+  return streams;
+}
+
 void
 AbdClient::SetRemote (Address ip, uint16_t port)
 {
@@ -359,56 +590,101 @@ AbdClient::SetFill (std::string fill)
 
   if (dataSize != m_dataSize)
     {
-      //delete [] m_data;
+      delete [] m_data;
       m_data = new uint8_t [dataSize];
       m_dataSize = dataSize;
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
+}
 
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
+/**************************************************************************************
+ * ABD Read/Write Handlers
+ **************************************************************************************/
+void
+AbdClient::SelectKey (void)
+{
+	NS_LOG_FUNCTION (this);
+
+	// start from the latest tag known for the key
+	m_key = m_keys.GetNext ();
+
+	Register &reg = m_registers.Get (m_key);
+	m_ts = reg.ts;
+	m_value = reg.value;
+	m_payload = reg.payload;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-AbdClient::ScheduleOperation (Time dt)
+void
+AbdClient::LoadOperation (uint32_t id)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this << id);
+
+	Operation &op = m_ops.Get (id);
+	m_opId = id;
+	m_opStatus = op.status;
+	m_msgType = op.msgType;
+	m_key = op.key;
+	m_ts = op.ts;
+	m_value = op.value;
+	m_payload = op.payload;
+	m_replies = op.replies;
+	m_opStart = op.start;
+	m_real_start = op.real_start;
+	m_contacted = op.contacted;
+	m_roundStart = op.roundStart;
+	m_confirmed = op.confirmed;
+	m_leased = op.leased;
+	m_leaseEnd = op.leaseEnd;
+}
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+void
+AbdClient::SaveOperation (void)
+{
+	NS_LOG_FUNCTION (this << m_opId);
+
+	// keep the latest tag of the key for the operations that follow
+	Register &reg = m_registers.Get (m_key);
+	if ( m_ts >= reg.ts )
+	{
+		reg.ts = m_ts;
+		reg.value = m_value;
+		reg.payload = m_payload;
+	}
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	if (m_opStatus == IDLE)
+	{
+		std::map<uint32_t, EventId>::iterator it = m_fallback.find (m_opId);
+		if (it != m_fallback.end ())
+		{
+			it->second.Cancel ();
+			m_fallback.erase (it);
+		}
+		m_ops.Remove (m_opId);
+		return;
+	}
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &AbdClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &AbdClient::InvokeWrite, this);
-  }
+	Operation &op = m_ops.Get (m_opId);
+	op.status = m_opStatus;
+	op.msgType = m_msgType;
+	op.key = m_key;
+	op.ts = m_ts;
+	op.value = m_value;
+	op.payload = m_payload;
+	op.replies = m_replies;
+	op.start = m_opStart;
+	op.real_start = m_real_start;
+	op.contacted = m_contacted;
+	op.roundStart = m_roundStart;
+	op.confirmed = m_confirmed;
+	op.leased = m_leased;
+	op.leaseEnd = m_leaseEnd;
 }
 
-/**************************************************************************************
- * ABD Read/Write Handlers
- **************************************************************************************/
 void
 AbdClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -417,16 +693,35 @@ AbdClient::InvokeRead (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+		m_opId = m_opCount;
+		m_confirmed = 0;
+		m_leased = 0;
+		m_leaseEnd = Seconds (0);
+
+		// a read lease on the key answers the read without a round
+		Register &reg = m_registers.Get (m_key);
+		if (reg.lease.IsValid ())
+		{
+			m_ts = reg.lease.ts;
+			m_value = reg.lease.value;
+			m_payload = reg.lease.payload;
+			m_leaseReads++;
+			AM_LOG_INFO ("** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s, under a read lease until "<< reg.lease.end.GetSeconds () <<"s");
+			CompleteRead (0);
+			return;
+		}
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
 
 		//Send msg to all
 		m_replies = 0;		//reset replies
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
+
+		SaveOperation ();
 	}
 }
 
@@ -434,7 +729,6 @@ void
 AbdClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -443,6 +737,23 @@ AbdClient::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
+		// a write of a key with a round in flight waits for the next round
+		if (m_batcher.IsEnabled ())
+		{
+			AmWriteBatcher::Write write;
+			write.op = m_opCount;
+			write.start = m_opStart;
+			write.realStart = std::chrono::system_clock::now ();
+			if (!m_batcher.Add (m_key, write))
+			{
+				AM_LOG_INFO ("** WRITE QUEUED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
+				return;
+			}
+		}
+		m_opId = m_opCount;
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = WRITE;
@@ -450,65 +761,223 @@ AbdClient::InvokeWrite (void)
 		//increment the ts and generate a random value
 		m_ts ++;
 		m_value = rand()%1000;
+		m_payload = Create<Packet> (m_size);
 
 		//Send msg to all
 		m_replies = 0;		//reset replies
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
+
+		SaveOperation ();
 	}
 }
 
+void
+AbdClient::CommitBatch (uint32_t key)
+{
+	NS_LOG_FUNCTION (this << key);
+
+	// the application stopped in between
+	if (!m_batcher.IsOpen (key))
+	{
+		return;
+	}
+
+	const std::vector<AmWriteBatcher::Write> &round = m_batcher.GetRound (key);
+	m_key = key;
+	m_opId = round.front ().op;
+	m_opStart = round.front ().start;
+
+	//Phase 1
+	m_opStatus = PHASE1;
+	m_msgType = WRITE;
+
+	//one ts per write of the round, the round carries the last one
+	m_ts = m_registers.Get (m_key).ts + round.size ();
+	m_value = rand()%1000;
+	m_payload = Create<Packet> (m_size);
+
+	//Send msg to all
+	m_replies = 0;		//reset replies
+	AM_LOG_INFO ("** WRITES COMMITTED: " << round.size () << " from " << round.front ().op << " at "<< Now ().GetSeconds() <<"s");
+	HandleSend();
+
+	SaveOperation ();
+}
+
 void 
 AbdClient::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT (m_sendEvent.IsExpired ());
-
   ++m_sent;
+  m_ops.SetCounter (m_opId, m_sent);
 
-  // Prepare packet content
-  std::stringstream pkts;
-  // serialize <msgType, ts, value, counter>
-  pkts << m_msgType << " " << m_ts << " " << m_value << " " << m_sent;
-
-  SetFill(pkts.str());
+  Ptr<Packet> p = BuildMessage (m_sent);
 
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "AbdClient::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "AbdClient::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // the servers of the round: all of them, or a thrifty quorum
+  m_quorum.Select (m_numServers - m_fail, m_contacted);
+  m_roundStart = Now ();
 
   //random server to start from
   int current = rand()%m_serverAddress.size();
 
-  //Send a single packet to each server
-  for (uint32_t i=0; i<m_serverAddress.size(); i++)
+  //Send a single packet to the group of the servers
+  if (m_groupSocket != 0)
   {
-	  // call to the trace sinks before the packet is actually sent
+	  m_serverMsgs++;
 	  m_txTrace (p);
-      m_socket[current]->Send (p);
+	  m_groupSocket->SendTo (p, 0, InetSocketAddress (Ipv4Address::ConvertFrom (m_group), m_peerPort));
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << m_size << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current]) << " port " << m_peerPort;
-		  LogInfo ( sstm );
+		  AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to group " << Ipv4Address::ConvertFrom (m_group) << " port " << m_peerPort);
+	  }
+  }
+
+  //Send a single packet to each server
+  for (uint32_t i=0; m_groupSocket == 0 && i<m_serverAddress.size(); i++)
+  {
+	  if (m_contacted.Contains (current))
+	  {
+		  // call to the trace sinks before the packet is actually sent
+		  m_txTrace (p);
+		  m_socket[current]->Send (p);
+		  m_serverMsgs++;
+
+		  if (m_verbose)
+		  {
+			  AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current]) << " port " << m_peerPort);
+		  }
 	  }
 
       // move to the next server
       current = (current+1)%m_serverAddress.size();
   }
+
+  if (m_transport == TRANSPORT_UDP)
+  {
+	  // the timer of the previous round of the operation would otherwise
+	  // fire later and drop the entry of this one
+	  m_retransmit[m_opId].Cancel ();
+	  m_retransmit[m_opId] = Simulator::Schedule (m_rto, &AbdClient::Retransmit, this, m_opId, m_sent, m_rto);
+  }
+
+  if (m_contacted.GetSize () < m_serverAddress.size ())
+  {
+	  m_fallback[m_opId].Cancel ();
+	  m_fallback[m_opId] = Simulator::Schedule (m_thriftyTimeout, &AbdClient::Fallback, this, m_opId, m_sent);
+  }
+}
+
+Ptr<Packet>
+AbdClient::BuildMessage (uint32_t counter)
+{
+  // Prepare packet content <msgType, ts, value, counter>
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
+  hdr.SetType (m_msgType);
+  hdr.SetTs (m_ts);
+  hdr.SetValue (m_value);
+  hdr.SetCounter (counter);
+  hdr.SetSender (m_muxId);
+
+  // Create packet, the writes carry the bytes of the value
+  return m_framer.Build (hdr, m_msgType == WRITE ? m_payload : 0);
+}
+
+void
+AbdClient::Fallback (uint32_t id, uint32_t counter)
+{
+  NS_LOG_FUNCTION (this << id << counter);
+
+  uint32_t opId;
+  if ( !m_ops.Lookup (counter, opId) || opId != id )
+  {
+	  return;
+  }
+
+  LoadOperation (id);
+  m_fallbacks++;
+
+  Ptr<Packet> p = BuildMessage (counter);
+  for (uint32_t i=0; i<m_serverAddress.size(); i++)
+  {
+	  if (!m_contacted.Contains (i))
+	  {
+		  m_txTrace (p);
+		  m_socket[i]->Send (p);
+		  m_serverMsgs++;
+		  m_contacted.Insert (i);
+
+		  if (m_verbose)
+		  {
+			  AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << " port " << m_peerPort << " after the thrifty timeout");
+		  }
+	  }
+  }
+
+  SaveOperation ();
+}
+
+void
+AbdClient::Retransmit (uint32_t id, uint32_t counter, Time timeout)
+{
+  NS_LOG_FUNCTION (this << id << counter << timeout);
+
+  // the round is over once a quorum replied
+  uint32_t opId;
+  if ( !m_ops.Lookup (counter, opId) || opId != id )
+  {
+	  m_retransmit.erase (id);
+	  return;
+  }
+
+  LoadOperation (id);
+
+  // the same counter, the servers answer again and the replies of the
+  // earlier datagrams are counted once
+  Ptr<Packet> p = BuildMessage (counter);
+
+  const AmSeenSet &replied = m_ops.GetReplies (id);
+  for (uint32_t i=0; i<m_serverAddress.size(); i++)
+  {
+	  if (m_contacted.Contains (i) && !replied.Contains (i))
+	  {
+		  m_txTrace (p);
+		  m_socket[i]->Send (p);
+		  m_retransmits++;
+
+		  if (m_verbose)
+		  {
+			  AM_LOG_INFO ("Resent " << p->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << " port " << m_peerPort);
+		  }
+	  }
+  }
+
+  m_retransmit[id] = Simulator::Schedule (timeout + timeout, &AbdClient::Retransmit, this, id, counter, timeout + timeout);
+}
+
+uint32_t
+AbdClient::FindServer (Ptr<Socket> socket, const Address &from) const
+{
+  for (uint32_t i=0; i<m_socket.size(); i++)
+  {
+	  if (m_socket[i] == socket)
+	  {
+		  return i;
+	  }
+  }
+
+  // a reply to a round sent to the group
+  for (uint32_t i=0; i<m_serverAddress.size(); i++)
+  {
+	  if (Ipv4Address::ConvertFrom (m_serverAddress[i]) == InetSocketAddress::ConvertFrom (from).GetIpv4 ())
+	  {
+		  return i;
+	  }
+  }
+  return m_serverAddress.size ();
 }
 
 void
@@ -518,43 +987,51 @@ AbdClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  uint32_t msgT, msgTs, msgV, msgC;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
-	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgT >> msgTs >> msgV >> msgC;
+	  HandleMessage (socket, packet, from);
+    }
+}
+
+void
+AbdClient::HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, const Address &from)
+{
+  NS_LOG_FUNCTION (this << socket);
 
+  AmProtocolHeader hdr;
 
-	  if (m_verbose)
+  //deserialize the contents of the packet
+  packet->RemoveHeader (hdr);
+
+  if (m_verbose)
+  {
+	  AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
+			  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
+			  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
+  }
+
+  // match the reply to the round of an outstanding operation
+  // a duplicate of a reply already received is dropped
+  uint32_t opId;
+  uint32_t server = FindServer (socket, from);
+  if ( m_ops.Lookup (hdr.GetCounter (), opId) && m_ops.AddReply (opId, server) )
+  {
+	  LoadOperation (opId);
+	  if (m_quorumMode == AmQuorumSelector::NEAREST && server < m_serverAddress.size ())
 	  {
-		  std::stringstream sstm;
-		  sstm << "Received " << packet->GetSize () << " bytes from " <<
-				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-		  LogInfo (sstm);
+		  m_quorum.AddRtt (server, Now () - m_roundStart);
 	  }
-
-      // check message freshness and if client is waiting
-      if ( msgC == m_sent && m_opStatus != IDLE)
-      {
-    	  ProcessReply(msgT, msgTs, msgV);
-      }
-    }
+	  ProcessReply(hdr.GetType (), hdr.GetTs (), hdr.GetValue (), packet, hdr.IsLeased ());
+	  SaveOperation ();
+  }
 }
 
 void
-AbdClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
+AbdClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val, Ptr<Packet> payload, bool leased)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-
 	//increment the number of replies received
 	m_replies ++;
 
@@ -563,24 +1040,27 @@ AbdClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 	case WRITER:
 		if (m_replies >= (m_numServers - m_fail))
 		{
-            // computation time of the writer once it gets the replies
-            m_real_start = std::chrono::system_clock::now();
-
 			m_opStatus = IDLE;
-			m_completeOps++;
-			ScheduleOperation (m_interval);
-
-			m_opEnd = Now();
-			m_real_end = std::chrono::system_clock::now();
-			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
-			
-			AsmCommon::Reset(sstm);
-			sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **";
-			//std::cout << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **"<<std::endl;
-			LogInfo(sstm);
-
-			m_real_opAve += elapsed_seconds;  //
-			m_opAve += m_opEnd - m_opStart;
+			if (m_batcher.IsEnabled ())
+			{
+				// every write of the round completes, with its ts
+				std::vector<AmWriteBatcher::Write> committed;
+				bool next = m_batcher.Complete (m_key, committed);
+				for (uint32_t i = 0; i < committed.size (); i++)
+				{
+					CompleteWrite (committed[i].start, m_ts - committed.size () + 1 + i);
+				}
+
+				// the round of the waiting writes, once this one is saved
+				if (next)
+				{
+					Simulator::ScheduleNow (&AbdClient::CommitBatch, this, m_key);
+				}
+			}
+			else
+			{
+				CompleteWrite (m_opStart, m_ts);
+			}
 		}
 		break;
 
@@ -588,29 +1068,53 @@ AbdClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 		switch(m_opStatus)
 		{
 		case PHASE1:
+			// count the replies with the greatest tag, and the read leases
+			if(m_ts < ts)
+			{
+				m_confirmed = 0;
+			}
+			if (leased)
+			{
+				m_leased++;
+			}
+
 			//update the local <ts, value> pair if necessary
 			if(m_ts < ts)
 			{
 				m_ts = ts;
 				m_value = val;
+				m_payload = payload;
 
 				if (m_verbose)
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Updated local <ts,value> pair to: [" << m_ts << "," << m_value << "]";
-					LogInfo(sstm);
+					AM_LOG_INFO ("Updated local <ts,value> pair to: [" << m_ts << "," << m_value << "]");
 				}
 			}
 
+			if (m_ts == ts)
+			{
+				m_confirmed++;
+			}
+
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Waiting for " << (m_numServers-m_fail) << " replies, received " << m_replies;
-				LogInfo(sstm);
+				AM_LOG_INFO ("Waiting for " << (m_numServers-m_fail) << " replies, received " << m_replies);
+			}
+
+			// the whole quorum granted a lease, counted from the sending of the query
+			if (m_replies >= (m_numServers - m_fail) && m_leased >= (m_numServers - m_fail))
+			{
+				m_leaseEnd = m_roundStart + m_leaseTime;
 			}
 
+			// with leases, a tag the whole quorum holds already is not propagated
+			if (m_replies >= (m_numServers - m_fail) && m_leaseTime.IsStrictlyPositive () && m_confirmed >= (m_numServers - m_fail))
+			{
+				m_fastReads++;
+				CompleteRead (2);
+			}
 			//if we received enough replies go to the next phase
-			if (m_replies >= (m_numServers - m_fail))
+			else if (m_replies >= (m_numServers - m_fail))
 			{
 				//Phase 1
 				m_opStatus = PHASE2;
@@ -624,20 +1128,7 @@ AbdClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 		case PHASE2:
 			if (m_replies >= (m_numServers - m_fail))
 			{
-				m_opStatus = IDLE;
-				m_completeOps++;
-				ScheduleOperation (m_interval);
-				m_opEnd = Now();
-				m_real_end = std::chrono::system_clock::now();
-				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
-				
-
-				AsmCommon::Reset(sstm);
-				sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], TWO COMM **";
-				LogInfo(sstm);
-
-				m_opAve += m_opEnd - m_opStart;
-				m_real_opAve += elapsed_seconds;  //
+				CompleteRead (4);
 			}
 			break;
 		default:
@@ -646,5 +1137,56 @@ AbdClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 	}
 }
 
+void
+AbdClient::CompleteRead (uint32_t exchanges)
+{
+	NS_LOG_FUNCTION (this << exchanges);
+
+	m_opStatus = IDLE;
+	m_completeOps++;
+	m_workload.OperationCompleted ();
+	m_opEnd = Now();
+	m_real_end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
+	
+
+	AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], "<< (exchanges > 2 ? "TWO" : exchanges > 0 ? "ONE" : "NO") <<" COMM **");
+
+	m_opAve += m_opEnd - m_opStart;
+	m_opCompletedTrace (READ, exchanges, m_opEnd - m_opStart, m_ts, m_key, 0);
+	m_real_opAve += elapsed_seconds;  //
+
+	// no operation completes with a greater tag until the lease of the quorum
+	// ends; a read that took none, or completed after it, still raises the
+	// lease of its client to the tag it returned, so that the reads the lease
+	// answers next do not return an older one
+	if (m_leaseTime.IsStrictlyPositive ())
+	{
+		m_registers.Get (m_key).lease.Renew (m_leaseEnd, m_ts, 0, m_value, m_payload);
+	}
+}
+
+void
+AbdClient::CompleteWrite (Time start, uint32_t ts)
+{
+	NS_LOG_FUNCTION (this << start << ts);
+
+	// computation time of the writer once it gets the replies
+	m_real_start = std::chrono::system_clock::now();
+
+	m_completeOps++;
+	m_workload.OperationCompleted ();
+
+	m_opEnd = Now();
+	m_real_end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
+
+	AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - start.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - start.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << ts << "," << m_value << "], @ 2 EXCH **");
+
+	m_real_opAve += elapsed_seconds;  //
+	m_opAve += m_opEnd - start;
+	m_opCompletedTrace (WRITE, 2, m_opEnd - start, ts, m_key, 0);
+}
+
 
 } // Namespace ns3
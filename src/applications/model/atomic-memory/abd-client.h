@@ -22,9 +22,21 @@
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
+#include "ns3/packet.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
 #include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-register-store.h"
+#include "am-key-selector.h"
+#include "am-workload.h"
+#include "am-op-table.h"
+#include "am-quorum-selector.h"
+#include "am-connection-manager.h"
+#include "am-write-batcher.h"
+#include "am-lease-table.h"
+#include <list>
+#include <map>
 #include <chrono>
 
 namespace ns3 {
@@ -83,6 +95,12 @@ public:
 	 */
 	uint32_t GetDataSize (void) const;
 
+	/**
+	 * \brief Get the totals of the operations of this client
+	 * \returns the counters reported in the LOG line
+	 */
+	AmClientStats GetStats (void) const;
+
 	/**
 	 * Set the data fill of the packet (what is sent as data to the server) to
 	 * the zero-terminated contents of the fill string string.
@@ -115,6 +133,14 @@ public:
 
 	void SetServers (std::vector<Address> ip);
 
+	/**
+	 * \brief Assign fixed random variable stream numbers to the random
+	 * variables used by this client
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned
+	 */
+	int64_t AssignStreams (int64_t stream);
+
 protected:
 	virtual void DoDispose (void);
 
@@ -132,12 +158,6 @@ private:
 	 * \brief clear the string stream
 	 */
 	//void Reset(stringstream& s);
-	/**
-	 * \brief Schedule the next packet transmission
-	 * \param dt time interval between packets.
-	 */
-	void ScheduleOperation (Time dt);
-
 	/**
 	 * \brief Read operation handler
 	 */
@@ -146,11 +166,68 @@ private:
 	 * \brief Write operation handler
 	 */
 	void InvokeWrite (void);
+	/**
+	 * \brief Send the round of the writes waiting on a key
+	 * \param key the key
+	 */
+	void CommitBatch (uint32_t key);
+	/**
+	 * \brief Record the completion of a write
+	 * \param start the invocation time of the write
+	 * \param ts the timestamp of the write
+	 */
+	void CompleteWrite (Time start, uint32_t ts);
+	/**
+	 * \brief Record the completion of the current read, and renew the read
+	 * lease of its key if its quorum granted one
+	 * \param exchanges the message exchanges of the read, 0 for a lease hit
+	 */
+	void CompleteRead (uint32_t exchanges);
+	/**
+	 * \brief Pick the key of the next operation and load its register state
+	 */
+	void SelectKey (void);
+	/**
+	 * \brief Make an outstanding operation the one being processed
+	 * \param id the op id
+	 */
+	void LoadOperation (uint32_t id);
+	/**
+	 * \brief Store the operation being processed back to the table of
+	 * outstanding operations, or drop it once it completed
+	 */
+	void SaveOperation (void);
 
 	/**
 	 * \brief Send a packet
 	 */
 	void HandleSend (void);
+	/**
+	 * \brief Send the message of the current round of an operation again, to
+	 * the servers that did not reply (UDP transport)
+	 * \param id the op id
+	 * \param counter the counter of the round
+	 * \param timeout the time waited for the replies
+	 */
+	void Retransmit (uint32_t id, uint32_t counter, Time timeout);
+	/**
+	 * \brief Send the message of the current round of an operation to the
+	 * servers left out of its thrifty quorum, once the timer expired
+	 * \param id the op id
+	 * \param counter the counter of the round
+	 */
+	void Fallback (uint32_t id, uint32_t counter);
+	/**
+	 * \param counter the counter of the round
+	 * \return the framed message of the current round
+	 */
+	Ptr<Packet> BuildMessage (uint32_t counter);
+	/**
+	 * \param socket the socket a reply was received on
+	 * \param from the address of the sender
+	 * \return the index of the server that sent the reply
+	 */
+	uint32_t FindServer (Ptr<Socket> socket, const Address &from) const;
 
 	/**
 	 * \brief Handle a packet reception.
@@ -160,13 +237,22 @@ private:
 	 * \param socket the socket the packet was received to.
 	 */
 	void HandleRecv (Ptr<Socket> socket);
+	/**
+	 * \brief Handle a received message
+	 * \param socket the socket the message was received on
+	 * \param packet the message, header included
+	 * \param from the address of the sender
+	 */
+	void HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, const Address &from);
 	/**
 	 * \brief process the received replies
 	 * \param type the type of the received message
 	 * \param ts the received timestamp
 	 * \param val the value associate with ts
+	 * \param payload the bytes of val
+	 * \param leased whether the server granted a read lease on the key
 	 */
-	void ProcessReply(uint32_t type, uint32_t ts, uint32_t val);
+	void ProcessReply(uint32_t type, uint32_t ts, uint32_t val, Ptr<Packet> payload, bool leased);
 	/**
 	 * \brief Handle a Connection Succeed event
 	 * \param socket the connected socket
@@ -178,16 +264,31 @@ private:
 	 */
 	void ConnectionFailed (Ptr<Socket> socket);
 
-	uint32_t m_size; 		//!< Size of the sent packet
+	uint32_t m_size; 		//!< Size of the values written, in bytes
 	uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
 	uint8_t *m_data; 		//!< packet payload data
 
 	std::vector< Ptr<Socket> > m_socket; //!< Socket
+	AmMessageFramer m_framer; //!< reassembles the messages of each socket
+	Transport m_transport;		//!< transport of the messages
+	Address m_group;			//!< multicast group of the servers (UDP), none if not multicast
+	Ptr<Socket> m_groupSocket;	//!< socket sending to m_group
+	Time m_rto;					//!< initial retransmission timeout (UDP)
+	std::map<uint32_t, EventId> m_retransmit; //!< retransmission timer of each operation (UDP)
+	uint32_t m_retransmits;		//!< messages sent again
+	AmQuorumSelector m_quorum;	//!< picks the servers a round is sent to first
+	AmQuorumSelector::Mode m_quorumMode;	//!< all the servers, or a thrifty quorum
+	Time m_thriftyTimeout;		//!< time a thrifty round waits before it goes to all the servers
+	std::map<uint32_t, EventId> m_fallback; //!< thrifty timer of each operation
+	uint32_t m_fallbacks;		//!< thrifty rounds sent to all the servers
+	uint32_t m_serverMsgs;		//!< messages sent to the servers, without the retransmissions
+	bool m_multiplex;			//!< whether the sockets are shared with the other clients of the node
+	Ptr<AmConnectionManager> m_mux;	//!< shares the sockets, if multiplexed
+	uint32_t m_muxId;			//!< id of the client in m_mux, carried in the sender field
 	std::vector<Address> m_serverAddress; //!< Remote server adresses
 	Address m_peerAddress; //!< Remote peer address
 	Address m_myAddress; //!< Remote peer address
 	uint16_t m_peerPort; //!< Remote peer port
-	EventId m_sendEvent;
 
 	uint16_t m_serversConnected;
 	uint32_t m_personalID; 				//My Personal ID
@@ -195,6 +296,60 @@ private:
 	// ABD variables
 	uint32_t m_ts; 				//!< latest timestamp
 	uint32_t m_value;			//!< value associated with m_ts
+	Ptr<Packet> m_payload;		//!< bytes of m_value
+
+	// Key-value store
+	/// Local state of a single register (key)
+	struct Register
+	{
+		uint32_t ts;      //!< latest timestamp
+		uint32_t value;   //!< value associated with ts
+		Ptr<Packet> payload; //!< bytes of value
+		AmReadLease lease;   //!< the read lease held on the key
+	};
+	AmRegisterStore<Register> m_registers; //!< register state of the keys not currently accessed
+	AmKeySelector m_keys;		//!< picks the key of each operation
+	uint32_t m_key;				//!< key accessed by the current operation
+	uint32_t m_numKeys;			//!< number of keys
+	AmKeySelector::Distribution m_keyDist; //!< distribution of the accessed keys
+	double m_zipfAlpha;			//!< exponent of the zipf key distribution
+
+	// Workload
+	AmWorkload m_workload;		//!< schedules the invocations of the operations
+	AmWorkload::Arrival m_arrival;	//!< arrival process of the operations
+	double m_arrivalRate;		//!< rate of the Poisson arrivals (ops/s)
+	std::string m_traceFile;	//!< file of the arrival times to replay
+
+	// Outstanding operations
+	/// State of a single operation
+	struct Operation
+	{
+		Status status;		//!< operation status
+		MessageType msgType;	//!< type of the messages of the current phase
+		uint32_t key;		//!< key accessed by the operation
+		uint32_t ts;		//!< timestamp of the operation
+		uint32_t value;		//!< value associated with the tag
+		Ptr<Packet> payload;	//!< bytes of value
+		uint32_t replies;	//!< replies received in the current phase
+		Time start;		//!< invocation time
+		std::chrono::time_point<std::chrono::system_clock> real_start; //!< wall clock invocation time
+		AmSeenSet contacted;	//!< servers the current round was sent to
+		Time roundStart;	//!< sending time of the current round
+		uint32_t confirmed;	//!< replies of the query carrying the greatest tag
+		uint32_t leased;	//!< replies of the query granting a read lease
+		Time leaseEnd;		//!< end of the read lease of the quorum, if all of it granted one
+	};
+	AmOpTable<Operation> m_ops;	//!< outstanding operations
+	uint32_t m_opId;			//!< id of the operation being processed
+	uint32_t m_maxInFlight;		//!< maximum number of outstanding operations
+	uint32_t m_writeBatch;		//!< writes committed by a round at most
+	Time m_leaseTime;			//!< duration of the read leases of the servers, 0 for none
+	uint32_t m_confirmed;		//!< replies of the query carrying the greatest tag
+	uint32_t m_leased;			//!< replies of the query granting a read lease
+	Time m_leaseEnd;			//!< end of the read lease of the quorum of the current read
+	uint32_t m_leaseReads;		//!< reads answered by a read lease
+	uint32_t m_fastReads;		//!< reads completed in one round
+	AmWriteBatcher m_batcher;	//!< the writes waiting for a round
 
 	uint32_t m_numServers;		//!< number of servers
 	uint32_t m_fail;			//!< max number of failures supported
@@ -214,6 +369,8 @@ private:
 	uint32_t m_completeOps;
 	uint32_t m_numClients;
 	uint32_t m_replies;
+	AmSeenSet m_contacted;		//!< servers the current round was sent to
+	Time m_roundStart;			//!< sending time of the current round
 	uint32_t m_sent; 		//!< Counter for sent packets
 	uint32_t m_count; 		//!< Maximum number of packets the application will send
 
@@ -227,6 +384,9 @@ private:
 
 	/// Callbacks for tracing the packet Tx events
 	TracedCallback<Ptr<const Packet> > m_txTrace;
+
+	/// Callbacks for tracing the completed operations
+	TracedCallback<uint32_t, uint32_t, Time, uint32_t, uint32_t, uint32_t> m_opCompletedTrace;
 };
 
 } // namespace ns3
@@ -30,8 +30,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/enum.h"
 
 #include "abd-server-mwmr.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 
 namespace ns3 {
 
@@ -76,6 +81,36 @@ AbdServerMWMR::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&AbdServerMWMR::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("ServiceCores",
+					 "Messages processed at the same time, 0 to process every message on arrival",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&AbdServerMWMR::m_serviceCores),
+					 MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("ServiceTime",
+					 "The processing time of a message, in seconds",
+					 StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"),
+					 MakePointerAccessor (&AbdServerMWMR::m_serviceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("Fault",
+					 "The fault of the server: None, Crash (the messages received are lost) or Pause (they are held until the fault ends)",
+					 EnumValue (AmServiceQueue::NONE),
+					 MakeEnumAccessor (&AbdServerMWMR::SetFault, &AbdServerMWMR::GetFault),
+					 MakeEnumChecker (AmServiceQueue::NONE, "None",
+					                  AmServiceQueue::CRASH, "Crash",
+					                  AmServiceQueue::PAUSE, "Pause"))
+					.AddAttribute ("Slowdown",
+					 "The time every message received waits before it is processed",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&AbdServerMWMR::SetSlowdown, &AbdServerMWMR::GetSlowdown),
+					 MakeTimeChecker ())
+					.AddAttribute ("LeaseTime",
+					 "The read lease granted with the reply to the query of a read, during which the register does not change for the other clients, 0 to grant none (to be the same as the one of the clients)",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&AbdServerMWMR::m_leaseTime),
+					 MakeTimeChecker ())
+					.AddTraceSource ("MessageHandled", "A message was received and answered",
+					 MakeTraceSourceAccessor (&AbdServerMWMR::m_handledTrace),
+					 "ns3::AmStatsCollector::MessageHandledCallback")
 		;
 	return tid;
 }
@@ -84,9 +119,6 @@ AbdServerMWMR::AbdServerMWMR ()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_id = 0;
-	m_ts = 0;
-	m_value = 0;
 	m_sent=0;     //!< sent messages counter
 }
 
@@ -94,9 +126,6 @@ AbdServerMWMR::~AbdServerMWMR()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_ts = 0;
-	m_id=0;
-	m_value = 0;
 	m_sent=0;     //!< sent messages counter
 
 }
@@ -109,9 +138,12 @@ void
 AbdServerMWMR::StartApplication (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
-	sstm << "Debug Mode="<<m_verbose;
-	LogInfo(sstm);
+
+	m_service.SetCores (m_serviceCores);
+	m_service.SetServiceTime (m_serviceTime);
+	m_service.SetServedCallback (MakeCallback (&AbdServerMWMR::HandleRead, this));
+	m_leases.SetLeaseTime (m_leaseTime);
+	AM_LOG_INFO ("Debug Mode="<<m_verbose);
 
 	if (m_socket == 0)
 	{
@@ -149,6 +181,12 @@ AbdServerMWMR::StartApplication (void)
 
 }
 
+uint32_t
+AbdServerMWMR::GetSentMessages (void) const
+{
+	return m_sent;
+}
+
 void 
 AbdServerMWMR::StopApplication ()
 {
@@ -160,17 +198,31 @@ AbdServerMWMR::StopApplication ()
 		m_socket->Close ();
 		m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
 	}
-	std::stringstream sstm;
-	sstm << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **";
-	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	LogInfo(sstm);
+	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	AM_LOG_INFO ("** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **");
+	if (m_serviceCores > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" CPU: #served="<<m_service.GetServed ()<<", busyTime="<<m_service.GetBusyTime ().GetSeconds ()<<"s, AveWait="<<(m_service.GetServed () > 0 ? m_service.GetWaitTime ().GetSeconds () / m_service.GetServed () : 0)<<"s, #maxQueue="<<m_service.GetMaxQueue ()<<" **"<<std::endl;
+	}
+	if (m_service.GetDropped () > 0 || m_service.GetHeld () > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" FAULTS: #dropped="<<m_service.GetDropped ()<<", #held="<<m_service.GetHeld ()<<" **"<<std::endl;
+	}
+	if (m_leases.IsEnabled ())
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" LEASE: #granted="<<m_leases.GetGranted ()<<", #heldWrites="<<m_leases.GetHeld ()<<", AveHold="<<(m_leases.GetHeld () > 0 ? m_leases.GetHoldTime ().GetSeconds () / m_leases.GetHeld () : 0)<<"s **"<<std::endl;
+	}
+	m_leases.Clear ();
 }
 
 void
 AbdServerMWMR::DoDispose (void)
 {
 	NS_LOG_FUNCTION (this);
+	m_framer.Clear ();
+	m_service.Clear ();
+	m_registers.Clear ();
 	Application::DoDispose ();
 }
 
@@ -181,6 +233,7 @@ AbdServerMWMR::DoDispose (void)
 void AbdServerMWMR::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void AbdServerMWMR::HandlePeerError (Ptr<Socket> socket)
@@ -197,33 +250,34 @@ void AbdServerMWMR::HandleAccept (Ptr<Socket> s, const Address& from)
 }
 
 /**************************************************************************************
- * PACKET DATA Handler
+ * ABD Rcv Handler
  **************************************************************************************/
 void
-AbdServerMWMR::SetFill (std::string fill)
+AbdServerMWMR::SetFault (AmServiceQueue::Fault fault)
 {
-  NS_LOG_FUNCTION (this << fill);
-
-  uint32_t dataSize = fill.size () + 1;
+	NS_LOG_FUNCTION (this << fault);
+	m_service.SetFault (fault);
+}
 
-  if (dataSize != m_dataSize)
-    {
-      //delete [] m_data;
-      m_data = new uint8_t [dataSize];
-      m_dataSize = dataSize;
-    }
+AmServiceQueue::Fault
+AbdServerMWMR::GetFault (void) const
+{
+	return m_service.GetFault ();
+}
 
-  memcpy (m_data, fill.c_str (), dataSize);
+void
+AbdServerMWMR::SetSlowdown (Time delay)
+{
+	NS_LOG_FUNCTION (this << delay);
+	m_service.SetSlowdown (delay);
+}
 
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
+Time
+AbdServerMWMR::GetSlowdown (void) const
+{
+	return m_service.GetSlowdown ();
 }
 
-/**************************************************************************************
- * ABD Rcv Handler
- **************************************************************************************/
 void 
 AbdServerMWMR::HandleRead (Ptr<Socket> socket)
 {
@@ -231,97 +285,98 @@ AbdServerMWMR::HandleRead (Ptr<Socket> socket)
 
 	Ptr<Packet> packet;
 	Address from;
-	uint32_t msgT, msgTs, msgId, msgV, msgOp;
-	std::stringstream sstm;
-	std::string message_type = "";
+	AmProtocolHeader hdr;
 
-	while ((packet = socket->RecvFrom (from)))
+	while ((packet = m_service.Recv (m_framer, socket, from)))
 	{
 		//deserialize the contents of the packet
-		uint8_t buf[1024];
-		packet->CopyData(buf,1024);
-		std::stringbuf sb;
-		sb.str(std::string((char*) buf));
-		std::istream istm(&sb);
-		istm >> msgT;
+		packet->RemoveHeader (hdr);
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Received " << packet->GetSize () << " bytes from " <<
+			AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-			LogInfo(sstm);
-		}
-
-		//Only second phase we update
-		if ((msgT==WRITE) || (msgT==READ)){
-			istm >> msgTs >> msgId >> msgV >> msgOp;
-
-			NS_LOG_LOGIC ("Updating Local Info");
-			if ((msgTs >= m_ts) || ((msgTs==m_ts)&& (msgId>=m_id)))
-			{
-				m_ts = msgTs;
-				m_value = msgV;
-				m_id = msgId;
-			}
-		}
-
-		if ((msgT==DISCOVER) || (msgT==READ_DISCOVER)){
-			istm >> msgOp;
+					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 		}
-		
 
-		// AsmCommon::Reset(sstm);
-		// sstm << "Received msgOp " << msgOp << " RCV Msg: " <<msgT;
-		// LogInfo(sstm);
+		HandleMessage (socket, packet, from, hdr);
+	}
+}
 
-		packet->RemoveAllPacketTags ();
-		packet->RemoveAllByteTags ();
+void
+AbdServerMWMR::ReleaseMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address from, AmProtocolHeader hdr, Time held)
+{
+	NS_LOG_FUNCTION (this << socket << held);
+	m_leases.Release (hdr.GetKey (), Now () - held);
+	HandleMessage (socket, packet, from, hdr);
+}
 
+void
+AbdServerMWMR::HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address from, AmProtocolHeader hdr)
+{
+	NS_LOG_FUNCTION (this << socket);
 
+	uint32_t sent = m_sent;
+	Register &reg = m_registers.Get (hdr.GetKey ());
+	MessageType msgT = hdr.GetType ();
+	AmLeaseTable::Holder holder (from, hdr.GetSender ());
 
-		NS_LOG_LOGIC ("Echoing packet");
+	// a newer tag waits out the read leases of the other clients
+	if (m_leases.IsEnabled () && ((msgT==WRITE) || (msgT==READ))
+	    && ((hdr.GetTs () > reg.ts) || ((hdr.GetTs ()==reg.ts)&& (hdr.GetId ()>reg.id))))
+	{
+		Time wait = m_leases.GetWait (hdr.GetKey (), holder);
+		if (wait.IsStrictlyPositive ())
+		{
+			AM_LOG_INFO ("Holding " << hdr << " for " << wait.GetSeconds () << "s of read leases");
+			m_leases.Hold (hdr.GetKey ());
+			Simulator::Schedule (wait, &AbdServerMWMR::ReleaseMessage, this, socket, packet, from, hdr, Now ());
+			return;
+		}
+	}
 
-		 // Prepare packet content
-		  std::stringstream pkts;
-		  // serialize <msgType, ts, value, counter>
-		  if (msgT == WRITE){
-		  	pkts << WRITEACK << " " << m_ts << " " << m_id << " " << m_value << " " << msgOp;
-		  }else if (msgT == READ){
-		  	pkts << READACK << " " << m_ts << " " << m_id << " " << m_value << " " << msgOp;
-		  }else if (msgT == DISCOVER){
-		  	pkts << DISCOVERACK << " " << m_ts << " " << msgOp;
-		  }else if (msgT == READ_DISCOVER){
-		  	pkts << READ_DISCOVER_ACK << " " << m_ts << " " << m_id << " " << m_value << " " << msgOp;
-		  }
+	//Only second phase we update
+	if ((msgT==WRITE) || (msgT==READ)){
+		NS_LOG_LOGIC ("Updating Local Info");
+		if ((hdr.GetTs () >= reg.ts) || ((hdr.GetTs ()==reg.ts)&& (hdr.GetId ()>=reg.id)))
+		{
+			reg.ts = hdr.GetTs ();
+			reg.value = hdr.GetValue ();
+			reg.id = hdr.GetId ();
+			reg.payload = packet;
+		}
+	}
 
-		  SetFill(pkts.str());
+	NS_LOG_LOGIC ("Echoing packet");
+
+	// Prepare packet content <msgType, <ts, id>, value, counter>
+	if (msgT == WRITE){
+		hdr.SetType (WRITEACK);
+	}else if (msgT == READ){
+		hdr.SetType (READACK);
+	}else if (msgT == DISCOVER){
+		hdr.SetType (DISCOVERACK);
+	}else if (msgT == READ_DISCOVER){
+		hdr.SetType (READ_DISCOVER_ACK);
+	}
+	hdr.SetTag (reg.ts, reg.id);
+	hdr.SetValue (reg.value);
+	hdr.SetLeased (m_leases.IsEnabled () && msgT == READ_DISCOVER && m_leases.Grant (hdr.GetKey (), holder));
 
-		Ptr<Packet> p;
-		  if (m_dataSize)
-		    {
-		      NS_ASSERT_MSG (m_dataSize == m_size, "AbdClient::HandleSend(): m_size and m_dataSize inconsistent");
-		      NS_ASSERT_MSG (m_data, "AbdClient::HandleSend(): m_dataSize but no m_data");
-		      p = Create<Packet> (m_data, m_dataSize);
-		    }
-		  else
-		    {
-		      p = Create<Packet> (m_size);
-		    }
+	// only the queries of the readers get the bytes of the value
+	Ptr<Packet> p = m_framer.Build (hdr, msgT == READ_DISCOVER ? reg.payload : 0);
 
-		socket->Send (p);
-		m_sent++;     //!< sent messages counter
+	socket->Send (p);
+	m_sent++;     //!< sent messages counter
 
-		if (m_verbose)
-		{
-			AsmCommon::Reset(sstm);
-			sstm << "Sent " << packet->GetSize () << " bytes to " <<
-					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort ();
-			LogInfo(sstm);
-		}
+	if (m_verbose)
+	{
+		AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " <<
+				InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
+				InetSocketAddress::ConvertFrom (from).GetPort ());
 	}
+
+	m_handledTrace (msgT, m_sent - sent);
 }
 
 } // Namespace ns3
@@ -23,7 +23,14 @@
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
 #include "ns3/address.h"
+#include "ns3/packet.h"
+#include "ns3/traced-callback.h"
 #include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-service-queue.h"
+#include "am-register-store.h"
+#include "am-protocol-header.h"
+#include "am-lease-table.h"
 
 namespace ns3 {
 
@@ -52,6 +59,12 @@ public:
   AbdServerMWMR ();
   virtual ~AbdServerMWMR ();
 
+  /**
+   * \brief Get the number of messages this server has sent
+   * \returns the #sentMsgs of the LOG line
+   */
+  uint32_t GetSentMessages (void) const;
+
 protected:
   virtual void DoDispose (void);
 
@@ -62,10 +75,6 @@ private:
 
   //string stream for ease of output
   void LogInfo(std::stringstream& s);
-  /**
-   * \brief function to fill the packet with data
-   */
-  void SetFill (std::string fill);
   /**
    * \brief Handle a packet reception.
    *
@@ -74,6 +83,41 @@ private:
    * \param socket the socket the packet was received to.
    */
   void HandleRead (Ptr<Socket> socket);
+  /**
+   * \brief Answer a message, or hold it while the read leases of other
+   * clients on its key are valid
+   * \param socket the socket the message was received to
+   * \param packet the bytes of the value of the message
+   * \param from the address of the client
+   * \param hdr the header of the message
+   */
+  void HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address from, AmProtocolHeader hdr);
+  /**
+   * \brief Answer a message held for the read leases of its key
+   * \param socket the socket the message was received to
+   * \param packet the bytes of the value of the message
+   * \param from the address of the client
+   * \param hdr the header of the message
+   * \param held the time the message was held at
+   */
+  void ReleaseMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address from, AmProtocolHeader hdr, Time held);
+  /**
+   * \brief Start or end a fault of the server
+   * \param fault the fault
+   */
+  void SetFault (AmServiceQueue::Fault fault);
+  /**
+   * \returns the fault of the server
+   */
+  AmServiceQueue::Fault GetFault (void) const;
+  /**
+   * \param delay the time every message received waits before it is processed
+   */
+  void SetSlowdown (Time delay);
+  /**
+   * \returns the time every message received waits before it is processed
+   */
+  Time GetSlowdown (void) const;
   /**
    * \brief Handle an incoming connection
    * \param socket the incoming connection socket
@@ -91,22 +135,33 @@ private:
    */
   void HandlePeerError (Ptr<Socket> socket);
 
-  uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
-  uint8_t *m_data; 		//!< packet payload data
-
   uint16_t m_port; //!< Port on which we listen for incoming packets.
   uint32_t m_size; //!< The size of the packet
   Ptr<Socket> m_socket; //!< IPv4 Socket
   std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
+  AmMessageFramer m_framer; //!< reassembles the messages of each socket
+  AmServiceQueue m_service; //!< processing time of the messages
+  uint32_t m_serviceCores; //!< cores of the server, 0 for no processing time
+  Ptr<RandomVariableStream> m_serviceTime; //!< processing time of a message (s)
   Address m_local; //!< local multicast address
   Address m_myAddress; //!< ip address
   uint32_t m_personalID;        //My Personal ID
 
   // ABD variables
-  uint32_t m_ts; 				//!< latest timestamp
-  uint32_t m_id;        //!< id of latest value
-  uint32_t m_value;			//!< value associated with m_ts
+  /// State of a single register (key)
+  struct Register
+  {
+    uint32_t ts;     //!< latest timestamp
+    uint32_t id;     //!< id of latest value
+    uint32_t value;  //!< value associated with ts
+    Ptr<Packet> payload; //!< bytes of value, as received
+  };
+  AmRegisterStore<Register> m_registers; //!< register state per key
+  Time m_leaseTime;     //!< duration of the read leases, 0 for none
+  AmLeaseTable m_leases; //!< the read leases granted
   uint32_t m_sent;     //!< sent messages counter
+  /// Callbacks for tracing the handled messages
+  TracedCallback<uint32_t, uint32_t> m_handledTrace;
   uint16_t m_verbose;   //!< Debug mode
 
 };
@@ -25,13 +25,18 @@
 #include "ns3/inet6-socket-address.h"
 #include "ns3/socket.h"
 #include "ns3/udp-socket.h"
+#include "ns3/enum.h"
 #include "ns3/tcp-socket.h"
 #include "ns3/simulator.h"
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
 
 #include "abd-server.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 
 namespace ns3 {
 
@@ -76,6 +81,47 @@ AbdServer::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&AbdServer::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("Transport",
+					 "The transport of the messages, to be the same as the one of the clients",
+					 EnumValue (TRANSPORT_TCP),
+					 MakeEnumAccessor (&AbdServer::m_transport),
+					 MakeEnumChecker (TRANSPORT_TCP, "Tcp",
+					                  TRANSPORT_UDP, "Udp"))
+					.AddAttribute ("MulticastGroup",
+					 "The multicast group the server listens to besides its own address (UDP)",
+					 AddressValue (),
+					 MakeAddressAccessor (&AbdServer::m_local),
+					 MakeAddressChecker ())
+					.AddAttribute ("ServiceCores",
+					 "Messages processed at the same time, 0 to process every message on arrival",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&AbdServer::m_serviceCores),
+					 MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("ServiceTime",
+					 "The processing time of a message, in seconds",
+					 StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"),
+					 MakePointerAccessor (&AbdServer::m_serviceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("Fault",
+					 "The fault of the server: None, Crash (the messages received are lost) or Pause (they are held until the fault ends)",
+					 EnumValue (AmServiceQueue::NONE),
+					 MakeEnumAccessor (&AbdServer::SetFault, &AbdServer::GetFault),
+					 MakeEnumChecker (AmServiceQueue::NONE, "None",
+					                  AmServiceQueue::CRASH, "Crash",
+					                  AmServiceQueue::PAUSE, "Pause"))
+					.AddAttribute ("Slowdown",
+					 "The time every message received waits before it is processed",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&AbdServer::SetSlowdown, &AbdServer::GetSlowdown),
+					 MakeTimeChecker ())
+					.AddAttribute ("LeaseTime",
+					 "The read lease granted with the reply to a read, during which the register does not change for the other clients, 0 to grant none (to be the same as the one of the clients)",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&AbdServer::m_leaseTime),
+					 MakeTimeChecker ())
+					.AddTraceSource ("MessageHandled", "A message was received and answered",
+					 MakeTraceSourceAccessor (&AbdServer::m_handledTrace),
+					 "ns3::AmStatsCollector::MessageHandledCallback")
 		;
 	return tid;
 }
@@ -84,8 +130,6 @@ AbdServer::AbdServer ()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_ts = 0;
-	m_value = 0;
 	m_sent=0;     //!< sent messages counter
 }
 
@@ -93,8 +137,6 @@ AbdServer::~AbdServer()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_ts = 0;
-	m_value = 0;
 	m_sent=0;     //!< sent messages counter
 
 }
@@ -107,17 +149,23 @@ void
 AbdServer::StartApplication (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
-	sstm << "Debug Mode="<<m_verbose;
-	LogInfo(sstm);
+
+	m_service.SetCores (m_serviceCores);
+	m_service.SetServiceTime (m_serviceTime);
+	m_service.SetServedCallback (MakeCallback (&AbdServer::HandleRead, this));
+	m_leases.SetLeaseTime (m_leaseTime);
+	AM_LOG_INFO ("Debug Mode="<<m_verbose);
 
 	if (m_socket == 0)
 	{
-		TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
+		TypeId tid = TypeId::LookupByName (m_transport == TRANSPORT_UDP ? "ns3::UdpSocketFactory" : "ns3::TcpSocketFactory");
 		m_socket = Socket::CreateSocket (GetNode (), tid);
 		InetSocketAddress local = InetSocketAddress (Ipv4Address::GetAny (), m_port);
 		m_socket->Bind (local);
-		m_socket->Listen ();
+		if (m_transport == TRANSPORT_TCP)
+		{
+			m_socket->Listen ();
+		}
 
 		if (addressUtils::IsMulticast (m_local))
 		{
@@ -147,6 +195,12 @@ AbdServer::StartApplication (void)
 
 }
 
+uint32_t
+AbdServer::GetSentMessages (void) const
+{
+	return m_sent;
+}
+
 void 
 AbdServer::StopApplication ()
 {
@@ -158,17 +212,31 @@ AbdServer::StopApplication ()
 		m_socket->Close ();
 		m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
 	}
-	std::stringstream sstm;
-	sstm << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **";
-	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	LogInfo(sstm);
+	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	AM_LOG_INFO ("** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **");
+	if (m_serviceCores > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" CPU: #served="<<m_service.GetServed ()<<", busyTime="<<m_service.GetBusyTime ().GetSeconds ()<<"s, AveWait="<<(m_service.GetServed () > 0 ? m_service.GetWaitTime ().GetSeconds () / m_service.GetServed () : 0)<<"s, #maxQueue="<<m_service.GetMaxQueue ()<<" **"<<std::endl;
+	}
+	if (m_service.GetDropped () > 0 || m_service.GetHeld () > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" FAULTS: #dropped="<<m_service.GetDropped ()<<", #held="<<m_service.GetHeld ()<<" **"<<std::endl;
+	}
+	if (m_leases.IsEnabled ())
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" LEASE: #granted="<<m_leases.GetGranted ()<<", #heldWrites="<<m_leases.GetHeld ()<<", AveHold="<<(m_leases.GetHeld () > 0 ? m_leases.GetHoldTime ().GetSeconds () / m_leases.GetHeld () : 0)<<"s **"<<std::endl;
+	}
+	m_leases.Clear ();
 }
 
 void
 AbdServer::DoDispose (void)
 {
 	NS_LOG_FUNCTION (this);
+	m_framer.Clear ();
+	m_service.Clear ();
+	m_registers.Clear ();
 	Application::DoDispose ();
 }
 
@@ -179,6 +247,7 @@ AbdServer::DoDispose (void)
 void AbdServer::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void AbdServer::HandlePeerError (Ptr<Socket> socket)
@@ -195,33 +264,34 @@ void AbdServer::HandleAccept (Ptr<Socket> s, const Address& from)
 }
 
 /**************************************************************************************
- * PACKET DATA Handler
+ * ABD Rcv Handler
  **************************************************************************************/
 void
-AbdServer::SetFill (std::string fill)
+AbdServer::SetFault (AmServiceQueue::Fault fault)
 {
-  NS_LOG_FUNCTION (this << fill);
-
-  uint32_t dataSize = fill.size () + 1;
+	NS_LOG_FUNCTION (this << fault);
+	m_service.SetFault (fault);
+}
 
-  if (dataSize != m_dataSize)
-    {
-      //delete [] m_data;
-      m_data = new uint8_t [dataSize];
-      m_dataSize = dataSize;
-    }
+AmServiceQueue::Fault
+AbdServer::GetFault (void) const
+{
+	return m_service.GetFault ();
+}
 
-  memcpy (m_data, fill.c_str (), dataSize);
+void
+AbdServer::SetSlowdown (Time delay)
+{
+	NS_LOG_FUNCTION (this << delay);
+	m_service.SetSlowdown (delay);
+}
 
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
+Time
+AbdServer::GetSlowdown (void) const
+{
+	return m_service.GetSlowdown ();
 }
 
-/**************************************************************************************
- * ABD Rcv Handler
- **************************************************************************************/
 void 
 AbdServer::HandleRead (Ptr<Socket> socket)
 {
@@ -229,74 +299,92 @@ AbdServer::HandleRead (Ptr<Socket> socket)
 
 	Ptr<Packet> packet;
 	Address from;
-	uint32_t msgT, msgTs, msgV, msgC;
-	std::stringstream sstm;
+	AmProtocolHeader hdr;
 
-	while ((packet = socket->RecvFrom (from)))
+	while ((packet = m_service.Recv (m_framer, socket, from)))
 	{
 		//deserialize the contents of the packet
-		uint8_t buf[1024];
-		packet->CopyData(buf,1024);
-		std::stringbuf sb;
-		sb.str(std::string((char*) buf));
-		std::istream istm(&sb);
-		istm >> msgT >> msgTs >> msgV >> msgC;
+		packet->RemoveHeader (hdr);
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Received " << packet->GetSize () << " bytes from " <<
+			AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-			LogInfo(sstm);
+					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 		}
 
+		HandleMessage (socket, packet, from, hdr);
+	}
+}
+
+void
+AbdServer::ReleaseMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address from, AmProtocolHeader hdr, Time held)
+{
+	NS_LOG_FUNCTION (this << socket << held);
+	m_leases.Release (hdr.GetKey (), Now () - held);
+	HandleMessage (socket, packet, from, hdr);
+}
 
-		packet->RemoveAllPacketTags ();
-		packet->RemoveAllByteTags ();
+void
+AbdServer::HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address from, AmProtocolHeader hdr)
+{
+	NS_LOG_FUNCTION (this << socket);
 
-		NS_LOG_LOGIC ("Updating Local Info");
-		if ( m_ts < msgTs )
+	uint32_t sent = m_sent;
+	Register &reg = m_registers.Get (hdr.GetKey ());
+	AmLeaseTable::Holder holder (from, hdr.GetSender ());
+
+	// a newer tag waits out the read leases of the other clients
+	if ( m_leases.IsEnabled () && reg.ts < hdr.GetTs () )
+	{
+		Time wait = m_leases.GetWait (hdr.GetKey (), holder);
+		if (wait.IsStrictlyPositive ())
 		{
-			m_ts = msgTs;
-			m_value = msgV;
+			AM_LOG_INFO ("Holding " << hdr << " for " << wait.GetSeconds () << "s of read leases");
+			m_leases.Hold (hdr.GetKey ());
+			Simulator::Schedule (wait, &AbdServer::ReleaseMessage, this, socket, packet, from, hdr, Now ());
+			return;
 		}
+	}
 
+	NS_LOG_LOGIC ("Updating Local Info");
+	if ( reg.ts < hdr.GetTs () )
+	{
+		reg.ts = hdr.GetTs ();
+		reg.value = hdr.GetValue ();
+		reg.payload = packet;
+	}
 
-		NS_LOG_LOGIC ("Echoing packet");
 
-		 // Prepare packet content
-		  std::stringstream pkts;
-		  // serialize <msgType, ts, value, counter>
-		  pkts << msgT << " " << m_ts << " " << m_value << " " << msgC;
+	NS_LOG_LOGIC ("Echoing packet");
 
-		  SetFill(pkts.str());
+	// Prepare packet content <msgType, ts, value, counter>
+	hdr.SetTs (reg.ts);
+	hdr.SetValue (reg.value);
+	hdr.SetLeased (m_leases.IsEnabled () && hdr.GetType () == READ && m_leases.Grant (hdr.GetKey (), holder));
 
-		Ptr<Packet> p;
-		  if (m_dataSize)
-		    {
-		      NS_ASSERT_MSG (m_dataSize == m_size, "AbdClient::HandleSend(): m_size and m_dataSize inconsistent");
-		      NS_ASSERT_MSG (m_data, "AbdClient::HandleSend(): m_dataSize but no m_data");
-		      p = Create<Packet> (m_data, m_dataSize);
-		    }
-		  else
-		    {
-		      p = Create<Packet> (m_size);
-		    }
+	// the reads get the bytes of the value, the writes an ack
+	Ptr<Packet> p = m_framer.Build (hdr, hdr.GetType () == READ ? reg.payload : 0);
 
-		//socket->SendTo (p, 0, from);
+	// the datagrams of all the clients arrive on the same socket
+	if (m_transport == TRANSPORT_UDP)
+	{
+		socket->SendTo (p, 0, from);
+	}
+	else
+	{
 		socket->Send (p);
-		m_sent++;     //!< sent messages counter
+	}
+	m_sent++;     //!< sent messages counter
 
-		if (m_verbose)
-		{
-			AsmCommon::Reset(sstm);
-			sstm << "Sent " << packet->GetSize () << " bytes to " <<
-					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort ();
-			LogInfo(sstm);
-		}
+	if (m_verbose)
+	{
+		AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " <<
+				InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
+				InetSocketAddress::ConvertFrom (from).GetPort ());
 	}
+
+	m_handledTrace (hdr.GetType (), m_sent - sent);
 }
 
 } // Namespace ns3
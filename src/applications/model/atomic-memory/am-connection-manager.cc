@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/packet.h"
+#include "am-connection-manager.h"
+#include "am-protocol-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmConnectionManager");
+
+NS_OBJECT_ENSURE_REGISTERED (AmConnectionManager);
+
+TypeId
+AmConnectionManager::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmConnectionManager")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<AmConnectionManager> ()
+  ;
+  return tid;
+}
+
+AmConnectionManager::AmConnectionManager ()
+  : m_nextId (0),
+    m_demultiplexed (0),
+    m_dropped (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AmConnectionManager::~AmConnectionManager ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AmConnectionManager::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_connections.empty ())
+    {
+      Close (m_connections.begin ());
+    }
+  m_clients.clear ();
+  m_framer.Clear ();
+  Object::DoDispose ();
+}
+
+Ptr<AmConnectionManager>
+AmConnectionManager::GetManager (Ptr<Node> node)
+{
+  Ptr<AmConnectionManager> manager = node->GetObject<AmConnectionManager> ();
+  if (manager == 0)
+    {
+      manager = CreateObject<AmConnectionManager> ();
+      node->AggregateObject (manager);
+    }
+  return manager;
+}
+
+uint32_t
+AmConnectionManager::Register (RecvCallback recv, ConnectedCallback connected)
+{
+  NS_LOG_FUNCTION (this);
+  Client &client = m_clients[m_nextId];
+  client.recv = recv;
+  client.connected = connected;
+  return m_nextId++;
+}
+
+void
+AmConnectionManager::Unregister (uint32_t client)
+{
+  NS_LOG_FUNCTION (this << client);
+  m_clients.erase (client);
+  for (std::map<Key, Connection>::iterator it = m_connections.begin (); it != m_connections.end (); )
+    {
+      std::map<Key, Connection>::iterator current = it++;
+      current->second.clients.erase (client);
+      if (current->second.clients.empty ())
+        {
+          Close (current);
+        }
+    }
+}
+
+Ptr<Socket>
+AmConnectionManager::Connect (uint32_t client, TypeId tid, const Address &server)
+{
+  NS_LOG_FUNCTION (this << client << tid << server);
+  Key key (tid, server);
+  std::map<Key, Connection>::iterator it = m_connections.find (key);
+  if (it != m_connections.end ())
+    {
+      it->second.clients.insert (client);
+      if (it->second.connected)
+        {
+          Simulator::ScheduleNow (&AmConnectionManager::NotifyConnected, this, client, it->second.socket);
+        }
+      return it->second.socket;
+    }
+
+  Ptr<Node> node = GetObject<Node> ();
+  NS_ASSERT_MSG (node != 0, "AmConnectionManager is not aggregated to a node");
+
+  // the connection is known before Connect, which connects a UDP socket at once
+  Connection &connection = m_connections[key];
+  connection.socket = Socket::CreateSocket (node, tid);
+  connection.connected = false;
+  connection.clients.insert (client);
+  m_servers[connection.socket] = key;
+
+  Ptr<Socket> socket = connection.socket;
+  socket->SetConnectCallback (MakeCallback (&AmConnectionManager::ConnectionSucceeded, this),
+                              MakeCallback (&AmConnectionManager::ConnectionFailed, this));
+  socket->Bind ();
+  socket->Connect (server);
+  socket->SetRecvCallback (MakeCallback (&AmConnectionManager::HandleRecv, this));
+  socket->SetAllowBroadcast (false);
+  return socket;
+}
+
+void
+AmConnectionManager::ConnectionSucceeded (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::map<Ptr<Socket>, Key>::iterator server = m_servers.find (socket);
+  if (server == m_servers.end ())
+    {
+      return;
+    }
+  Connection &connection = m_connections[server->second];
+  connection.connected = true;
+
+  // the clients are notified once Connect returned the socket to them
+  for (std::set<uint32_t>::iterator it = connection.clients.begin (); it != connection.clients.end (); ++it)
+    {
+      Simulator::ScheduleNow (&AmConnectionManager::NotifyConnected, this, *it, socket);
+    }
+}
+
+void
+AmConnectionManager::ConnectionFailed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  NS_LOG_WARN ("A shared socket failed to connect");
+}
+
+void
+AmConnectionManager::NotifyConnected (uint32_t client, Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << client << socket);
+  std::map<uint32_t, Client>::iterator it = m_clients.find (client);
+  std::map<Ptr<Socket>, Key>::iterator server = m_servers.find (socket);
+  if (it == m_clients.end () || server == m_servers.end ()
+      || m_connections[server->second].clients.count (client) == 0)
+    {
+      return;
+    }
+  it->second.connected (socket);
+}
+
+void
+AmConnectionManager::HandleRecv (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  Ptr<Packet> packet;
+  Address from;
+  AmProtocolHeader hdr;
+
+  while ((packet = m_framer.Recv (socket, from)))
+    {
+      // the servers return the sender of the request in the reply
+      packet->PeekHeader (hdr);
+      std::map<uint32_t, Client>::iterator it = m_clients.find (hdr.GetSender ());
+      if (it == m_clients.end ())
+        {
+          NS_LOG_WARN ("Dropped a message of no registered client: " << hdr);
+          m_dropped++;
+          continue;
+        }
+      m_demultiplexed++;
+      it->second.recv (socket, packet, from);
+    }
+}
+
+void
+AmConnectionManager::Close (std::map<Key, Connection>::iterator it)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Socket> socket = it->second.socket;
+  socket->Close ();
+  socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+  m_framer.Remove (socket);
+  m_servers.erase (socket);
+  m_connections.erase (it);
+}
+
+uint32_t
+AmConnectionManager::GetClients (void) const
+{
+  return m_clients.size ();
+}
+
+uint32_t
+AmConnectionManager::GetConnections (void) const
+{
+  return m_connections.size ();
+}
+
+uint64_t
+AmConnectionManager::GetDemultiplexed (void) const
+{
+  return m_demultiplexed;
+}
+
+uint64_t
+AmConnectionManager::GetDropped (void) const
+{
+  return m_dropped;
+}
+
+} // namespace ns3
@@ -0,0 +1,193 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_CONNECTION_MANAGER_H
+#define AM_CONNECTION_MANAGER_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/callback.h"
+#include "ns3/type-id.h"
+#include "am-message-framer.h"
+#include <map>
+#include <set>
+#include <utility>
+
+namespace ns3 {
+
+class Node;
+class Socket;
+class Packet;
+
+/**
+ * \ingroup applications
+ * \class AmConnectionManager
+ * \brief Shares one connection per server among the clients of a node.
+ *
+ * Every client application opens its own socket to every server, so k
+ * clients on a node make k x n connections, each with its TCP timers and
+ * its entry in the lists of accepted sockets of the servers. The manager is
+ * aggregated to the node and multiplexes its clients over one socket per
+ * server address and transport: the first client to connect to a server
+ * opens the socket, the others share it, and the socket is closed once the
+ * last of them unregisters.
+ *
+ * A client registers for an id and puts it in the sender field of its
+ * messages. The servers of the echo protocols (ABD and its multi-writer
+ * variant) return the header of a request in its reply, sender included, so
+ * the manager reassembles the replies of a shared socket and hands each one,
+ * header included, to the client its sender names. The servers see a single
+ * client per node; the relay protocols, which tell the clients apart by
+ * their address, cannot be multiplexed.
+ *
+ * The connect callback of a client is called once per server, when the
+ * shared socket connects or, if it is already connected, right after the
+ * client joined it.
+ */
+class AmConnectionManager : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  AmConnectionManager ();
+  virtual ~AmConnectionManager ();
+
+  /// Receives a message: the shared socket, the message (header included) and the server address
+  typedef Callback<void, Ptr<Socket>, Ptr<Packet>, const Address &> RecvCallback;
+
+  /// Notified that a shared socket is connected
+  typedef Callback<void, Ptr<Socket> > ConnectedCallback;
+
+  /**
+   * \param node a node
+   * \returns the manager of the node, aggregated to it on first use
+   */
+  static Ptr<AmConnectionManager> GetManager (Ptr<Node> node);
+
+  /**
+   * \brief add a client
+   * \param recv called with the messages sent to the client
+   * \param connected called as the sockets of the client connect
+   * \returns the id the client puts in the sender field of its messages
+   */
+  uint32_t Register (RecvCallback recv, ConnectedCallback connected);
+
+  /**
+   * \brief remove a client from its sockets, closing the ones no other
+   * client shares
+   * \param client the id of the client
+   */
+  void Unregister (uint32_t client);
+
+  /**
+   * \brief join a client to the socket of a server, opened if needed
+   * \param client the id of the client
+   * \param tid the socket factory (ns3::TcpSocketFactory or ns3::UdpSocketFactory)
+   * \param server the address and port of the server
+   * \returns the shared socket
+   */
+  Ptr<Socket> Connect (uint32_t client, TypeId tid, const Address &server);
+
+  /**
+   * \returns the clients registered
+   */
+  uint32_t GetClients (void) const;
+
+  /**
+   * \returns the sockets open
+   */
+  uint32_t GetConnections (void) const;
+
+  /**
+   * \returns the messages handed to the clients
+   */
+  uint64_t GetDemultiplexed (void) const;
+
+  /**
+   * \returns the messages of no registered client, dropped
+   */
+  uint64_t GetDropped (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// A registered client
+  struct Client
+  {
+    RecvCallback recv;            //!< receives the messages of the client
+    ConnectedCallback connected;  //!< notified of the connected sockets
+  };
+
+  /// The factory and the address of a server
+  typedef std::pair<TypeId, Address> Key;
+
+  /// A shared socket
+  struct Connection
+  {
+    Ptr<Socket> socket;           //!< the socket
+    bool connected;               //!< whether it is connected
+    std::set<uint32_t> clients;   //!< the clients sharing it
+  };
+
+  /**
+   * \brief notify the clients of a socket that it is connected
+   * \param socket the socket
+   */
+  void ConnectionSucceeded (Ptr<Socket> socket);
+
+  /**
+   * \brief log a socket that failed to connect
+   * \param socket the socket
+   */
+  void ConnectionFailed (Ptr<Socket> socket);
+
+  /**
+   * \brief notify a client that a socket is connected, if it still shares it
+   * \param client the id of the client
+   * \param socket the socket
+   */
+  void NotifyConnected (uint32_t client, Ptr<Socket> socket);
+
+  /**
+   * \brief hand the messages received on a socket to their clients
+   * \param socket the socket
+   */
+  void HandleRecv (Ptr<Socket> socket);
+
+  /**
+   * \brief close a socket and forget it
+   * \param it the connection of the socket
+   */
+  void Close (std::map<Key, Connection>::iterator it);
+
+  std::map<uint32_t, Client> m_clients;     //!< the registered clients, by id
+  std::map<Key, Connection> m_connections;  //!< the shared sockets, by server
+  std::map<Ptr<Socket>, Key> m_servers;     //!< the server of each shared socket
+  AmMessageFramer m_framer;                 //!< reassembles the messages of each socket
+  uint32_t m_nextId;                        //!< id of the next client
+  uint64_t m_demultiplexed;                 //!< messages handed to the clients
+  uint64_t m_dropped;                       //!< messages of no registered client
+};
+
+} // namespace ns3
+
+#endif /* AM_CONNECTION_MANAGER_H */
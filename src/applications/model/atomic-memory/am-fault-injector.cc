@@ -0,0 +1,362 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/fatal-error.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/pointer.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "am-fault-injector.h"
+#include "am-service-queue.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmFaultInjector");
+
+NS_OBJECT_ENSURE_REGISTERED (AmFaultInjector);
+
+TypeId
+AmFaultInjector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmFaultInjector")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<AmFaultInjector> ()
+    .AddAttribute ("Crashes",
+                   "The number of servers, from the first one, that crash at CrashTime",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&AmFaultInjector::m_crashes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CrashTime",
+                   "The time the Crashes servers crash",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&AmFaultInjector::m_crashTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("RecoveryTime",
+                   "The time the Crashes servers recover, 0 for never",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&AmFaultInjector::m_recoveryTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("ScheduleFile",
+                   "File of the faults to schedule, one per line: time action target [value]",
+                   StringValue (""),
+                   MakeStringAccessor (&AmFaultInjector::m_scheduleFile),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+AmFaultInjector::AmFaultInjector ()
+  : m_faults (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AmFaultInjector::~AmFaultInjector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AmFaultInjector::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<EventId>::iterator it = m_events.begin (); it != m_events.end (); ++it)
+    {
+      it->Cancel ();
+    }
+  m_events.clear ();
+  m_servers = ApplicationContainer ();
+  m_links.clear ();
+  m_drops.clear ();
+  Object::DoDispose ();
+}
+
+void
+AmFaultInjector::AddServers (ApplicationContainer servers)
+{
+  NS_LOG_FUNCTION (this);
+  for (ApplicationContainer::Iterator i = servers.Begin (); i != servers.End (); ++i)
+    {
+      TypeId::AttributeInformation info;
+      if (!(*i)->GetInstanceTypeId ().LookupAttributeByName ("Fault", &info))
+        {
+          NS_FATAL_ERROR ("Application " << (*i)->GetInstanceTypeId ().GetName () << " has no Fault attribute");
+        }
+      m_servers.Add (*i);
+    }
+}
+
+uint32_t
+AmFaultInjector::AddLink (NetDeviceContainer devices)
+{
+  NS_LOG_FUNCTION (this);
+  m_links.push_back (devices);
+  m_drops.push_back (std::vector<Ptr<RateErrorModel> > ());
+  return m_links.size () - 1;
+}
+
+void
+AmFaultInjector::ScheduleFaults (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_crashes; i++)
+    {
+      Crash (i, m_crashTime);
+      if (m_recoveryTime > m_crashTime)
+        {
+          Recover (i, m_recoveryTime);
+        }
+    }
+  if (!m_scheduleFile.empty ())
+    {
+      Load (m_scheduleFile);
+    }
+}
+
+void
+AmFaultInjector::Crash (uint32_t server, Time at)
+{
+  GetServer (server);
+  m_events.push_back (Simulator::Schedule (at - Simulator::Now (), &AmFaultInjector::SetFault, this,
+                                           server, (uint32_t) AmServiceQueue::CRASH));
+}
+
+void
+AmFaultInjector::Recover (uint32_t server, Time at)
+{
+  GetServer (server);
+  m_events.push_back (Simulator::Schedule (at - Simulator::Now (), &AmFaultInjector::SetFault, this,
+                                           server, (uint32_t) AmServiceQueue::NONE));
+  m_events.push_back (Simulator::Schedule (at - Simulator::Now (), &AmFaultInjector::SetSlowdown, this,
+                                           server, Seconds (0)));
+}
+
+void
+AmFaultInjector::Pause (uint32_t server, Time at, Time duration)
+{
+  GetServer (server);
+  m_events.push_back (Simulator::Schedule (at - Simulator::Now (), &AmFaultInjector::SetFault, this,
+                                           server, (uint32_t) AmServiceQueue::PAUSE));
+  m_events.push_back (Simulator::Schedule (at + duration - Simulator::Now (), &AmFaultInjector::SetFault, this,
+                                           server, (uint32_t) AmServiceQueue::NONE));
+}
+
+void
+AmFaultInjector::Slow (uint32_t server, Time at, Time delay)
+{
+  GetServer (server);
+  m_events.push_back (Simulator::Schedule (at - Simulator::Now (), &AmFaultInjector::SetSlowdown, this,
+                                           server, delay));
+}
+
+void
+AmFaultInjector::LinkDown (uint32_t link, Time at)
+{
+  CheckLink (link, at);
+  if (m_drops[link].empty ())
+    {
+      // every packet the devices receive is corrupt while the link is down
+      for (uint32_t i = 0; i < m_links[link].GetN (); i++)
+        {
+          Ptr<RateErrorModel> drop = CreateObject<RateErrorModel> ();
+          drop->SetAttribute ("ErrorUnit", EnumValue (RateErrorModel::ERROR_UNIT_PACKET));
+          drop->SetAttribute ("ErrorRate", DoubleValue (1.0));
+          drop->Disable ();
+          m_links[link].Get (i)->SetAttribute ("ReceiveErrorModel", PointerValue (drop));
+          m_drops[link].push_back (drop);
+        }
+    }
+  m_events.push_back (Simulator::Schedule (at - Simulator::Now (), &AmFaultInjector::SetLinkUp, this,
+                                           link, false));
+}
+
+void
+AmFaultInjector::LinkUp (uint32_t link, Time at)
+{
+  CheckLink (link, at);
+  m_events.push_back (Simulator::Schedule (at - Simulator::Now (), &AmFaultInjector::SetLinkUp, this,
+                                           link, true));
+}
+
+void
+AmFaultInjector::SlowLink (uint32_t link, Time at, Time delay)
+{
+  CheckLink (link, at);
+  m_events.push_back (Simulator::Schedule (at - Simulator::Now (), &AmFaultInjector::SetLinkDelay, this,
+                                           link, delay));
+}
+
+void
+AmFaultInjector::Load (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  std::ifstream in (fileName.c_str ());
+  if (!in.is_open ())
+    {
+      NS_FATAL_ERROR ("AmFaultInjector: cannot open the schedule file " << fileName);
+    }
+
+  std::string line;
+  uint32_t lineNumber = 0;
+  while (std::getline (in, line))
+    {
+      lineNumber++;
+      std::string::size_type comment = line.find ('#');
+      if (comment != std::string::npos)
+        {
+          line.erase (comment);
+        }
+      std::istringstream fields (line);
+      std::string time, action, value;
+      uint32_t target;
+      if (!(fields >> time))
+        {
+          continue;
+        }
+      if (!(fields >> action >> target))
+        {
+          NS_FATAL_ERROR ("AmFaultInjector: " << fileName << ":" << lineNumber << ": expected time action target [value]");
+        }
+      fields >> value;
+
+      Time at (time);
+      if (action == "crash")
+        {
+          Crash (target, at);
+        }
+      else if (action == "recover")
+        {
+          Recover (target, at);
+        }
+      else if (action == "link-down")
+        {
+          LinkDown (target, at);
+        }
+      else if (action == "link-up")
+        {
+          LinkUp (target, at);
+        }
+      else if (value.empty ())
+        {
+          NS_FATAL_ERROR ("AmFaultInjector: " << fileName << ":" << lineNumber << ": " << action << " needs a value");
+        }
+      else if (action == "pause")
+        {
+          Pause (target, at, Time (value));
+        }
+      else if (action == "slow")
+        {
+          Slow (target, at, Time (value));
+        }
+      else if (action == "link-delay")
+        {
+          SlowLink (target, at, Time (value));
+        }
+      else
+        {
+          NS_FATAL_ERROR ("AmFaultInjector: " << fileName << ":" << lineNumber << ": unknown action " << action);
+        }
+    }
+}
+
+uint32_t
+AmFaultInjector::GetFaults (void) const
+{
+  return m_faults;
+}
+
+void
+AmFaultInjector::SetFault (uint32_t server, uint32_t fault)
+{
+  NS_LOG_FUNCTION (this << server << fault);
+  static const char *names[] = { "recovers", "crashes", "pauses" };
+  std::cout << "** FAULT: server " << server << " " << names[fault] << " at " << Simulator::Now ().GetSeconds () << "s **" << std::endl;
+  m_faults++;
+  GetServer (server)->SetAttribute ("Fault", EnumValue (fault));
+}
+
+void
+AmFaultInjector::SetSlowdown (uint32_t server, Time delay)
+{
+  NS_LOG_FUNCTION (this << server << delay);
+  TimeValue current;
+  GetServer (server)->GetAttribute ("Slowdown", current);
+  if (current.Get () == delay)
+    {
+      return;
+    }
+  std::cout << "** FAULT: server " << server << " slowed down by " << delay.GetSeconds () << "s at " << Simulator::Now ().GetSeconds () << "s **" << std::endl;
+  m_faults++;
+  GetServer (server)->SetAttribute ("Slowdown", TimeValue (delay));
+}
+
+void
+AmFaultInjector::SetLinkUp (uint32_t link, bool up)
+{
+  NS_LOG_FUNCTION (this << link << up);
+  std::cout << "** FAULT: link " << link << (up ? " up" : " down") << " at " << Simulator::Now ().GetSeconds () << "s **" << std::endl;
+  m_faults++;
+  for (std::vector<Ptr<RateErrorModel> >::iterator it = m_drops[link].begin (); it != m_drops[link].end (); ++it)
+    {
+      if (up)
+        {
+          (*it)->Disable ();
+        }
+      else
+        {
+          (*it)->Enable ();
+        }
+    }
+}
+
+void
+AmFaultInjector::SetLinkDelay (uint32_t link, Time delay)
+{
+  NS_LOG_FUNCTION (this << link << delay);
+  std::cout << "** FAULT: link " << link << " delay " << delay.GetSeconds () << "s at " << Simulator::Now ().GetSeconds () << "s **" << std::endl;
+  m_faults++;
+  m_links[link].Get (0)->GetChannel ()->SetAttribute ("Delay", TimeValue (delay));
+}
+
+Ptr<Application>
+AmFaultInjector::GetServer (uint32_t server) const
+{
+  if (server >= m_servers.GetN ())
+    {
+      NS_FATAL_ERROR ("AmFaultInjector: no server " << server << ", " << m_servers.GetN () << " were added");
+    }
+  return m_servers.Get (server);
+}
+
+void
+AmFaultInjector::CheckLink (uint32_t link, Time at) const
+{
+  if (link >= m_links.size ())
+    {
+      NS_FATAL_ERROR ("AmFaultInjector: no link " << link << " for the fault at " << at.GetSeconds () << "s, " << m_links.size () << " were added");
+    }
+}
+
+} // namespace ns3
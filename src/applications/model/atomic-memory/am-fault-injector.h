@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_FAULT_INJECTOR_H
+#define AM_FAULT_INJECTOR_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/error-model.h"
+#include "ns3/application-container.h"
+#include "ns3/net-device-container.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmFaultInjector
+ * \brief Crashes, pauses and slows down servers and links at given times.
+ *
+ * The servers are added with AddServers, in the order of their IDs, and
+ * must have the "Fault" and "Slowdown" attributes of the atomic memory
+ * servers (see AmServiceQueue): a crashed server loses every message it
+ * receives until it recovers, a paused one handles them when the pause
+ * ends, and a slowed down one handles each message only after the given
+ * delay. A server recovers with the registers it had, as from stable
+ * storage. The links are added with AddLink: a link that is down drops
+ * every packet, in both directions, and the delay of a link can be
+ * changed (point-to-point and CSMA channels).
+ *
+ * The faults are scheduled by the methods below, by the Crashes,
+ * CrashTime and RecoveryTime attributes, or by a ScheduleFile with one
+ * fault per line:
+ *
+ * \verbatim
+   # time  action      target  [value]
+   5s      crash       1
+   8s      recover     1
+   5s      pause       2       1.5s
+   6s      slow        0       20ms
+   9s      slow        0       0s
+   7s      link-down   3
+   7.5s    link-up     3
+   7s      link-delay  0       50ms
+   \endverbatim
+ *
+ * where the target is the index of a server or of a link and a time
+ * without a unit is in seconds. Every fault prints a "** FAULT" line when
+ * it happens; combined with the intervals of AmStatsCollector, the
+ * latency can be followed around the faults.
+ */
+class AmFaultInjector : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  AmFaultInjector ();
+  virtual ~AmFaultInjector ();
+
+  /**
+   * \brief add servers the faults can target
+   * \param servers the server applications, in the order of their IDs
+   */
+  void AddServers (ApplicationContainer servers);
+
+  /**
+   * \brief add a link the faults can target
+   * \param devices the devices of the link
+   * \return the index of the link
+   */
+  uint32_t AddLink (NetDeviceContainer devices);
+
+  /**
+   * \brief schedule the faults of the attributes and of the ScheduleFile,
+   * once the servers and the links are added
+   */
+  void ScheduleFaults (void);
+
+  /**
+   * \param server the index of a server
+   * \param at the time it crashes
+   */
+  void Crash (uint32_t server, Time at);
+
+  /**
+   * \param server the index of a server
+   * \param at the time it recovers from a crash, a pause or a slowdown
+   */
+  void Recover (uint32_t server, Time at);
+
+  /**
+   * \param server the index of a server
+   * \param at the time it is paused
+   * \param duration the length of the pause
+   */
+  void Pause (uint32_t server, Time at, Time duration);
+
+  /**
+   * \param server the index of a server
+   * \param at the time it slows down
+   * \param delay the time every message waits, 0 to end the slowdown
+   */
+  void Slow (uint32_t server, Time at, Time delay);
+
+  /**
+   * \param link the index of a link
+   * \param at the time it goes down
+   */
+  void LinkDown (uint32_t link, Time at);
+
+  /**
+   * \param link the index of a link
+   * \param at the time it goes back up
+   */
+  void LinkUp (uint32_t link, Time at);
+
+  /**
+   * \param link the index of a link
+   * \param at the time its delay changes
+   * \param delay the new delay of the link
+   */
+  void SlowLink (uint32_t link, Time at, Time delay);
+
+  /**
+   * \brief schedule the faults of a file
+   * \param fileName the schedule, in the format above
+   */
+  void Load (std::string fileName);
+
+  /**
+   * \returns the faults that happened
+   */
+  uint32_t GetFaults (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \param server the index of a server
+   * \param fault the AmServiceQueue::Fault it suffers from now on
+   */
+  void SetFault (uint32_t server, uint32_t fault);
+
+  /**
+   * \param server the index of a server
+   * \param delay the time every message waits from now on
+   */
+  void SetSlowdown (uint32_t server, Time delay);
+
+  /**
+   * \param link the index of a link
+   * \param up whether its packets go through from now on
+   */
+  void SetLinkUp (uint32_t link, bool up);
+
+  /**
+   * \param link the index of a link
+   * \param delay its delay from now on
+   */
+  void SetLinkDelay (uint32_t link, Time delay);
+
+  /**
+   * \param server the index of a server
+   * \returns the server, after checking the index
+   */
+  Ptr<Application> GetServer (uint32_t server) const;
+
+  /**
+   * \param link the index of a link
+   * \param at the time of its fault
+   */
+  void CheckLink (uint32_t link, Time at) const;
+
+  uint32_t m_crashes;                         //!< servers crashed by the attributes
+  Time m_crashTime;                           //!< time of these crashes
+  Time m_recoveryTime;                        //!< time they recover, 0 for never
+  std::string m_scheduleFile;                 //!< file of faults to schedule
+  ApplicationContainer m_servers;             //!< the servers
+  std::vector<NetDeviceContainer> m_links;    //!< the devices of the links
+  std::vector<std::vector<Ptr<RateErrorModel> > > m_drops; //!< drop models of the links
+  std::vector<EventId> m_events;              //!< the scheduled faults
+  uint32_t m_faults;                          //!< faults that happened
+};
+
+} // namespace ns3
+
+#endif /* AM_FAULT_INJECTOR_H */
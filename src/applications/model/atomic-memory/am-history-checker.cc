@@ -0,0 +1,350 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/fatal-error.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/callback.h"
+#include "am-history-checker.h"
+#include "asm-common.h"
+#include <algorithm>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmHistoryChecker");
+
+NS_OBJECT_ENSURE_REGISTERED (AmHistoryChecker);
+
+namespace {
+
+/**
+ * \param op an operation
+ * \param t a time
+ * \returns whether op completed before t
+ */
+bool
+CompletedBefore (const AmHistoryChecker::Operation &op, Time t)
+{
+  return op.completed < t;
+}
+
+} // anonymous namespace
+
+TypeId
+AmHistoryChecker::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmHistoryChecker")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<AmHistoryChecker> ()
+    .AddAttribute ("Horizon",
+                   "The history kept per key: operations invoked before it are not checked, 0 to keep all",
+                   TimeValue (Seconds (60)),
+                   MakeTimeAccessor (&AmHistoryChecker::m_horizon),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxViolations",
+                   "The violations kept, with their operations, for Report",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&AmHistoryChecker::m_maxViolations),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("HistoryFile",
+                   "File the operations are streamed to, none if empty",
+                   StringValue (""),
+                   MakeStringAccessor (&AmHistoryChecker::m_historyFile),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+AmHistoryChecker::Register::Register ()
+  : pruned (false),
+    floor (0, 0)
+{
+}
+
+AmHistoryChecker::AmHistoryChecker ()
+  : m_clients (0),
+    m_operations (0),
+    m_unchecked (0),
+    m_unmatched (0),
+    m_violations (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AmHistoryChecker::~AmHistoryChecker ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AmHistoryChecker::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_history.is_open ())
+    {
+      m_history.close ();
+    }
+  m_registers.clear ();
+  Object::DoDispose ();
+}
+
+void
+AmHistoryChecker::AddClients (ApplicationContainer clients)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_historyFile.empty () && !m_history.is_open ())
+    {
+      m_history.open (m_historyFile.c_str ());
+      if (!m_history.is_open ())
+        {
+          NS_FATAL_ERROR ("AmHistoryChecker: cannot open the history file " << m_historyFile);
+        }
+    }
+  for (ApplicationContainer::Iterator i = clients.Begin (); i != clients.End (); ++i)
+    {
+      if (!(*i)->TraceConnectWithoutContext ("OpCompleted", MakeBoundCallback (&AmHistoryChecker::OpCompleted, this, m_clients++)))
+        {
+          NS_FATAL_ERROR ("Application " << (*i)->GetInstanceTypeId ().GetName () << " has no OpCompleted trace source");
+        }
+    }
+}
+
+void
+AmHistoryChecker::OpCompleted (AmHistoryChecker *checker, uint32_t client, uint32_t type,
+                               uint32_t exchanges, Time latency, uint32_t tag,
+                               uint32_t key, uint32_t writer)
+{
+  Operation op;
+  op.client = client;
+  op.type = type;
+  op.key = key;
+  op.completed = Simulator::Now ();
+  op.invoked = op.completed - latency;
+  op.tag = Tag (tag, writer);
+  checker->Check (op);
+}
+
+void
+AmHistoryChecker::Check (const Operation &op)
+{
+  NS_LOG_FUNCTION (this << op.client << op.type << op.key << op.tag.first << op.tag.second);
+  m_operations++;
+  if (m_history.is_open ())
+    {
+      m_history << op.client << " " << op.type << " " << op.key << " "
+                << op.invoked.GetNanoSeconds () << " " << op.completed.GetNanoSeconds () << " "
+                << op.tag.first << " " << op.tag.second << "\n";
+    }
+
+  Register &reg = m_registers[op.key];
+  Prune (reg);
+
+  // the greatest tag completed before the invocation bounds the tag of op
+  std::deque<Operation>::iterator bound = std::lower_bound (reg.raised.begin (), reg.raised.end (),
+                                                            op.invoked, CompletedBefore);
+  if (bound == reg.raised.begin ())
+    {
+      if (reg.pruned)
+        {
+          m_unchecked++;
+        }
+      else if (op.type == WRITE && op.tag == Tag (0, 0))
+        {
+          Violate ("the write has the initial tag", op, 0);
+        }
+    }
+  else
+    {
+      --bound;
+      if (op.type == WRITE && !(bound->tag < op.tag))
+        {
+          Violate ("the write has no greater tag than an operation completed before it", op, &*bound);
+        }
+      else if (op.type == READ && op.tag < bound->tag)
+        {
+          Violate ("the read returned an older tag than an operation completed before it", op, &*bound);
+        }
+    }
+
+  if (op.type == WRITE)
+    {
+      if (!(op.tag < reg.floor))
+        {
+          std::pair<std::map<Tag, Operation>::iterator, bool> added = reg.writes.insert (std::make_pair (op.tag, op));
+          if (!added.second)
+            {
+              Violate ("two writes have the same tag", op, &added.first->second);
+            }
+        }
+      std::pair<std::multimap<Tag, Operation>::iterator, std::multimap<Tag, Operation>::iterator> reads = reg.waiting.equal_range (op.tag);
+      for (std::multimap<Tag, Operation>::iterator it = reads.first; it != reads.second; ++it)
+        {
+          if (!(op.invoked < it->second.completed))
+            {
+              Violate ("the read returned the tag of a write invoked after it completed", it->second, &op);
+            }
+        }
+      reg.waiting.erase (reads.first, reads.second);
+    }
+  else if (op.tag != Tag (0, 0) && !(op.tag < reg.floor) && reg.writes.find (op.tag) == reg.writes.end ())
+    {
+      // the write is still in progress, or was never invoked
+      reg.waiting.insert (std::make_pair (op.tag, op));
+    }
+
+  // the operations complete in order, so raised stays sorted by response
+  if (reg.raised.empty () || reg.raised.back ().tag < op.tag)
+    {
+      reg.raised.push_back (op);
+    }
+}
+
+void
+AmHistoryChecker::Prune (Register &reg)
+{
+  if (m_horizon.IsZero ())
+    {
+      return;
+    }
+  Time horizon = Simulator::Now () - m_horizon;
+  if (reg.raised.size () < 2 || !(reg.raised[1].completed < horizon))
+    {
+      return;
+    }
+
+  // the last operation before the horizon still bounds the newer ones
+  while (reg.raised.size () > 1 && reg.raised[1].completed < horizon)
+    {
+      reg.raised.pop_front ();
+    }
+  reg.pruned = true;
+  reg.floor = reg.raised.front ().tag;
+  reg.writes.erase (reg.writes.begin (), reg.writes.lower_bound (reg.floor));
+
+  for (std::multimap<Tag, Operation>::iterator it = reg.waiting.begin (); it != reg.waiting.end (); )
+    {
+      if (it->second.completed < horizon)
+        {
+          NS_LOG_WARN ("No write of the tag <" << it->first.first << "," << it->first.second << "> completed within the horizon");
+          m_unmatched++;
+          reg.waiting.erase (it++);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+}
+
+void
+AmHistoryChecker::Finish (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::map<uint32_t, Register>::iterator it = m_registers.begin (); it != m_registers.end (); ++it)
+    {
+      m_unmatched += it->second.waiting.size ();
+      it->second.waiting.clear ();
+    }
+}
+
+void
+AmHistoryChecker::Violate (const std::string &reason, const Operation &op, const Operation *other)
+{
+  m_violations++;
+  std::ostringstream oss;
+  Print (oss, op);
+  if (other != 0)
+    {
+      oss << " / ";
+      Print (oss, *other);
+    }
+  NS_LOG_WARN ("Violation: " << reason << ": " << oss.str ());
+
+  if (m_violationList.size () < m_maxViolations)
+    {
+      Violation v;
+      v.reason = reason;
+      v.op = op;
+      v.hasOther = other != 0;
+      if (other != 0)
+        {
+          v.other = *other;
+        }
+      m_violationList.push_back (v);
+    }
+}
+
+void
+AmHistoryChecker::Print (std::ostream &os, const Operation &op)
+{
+  os << "client " << op.client << (op.type == WRITE ? " write" : " read")
+     << " key " << op.key << " [" << op.invoked.GetSeconds () << "s, "
+     << op.completed.GetSeconds () << "s] <" << op.tag.first << "," << op.tag.second << ">";
+}
+
+uint64_t
+AmHistoryChecker::GetOperations (void) const
+{
+  return m_operations;
+}
+
+uint64_t
+AmHistoryChecker::GetUnchecked (void) const
+{
+  return m_unchecked;
+}
+
+uint64_t
+AmHistoryChecker::GetUnmatched (void) const
+{
+  return m_unmatched;
+}
+
+uint64_t
+AmHistoryChecker::GetViolations (void) const
+{
+  return m_violations;
+}
+
+const std::vector<AmHistoryChecker::Violation> &
+AmHistoryChecker::GetViolationList (void) const
+{
+  return m_violationList;
+}
+
+void
+AmHistoryChecker::Report (std::ostream &os) const
+{
+  os << "** HISTORY: #ops=" << m_operations << ", #unchecked=" << m_unchecked
+     << ", #unmatched=" << m_unmatched << ", #violations=" << m_violations << " **" << std::endl;
+  for (std::vector<Violation>::const_iterator it = m_violationList.begin (); it != m_violationList.end (); ++it)
+    {
+      os << "** VIOLATION: " << it->reason << ": ";
+      Print (os, it->op);
+      if (it->hasOther)
+        {
+          os << " / ";
+          Print (os, it->other);
+        }
+      os << " **" << std::endl;
+    }
+}
+
+} // namespace ns3
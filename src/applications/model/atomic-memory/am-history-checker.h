@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_HISTORY_CHECKER_H
+#define AM_HISTORY_CHECKER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/application-container.h"
+#include <deque>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmHistoryChecker
+ * \brief Streaming atomicity checker of the operations of the clients.
+ *
+ * The checker connects to the "OpCompleted" trace source of the clients and
+ * checks every completed operation, as it completes, against the history of
+ * its key. An operation is its interval [invocation, response] and the tag
+ * <ts, writer> it wrote or returned; tags are ordered by timestamp then by
+ * writer, as the servers order them. The history is atomic if:
+ *
+ *  - an operation has a tag at least the one of every operation that
+ *    completed before it was invoked, and a write a greater one;
+ *  - no two writes have the same tag;
+ *  - a read returns the initial tag <0, 0> or the tag of a write invoked
+ *    before the read completed.
+ *
+ * For the first check each key keeps, in the order of the responses, the
+ * operations that raised the greatest tag completed so far: the bound of an
+ * operation is found by a binary search on its invocation, so each operation
+ * costs O(log n). The memory is bounded by Horizon: the operations that
+ * completed before it are dropped but for the last one, which still bounds
+ * the newer operations, and an operation invoked before that one is counted
+ * as unchecked instead. A read of a write still in progress waits for it; if
+ * the write never completes (the run ended, or its client is stuck), the
+ * read is counted as unmatched, which is no violation.
+ *
+ * A violation is logged and counted; the first MaxViolations are kept,
+ * with the two offending operations, for Report. The HistoryFile attribute
+ * streams every operation, one per line:
+ *
+ * \verbatim
+   client type key invocation(ns) response(ns) ts writer
+   \endverbatim
+ *
+ * The tags of the single-writer protocols carry the writer 0, and those of
+ * the multi-writer ones the id of the writer.
+ */
+class AmHistoryChecker : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  AmHistoryChecker ();
+  virtual ~AmHistoryChecker ();
+
+  /// The tag of a value: timestamp and writer id
+  typedef std::pair<uint32_t, uint32_t> Tag;
+
+  /// A completed operation
+  struct Operation
+  {
+    uint32_t client;     //!< index of the client
+    uint32_t type;       //!< WRITE or READ
+    uint32_t key;        //!< the key of the register
+    Time invoked;        //!< invocation time
+    Time completed;      //!< response time
+    Tag tag;             //!< tag written or returned
+  };
+
+  /// A violation of atomicity
+  struct Violation
+  {
+    std::string reason;  //!< the broken rule
+    Operation op;        //!< the operation that broke it
+    Operation other;     //!< the operation it conflicts with
+    bool hasOther;       //!< whether there is such an operation
+  };
+
+  /**
+   * \brief check the operations of the clients
+   * \param clients the client applications
+   */
+  void AddClients (ApplicationContainer clients);
+
+  /**
+   * \brief check a completed operation
+   * \param op the operation
+   */
+  void Check (const Operation &op);
+
+  /**
+   * \brief count the reads still waiting for their write as unmatched, at
+   * the end of the run
+   */
+  void Finish (void);
+
+  /**
+   * \returns the operations checked so far
+   */
+  uint64_t GetOperations (void) const;
+
+  /**
+   * \returns the operations invoked before the horizon of their key
+   */
+  uint64_t GetUnchecked (void) const;
+
+  /**
+   * \returns the reads of a write that never completed
+   */
+  uint64_t GetUnmatched (void) const;
+
+  /**
+   * \returns the violations found
+   */
+  uint64_t GetViolations (void) const;
+
+  /**
+   * \returns the first MaxViolations violations
+   */
+  const std::vector<Violation> & GetViolationList (void) const;
+
+  /**
+   * \brief write the counters and the violations kept
+   * \param os the output stream
+   */
+  void Report (std::ostream &os) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// The history of a key
+  struct Register
+  {
+    Register ();
+
+    std::deque<Operation> raised;           //!< operations that raised the greatest tag, by response
+    bool pruned;                            //!< whether operations were dropped
+    Tag floor;                              //!< the tags below it are forgotten
+    std::map<Tag, Operation> writes;        //!< completed writes from the floor on
+    std::multimap<Tag, Operation> waiting;  //!< reads of a write in progress
+  };
+
+  /**
+   * \brief trace sink of the clients
+   * \param checker the checker
+   * \param client the index of the client
+   * \param type WRITE or READ
+   * \param exchanges the exchanges of the operation
+   * \param latency the latency
+   * \param tag the timestamp of the value
+   * \param key the key of the register
+   * \param writer the writer id of the tag
+   */
+  static void OpCompleted (AmHistoryChecker *checker, uint32_t client, uint32_t type,
+                           uint32_t exchanges, Time latency, uint32_t tag,
+                           uint32_t key, uint32_t writer);
+
+  /**
+   * \brief drop the history older than the horizon
+   * \param reg the history of a key
+   */
+  void Prune (Register &reg);
+
+  /**
+   * \brief count and keep a violation
+   * \param reason the broken rule
+   * \param op the operation that broke it
+   * \param other the operation it conflicts with, or 0
+   */
+  void Violate (const std::string &reason, const Operation &op, const Operation *other);
+
+  /**
+   * \brief write an operation
+   * \param os the output stream
+   * \param op the operation
+   */
+  static void Print (std::ostream &os, const Operation &op);
+
+  Time m_horizon;                           //!< history kept per key
+  uint32_t m_maxViolations;                 //!< violations kept for Report
+  std::string m_historyFile;                //!< file of the operations
+  std::ofstream m_history;                  //!< stream of HistoryFile
+  uint32_t m_clients;                       //!< clients connected
+  std::map<uint32_t, Register> m_registers; //!< the history of each key
+  uint64_t m_operations;                    //!< operations checked
+  uint64_t m_unchecked;                     //!< operations before the horizon
+  uint64_t m_unmatched;                     //!< reads of a write that never completed
+  uint64_t m_violations;                    //!< violations found
+  std::vector<Violation> m_violationList;   //!< the first violations
+};
+
+} // namespace ns3
+
+#endif /* AM_HISTORY_CHECKER_H */
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "am-key-selector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmKeySelector");
+
+AmKeySelector::AmKeySelector ()
+  : m_numKeys (1),
+    m_dist (UNIFORM)
+{
+  m_rv = CreateObject<UniformRandomVariable> ();
+}
+
+void
+AmKeySelector::SetDistribution (uint32_t numKeys, Distribution dist, double alpha)
+{
+  NS_LOG_FUNCTION (this << numKeys << dist << alpha);
+  NS_ASSERT_MSG (numKeys > 0, "AmKeySelector: the key space is empty");
+
+  m_numKeys = numKeys;
+  m_dist = dist;
+  m_cdf.clear ();
+
+  if (m_dist == ZIPF)
+    {
+      m_cdf.resize (m_numKeys);
+      double sum = 0;
+      for (uint32_t i = 0; i < m_numKeys; i++)
+        {
+          sum += 1.0 / std::pow ((double)(i + 1), alpha);
+          m_cdf[i] = sum;
+        }
+      for (uint32_t i = 0; i < m_numKeys; i++)
+        {
+          m_cdf[i] /= sum;
+        }
+    }
+}
+
+int64_t
+AmKeySelector::AssignStreams (int64_t stream)
+{
+  m_rv->SetStream (stream);
+  return 1;
+}
+
+uint32_t
+AmKeySelector::GetNext (void)
+{
+  if (m_numKeys == 1)
+    {
+      return 0;
+    }
+
+  if (m_dist == ZIPF)
+    {
+      double u = m_rv->GetValue ();
+      uint32_t key = std::upper_bound (m_cdf.begin (), m_cdf.end (), u) - m_cdf.begin ();
+      return std::min (key, m_numKeys - 1);
+    }
+
+  return m_rv->GetInteger (0, m_numKeys - 1);
+}
+
+} // namespace ns3
@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_KEY_SELECTOR_H
+#define AM_KEY_SELECTOR_H
+
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmKeySelector
+ * \brief Picks the key accessed by each operation of a client.
+ *
+ * Keys are drawn from [0, numKeys) either uniformly or following a zipf
+ * distribution with exponent alpha, where key 0 is the most popular one.
+ * The zipf cumulative distribution is computed once, so drawing a key costs
+ * a binary search regardless of the distribution.
+ */
+class AmKeySelector
+{
+public:
+  /// Key distributions
+  enum Distribution
+  {
+    UNIFORM,
+    ZIPF
+  };
+
+  AmKeySelector ();
+
+  /**
+   * \brief set the key space and the distribution of the keys
+   * \param numKeys the number of keys
+   * \param dist the distribution of the keys
+   * \param alpha the exponent of the zipf distribution
+   */
+  void SetDistribution (uint32_t numKeys, Distribution dist, double alpha);
+
+  /**
+   * \brief assign a fixed random variable stream number
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * \return the key of the next operation
+   */
+  uint32_t GetNext (void);
+
+private:
+  uint32_t m_numKeys;           //!< size of the key space
+  Distribution m_dist;          //!< distribution of the keys
+  std::vector<double> m_cdf;    //!< zipf cumulative distribution
+  Ptr<UniformRandomVariable> m_rv; //!< source of randomness
+};
+
+} // namespace ns3
+
+#endif /* AM_KEY_SELECTOR_H */
@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "am-lease-table.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmLeaseTable");
+
+AmLeaseTable::AmLeaseTable ()
+  : m_leaseTime (Seconds (0)),
+    m_granted (0),
+    m_held (0),
+    m_holdTime (Seconds (0))
+{
+}
+
+void
+AmLeaseTable::SetLeaseTime (Time time)
+{
+  NS_LOG_FUNCTION (this << time);
+  m_leaseTime = time;
+}
+
+bool
+AmLeaseTable::IsEnabled (void) const
+{
+  return m_leaseTime.IsStrictlyPositive ();
+}
+
+bool
+AmLeaseTable::Grant (uint32_t key, const Holder &holder)
+{
+  NS_LOG_FUNCTION (this << key << holder.second);
+  Key &k = m_keys[key];
+
+  // the leases would hold the waiting messages back again
+  if (k.held > 0)
+    {
+      return false;
+    }
+  k.leases[holder] = Simulator::Now () + m_leaseTime;
+  m_granted++;
+  return true;
+}
+
+Time
+AmLeaseTable::GetWait (uint32_t key, const Holder &holder)
+{
+  NS_LOG_FUNCTION (this << key << holder.second);
+  std::map<uint32_t, Key>::iterator it = m_keys.find (key);
+  if (it == m_keys.end ())
+    {
+      return Seconds (0);
+    }
+  Expire (it->second);
+
+  Time end = Simulator::Now ();
+  for (std::map<Holder, Time>::const_iterator lease = it->second.leases.begin (); lease != it->second.leases.end (); ++lease)
+    {
+      if (lease->first != holder && lease->second > end)
+        {
+          end = lease->second;
+        }
+    }
+  if (it->second.leases.empty () && it->second.held == 0)
+    {
+      m_keys.erase (it);
+    }
+  return end - Simulator::Now ();
+}
+
+void
+AmLeaseTable::Hold (uint32_t key)
+{
+  NS_LOG_FUNCTION (this << key);
+  m_keys[key].held++;
+  m_held++;
+}
+
+void
+AmLeaseTable::Release (uint32_t key, Time waited)
+{
+  NS_LOG_FUNCTION (this << key << waited);
+  std::map<uint32_t, Key>::iterator it = m_keys.find (key);
+  if (it != m_keys.end () && it->second.held > 0)
+    {
+      it->second.held--;
+    }
+  m_holdTime += waited;
+}
+
+void
+AmLeaseTable::Expire (Key &key)
+{
+  Time now = Simulator::Now ();
+  for (std::map<Holder, Time>::iterator it = key.leases.begin (); it != key.leases.end (); )
+    {
+      if (it->second <= now)
+        {
+          key.leases.erase (it++);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+}
+
+void
+AmLeaseTable::Clear (void)
+{
+  m_keys.clear ();
+}
+
+uint64_t
+AmLeaseTable::GetGranted (void) const
+{
+  return m_granted;
+}
+
+uint64_t
+AmLeaseTable::GetHeld (void) const
+{
+  return m_held;
+}
+
+Time
+AmLeaseTable::GetHoldTime (void) const
+{
+  return m_holdTime;
+}
+
+bool
+AmReadLease::IsValid (void) const
+{
+  return end > Simulator::Now ();
+}
+
+void
+AmReadLease::Renew (Time leaseEnd, uint32_t leaseTs, uint32_t leaseId, uint32_t leaseValue, Ptr<Packet> leasePayload)
+{
+  // a tag read is at a quorum, the greater one stays valid under either lease
+  if (leaseTs > ts || (leaseTs == ts && leaseId >= id))
+    {
+      ts = leaseTs;
+      id = leaseId;
+      value = leaseValue;
+      payload = leasePayload;
+    }
+  if (leaseEnd > end)
+    {
+      end = leaseEnd;
+    }
+}
+
+} // namespace ns3
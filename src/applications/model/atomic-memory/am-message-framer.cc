@@ -0,0 +1,288 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "am-message-framer.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmMessageFramer");
+
+NS_OBJECT_ENSURE_REGISTERED (AmFrameHeader);
+
+AmFrameHeader::AmFrameHeader ()
+  : m_length (0)
+{
+}
+
+void
+AmFrameHeader::SetLength (uint32_t length)
+{
+  m_length = length;
+}
+uint32_t
+AmFrameHeader::GetLength (void) const
+{
+  return m_length;
+}
+
+TypeId
+AmFrameHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmFrameHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<AmFrameHeader> ()
+  ;
+  return tid;
+}
+TypeId
+AmFrameHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+void
+AmFrameHeader::Print (std::ostream &os) const
+{
+  os << "length=" << m_length;
+}
+uint32_t
+AmFrameHeader::GetSerializedSize (void) const
+{
+  return 4;
+}
+void
+AmFrameHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteHtonU32 (m_length);
+}
+uint32_t
+AmFrameHeader::Deserialize (Buffer::Iterator start)
+{
+  m_length = start.ReadNtohU32 ();
+  return GetSerializedSize ();
+}
+
+
+AmMessageFramer::AmMessageFramer ()
+{
+}
+
+void
+AmMessageFramer::Frame (Ptr<Packet> p)
+{
+  AmFrameHeader frame;
+  frame.SetLength (p->GetSize ());
+  p->AddHeader (frame);
+}
+
+Ptr<Packet>
+AmMessageFramer::Build (const Header &msg)
+{
+  // the message and its prefix are serialized in place, in the headroom
+  // that Buffer reserves at the start of a new packet
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (msg);
+  Frame (p);
+  return p;
+}
+
+Ptr<Packet>
+AmMessageFramer::Build (const Header &msg, Ptr<const Packet> payload)
+{
+  if (payload == 0 || payload->GetSize () == 0)
+    {
+      return Build (msg);
+    }
+
+  Ptr<Packet> p = payload->Copy ();
+  p->AddHeader (msg);
+  Frame (p);
+  return p;
+}
+
+Ptr<Packet>
+AmMessageFramer::Recv (Ptr<Socket> socket, Address &from)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  Stream &s = m_streams[socket];
+
+  Ptr<Packet> msg;
+  while ((msg = Extract (s)) == 0)
+    {
+      Ptr<Packet> segment = socket->RecvFrom (s.from);
+      if (segment == 0)
+        {
+          return 0;
+        }
+      if (segment->GetSize () > 0)
+        {
+          s.size += segment->GetSize ();
+          s.segments.push_back (segment);
+        }
+    }
+
+  from = s.from;
+  return msg;
+}
+
+Ptr<Packet>
+AmMessageFramer::Extract (Stream &s)
+{
+  AmFrameHeader frame;
+
+  if (s.size < frame.GetSerializedSize ())
+    {
+      return 0;
+    }
+
+  // the length prefix may be split over segments
+  while (s.segments.front ()->GetSize () < frame.GetSerializedSize ())
+    {
+      Ptr<Packet> first = s.segments.front ();
+      s.segments.pop_front ();
+      first->AddAtEnd (s.segments.front ());
+      s.segments.front () = first;
+    }
+
+  s.segments.front ()->PeekHeader (frame);
+  if (s.size < frame.GetSerializedSize () + frame.GetLength ())
+    {
+      NS_LOG_LOGIC ("Partial message: " << s.size << " of " << frame.GetLength () << " bytes buffered");
+      return 0;
+    }
+
+  Take (s, frame.GetSerializedSize ());
+  return Take (s, frame.GetLength ());
+}
+
+Ptr<Packet>
+AmMessageFramer::Take (Stream &s, uint32_t size)
+{
+  Ptr<Packet> front = s.segments.front ();
+  Ptr<Packet> bytes;
+
+  if (front->GetSize () >= size)
+    {
+      bytes = front->CreateFragment (0, size);
+      front->RemoveAtStart (size);
+      if (front->GetSize () == 0)
+        {
+          s.segments.pop_front ();
+        }
+    }
+  else if (IsVirtual (*(++s.segments.begin ())))
+    {
+      // a value sent as virtual zero bytes arrives in segments that start in
+      // their zero area: appending them to a packet that ends with its own
+      // bytes copies only their real bytes, so the zeros stay virtual. The
+      // first segment, which holds the message header, is copied into such
+      // a packet.
+      Ptr<Packet> first = s.segments.front ();
+      s.segments.pop_front ();
+      m_assembly.resize (first->GetSize ());
+      first->CopyData (&m_assembly[0], first->GetSize ());
+      bytes = Create<Packet> (&m_assembly[0], first->GetSize ());
+      while (bytes->GetSize () < size)
+        {
+          Ptr<Packet> segment = s.segments.front ();
+          uint32_t n = std::min (segment->GetSize (), size - bytes->GetSize ());
+          Ptr<Packet> piece = segment;
+          if (n == segment->GetSize ())
+            {
+              s.segments.pop_front ();
+            }
+          else
+            {
+              piece = segment->CreateFragment (0, n);
+              segment->RemoveAtStart (n);
+            }
+          // a segment copied by the sender, as one spanning two messages is,
+          // holds real zero bytes, which are appended as virtual ones
+          if (!IsVirtual (piece) && IsZero (piece))
+            {
+              piece = Create<Packet> (n);
+            }
+          bytes->AddAtEnd (piece);
+        }
+    }
+  else
+    {
+      // appending segments of real bytes one by one copies the bytes
+      // gathered so far at every step, so they are gathered in a single copy
+      m_assembly.resize (size);
+      uint32_t copied = 0;
+      while (copied < size)
+        {
+          Ptr<Packet> segment = s.segments.front ();
+          uint32_t n = std::min (segment->GetSize (), size - copied);
+          segment->CopyData (&m_assembly[copied], n);
+          copied += n;
+          if (n == segment->GetSize ())
+            {
+              s.segments.pop_front ();
+            }
+          else
+            {
+              segment->RemoveAtStart (n);
+            }
+        }
+      bytes = Create<Packet> (&m_assembly[0], size);
+    }
+
+  s.size -= size;
+  return bytes;
+}
+
+bool
+AmMessageFramer::IsVirtual (Ptr<const Packet> p)
+{
+  // the serialized form of a packet holds only the real bytes of its buffer
+  return p->GetSerializedSize () < p->GetSize ();
+}
+
+bool
+AmMessageFramer::IsZero (Ptr<const Packet> p)
+{
+  m_assembly.resize (p->GetSize ());
+  p->CopyData (&m_assembly[0], p->GetSize ());
+  for (uint32_t i = 0; i < m_assembly.size (); i++)
+    {
+      if (m_assembly[i] != 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+AmMessageFramer::Remove (Ptr<Socket> socket)
+{
+  m_streams.erase (socket);
+}
+
+void
+AmMessageFramer::Clear (void)
+{
+  m_streams.clear ();
+}
+
+} // namespace ns3
@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "am-protocol-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmProtocolHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (AmProtocolHeader);
+
+AmProtocolHeader::AmProtocolHeader ()
+  : m_type (0),
+    m_flags (0),
+    m_key (0),
+    m_counter (0),
+    m_ts (0),
+    m_id (0),
+    m_value (0),
+    m_pvalue (0),
+    m_sender (0),
+    m_views (0),
+    m_postit (0)
+{
+}
+
+void
+AmProtocolHeader::SetType (MessageType type)
+{
+  m_type = type;
+}
+MessageType
+AmProtocolHeader::GetType (void) const
+{
+  return (MessageType) m_type;
+}
+
+void
+AmProtocolHeader::SetKey (uint32_t key)
+{
+  m_key = key;
+}
+uint32_t
+AmProtocolHeader::GetKey (void) const
+{
+  return m_key;
+}
+
+void
+AmProtocolHeader::SetCounter (uint32_t counter)
+{
+  m_counter = counter;
+}
+uint32_t
+AmProtocolHeader::GetCounter (void) const
+{
+  return m_counter;
+}
+
+void
+AmProtocolHeader::SetTag (uint32_t ts, uint32_t id)
+{
+  m_ts = ts;
+  m_id = id;
+}
+void
+AmProtocolHeader::SetTs (uint32_t ts)
+{
+  m_ts = ts;
+}
+uint32_t
+AmProtocolHeader::GetTs (void) const
+{
+  return m_ts;
+}
+void
+AmProtocolHeader::SetId (uint32_t id)
+{
+  m_id = id;
+}
+uint32_t
+AmProtocolHeader::GetId (void) const
+{
+  return m_id;
+}
+
+void
+AmProtocolHeader::SetValue (uint32_t value)
+{
+  m_value = value;
+}
+uint32_t
+AmProtocolHeader::GetValue (void) const
+{
+  return m_value;
+}
+void
+AmProtocolHeader::SetPvalue (uint32_t pvalue)
+{
+  m_pvalue = pvalue;
+}
+uint32_t
+AmProtocolHeader::GetPvalue (void) const
+{
+  return m_pvalue;
+}
+
+void
+AmProtocolHeader::SetSender (uint32_t sender)
+{
+  m_sender = sender;
+}
+uint32_t
+AmProtocolHeader::GetSender (void) const
+{
+  return m_sender;
+}
+
+void
+AmProtocolHeader::SetViews (uint32_t views)
+{
+  m_views = views;
+}
+uint32_t
+AmProtocolHeader::GetViews (void) const
+{
+  return m_views;
+}
+void
+AmProtocolHeader::SetPostit (uint32_t postit)
+{
+  m_postit = postit;
+}
+uint32_t
+AmProtocolHeader::GetPostit (void) const
+{
+  return m_postit;
+}
+
+void
+AmProtocolHeader::SetFlag (uint8_t flag, bool on)
+{
+  if (on)
+    {
+      m_flags |= flag;
+    }
+  else
+    {
+      m_flags &= ~flag;
+    }
+}
+void
+AmProtocolHeader::SetSecured (bool secured)
+{
+  SetFlag (SECURED, secured);
+}
+bool
+AmProtocolHeader::IsSecured (void) const
+{
+  return (m_flags & SECURED) != 0;
+}
+void
+AmProtocolHeader::SetInitiator (bool initiator)
+{
+  SetFlag (INITIATOR, initiator);
+}
+bool
+AmProtocolHeader::IsInitiator (void) const
+{
+  return (m_flags & INITIATOR) != 0;
+}
+void
+AmProtocolHeader::SetPropagated (bool propagated)
+{
+  SetFlag (PROPAGATED, propagated);
+}
+bool
+AmProtocolHeader::IsPropagated (void) const
+{
+  return (m_flags & PROPAGATED) != 0;
+}
+void
+AmProtocolHeader::SetLeased (bool leased)
+{
+  SetFlag (LEASED, leased);
+}
+bool
+AmProtocolHeader::IsLeased (void) const
+{
+  return (m_flags & LEASED) != 0;
+}
+
+void
+AmProtocolHeader::SetSeen (const AmSeenSet &seen)
+{
+  m_seen = seen.GetWords ();
+}
+AmSeenSet
+AmProtocolHeader::GetSeen (void) const
+{
+  AmSeenSet seen;
+  seen.SetWords (m_seen);
+  return seen;
+}
+
+TypeId
+AmProtocolHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmProtocolHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<AmProtocolHeader> ()
+  ;
+  return tid;
+}
+TypeId
+AmProtocolHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+AmProtocolHeader::Print (std::ostream &os) const
+{
+  // the old space separated text format, only used for debug output
+  os << (uint32_t) m_type << " " << m_key << " " << m_counter << " " << m_ts << " " << m_id
+     << " " << m_value << " " << m_pvalue << " " << m_sender << " " << m_views
+     << " " << m_postit << " " << IsSecured () << " " << IsInitiator ()
+     << " " << IsPropagated ();
+
+  AmSeenSet seen = GetSeen ();
+  for (uint32_t id = 0; id < seen.GetBound (); id++)
+    {
+      if (seen.Contains (id))
+        {
+          os << " " << id;
+        }
+    }
+}
+
+uint32_t
+AmProtocolHeader::GetSerializedSize (void) const
+{
+  return 1 + 1 + 4 * 9 + 2 + 4 * m_seen.size ();
+}
+
+void
+AmProtocolHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8 (m_type);
+  i.WriteU8 (m_flags);
+  i.WriteHtonU32 (m_key);
+  i.WriteHtonU32 (m_counter);
+  i.WriteHtonU32 (m_ts);
+  i.WriteHtonU32 (m_id);
+  i.WriteHtonU32 (m_value);
+  i.WriteHtonU32 (m_pvalue);
+  i.WriteHtonU32 (m_sender);
+  i.WriteHtonU32 (m_views);
+  i.WriteHtonU32 (m_postit);
+  i.WriteHtonU16 (m_seen.size ());
+  for (uint32_t w = 0; w < m_seen.size (); w++)
+    {
+      i.WriteHtonU32 (m_seen[w]);
+    }
+}
+
+uint32_t
+AmProtocolHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_type = i.ReadU8 ();
+  m_flags = i.ReadU8 ();
+  m_key = i.ReadNtohU32 ();
+  m_counter = i.ReadNtohU32 ();
+  m_ts = i.ReadNtohU32 ();
+  m_id = i.ReadNtohU32 ();
+  m_value = i.ReadNtohU32 ();
+  m_pvalue = i.ReadNtohU32 ();
+  m_sender = i.ReadNtohU32 ();
+  m_views = i.ReadNtohU32 ();
+  m_postit = i.ReadNtohU32 ();
+  m_seen.resize (i.ReadNtohU16 ());
+  for (uint32_t w = 0; w < m_seen.size (); w++)
+    {
+      m_seen[w] = i.ReadNtohU32 ();
+    }
+  return GetSerializedSize ();
+}
+
+} // namespace ns3
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "am-quorum-selector.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmQuorumSelector");
+
+namespace {
+
+/// Orders server indices by smoothed round trip time
+struct NearerThan
+{
+  const std::vector<Time> *srtt;    //!< smoothed round trip times
+  const std::vector<bool> *measured; //!< servers measured
+
+  bool operator() (uint32_t a, uint32_t b) const
+  {
+    Time ra = (*measured)[a] ? (*srtt)[a] : Seconds (0);
+    Time rb = (*measured)[b] ? (*srtt)[b] : Seconds (0);
+    return ra < rb;
+  }
+};
+
+} // anonymous namespace
+
+AmQuorumSelector::AmQuorumSelector ()
+  : m_numServers (0),
+    m_mode (ALL)
+{
+}
+
+void
+AmQuorumSelector::SetMode (uint32_t numServers, Mode mode)
+{
+  NS_LOG_FUNCTION (this << numServers << mode);
+  m_numServers = numServers;
+  m_mode = mode;
+  m_srtt.assign (numServers, Seconds (0));
+  m_measured.assign (numServers, false);
+
+  // created only when needed, the other random variables keep their streams
+  if (m_mode == RANDOM && m_rv == 0)
+    {
+      m_rv = CreateObject<UniformRandomVariable> ();
+    }
+}
+
+AmQuorumSelector::Mode
+AmQuorumSelector::GetMode (void) const
+{
+  return m_mode;
+}
+
+int64_t
+AmQuorumSelector::AssignStreams (int64_t stream)
+{
+  if (m_rv == 0)
+    {
+      m_rv = CreateObject<UniformRandomVariable> ();
+    }
+  m_rv->SetStream (stream);
+  return 1;
+}
+
+void
+AmQuorumSelector::Select (uint32_t quorum, AmSeenSet &servers)
+{
+  servers.Clear ();
+  m_order.resize (m_numServers);
+  for (uint32_t i = 0; i < m_numServers; i++)
+    {
+      m_order[i] = i;
+    }
+
+  if (m_mode == ALL || quorum >= m_numServers)
+    {
+      quorum = m_numServers;
+    }
+  else if (m_mode == RANDOM)
+    {
+      // the first quorum entries of a Fisher-Yates shuffle
+      for (uint32_t i = 0; i < quorum; i++)
+        {
+          uint32_t j = m_rv->GetInteger (i, m_numServers - 1);
+          std::swap (m_order[i], m_order[j]);
+        }
+    }
+  else
+    {
+      NearerThan nearer;
+      nearer.srtt = &m_srtt;
+      nearer.measured = &m_measured;
+      std::stable_sort (m_order.begin (), m_order.end (), nearer);
+    }
+
+  for (uint32_t i = 0; i < quorum; i++)
+    {
+      servers.Insert (m_order[i]);
+    }
+}
+
+void
+AmQuorumSelector::AddRtt (uint32_t server, Time rtt)
+{
+  NS_ASSERT (server < m_numServers);
+  if (!m_measured[server])
+    {
+      m_srtt[server] = rtt;
+      m_measured[server] = true;
+      return;
+    }
+  // the smoothing of TCP (RFC 6298): srtt = 7/8 srtt + 1/8 rtt
+  m_srtt[server] = m_srtt[server] + (rtt - m_srtt[server]) / 8;
+}
+
+} // namespace ns3
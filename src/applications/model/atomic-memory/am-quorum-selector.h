@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_QUORUM_SELECTOR_H
+#define AM_QUORUM_SELECTOR_H
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include "am-seen-set.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmQuorumSelector
+ * \brief Picks the servers a client sends the first messages of a round to.
+ *
+ * By default a round goes to all the servers. A thrifty client sends it to
+ * a quorum only, and to the other servers once a timer expires without the
+ * replies it waits for. The quorum is drawn uniformly at random, which
+ * spreads the load over the servers, or made of the servers with the
+ * smallest smoothed round trip time. A server never measured counts as the
+ * nearest, so every server is tried before the measurements decide.
+ */
+class AmQuorumSelector
+{
+public:
+  /// Servers contacted first
+  enum Mode
+  {
+    ALL,      //!< all the servers
+    RANDOM,   //!< a random quorum
+    NEAREST   //!< the quorum of the smallest round trip times
+  };
+
+  AmQuorumSelector ();
+
+  /**
+   * \brief set the servers and the way a quorum is picked
+   * \param numServers the number of servers
+   * \param mode the servers contacted first
+   */
+  void SetMode (uint32_t numServers, Mode mode);
+
+  /**
+   * \return the servers contacted first
+   */
+  Mode GetMode (void) const;
+
+  /**
+   * \brief assign a fixed random variable stream number to the random quorums
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * \brief pick the servers the next round is sent to first
+   * \param quorum the size of a quorum
+   * \param servers set to the indices of the servers picked
+   */
+  void Select (uint32_t quorum, AmSeenSet &servers);
+
+  /**
+   * \brief account for a round trip time measured with a server
+   * \param server the index of the server
+   * \param rtt the time from the sending of a round to the reply
+   */
+  void AddRtt (uint32_t server, Time rtt);
+
+private:
+  uint32_t m_numServers;            //!< number of servers
+  Mode m_mode;                      //!< servers contacted first
+  std::vector<Time> m_srtt;         //!< smoothed round trip time per server
+  std::vector<bool> m_measured;     //!< true once a server replied
+  std::vector<uint32_t> m_order;    //!< scratch list of the server indices
+  Ptr<UniformRandomVariable> m_rv;  //!< source of randomness
+};
+
+} // namespace ns3
+
+#endif /* AM_QUORUM_SELECTOR_H */
@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "am-reed-solomon.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmReedSolomon");
+
+namespace {
+
+/// log/exp tables of GF(2^8) with the primitive polynomial x^8+x^4+x^3+x^2+1
+struct GfTables
+{
+  GfTables ()
+  {
+    uint32_t x = 1;
+    for (uint32_t i = 0; i < 255; i++)
+      {
+        exp[i] = x;
+        exp[i + 255] = x;
+        log[x] = i;
+        x <<= 1;
+        if (x & 0x100)
+          {
+            x ^= 0x11d;
+          }
+      }
+    log[0] = 0;
+  }
+  uint8_t exp[510]; //!< powers of the generator, twice so sums of logs need no modulo
+  uint8_t log[256]; //!< discrete logarithms
+};
+
+const GfTables&
+GetTables (void)
+{
+  static GfTables tables;
+  return tables;
+}
+
+} // anonymous namespace
+
+AmReedSolomon::AmReedSolomon ()
+  : m_n (1),
+    m_k (1)
+{
+}
+
+void
+AmReedSolomon::SetCode (uint32_t n, uint32_t k)
+{
+  NS_LOG_FUNCTION (this << n << k);
+  NS_ASSERT_MSG (k >= 1 && k <= n && n <= 256, "AmReedSolomon: invalid [" << n << "," << k << "] code");
+  m_n = n;
+  m_k = k;
+}
+
+uint32_t
+AmReedSolomon::GetN (void) const
+{
+  return m_n;
+}
+
+uint32_t
+AmReedSolomon::GetK (void) const
+{
+  return m_k;
+}
+
+uint32_t
+AmReedSolomon::GetFragmentSize (uint32_t valueSize) const
+{
+  return (valueSize + m_k - 1) / m_k;
+}
+
+void
+AmReedSolomon::Encode (const std::vector<uint8_t> &value, std::vector<std::vector<uint8_t> > &fragments) const
+{
+  NS_LOG_FUNCTION (this << value.size ());
+
+  uint32_t size = GetFragmentSize (value.size ());
+  fragments.resize (m_n);
+
+  // the data fragments are slices of the value
+  for (uint32_t j = 0; j < m_k; j++)
+    {
+      fragments[j].assign (size, 0);
+      for (uint32_t b = 0; b < size && j * size + b < value.size (); b++)
+        {
+          fragments[j][b] = value[j * size + b];
+        }
+    }
+
+  // the parity fragments are combinations of the data fragments
+  for (uint32_t i = m_k; i < m_n; i++)
+    {
+      fragments[i].assign (size, 0);
+      for (uint32_t j = 0; j < m_k && size > 0; j++)
+        {
+          MulAdd (&fragments[i][0], &fragments[j][0], size, GetCoefficient (i, j));
+        }
+    }
+}
+
+bool
+AmReedSolomon::Decode (const std::map<uint32_t, std::vector<uint8_t> > &fragments, std::vector<uint8_t> &value) const
+{
+  NS_LOG_FUNCTION (this << fragments.size ());
+
+  if (fragments.size () < m_k)
+    {
+      return false;
+    }
+
+  // the rows of the generator matrix of the first k fragments
+  std::vector<uint32_t> rows;
+  std::vector<const std::vector<uint8_t>*> data;
+  for (std::map<uint32_t, std::vector<uint8_t> >::const_iterator it = fragments.begin ();
+       it != fragments.end () && rows.size () < m_k; it++)
+    {
+      if (it->first >= m_n || (!data.empty () && it->second.size () != data[0]->size ()))
+        {
+          return false;
+        }
+      rows.push_back (it->first);
+      data.push_back (&it->second);
+    }
+
+  uint32_t size = data[0]->size ();
+  value.assign (m_k * size, 0);
+
+  // invert the k x k matrix of these rows with Gauss-Jordan elimination
+  std::vector<std::vector<uint8_t> > m (m_k, std::vector<uint8_t> (2 * m_k, 0));
+  for (uint32_t r = 0; r < m_k; r++)
+    {
+      for (uint32_t c = 0; c < m_k; c++)
+        {
+          m[r][c] = GetCoefficient (rows[r], c);
+        }
+      m[r][m_k + r] = 1;
+    }
+  for (uint32_t c = 0; c < m_k; c++)
+    {
+      uint32_t pivot = c;
+      while (m[pivot][c] == 0)
+        {
+          // cannot happen with a Cauchy matrix, every submatrix is invertible
+          pivot++;
+          NS_ASSERT (pivot < m_k);
+        }
+      std::swap (m[pivot], m[c]);
+
+      uint8_t inv = Inv (m[c][c]);
+      for (uint32_t x = 0; x < 2 * m_k; x++)
+        {
+          m[c][x] = Mul (m[c][x], inv);
+        }
+      for (uint32_t r = 0; r < m_k; r++)
+        {
+          if (r != c && m[r][c] != 0)
+            {
+              MulAdd (&m[r][0], &m[c][0], 2 * m_k, m[r][c]);
+            }
+        }
+    }
+
+  // data fragment j is row j of the inverse applied to the received fragments
+  for (uint32_t j = 0; j < m_k && size > 0; j++)
+    {
+      for (uint32_t r = 0; r < m_k; r++)
+        {
+          MulAdd (&value[j * size], &(*data[r])[0], size, m[j][m_k + r]);
+        }
+    }
+  return true;
+}
+
+uint8_t
+AmReedSolomon::GetCoefficient (uint32_t row, uint32_t col) const
+{
+  if (row < m_k)
+    {
+      return row == col ? 1 : 0;
+    }
+  // Cauchy entry 1 / (x_row + y_col), with x_row = row and y_col = col:
+  // row >= k > col, so the two never cancel out
+  return Inv (row ^ col);
+}
+
+void
+AmReedSolomon::MulAdd (uint8_t *dst, const uint8_t *src, uint32_t size, uint8_t c)
+{
+  if (c == 0)
+    {
+      return;
+    }
+  const GfTables &t = GetTables ();
+  uint32_t logc = t.log[c];
+  for (uint32_t b = 0; b < size; b++)
+    {
+      if (src[b] != 0)
+        {
+          dst[b] ^= t.exp[logc + t.log[src[b]]];
+        }
+    }
+}
+
+uint8_t
+AmReedSolomon::Mul (uint8_t a, uint8_t b)
+{
+  if (a == 0 || b == 0)
+    {
+      return 0;
+    }
+  const GfTables &t = GetTables ();
+  return t.exp[t.log[a] + t.log[b]];
+}
+
+uint8_t
+AmReedSolomon::Inv (uint8_t a)
+{
+  NS_ASSERT (a != 0);
+  const GfTables &t = GetTables ();
+  return t.exp[255 - t.log[a]];
+}
+
+} // namespace ns3
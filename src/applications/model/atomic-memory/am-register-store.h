@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_REGISTER_STORE_H
+#define AM_REGISTER_STORE_H
+
+#include <stdint.h>
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmRegisterStore
+ * \brief Hash indexed table of the registers of a key-value store.
+ *
+ * Each protocol defines the state it keeps for a single register (R) and
+ * uses the store to hold one such state per key. A register is created,
+ * value initialized, the first time its key is accessed, so only the keys
+ * that were actually used take up memory.
+ */
+template <typename R>
+class AmRegisterStore
+{
+public:
+  /**
+   * \brief get the register of a key, creating it if needed
+   * \param key the key
+   * \return the state of the register
+   */
+  R& Get (uint32_t key)
+  {
+    return m_registers[key];
+  }
+
+  /**
+   * \brief get the register of a key, without creating it
+   * \param key the key
+   * \return the state of the register, 0 if the key was never accessed
+   */
+  const R* Find (uint32_t key) const
+  {
+    typename std::unordered_map<uint32_t, R>::const_iterator it = m_registers.find (key);
+    return it == m_registers.end () ? 0 : &it->second;
+  }
+
+  /**
+   * \return the number of registers in the store
+   */
+  uint32_t GetSize (void) const
+  {
+    return m_registers.size ();
+  }
+
+  /**
+   * \brief remove all the registers
+   */
+  void Clear (void)
+  {
+    m_registers.clear ();
+  }
+
+private:
+  std::unordered_map<uint32_t, R> m_registers; //!< register state per key
+};
+
+} // namespace ns3
+
+#endif /* AM_REGISTER_STORE_H */
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "am-relay-batcher.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmRelayBatcher");
+
+AmRelayBatcher::AmRelayBatcher ()
+  : m_window (Seconds (0)),
+    m_maxMessages (32),
+    m_messages (0),
+    m_packets (0)
+{
+}
+
+void
+AmRelayBatcher::SetWindow (Time window)
+{
+  m_window = window;
+}
+
+void
+AmRelayBatcher::SetMaxMessages (uint32_t max)
+{
+  m_maxMessages = max;
+}
+
+void
+AmRelayBatcher::Send (Ptr<Socket> socket, Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << socket << p);
+  m_messages++;
+  if (m_window.IsZero () || m_maxMessages <= 1)
+    {
+      socket->Send (p);
+      m_packets++;
+      return;
+    }
+
+  Batch &batch = m_batches[socket];
+  if (batch.messages == 0)
+    {
+      // the packet may be shared by the sends to the other peers
+      batch.packet = p->Copy ();
+      batch.timeout = Simulator::Schedule (m_window, &AmRelayBatcher::FlushSocket, this, socket);
+    }
+  else
+    {
+      batch.packet->AddAtEnd (p);
+    }
+  batch.messages++;
+
+  if (batch.messages >= m_maxMessages)
+    {
+      FlushSocket (socket);
+    }
+}
+
+void
+AmRelayBatcher::FlushSocket (Ptr<Socket> socket)
+{
+  std::map<Ptr<Socket>, Batch>::iterator it = m_batches.find (socket);
+  if (it == m_batches.end ())
+    {
+      return;
+    }
+  if (it->second.messages > 0)
+    {
+      NS_LOG_LOGIC ("Sending " << it->second.messages << " messages in " << it->second.packet->GetSize () << " bytes");
+      it->second.timeout.Cancel ();
+      socket->Send (it->second.packet);
+      m_packets++;
+    }
+  m_batches.erase (it);
+}
+
+void
+AmRelayBatcher::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_batches.empty ())
+    {
+      FlushSocket (m_batches.begin ()->first);
+    }
+}
+
+void
+AmRelayBatcher::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::map<Ptr<Socket>, Batch>::iterator it = m_batches.begin (); it != m_batches.end (); ++it)
+    {
+      it->second.timeout.Cancel ();
+    }
+  m_batches.clear ();
+}
+
+uint32_t
+AmRelayBatcher::GetMessages (void) const
+{
+  return m_messages;
+}
+
+uint32_t
+AmRelayBatcher::GetPackets (void) const
+{
+  return m_packets;
+}
+
+} // namespace ns3
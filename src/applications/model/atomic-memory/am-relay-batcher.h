@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_RELAY_BATCHER_H
+#define AM_RELAY_BATCHER_H
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include <map>
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+
+/**
+ * \ingroup applications
+ * \class AmRelayBatcher
+ * \brief Coalesces the messages a server sends to its peers.
+ *
+ * Send () queues a framed message (see AmMessageFramer::Build) for a
+ * socket instead of sending it. The first message queued for a socket
+ * opens a window: every message queued for the same socket until the
+ * window closes, or until MaxMessages are queued, is appended to the same
+ * packet, sent with a single Socket::Send. The messages keep their length
+ * prefixes, so the receiving framer splits the batch back into the
+ * original messages without any change on its side.
+ *
+ * With a zero window, the default, Send () sends every message at once.
+ */
+class AmRelayBatcher
+{
+public:
+  AmRelayBatcher ();
+
+  /**
+   * \param window the time a message may wait for others, 0 to disable
+   */
+  void SetWindow (Time window);
+
+  /**
+   * \param max the messages of a batch that trigger its sending
+   */
+  void SetMaxMessages (uint32_t max);
+
+  /**
+   * \brief send a message, possibly batched with the next ones
+   * \param socket the socket to send to
+   * \param p the framed message
+   */
+  void Send (Ptr<Socket> socket, Ptr<Packet> p);
+
+  /**
+   * \brief send all the pending batches
+   */
+  void Flush (void);
+
+  /**
+   * \brief drop all the pending batches
+   */
+  void Clear (void);
+
+  /**
+   * \returns the messages handed to Send
+   */
+  uint32_t GetMessages (void) const;
+
+  /**
+   * \returns the packets sent to the sockets
+   */
+  uint32_t GetPackets (void) const;
+
+private:
+  /// Messages waiting for a socket
+  struct Batch
+  {
+    Batch () : messages (0) {}
+    Ptr<Packet> packet;   //!< the framed messages, one after the other
+    uint32_t messages;    //!< number of messages in packet
+    EventId timeout;      //!< end of the window
+  };
+
+  /**
+   * \brief send the batch of a socket
+   * \param socket the socket
+   */
+  void FlushSocket (Ptr<Socket> socket);
+
+  Time m_window;                              //!< batching window
+  uint32_t m_maxMessages;                     //!< size cap of a batch
+  std::map<Ptr<Socket>, Batch> m_batches;     //!< pending batch per socket
+  uint32_t m_messages;                        //!< messages handed to Send
+  uint32_t m_packets;                         //!< packets sent
+};
+
+} // namespace ns3
+
+#endif /* AM_RELAY_BATCHER_H */
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "am-seen-set.h"
+
+namespace ns3 {
+
+AmSeenSet::AmSeenSet ()
+  : m_size (0)
+{
+}
+
+void
+AmSeenSet::Insert (uint32_t id)
+{
+  uint32_t w = id / 32;
+  uint32_t bit = 1u << (id % 32);
+
+  if (w >= m_words.size ())
+    {
+      m_words.resize (w + 1, 0);
+    }
+  if ((m_words[w] & bit) == 0)
+    {
+      m_words[w] |= bit;
+      m_size++;
+    }
+}
+
+bool
+AmSeenSet::Contains (uint32_t id) const
+{
+  uint32_t w = id / 32;
+  return w < m_words.size () && (m_words[w] & (1u << (id % 32))) != 0;
+}
+
+void
+AmSeenSet::Clear (void)
+{
+  // keeps the capacity of the words
+  m_words.clear ();
+  m_size = 0;
+}
+
+uint32_t
+AmSeenSet::GetSize (void) const
+{
+  return m_size;
+}
+
+bool
+AmSeenSet::IsEmpty (void) const
+{
+  return m_size == 0;
+}
+
+uint32_t
+AmSeenSet::GetBound (void) const
+{
+  return m_words.size () * 32;
+}
+
+void
+AmSeenSet::IntersectWith (const AmSeenSet &other)
+{
+  if (m_words.size () > other.m_words.size ())
+    {
+      m_words.resize (other.m_words.size ());
+    }
+  for (uint32_t w = 0; w < m_words.size (); w++)
+    {
+      m_words[w] &= other.m_words[w];
+    }
+  Normalize ();
+}
+
+bool
+AmSeenSet::IsSubsetOf (const AmSeenSet &other) const
+{
+  if (m_size > other.m_size || m_words.size () > other.m_words.size ())
+    {
+      return false;
+    }
+  for (uint32_t w = 0; w < m_words.size (); w++)
+    {
+      if ((m_words[w] & ~other.m_words[w]) != 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+const std::vector<uint32_t>&
+AmSeenSet::GetWords (void) const
+{
+  return m_words;
+}
+
+void
+AmSeenSet::SetWords (const std::vector<uint32_t> &words)
+{
+  m_words = words;
+  Normalize ();
+}
+
+void
+AmSeenSet::Print (std::ostream &os, std::string prefix) const
+{
+  os << "{";
+  for (uint32_t id = 0; id < GetBound (); id++)
+    {
+      if (Contains (id))
+        {
+          os << " " << prefix << id;
+        }
+    }
+  os << " }";
+}
+
+bool
+AmSeenSet::operator== (const AmSeenSet &other) const
+{
+  return m_words == other.m_words;
+}
+
+bool
+AmSeenSet::operator< (const AmSeenSet &other) const
+{
+  return m_words < other.m_words;
+}
+
+void
+AmSeenSet::Normalize (void)
+{
+  while (!m_words.empty () && m_words.back () == 0)
+    {
+      m_words.pop_back ();
+    }
+  m_size = 0;
+  for (uint32_t w = 0; w < m_words.size (); w++)
+    {
+      m_size += __builtin_popcount (m_words[w]);
+    }
+}
+
+std::ostream&
+operator<< (std::ostream &os, const AmSeenSet &seen)
+{
+  seen.Print (os);
+  return os;
+}
+
+} // namespace ns3
@@ -0,0 +1,358 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "am-service-queue.h"
+#include "am-message-framer.h"
+#include "am-protocol-header.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmServiceQueue");
+
+namespace {
+
+/**
+ * \brief drop the events that already ran, or were cancelled
+ * \param events the events
+ */
+void
+RemoveExpired (std::vector<EventId> &events)
+{
+  std::vector<EventId>::iterator end = events.begin ();
+  for (std::vector<EventId>::iterator it = events.begin (); it != events.end (); ++it)
+    {
+      if (!it->IsExpired ())
+        {
+          *end++ = *it;
+        }
+    }
+  events.erase (end, events.end ());
+}
+
+} // anonymous namespace
+
+AmServiceQueue::AmServiceQueue ()
+  : m_cores (0),
+    m_perItem (Seconds (0)),
+    m_busy (0),
+    m_servedMessages (0),
+    m_busyTime (Seconds (0)),
+    m_waitTime (Seconds (0)),
+    m_maxQueue (0),
+    m_fault (NONE),
+    m_slowdown (Seconds (0)),
+    m_dropped (0),
+    m_heldMessages (0)
+{
+}
+
+void
+AmServiceQueue::SetCores (uint32_t cores)
+{
+  m_cores = cores;
+}
+
+uint32_t
+AmServiceQueue::GetCores (void) const
+{
+  return m_cores;
+}
+
+void
+AmServiceQueue::SetServiceTime (Ptr<RandomVariableStream> time)
+{
+  m_time = time;
+}
+
+void
+AmServiceQueue::SetServiceTime (uint32_t type, Ptr<RandomVariableStream> time)
+{
+  if (time == 0)
+    {
+      m_typeTime.erase (type);
+      return;
+    }
+  m_typeTime[type] = time;
+}
+
+void
+AmServiceQueue::SetPerItem (Time perItem)
+{
+  m_perItem = perItem;
+}
+
+void
+AmServiceQueue::SetItemsCallback (Callback<uint32_t, const AmProtocolHeader &> items)
+{
+  m_items = items;
+}
+
+void
+AmServiceQueue::SetFault (Fault fault)
+{
+  NS_LOG_FUNCTION (this << fault);
+  Fault previous = m_fault;
+  m_fault = fault;
+
+  if (fault == CRASH)
+    {
+      // the messages waiting for a core, or on one, are lost as well
+      for (std::vector<EventId>::iterator it = m_services.begin (); it != m_services.end (); ++it)
+        {
+          it->Cancel ();
+        }
+      m_services.clear ();
+      m_dropped += m_queue.size () + m_held.size () + m_busy;
+      m_queue.clear ();
+      m_held.clear ();
+      m_busy = 0;
+    }
+  else if (fault == NONE && previous == PAUSE)
+    {
+      std::deque<Message> held;
+      held.swap (m_held);
+      for (std::deque<Message>::iterator it = held.begin (); it != held.end (); ++it)
+        {
+          Arrive (*it, true);
+        }
+    }
+}
+
+AmServiceQueue::Fault
+AmServiceQueue::GetFault (void) const
+{
+  return m_fault;
+}
+
+void
+AmServiceQueue::SetSlowdown (Time delay)
+{
+  m_slowdown = delay;
+}
+
+Time
+AmServiceQueue::GetSlowdown (void) const
+{
+  return m_slowdown;
+}
+
+void
+AmServiceQueue::SetServedCallback (Callback<void, Ptr<Socket> > served)
+{
+  m_servedCallback = served;
+}
+
+Time
+AmServiceQueue::GetServiceTime (Ptr<Packet> p)
+{
+  AmProtocolHeader hdr;
+  p->PeekHeader (hdr);
+
+  Time service = Seconds (0);
+  std::map<uint32_t, Ptr<RandomVariableStream> >::iterator it = m_typeTime.find (hdr.GetType ());
+  if (it != m_typeTime.end ())
+    {
+      service = Seconds (it->second->GetValue ());
+    }
+  else if (m_time != 0)
+    {
+      service = Seconds (m_time->GetValue ());
+    }
+
+  if (!m_perItem.IsZero () && !m_items.IsNull ())
+    {
+      service += m_perItem * m_items (hdr);
+    }
+
+  // a negative draw (e.g. of a normal distribution) costs nothing
+  return std::max (service, Seconds (0));
+}
+
+Ptr<Packet>
+AmServiceQueue::Recv (AmMessageFramer &framer, Ptr<Socket> socket, Address &from)
+{
+  if (m_cores == 0 && m_fault == NONE && m_slowdown.IsZero () && m_served.empty ())
+    {
+      return framer.Recv (socket, from);
+    }
+
+  Ptr<Packet> p;
+  Address peer;
+  while ((p = framer.Recv (socket, peer)))
+    {
+      Message m;
+      m.socket = socket;
+      m.packet = p;
+      m.from = peer;
+      m.service = m_cores > 0 ? GetServiceTime (p) : Seconds (0);
+      if (m_fault == CRASH)
+        {
+          m_dropped++;
+        }
+      else if (!m_slowdown.IsZero ())
+        {
+          RemoveExpired (m_delayed);
+          m_delayed.push_back (Simulator::Schedule (m_slowdown, &AmServiceQueue::Arrive, this, m, true));
+        }
+      else
+        {
+          Arrive (m, false);
+        }
+    }
+  Serve ();
+
+  std::map<Ptr<Socket>, std::deque<Message> >::iterator it = m_served.find (socket);
+  if (it == m_served.end ())
+    {
+      return 0;
+    }
+  p = it->second.front ().packet;
+  from = it->second.front ().from;
+  it->second.pop_front ();
+  if (it->second.empty ())
+    {
+      m_served.erase (it);
+    }
+  return p;
+}
+
+void
+AmServiceQueue::Arrive (Message m, bool notify)
+{
+  if (m_fault == CRASH)
+    {
+      m_dropped++;
+      return;
+    }
+  if (m_fault == PAUSE)
+    {
+      m_heldMessages++;
+      m_held.push_back (m);
+      return;
+    }
+
+  m.arrival = Simulator::Now ();
+  if (m_cores == 0)
+    {
+      m_served[m.socket].push_back (m);
+      if (notify && !m_servedCallback.IsNull ())
+        {
+          m_servedCallback (m.socket);
+        }
+      return;
+    }
+
+  m_queue.push_back (m);
+  m_maxQueue = std::max<uint32_t> (m_maxQueue, m_queue.size ());
+  if (notify)
+    {
+      Serve ();
+    }
+}
+
+void
+AmServiceQueue::Serve (void)
+{
+  // the event of a service that just ended is expired as well
+  RemoveExpired (m_services);
+
+  while (m_busy < m_cores && !m_queue.empty ())
+    {
+      Message m = m_queue.front ();
+      m_queue.pop_front ();
+      m_busy++;
+      m_busyTime += m.service;
+      m_waitTime += Simulator::Now () - m.arrival;
+      NS_LOG_LOGIC ("Serving a message of " << m.packet->GetSize () << " bytes in " << m.service.GetSeconds () << "s");
+      m_services.push_back (Simulator::Schedule (m.service, &AmServiceQueue::Served, this, m));
+    }
+}
+
+void
+AmServiceQueue::Served (Message m)
+{
+  m_busy--;
+  m_servedMessages++;
+  m_served[m.socket].push_back (m);
+  Serve ();
+  if (!m_servedCallback.IsNull ())
+    {
+      m_servedCallback (m.socket);
+    }
+}
+
+void
+AmServiceQueue::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<EventId>::iterator it = m_services.begin (); it != m_services.end (); ++it)
+    {
+      it->Cancel ();
+    }
+  m_services.clear ();
+  for (std::vector<EventId>::iterator it = m_delayed.begin (); it != m_delayed.end (); ++it)
+    {
+      it->Cancel ();
+    }
+  m_delayed.clear ();
+  m_queue.clear ();
+  m_held.clear ();
+  m_served.clear ();
+  m_busy = 0;
+}
+
+uint32_t
+AmServiceQueue::GetServed (void) const
+{
+  return m_servedMessages;
+}
+
+Time
+AmServiceQueue::GetBusyTime (void) const
+{
+  return m_busyTime;
+}
+
+Time
+AmServiceQueue::GetWaitTime (void) const
+{
+  return m_waitTime;
+}
+
+uint32_t
+AmServiceQueue::GetMaxQueue (void) const
+{
+  return m_maxQueue;
+}
+
+uint32_t
+AmServiceQueue::GetDropped (void) const
+{
+  return m_dropped;
+}
+
+uint32_t
+AmServiceQueue::GetHeld (void) const
+{
+  return m_heldMessages;
+}
+
+} // namespace ns3
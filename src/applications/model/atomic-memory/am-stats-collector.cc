@@ -0,0 +1,434 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/fatal-error.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/data-collector.h"
+#include "ns3/data-output-interface.h"
+#include "am-stats-collector.h"
+#include "asm-common.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmStatsCollector");
+
+NS_OBJECT_ENSURE_REGISTERED (AmLatencyHistogram);
+NS_OBJECT_ENSURE_REGISTERED (AmStatsCollector);
+
+/**************************************************************************************
+ * AmLatencyHistogram
+ **************************************************************************************/
+TypeId
+AmLatencyHistogram::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmLatencyHistogram")
+    .SetParent<DataCalculator> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<AmLatencyHistogram> ()
+  ;
+  return tid;
+}
+
+AmLatencyHistogram::AmLatencyHistogram ()
+  : m_count (0),
+    m_sum (0),
+    m_sqrSum (0),
+    m_min (0),
+    m_max (0)
+{
+}
+
+AmLatencyHistogram::~AmLatencyHistogram ()
+{
+}
+
+uint32_t
+AmLatencyHistogram::GetBucket (uint64_t ns)
+{
+  if (ns < 32)
+    {
+      return ns;
+    }
+  // the five bits below the most significant one select the sub-bucket
+  uint32_t msb = 63 - __builtin_clzll (ns);
+  return (msb - 4) * 32 + ((ns >> (msb - 5)) & 31);
+}
+
+Time
+AmLatencyHistogram::GetBucketStart (uint32_t bucket)
+{
+  if (bucket < 32)
+    {
+      return NanoSeconds (bucket);
+    }
+  uint32_t msb = bucket / 32 + 4;
+  return NanoSeconds (static_cast<uint64_t> (32 + bucket % 32) << (msb - 5));
+}
+
+void
+AmLatencyHistogram::Update (Time latency)
+{
+  if (!m_enabled)
+    {
+      return;
+    }
+
+  int64_t ns = latency.GetNanoSeconds ();
+  uint32_t bucket = GetBucket (ns > 0 ? ns : 0);
+  if (bucket >= m_buckets.size ())
+    {
+      m_buckets.resize (bucket + 1, 0);
+    }
+  m_buckets[bucket]++;
+
+  double s = latency.GetSeconds ();
+  if (m_count == 0 || s < m_min)
+    {
+      m_min = s;
+    }
+  if (m_count == 0 || s > m_max)
+    {
+      m_max = s;
+    }
+  m_count++;
+  m_sum += s;
+  m_sqrSum += s * s;
+}
+
+Time
+AmLatencyHistogram::GetPercentile (double q) const
+{
+  if (m_count == 0)
+    {
+      return Seconds (0);
+    }
+
+  uint64_t rank = std::max<uint64_t> (1, std::ceil (q * m_count));
+  uint64_t seen = 0;
+  uint32_t bucket = 0;
+  while (bucket + 1 < m_buckets.size () && seen + m_buckets[bucket] < rank)
+    {
+      seen += m_buckets[bucket++];
+    }
+
+  // the midpoint of the bucket, within the observed range
+  Time mid = (GetBucketStart (bucket) + GetBucketStart (bucket + 1)) / 2;
+  return std::min (std::max (mid, Seconds (m_min)), Seconds (m_max));
+}
+
+uint32_t
+AmLatencyHistogram::GetNBuckets (void) const
+{
+  return m_buckets.size ();
+}
+
+uint64_t
+AmLatencyHistogram::GetBucketCount (uint32_t bucket) const
+{
+  return bucket < m_buckets.size () ? m_buckets[bucket] : 0;
+}
+
+void
+AmLatencyHistogram::Output (DataOutputCallback &callback) const
+{
+  callback.OutputStatistic (m_context, m_key, this);
+  if (m_count > 0)
+    {
+      callback.OutputSingleton (m_context, m_key + "-p50", GetPercentile (0.5).GetSeconds ());
+      callback.OutputSingleton (m_context, m_key + "-p90", GetPercentile (0.9).GetSeconds ());
+      callback.OutputSingleton (m_context, m_key + "-p99", GetPercentile (0.99).GetSeconds ());
+      callback.OutputSingleton (m_context, m_key + "-p999", GetPercentile (0.999).GetSeconds ());
+    }
+}
+
+long
+AmLatencyHistogram::getCount () const
+{
+  return m_count;
+}
+
+double
+AmLatencyHistogram::getSum () const
+{
+  return m_sum;
+}
+
+double
+AmLatencyHistogram::getSqrSum () const
+{
+  return m_sqrSum;
+}
+
+double
+AmLatencyHistogram::getMin () const
+{
+  return m_min;
+}
+
+double
+AmLatencyHistogram::getMax () const
+{
+  return m_max;
+}
+
+double
+AmLatencyHistogram::getMean () const
+{
+  return m_count > 0 ? m_sum / m_count : 0;
+}
+
+double
+AmLatencyHistogram::getStddev () const
+{
+  return std::sqrt (getVariance ());
+}
+
+double
+AmLatencyHistogram::getVariance () const
+{
+  if (m_count < 2)
+    {
+      return 0;
+    }
+  double mean = getMean ();
+  return std::max (0.0, (m_sqrSum - m_count * mean * mean) / (m_count - 1));
+}
+
+/**************************************************************************************
+ * AmStatsCollector
+ **************************************************************************************/
+TypeId
+AmStatsCollector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmStatsCollector")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<AmStatsCollector> ()
+    .AddAttribute ("Interval",
+                   "The length of the intervals over which the operations are counted",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&AmStatsCollector::m_interval),
+                   MakeTimeChecker (NanoSeconds (1)))
+  ;
+  return tid;
+}
+
+AmStatsCollector::AmStatsCollector ()
+{
+  NS_LOG_FUNCTION (this);
+  m_readLatency = CreateObject<AmLatencyHistogram> ();
+  m_readLatency->SetKey ("read-latency");
+  m_writeLatency = CreateObject<AmLatencyHistogram> ();
+  m_writeLatency->SetKey ("write-latency");
+  m_fastReads = CreateObject<CounterCalculator<> > ();
+  m_fastReads->SetKey ("fast-reads");
+  m_slowReads = CreateObject<CounterCalculator<> > ();
+  m_slowReads->SetKey ("slow-reads");
+  m_handled = CreateObject<CounterCalculator<> > ();
+  m_handled->SetKey ("server-handled");
+  m_sent = CreateObject<CounterCalculator<> > ();
+  m_sent->SetKey ("server-sent");
+}
+
+AmStatsCollector::~AmStatsCollector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AmStatsCollector::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_readLatency = 0;
+  m_writeLatency = 0;
+  m_fastReads = 0;
+  m_slowReads = 0;
+  m_handled = 0;
+  m_sent = 0;
+  Object::DoDispose ();
+}
+
+void
+AmStatsCollector::AddClients (ApplicationContainer clients)
+{
+  NS_LOG_FUNCTION (this);
+  for (ApplicationContainer::Iterator i = clients.Begin (); i != clients.End (); ++i)
+    {
+      if (!(*i)->TraceConnectWithoutContext ("OpCompleted", MakeCallback (&AmStatsCollector::OpCompleted, this)))
+        {
+          NS_FATAL_ERROR ("Application " << (*i)->GetInstanceTypeId ().GetName () << " has no OpCompleted trace source");
+        }
+    }
+}
+
+void
+AmStatsCollector::AddServers (ApplicationContainer servers)
+{
+  NS_LOG_FUNCTION (this);
+  for (ApplicationContainer::Iterator i = servers.Begin (); i != servers.End (); ++i)
+    {
+      uint32_t server = m_servers.size ();
+      m_servers.push_back (ServerStats ());
+      if (!(*i)->TraceConnectWithoutContext ("MessageHandled", MakeBoundCallback (&AmStatsCollector::MessageHandled, this, server)))
+        {
+          NS_FATAL_ERROR ("Application " << (*i)->GetInstanceTypeId ().GetName () << " has no MessageHandled trace source");
+        }
+    }
+}
+
+void
+AmStatsCollector::OpCompleted (uint32_t type, uint32_t exchanges, Time latency, uint32_t tag,
+                               uint32_t key, uint32_t writer)
+{
+  NS_LOG_FUNCTION (this << type << exchanges << latency << tag << key << writer);
+
+  uint64_t i = Simulator::Now ().GetTimeStep () / m_interval.GetTimeStep ();
+  if (i >= m_intervals.size ())
+    {
+      m_intervals.resize (i + 1);
+    }
+
+  m_intervals[i].maxLatency = std::max (m_intervals[i].maxLatency, latency.GetSeconds ());
+  if (type == WRITE)
+    {
+      m_writeLatency->Update (latency);
+      m_intervals[i].writes++;
+      m_intervals[i].writeTime += latency.GetSeconds ();
+    }
+  else if (exchanges <= 2)
+    {
+      m_readLatency->Update (latency);
+      m_fastReads->Update ();
+      m_intervals[i].fastReads++;
+      m_intervals[i].readTime += latency.GetSeconds ();
+    }
+  else
+    {
+      m_readLatency->Update (latency);
+      m_slowReads->Update ();
+      m_intervals[i].slowReads++;
+      m_intervals[i].readTime += latency.GetSeconds ();
+    }
+}
+
+void
+AmStatsCollector::MessageHandled (AmStatsCollector *collector, uint32_t server,
+                                  uint32_t type, uint32_t sent)
+{
+  NS_LOG_FUNCTION (collector << server << type << sent);
+  collector->m_servers[server].handled++;
+  collector->m_servers[server].sent += sent;
+  collector->m_handled->Update ();
+  collector->m_sent->Update (sent);
+}
+
+Ptr<AmLatencyHistogram>
+AmStatsCollector::GetReadLatency (void) const
+{
+  return m_readLatency;
+}
+
+Ptr<AmLatencyHistogram>
+AmStatsCollector::GetWriteLatency (void) const
+{
+  return m_writeLatency;
+}
+
+uint32_t
+AmStatsCollector::GetFastReads (void) const
+{
+  return m_fastReads->GetCount ();
+}
+
+uint32_t
+AmStatsCollector::GetSlowReads (void) const
+{
+  return m_slowReads->GetCount ();
+}
+
+void
+AmStatsCollector::AddToCollector (DataCollector &collector, std::string context)
+{
+  NS_LOG_FUNCTION (this << context);
+  m_readLatency->SetContext (context);
+  m_writeLatency->SetContext (context);
+  m_fastReads->SetContext (context);
+  m_slowReads->SetContext (context);
+  m_handled->SetContext (context);
+  m_sent->SetContext (context);
+
+  collector.AddDataCalculator (m_readLatency);
+  collector.AddDataCalculator (m_writeLatency);
+  collector.AddDataCalculator (m_fastReads);
+  collector.AddDataCalculator (m_slowReads);
+  collector.AddDataCalculator (m_handled);
+  collector.AddDataCalculator (m_sent);
+}
+
+void
+AmStatsCollector::WriteCsv (std::string prefix) const
+{
+  NS_LOG_FUNCTION (this << prefix);
+
+  std::ofstream latency ((prefix + "-latency.csv").c_str ());
+  if (!latency)
+    {
+      NS_FATAL_ERROR ("Cannot open " << prefix << "-latency.csv");
+    }
+  latency << "operation,bucketStart,bucketEnd,count" << std::endl;
+  Ptr<AmLatencyHistogram> histograms[] = { m_writeLatency, m_readLatency };
+  const char *names[] = { "write", "read" };
+  for (uint32_t h = 0; h < 2; h++)
+    {
+      for (uint32_t b = 0; b < histograms[h]->GetNBuckets (); b++)
+        {
+          if (histograms[h]->GetBucketCount (b) > 0)
+            {
+              latency << names[h] << "," << AmLatencyHistogram::GetBucketStart (b).GetSeconds ()
+                      << "," << AmLatencyHistogram::GetBucketStart (b + 1).GetSeconds ()
+                      << "," << histograms[h]->GetBucketCount (b) << std::endl;
+            }
+        }
+    }
+
+  std::ofstream interval ((prefix + "-interval.csv").c_str ());
+  interval << "start,writes,fastReads,slowReads,writeLatency,readLatency,maxLatency" << std::endl;
+  for (uint32_t i = 0; i < m_intervals.size (); i++)
+    {
+      const IntervalStats &s = m_intervals[i];
+      uint32_t reads = s.fastReads + s.slowReads;
+      interval << (m_interval * i).GetSeconds () << "," << s.writes
+               << "," << s.fastReads << "," << s.slowReads
+               << "," << (s.writes > 0 ? s.writeTime / s.writes : 0)
+               << "," << (reads > 0 ? s.readTime / reads : 0)
+               << "," << s.maxLatency << std::endl;
+    }
+
+  std::ofstream servers ((prefix + "-servers.csv").c_str ());
+  servers << "server,handled,sent" << std::endl;
+  for (uint32_t s = 0; s < m_servers.size (); s++)
+    {
+      servers << s << "," << m_servers[s].handled << "," << m_servers[s].sent << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,276 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_STATS_COLLECTOR_H
+#define AM_STATS_COLLECTOR_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/application-container.h"
+#include "ns3/data-calculator.h"
+#include "ns3/basic-data-calculators.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class DataCollector;
+
+/**
+ * \ingroup applications
+ * \class AmLatencyHistogram
+ * \brief Log-bucketed histogram of operation latencies.
+ *
+ * Latencies are kept in nanoseconds: values below 32ns get a bucket of
+ * their own, every larger power of two is split in 32 linear sub-buckets,
+ * so a bucket is at most 1/32 (~3%) wide relatively to its values. An
+ * update is a few bit operations, whatever the number of samples.
+ *
+ * The summary (count, mean, min, max, ...) is in seconds and exact; the
+ * percentiles are the midpoints of their buckets.
+ */
+class AmLatencyHistogram : public DataCalculator,
+                           public StatisticalSummary
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  AmLatencyHistogram ();
+  virtual ~AmLatencyHistogram ();
+
+  /**
+   * \brief record a latency
+   * \param latency the latency
+   */
+  void Update (Time latency);
+
+  /**
+   * \param q the quantile, in [0, 1]
+   * \returns the latency below which a fraction q of the samples fall
+   */
+  Time GetPercentile (double q) const;
+
+  /**
+   * \returns the number of buckets in use
+   */
+  uint32_t GetNBuckets (void) const;
+
+  /**
+   * \param bucket the bucket index
+   * \returns the smallest latency of the bucket
+   */
+  static Time GetBucketStart (uint32_t bucket);
+
+  /**
+   * \param bucket the bucket index
+   * \returns the number of samples in the bucket
+   */
+  uint64_t GetBucketCount (uint32_t bucket) const;
+
+  virtual void Output (DataOutputCallback &callback) const;
+
+  virtual long getCount () const;
+  virtual double getSum () const;
+  virtual double getSqrSum () const;
+  virtual double getMin () const;
+  virtual double getMax () const;
+  virtual double getMean () const;
+  virtual double getStddev () const;
+  virtual double getVariance () const;
+
+private:
+  /**
+   * \param ns a latency in nanoseconds
+   * \returns the bucket of the latency
+   */
+  static uint32_t GetBucket (uint64_t ns);
+
+  std::vector<uint64_t> m_buckets;  //!< samples per bucket
+  long m_count;                     //!< number of samples
+  double m_sum;                     //!< sum of the samples (s)
+  double m_sqrSum;                  //!< sum of the squared samples (s^2)
+  double m_min;                     //!< smallest sample (s)
+  double m_max;                     //!< largest sample (s)
+};
+
+/**
+ * \ingroup applications
+ * \class AmStatsCollector
+ * \brief Aggregates the metrics traced by the clients and the servers.
+ *
+ * The collector connects to the "OpCompleted" trace source of every client
+ * and the "MessageHandled" trace source of every server, and keeps:
+ *  - a latency histogram of the reads and one of the writes;
+ *  - the number of fast (at most two exchanges) and slow reads, in total
+ *    and per Interval of simulated time, with the mean and the largest
+ *    latency of each Interval to follow the latency over time (e.g. around
+ *    the faults of an AmFaultInjector);
+ *  - the messages handled and sent by every server.
+ *
+ * The totals can be added to a DataCollector, to be written by any
+ * DataOutputInterface (e.g. SqliteDataOutput); WriteCsv dumps everything,
+ * histogram buckets included, in CSV files. Every trace callback costs a
+ * constant time.
+ */
+class AmStatsCollector : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  AmStatsCollector ();
+  virtual ~AmStatsCollector ();
+
+  /**
+   * TracedCallback signature of a completed operation.
+   *
+   * \param [in] type WRITE or READ
+   * \param [in] exchanges the communication exchanges of the operation
+   * \param [in] latency the simulated time from invocation to completion
+   * \param [in] tag the timestamp of the value written or returned
+   * \param [in] key the key of the register accessed
+   * \param [in] writer the writer id of the tag, 0 for the single-writer
+   *             protocols
+   */
+  typedef void (* OpCompletedCallback)
+    (uint32_t type, uint32_t exchanges, Time latency, uint32_t tag,
+     uint32_t key, uint32_t writer);
+
+  /**
+   * TracedCallback signature of a message handled by a server.
+   *
+   * \param [in] type the MessageType received
+   * \param [in] sent the messages the server sent in response
+   */
+  typedef void (* MessageHandledCallback) (uint32_t type, uint32_t sent);
+
+  /**
+   * \brief collect the operations of the clients
+   * \param clients the client applications
+   */
+  void AddClients (ApplicationContainer clients);
+
+  /**
+   * \brief collect the messages of the servers
+   * \param servers the server applications, in the order of their IDs
+   */
+  void AddServers (ApplicationContainer servers);
+
+  /**
+   * \returns the latencies of the reads
+   */
+  Ptr<AmLatencyHistogram> GetReadLatency (void) const;
+
+  /**
+   * \returns the latencies of the writes
+   */
+  Ptr<AmLatencyHistogram> GetWriteLatency (void) const;
+
+  /**
+   * \returns the reads completed in at most two exchanges
+   */
+  uint32_t GetFastReads (void) const;
+
+  /**
+   * \returns the reads that needed more than two exchanges
+   */
+  uint32_t GetSlowReads (void) const;
+
+  /**
+   * \brief add the totals to the calculators of a DataCollector
+   * \param collector the collector
+   * \param context the context of the values
+   */
+  void AddToCollector (DataCollector &collector, std::string context);
+
+  /**
+   * \brief write the metrics to prefix-latency.csv (the buckets of the
+   * histograms), prefix-interval.csv (the operations and their mean
+   * latencies per Interval) and
+   * prefix-servers.csv (the messages per server)
+   * \param prefix the prefix of the file names
+   */
+  void WriteCsv (std::string prefix) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// Operations completed in one Interval
+  struct IntervalStats
+  {
+    IntervalStats () : writes (0), fastReads (0), slowReads (0),
+                       writeTime (0), readTime (0), maxLatency (0) {}
+    uint32_t writes;     //!< completed writes
+    uint32_t fastReads;  //!< reads of at most two exchanges
+    uint32_t slowReads;  //!< reads of more exchanges
+    double writeTime;    //!< sum of the latencies of the writes (s)
+    double readTime;     //!< sum of the latencies of the reads (s)
+    double maxLatency;   //!< largest latency of an operation (s)
+  };
+
+  /// Messages of one server
+  struct ServerStats
+  {
+    ServerStats () : handled (0), sent (0) {}
+    uint64_t handled;    //!< messages received
+    uint64_t sent;       //!< messages sent in response
+  };
+
+  /**
+   * \brief trace sink of the clients
+   * \param type WRITE or READ
+   * \param exchanges the exchanges of the operation
+   * \param latency the latency
+   * \param tag the timestamp of the value
+   * \param key the key of the register
+   * \param writer the writer id of the tag
+   */
+  void OpCompleted (uint32_t type, uint32_t exchanges, Time latency, uint32_t tag,
+                    uint32_t key, uint32_t writer);
+
+  /**
+   * \brief trace sink of the servers
+   * \param collector the collector
+   * \param server the index of the server
+   * \param type the MessageType received
+   * \param sent the messages sent in response
+   */
+  static void MessageHandled (AmStatsCollector *collector, uint32_t server,
+                              uint32_t type, uint32_t sent);
+
+  Time m_interval;                          //!< length of the intervals
+  Ptr<AmLatencyHistogram> m_readLatency;    //!< latencies of the reads
+  Ptr<AmLatencyHistogram> m_writeLatency;   //!< latencies of the writes
+  Ptr<CounterCalculator<> > m_fastReads;    //!< reads of at most two exchanges
+  Ptr<CounterCalculator<> > m_slowReads;    //!< reads of more exchanges
+  Ptr<CounterCalculator<> > m_handled;      //!< messages received by the servers
+  Ptr<CounterCalculator<> > m_sent;         //!< messages sent by the servers
+  std::vector<IntervalStats> m_intervals;   //!< operations per interval
+  std::vector<ServerStats> m_servers;       //!< messages per server
+};
+
+} // namespace ns3
+
+#endif /* AM_STATS_COLLECTOR_H */
@@ -0,0 +1,236 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/fatal-error.h"
+#include "ns3/uinteger.h"
+#include "ns3/callback.h"
+#include "am-trace-ring.h"
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmTraceRing");
+
+NS_OBJECT_ENSURE_REGISTERED (AmTraceRing);
+
+namespace {
+
+AmTraceRing *g_armedRing = 0;                  //!< ring of DumpOnTerminate
+std::terminate_handler g_previousHandler = 0;  //!< handler it replaced
+
+} // anonymous namespace
+
+TypeId
+AmTraceRing::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AmTraceRing")
+    .SetParent<Object> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<AmTraceRing> ()
+    .AddAttribute ("Capacity", "Records held, rounded up to a power of two.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&AmTraceRing::SetCapacity,
+                                         &AmTraceRing::GetCapacity),
+                   MakeUintegerChecker<uint32_t> (1, 1u << 30))
+  ;
+  return tid;
+}
+
+AmTraceRing::AmTraceRing ()
+  : m_next (0),
+    m_clients (0),
+    m_servers (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AmTraceRing::~AmTraceRing ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AmTraceRing::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (g_armedRing == this)
+    {
+      std::set_terminate (g_previousHandler);
+      g_armedRing = 0;
+    }
+  Object::DoDispose ();
+}
+
+void
+AmTraceRing::SetCapacity (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  uint32_t size = 1;
+  while (size < capacity)
+    {
+      size <<= 1;
+    }
+  m_records.assign (size, Record ());
+  m_next = 0;
+}
+
+uint32_t
+AmTraceRing::GetCapacity (void) const
+{
+  return m_records.size ();
+}
+
+void
+AmTraceRing::AddClients (ApplicationContainer clients)
+{
+  NS_LOG_FUNCTION (this);
+  for (ApplicationContainer::Iterator i = clients.Begin (); i != clients.End (); ++i)
+    {
+      if (!(*i)->TraceConnectWithoutContext ("OpCompleted", MakeBoundCallback (&AmTraceRing::OpCompleted, this, m_clients++)))
+        {
+          NS_FATAL_ERROR ("Application " << (*i)->GetInstanceTypeId ().GetName () << " has no OpCompleted trace source");
+        }
+    }
+}
+
+void
+AmTraceRing::AddServers (ApplicationContainer servers)
+{
+  NS_LOG_FUNCTION (this);
+  for (ApplicationContainer::Iterator i = servers.Begin (); i != servers.End (); ++i)
+    {
+      if (!(*i)->TraceConnectWithoutContext ("MessageHandled", MakeBoundCallback (&AmTraceRing::MessageHandled, this, m_servers++)))
+        {
+          NS_FATAL_ERROR ("Application " << (*i)->GetInstanceTypeId ().GetName () << " has no MessageHandled trace source");
+        }
+    }
+}
+
+void
+AmTraceRing::Push (uint32_t event, uint32_t node, uint32_t type, uint32_t a,
+                   uint32_t b, int64_t latency)
+{
+  // the size is a power of two: the mask replaces a modulo
+  Record &r = m_records[m_next & (m_records.size () - 1)];
+  r.time = Simulator::Now ().GetNanoSeconds ();
+  r.latency = latency;
+  r.event = event;
+  r.node = node;
+  r.type = type;
+  r.a = a;
+  r.b = b;
+  m_next++;
+}
+
+void
+AmTraceRing::OpCompleted (AmTraceRing *ring, uint32_t client, uint32_t type,
+                          uint32_t exchanges, Time latency, uint32_t tag,
+                          uint32_t key, uint32_t writer)
+{
+  ring->Push (OP_COMPLETED, client, type, exchanges, tag, latency.GetNanoSeconds ());
+}
+
+void
+AmTraceRing::MessageHandled (AmTraceRing *ring, uint32_t server,
+                             uint32_t type, uint32_t sent)
+{
+  ring->Push (MESSAGE_HANDLED, server, type, sent, 0, 0);
+}
+
+uint32_t
+AmTraceRing::GetNRecords (void) const
+{
+  return m_next < m_records.size () ? m_next : m_records.size ();
+}
+
+const AmTraceRing::Record &
+AmTraceRing::GetRecord (uint32_t i) const
+{
+  NS_ASSERT (i < GetNRecords ());
+  return m_records[(m_next - GetNRecords () + i) & (m_records.size () - 1)];
+}
+
+void
+AmTraceRing::Dump (std::ostream &os) const
+{
+  os << "# " << GetNRecords () << " of " << m_next << " records" << std::endl;
+  for (uint32_t i = 0; i < GetNRecords (); i++)
+    {
+      const Record &r = GetRecord (i);
+      os << r.time << "ns ";
+      if (r.event == OP_COMPLETED)
+        {
+          os << "client " << r.node << " op " << r.type
+             << " exch " << r.a << " tag " << r.b
+             << " latency " << r.latency << "ns";
+        }
+      else
+        {
+          os << "server " << r.node << " msg " << r.type
+             << " sent " << r.a;
+        }
+      os << std::endl;
+    }
+}
+
+void
+AmTraceRing::Dump (std::string file) const
+{
+  NS_LOG_FUNCTION (this << file);
+  std::ofstream os (file.c_str ());
+  if (!os.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open " << file);
+      return;
+    }
+  Dump (os);
+}
+
+void
+AmTraceRing::DumpOnTerminate (std::string file)
+{
+  NS_LOG_FUNCTION (this << file);
+  m_dumpFile = file;
+  if (g_armedRing == 0)
+    {
+      g_previousHandler = std::set_terminate (&AmTraceRing::Terminate);
+    }
+  g_armedRing = this;
+}
+
+void
+AmTraceRing::Terminate (void)
+{
+  AmTraceRing *ring = g_armedRing;
+  g_armedRing = 0;
+  if (ring != 0)
+    {
+      std::cerr << "Dumping the trace ring to " << ring->m_dumpFile << std::endl;
+      ring->Dump (ring->m_dumpFile);
+    }
+  if (g_previousHandler != 0)
+    {
+      g_previousHandler ();
+    }
+  std::abort ();
+}
+
+} // namespace ns3
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_TRACE_RING_H
+#define AM_TRACE_RING_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/application-container.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmTraceRing
+ * \brief Binary ring buffer of the last events of a run.
+ *
+ * The ring connects to the "OpCompleted" trace source of the clients and
+ * the "MessageHandled" trace source of the servers and stores every event
+ * as a fixed size record, overwriting the oldest one once Capacity records
+ * are stored. Recording copies a few integers and never formats text, so
+ * the ring can stay attached to long runs; the records are turned into
+ * text only by Dump, after the run or from the terminate handler installed
+ * by DumpOnTerminate when a NS_FATAL_ERROR or NS_ASSERT stops it.
+ */
+class AmTraceRing : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  AmTraceRing ();
+  virtual ~AmTraceRing ();
+
+  /// Kind of a record
+  enum Event
+  {
+    OP_COMPLETED = 0,    //!< a client completed an operation
+    MESSAGE_HANDLED = 1  //!< a server handled a message
+  };
+
+  /// One traced event
+  struct Record
+  {
+    int64_t time;        //!< simulation time (ns)
+    int64_t latency;     //!< latency of the operation (ns), or 0
+    uint32_t event;      //!< the Event
+    uint32_t node;       //!< index of the client or the server
+    uint32_t type;       //!< operation or message type
+    uint32_t a;          //!< exchanges, or messages sent
+    uint32_t b;          //!< tag of the operation, or 0
+  };
+
+  /**
+   * \brief record the operations of the clients
+   * \param clients the client applications
+   */
+  void AddClients (ApplicationContainer clients);
+
+  /**
+   * \brief record the messages of the servers
+   * \param servers the server applications, in the order of their IDs
+   */
+  void AddServers (ApplicationContainer servers);
+
+  /**
+   * \returns the number of records held, at most the capacity
+   */
+  uint32_t GetNRecords (void) const;
+
+  /**
+   * \param i the index of the record, 0 being the oldest held
+   * \returns the record
+   */
+  const Record & GetRecord (uint32_t i) const;
+
+  /**
+   * \brief write the records held, oldest first, one per line
+   * \param os the output stream
+   */
+  void Dump (std::ostream &os) const;
+
+  /**
+   * \brief write the records held to a file
+   * \param file the file name
+   */
+  void Dump (std::string file) const;
+
+  /**
+   * \brief dump the ring to file if the run terminates abnormally
+   *
+   * Installs a std::terminate handler that writes the ring before calling
+   * the previous handler. A single ring can be armed at a time.
+   *
+   * \param file the file name
+   */
+  void DumpOnTerminate (std::string file);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief append a record, overwriting the oldest one if full
+   * \param event the Event
+   * \param node the client or server index
+   * \param type the operation or message type
+   * \param a exchanges, or messages sent
+   * \param b tag, or 0
+   * \param latency latency, or 0
+   */
+  void Push (uint32_t event, uint32_t node, uint32_t type, uint32_t a,
+             uint32_t b, int64_t latency);
+
+  /**
+   * \brief trace sink of the clients
+   * \param ring the ring
+   * \param client the index of the client
+   * \param type WRITE or READ
+   * \param exchanges the exchanges of the operation
+   * \param latency the latency
+   * \param tag the timestamp of the value
+   * \param key the key of the register
+   * \param writer the writer id of the tag
+   */
+  static void OpCompleted (AmTraceRing *ring, uint32_t client, uint32_t type,
+                           uint32_t exchanges, Time latency, uint32_t tag,
+                           uint32_t key, uint32_t writer);
+
+  /**
+   * \brief trace sink of the servers
+   * \param ring the ring
+   * \param server the index of the server
+   * \param type the MessageType received
+   * \param sent the messages sent in response
+   */
+  static void MessageHandled (AmTraceRing *ring, uint32_t server,
+                              uint32_t type, uint32_t sent);
+
+  /// std::terminate handler of DumpOnTerminate
+  static void Terminate (void);
+
+  /**
+   * \brief set the capacity, rounded up to a power of two
+   * \param capacity the requested capacity
+   */
+  void SetCapacity (uint32_t capacity);
+
+  /**
+   * \returns the capacity
+   */
+  uint32_t GetCapacity (void) const;
+
+  std::vector<Record> m_records;   //!< the ring, of a power of two size
+  uint64_t m_next;                 //!< records pushed since the start
+  uint32_t m_clients;              //!< clients connected
+  uint32_t m_servers;              //!< servers connected
+  std::string m_dumpFile;          //!< file of DumpOnTerminate
+};
+
+} // namespace ns3
+
+#endif /* AM_TRACE_RING_H */
@@ -0,0 +1,246 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/fatal-error.h"
+#include "ns3/double.h"
+#include "am-workload.h"
+#include <fstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmWorkload");
+
+AmWorkload::AmWorkload ()
+  : m_arrival (CLOSED_LOOP),
+    m_thinkTime (Seconds (1.0)),
+    m_randomThink (false),
+    m_rate (1.0),
+    m_next (0),
+    m_maxInFlight (1),
+    m_outstanding (0),
+    m_backlog (0)
+{
+  m_think = CreateObject<UniformRandomVariable> ();
+  m_interArrival = CreateObject<ExponentialRandomVariable> ();
+}
+
+void
+AmWorkload::SetInvokeCallback (Callback<void> invoke)
+{
+  m_invoke = invoke;
+}
+
+void
+AmWorkload::SetClosedLoop (Time thinkTime, bool random)
+{
+  NS_LOG_FUNCTION (this << thinkTime << random);
+  m_arrival = CLOSED_LOOP;
+  m_thinkTime = thinkTime;
+  m_randomThink = random;
+}
+
+void
+AmWorkload::SetPoisson (double rate)
+{
+  NS_LOG_FUNCTION (this << rate);
+  NS_ASSERT_MSG (rate > 0, "AmWorkload: the arrival rate must be positive");
+  m_arrival = POISSON;
+  m_rate = rate;
+  m_interArrival->SetAttribute ("Mean", DoubleValue (1.0 / m_rate));
+}
+
+void
+AmWorkload::SetTrace (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  std::ifstream in (fileName.c_str ());
+  if (!in.is_open ())
+    {
+      NS_FATAL_ERROR ("AmWorkload: cannot open the trace file " << fileName);
+    }
+
+  m_arrival = TRACE;
+  m_trace.clear ();
+  m_next = 0;
+
+  double t;
+  while (in >> t)
+    {
+      m_trace.push_back (Seconds (t));
+    }
+}
+
+void
+AmWorkload::SetMaxInFlight (uint32_t maxInFlight)
+{
+  m_maxInFlight = maxInFlight;
+}
+
+int64_t
+AmWorkload::AssignStreams (int64_t stream)
+{
+  m_think->SetStream (stream);
+  m_interArrival->SetStream (stream + 1);
+  return 2;
+}
+
+void
+AmWorkload::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_started = Simulator::Now ();
+  m_outstanding = 0;
+  m_backlog = 0;
+  m_next = 0;
+
+  if (m_arrival == CLOSED_LOOP)
+    {
+      for (uint32_t i = 0; i < m_maxInFlight; i++)
+        {
+          Schedule (GetThinkTime ());
+        }
+    }
+  else
+    {
+      ScheduleArrival ();
+    }
+}
+
+void
+AmWorkload::OperationCompleted (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_outstanding > 0)
+    {
+      m_outstanding--;
+    }
+
+  if (m_arrival == CLOSED_LOOP)
+    {
+      Schedule (GetThinkTime ());
+    }
+  else if (m_backlog > 0)
+    {
+      // the completing operation is still being processed - start the
+      // queued one in a separate event
+      m_backlog--;
+      Schedule (Seconds (0));
+    }
+}
+
+void
+AmWorkload::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (std::list<EventId>::iterator it = m_events.begin (); it != m_events.end (); it++)
+    {
+      Simulator::Cancel (*it);
+    }
+  m_events.clear ();
+  Simulator::Cancel (m_arrivalEvent);
+}
+
+void
+AmWorkload::Schedule (Time dt)
+{
+  NS_LOG_LOGIC ("Next operation in " << dt.GetSeconds () << "s");
+
+  // forget the events that already took place
+  for (std::list<EventId>::iterator it = m_events.begin (); it != m_events.end (); )
+    {
+      if (it->IsExpired ())
+        {
+          it = m_events.erase (it);
+        }
+      else
+        {
+          it++;
+        }
+    }
+
+  m_events.push_back (Simulator::Schedule (dt, &AmWorkload::Invoke, this));
+}
+
+void
+AmWorkload::Invoke (void)
+{
+  m_outstanding++;
+  m_invoke ();
+}
+
+void
+AmWorkload::Arrive (void)
+{
+  ScheduleArrival ();
+
+  if (m_outstanding < m_maxInFlight)
+    {
+      Invoke ();
+    }
+  else
+    {
+      NS_LOG_LOGIC ("All " << m_maxInFlight << " slots busy, " << m_backlog + 1 << " arrivals queued");
+      m_backlog++;
+    }
+}
+
+void
+AmWorkload::ScheduleArrival (void)
+{
+  Time dt;
+
+  if (m_arrival == POISSON)
+    {
+      dt = Seconds (m_interArrival->GetValue ());
+    }
+  else
+    {
+      if (m_next >= m_trace.size ())
+        {
+          return;
+        }
+      dt = m_started + m_trace[m_next++] - Simulator::Now ();
+      if (dt.IsNegative ())
+        {
+          dt = Seconds (0);
+        }
+    }
+
+  // a single arrival is pending at a time, so it is not kept with the
+  // invocations, which are pruned at every operation
+  m_arrivalEvent = Simulator::Schedule (dt, &AmWorkload::Arrive, this);
+}
+
+Time
+AmWorkload::GetThinkTime (void)
+{
+  int64_t ms = m_thinkTime.GetMilliSeconds ();
+
+  // a random think time is drawn in [1s, thinkTime)
+  if (m_randomThink && ms > 1001)
+    {
+      return MilliSeconds (m_think->GetInteger (1000, ms - 1));
+    }
+  return m_thinkTime;
+}
+
+} // namespace ns3
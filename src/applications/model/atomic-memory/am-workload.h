@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AM_WORKLOAD_H
+#define AM_WORKLOAD_H
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+#include "ns3/random-variable-stream.h"
+#include <list>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \class AmWorkload
+ * \brief Decides when a client invokes its operations.
+ *
+ * Three arrival processes are supported:
+ *  - CLOSED_LOOP: every outstanding slot waits a think time after its
+ *    operation completes (the Interval of the client, or a uniform draw in
+ *    [1s, Interval) when RandomInterval is set);
+ *  - POISSON: operations arrive with exponential inter-arrival times,
+ *    independently of the completions;
+ *  - TRACE: operations arrive at the times listed in a file (seconds, one
+ *    per line, relative to the start of the workload).
+ *
+ * With open-loop arrivals an operation that finds the client at its limit
+ * of outstanding operations is queued and invoked as soon as one completes.
+ * The random variables are ns-3 streams, so every client draws from its own
+ * reproducible stream.
+ */
+class AmWorkload
+{
+public:
+  /// Arrival processes
+  enum Arrival
+  {
+    CLOSED_LOOP,
+    POISSON,
+    TRACE
+  };
+
+  AmWorkload ();
+
+  /**
+   * \brief set the function that invokes an operation
+   * \param invoke the callback
+   */
+  void SetInvokeCallback (Callback<void> invoke);
+
+  /**
+   * \brief use closed-loop arrivals
+   * \param thinkTime the time between a completion and the next invocation
+   * \param random draw the think time uniformly in [1s, thinkTime)
+   */
+  void SetClosedLoop (Time thinkTime, bool random);
+
+  /**
+   * \brief use open-loop Poisson arrivals
+   * \param rate the mean number of operations per second
+   */
+  void SetPoisson (double rate);
+
+  /**
+   * \brief replay the arrivals listed in a file
+   * \param fileName the trace file
+   */
+  void SetTrace (std::string fileName);
+
+  /**
+   * \param maxInFlight the maximum number of outstanding operations
+   */
+  void SetMaxInFlight (uint32_t maxInFlight);
+
+  /**
+   * \brief assign fixed random variable stream numbers
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * \brief start generating operations
+   */
+  void Start (void);
+
+  /**
+   * \brief notify that an outstanding operation completed
+   */
+  void OperationCompleted (void);
+
+  /**
+   * \brief cancel the pending invocations
+   */
+  void Stop (void);
+
+private:
+  /**
+   * \brief schedule an invocation
+   * \param dt the delay
+   */
+  void Schedule (Time dt);
+  /**
+   * \brief an operation is invoked now
+   */
+  void Invoke (void);
+  /**
+   * \brief an open-loop operation arrives
+   */
+  void Arrive (void);
+  /**
+   * \brief schedule the next open-loop arrival
+   */
+  void ScheduleArrival (void);
+  /**
+   * \return the next think time
+   */
+  Time GetThinkTime (void);
+
+  Arrival m_arrival;              //!< arrival process
+  Time m_thinkTime;               //!< closed-loop think time
+  bool m_randomThink;             //!< draw the think time at random
+  double m_rate;                  //!< Poisson arrival rate (ops/s)
+  std::vector<Time> m_trace;      //!< arrival times to replay
+  uint32_t m_next;                //!< next arrival of the trace
+  Time m_started;                 //!< start time of the workload
+
+  uint32_t m_maxInFlight;         //!< maximum outstanding operations
+  uint32_t m_outstanding;         //!< operations invoked and not completed
+  uint32_t m_backlog;             //!< arrivals waiting for a free slot
+
+  Callback<void> m_invoke;        //!< invokes an operation
+  std::list<EventId> m_events;    //!< pending invocations
+  EventId m_arrivalEvent;         //!< pending arrival of the open-loop workloads
+  Ptr<UniformRandomVariable> m_think;           //!< think time stream
+  Ptr<ExponentialRandomVariable> m_interArrival; //!< inter-arrival stream
+};
+
+} // namespace ns3
+
+#endif /* AM_WORKLOAD_H */
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "am-write-batcher.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AmWriteBatcher");
+
+AmWriteBatcher::AmWriteBatcher ()
+  : m_maxWrites (1),
+    m_rounds (0),
+    m_writes (0)
+{
+}
+
+void
+AmWriteBatcher::SetMaxWrites (uint32_t max)
+{
+  NS_LOG_FUNCTION (this << max);
+  m_maxWrites = std::max<uint32_t> (max, 1);
+}
+
+bool
+AmWriteBatcher::IsEnabled (void) const
+{
+  return m_maxWrites > 1;
+}
+
+bool
+AmWriteBatcher::Add (uint32_t key, const Write &write)
+{
+  NS_LOG_FUNCTION (this << key << write.op);
+  Key &k = m_keys[key];
+  if (k.open)
+    {
+      k.waiting.push_back (write);
+      return false;
+    }
+  k.open = true;
+  k.round.assign (1, write);
+  return true;
+}
+
+void
+AmWriteBatcher::Queue (uint32_t key, const Write &write)
+{
+  NS_LOG_FUNCTION (this << key << write.op);
+  m_keys[key].waiting.push_back (write);
+}
+
+bool
+AmWriteBatcher::Complete (uint32_t key, std::vector<Write> &committed)
+{
+  NS_LOG_FUNCTION (this << key);
+  std::map<uint32_t, Key>::iterator it = m_keys.find (key);
+  NS_ASSERT_MSG (it != m_keys.end () && it->second.open, "No round in flight on key " << key);
+
+  committed.swap (it->second.round);
+  it->second.round.clear ();
+  it->second.open = false;
+  m_rounds++;
+  m_writes += committed.size ();
+  return Open (it);
+}
+
+bool
+AmWriteBatcher::Next (uint32_t &key)
+{
+  NS_LOG_FUNCTION (this);
+
+  // the writes are numbered in invocation order
+  std::map<uint32_t, Key>::iterator oldest = m_keys.end ();
+  for (std::map<uint32_t, Key>::iterator it = m_keys.begin (); it != m_keys.end (); ++it)
+    {
+      if (!it->second.open && !it->second.waiting.empty ()
+          && (oldest == m_keys.end () || it->second.waiting.front ().op < oldest->second.waiting.front ().op))
+        {
+          oldest = it;
+        }
+    }
+  if (oldest == m_keys.end ())
+    {
+      return false;
+    }
+  key = oldest->first;
+  return Open (oldest);
+}
+
+bool
+AmWriteBatcher::Open (std::map<uint32_t, Key>::iterator it)
+{
+  Key &k = it->second;
+  if (k.waiting.empty ())
+    {
+      m_keys.erase (it);
+      return false;
+    }
+  uint32_t n = std::min<uint32_t> (k.waiting.size (), m_maxWrites);
+  k.round.assign (k.waiting.begin (), k.waiting.begin () + n);
+  k.waiting.erase (k.waiting.begin (), k.waiting.begin () + n);
+  k.open = true;
+  return true;
+}
+
+bool
+AmWriteBatcher::IsOpen (uint32_t key) const
+{
+  std::map<uint32_t, Key>::const_iterator it = m_keys.find (key);
+  return it != m_keys.end () && it->second.open;
+}
+
+bool
+AmWriteBatcher::IsIdle (void) const
+{
+  for (std::map<uint32_t, Key>::const_iterator it = m_keys.begin (); it != m_keys.end (); ++it)
+    {
+      if (it->second.open)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+const std::vector<AmWriteBatcher::Write> &
+AmWriteBatcher::GetRound (uint32_t key) const
+{
+  std::map<uint32_t, Key>::const_iterator it = m_keys.find (key);
+  NS_ASSERT_MSG (it != m_keys.end () && it->second.open, "No round in flight on key " << key);
+  return it->second.round;
+}
+
+void
+AmWriteBatcher::Clear (void)
+{
+  m_keys.clear ();
+}
+
+uint32_t
+AmWriteBatcher::GetRounds (void) const
+{
+  return m_rounds;
+}
+
+uint32_t
+AmWriteBatcher::GetWrites (void) const
+{
+  return m_writes;
+}
+
+} // namespace ns3
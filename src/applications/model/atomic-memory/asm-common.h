@@ -2,6 +2,7 @@
 #define AM_COMMON_H
 
 #include <sstream>
+#include <stdint.h>
 
 // Process Types
 enum ProcessType{
@@ -14,6 +15,7 @@ enum Status{
     IDLE,
     PHASE1,
     PHASE2,
+    PHASE3,
 };
 
 // Message Types
@@ -32,6 +34,12 @@ enum MessageType{
 	DISCOVERACK,
     READ_DISCOVER,
     READ_DISCOVER_ACK,
+    PRE_WRITE,
+    PRE_WRITE_ACK,
+    FINALIZE,
+    FINALIZE_ACK,
+    READ_FINALIZE,
+    READ_FINALIZE_ACK,
 };
 
 // Log message level
@@ -40,6 +48,26 @@ enum logLevel_t{
 	DEBUG
 };
 
+// Transports of the messages
+enum Transport{
+	TRANSPORT_TCP,	// one connection per client and server
+	TRANSPORT_UDP,	// datagrams, the clients retransmit
+};
+
+// Totals of a client, as reported in its LOG line
+struct AmClientStats
+{
+	AmClientStats () : sent (0), invoked (0), completed (0), slowReads (0), fastReads (0), commTime (0), compTime (0) {}
+
+	uint32_t sent;		//!< messages sent
+	uint32_t invoked;	//!< operations invoked
+	uint32_t completed;	//!< operations completed
+	uint32_t slowReads;	//!< completed reads logged as #4EXCH/#3EXCH
+	uint32_t fastReads;	//!< completed reads logged as #2EXCH
+	double commTime;	//!< simulated time per invoked operation, in seconds
+	double compTime;	//!< computation (wall-clock) time per invoked operation, in seconds
+};
+
 class AsmCommon
 {
 public:
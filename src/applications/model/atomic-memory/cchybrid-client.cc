@@ -26,8 +26,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
 #include "cchybrid-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <unistd.h>
 #include <chrono>
 #include <thread>
@@ -92,7 +97,7 @@ CCHybridClient::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&CCHybridClient::m_peerPort),
                    MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&CCHybridClient::SetDataSize,
                                          &CCHybridClient::GetDataSize),
@@ -100,6 +105,9 @@ CCHybridClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&CCHybridClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&CCHybridClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -125,6 +133,44 @@ CCHybridClient::GetTypeId (void)
                    	 UintegerValue (100),
                   	 MakeUintegerAccessor (&CCHybridClient::m_numClients),
                   	 MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&CCHybridClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&CCHybridClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&CCHybridClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&CCHybridClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&CCHybridClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&CCHybridClient::m_traceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("LeaseTime",
+                   "The duration of the read leases granted by the servers, the same as theirs; 0 for no lease",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&CCHybridClient::m_leaseTime),
+                   MakeTimeChecker ())
 	;
   return tid;
 }
@@ -137,7 +183,6 @@ CCHybridClient::CCHybridClient ()
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
 	//m_socket = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -151,6 +196,8 @@ CCHybridClient::CCHybridClient ()
 
 	m_twoExOps = 0;
 	m_fourExOps = 0;
+	m_leaseReads = 0;
+	m_leased = 0;
 }
 
 CCHybridClient::~CCHybridClient()
@@ -183,7 +230,31 @@ CCHybridClient::StartApplication (void)
 
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&CCHybridClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&CCHybridClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	m_workload.SetMaxInFlight (1);
 
 	// seed pseudo-randomness
 	srand(m_seed);
@@ -197,9 +268,7 @@ CCHybridClient::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -217,10 +286,28 @@ CCHybridClient::StartApplication (void)
 		}
 	}
 
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
+
+}
 
+AmClientStats
+CCHybridClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_twoExOps+m_fourExOps+m_leaseReads;
+	if (m_prType == READER)
+	{
+		stats.slowReads = m_fourExOps;
+		stats.fastReads = m_twoExOps+m_leaseReads;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
 }
 
 void 
@@ -228,8 +315,6 @@ CCHybridClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
   if ( !m_socket.empty() )
     {
 	  for(uint32_t i=0; i< m_socket.size(); i++ )
@@ -253,22 +338,22 @@ CCHybridClient::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_twoExOps+m_fourExOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_twoExOps+m_fourExOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_twoExOps+m_fourExOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-	  sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_twoExOps+m_fourExOps <<", #4EXCH_reads="<< m_fourExOps << ", #2EXCH_reads="<<m_twoExOps<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
-	  std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_twoExOps+m_fourExOps <<", #4EXCH_reads="<< m_fourExOps << ", #2EXCH_reads="<<m_twoExOps<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_twoExOps+m_fourExOps+m_leaseReads <<", #4EXCH_reads="<< m_fourExOps << ", #2EXCH_reads="<<m_twoExOps<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_twoExOps+m_fourExOps+m_leaseReads <<", #4EXCH_reads="<< m_fourExOps << ", #2EXCH_reads="<<m_twoExOps<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
 
-if(m_personalID==m_numClients-1){
-  	exit(0);
-}
+  if (m_leaseTime.IsStrictlyPositive () && m_prType == READER)
+    {
+      uint32_t reads = m_twoExOps+m_fourExOps+m_leaseReads;
+      std::cout << "** CLIENT_"<<m_personalID <<" LEASE: #leaseReads="<<m_leaseReads<<", #fastReads="<<m_twoExOps<<", LeaseHitRatio="<<(reads > 0 ? (double) m_leaseReads / reads : 0)<<", FastPathRatio="<<(reads > 0 ? (double) m_twoExOps / reads : 0)<<" **"<<std::endl;
+    }
 
-Simulator::Cancel (m_sendEvent);
+m_workload.Stop ();
   // switch(m_prType)
   // {
   // case WRITER:
@@ -286,6 +371,8 @@ void
 CCHybridClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
   Application::DoDispose ();
 }
 
@@ -302,15 +389,13 @@ void CCHybridClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
@@ -334,6 +419,14 @@ CCHybridClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+CCHybridClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  return streams + m_keys.AssignStreams (stream + streams);
+}
+
 void
 CCHybridClient::SetRemote (Address ip, uint16_t port)
 {
@@ -383,51 +476,36 @@ CCHybridClient::SetFill (std::string fill)
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
-
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-CCHybridClient::ScheduleOperation (Time dt)
+/**************************************************************************************
+ * CCHybrid Read/Write Handlers
+ **************************************************************************************/
+void
+CCHybridClient::SelectKey (void)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
-
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+	NS_LOG_FUNCTION (this);
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	// park the state of the current key and load the one of the next key
+	Register &reg = m_registers.Get (m_key);
+	reg.ts = m_ts;
+	reg.value = m_value;
+	reg.pvalue = m_pvalue;
+	reg.payload = m_payload;
 
+	m_key = m_keys.GetNext ();
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &CCHybridClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &CCHybridClient::InvokeWrite, this);
-  }
+	Register &next = m_registers.Get (m_key);
+	m_ts = next.ts;
+	m_value = next.value;
+	m_pvalue = next.pvalue;
+	m_payload = next.payload;
 }
 
-/**************************************************************************************
- * CCHybrid Read/Write Handlers
- **************************************************************************************/
 void
 CCHybridClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -436,6 +514,28 @@ CCHybridClient::InvokeRead (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+		m_leased = 0;
+
+		// a valid lease on the key answers the read without a round
+		Register &reg = m_registers.Get (m_key);
+		if (reg.lease.IsValid ())
+		{
+			m_opStatus = IDLE;
+			m_opEnd = Now();
+			m_real_end = std::chrono::system_clock::now();
+			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
+
+			AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Lease Value: "<< reg.lease.value <<
+					", <ts, value>: ["<< reg.lease.ts << "," << reg.lease.value <<"] - @ 0 EXCH **");
+			m_opAve += m_opEnd - m_opStart;
+			m_opCompletedTrace (READ, 0, m_opEnd - m_opStart, reg.lease.ts, m_key, 0);
+			m_real_opAve += elapsed_seconds;  //
+			m_workload.OperationCompleted ();
+			m_leaseReads++;
+			return;
+		}
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
@@ -444,9 +544,7 @@ CCHybridClient::InvokeRead (void)
 		m_replies = 0;		//reset replies
 		HandleSend();
 
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 	}
 }
 
@@ -454,7 +552,6 @@ void
 CCHybridClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -463,6 +560,8 @@ CCHybridClient::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = WRITE;
@@ -471,14 +570,14 @@ CCHybridClient::InvokeWrite (void)
 		m_ts ++;
 		m_pvalue = m_value;
 		m_value = 900+m_opCount;
+		// the new value and the previous one, which is none before the first write
+		m_payload = Create<Packet> (m_ts > 1 ? 2 * m_size : m_size);
 
 		//Send msg to all
 		m_replies = 0;		//reset replies
 		HandleSend();
 
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 	}
 }
 
@@ -487,30 +586,21 @@ CCHybridClient::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT (m_sendEvent.IsExpired ());
-
   ++m_sent;
 
-  // Prepare packet content
-  std::stringstream pkts;
-  // serialize <msgType, ts, value, counter>
-  pkts << m_sent << " " << m_msgType << " " << m_ts << " " << m_value << " " << m_pvalue;
-
-  SetFill(pkts.str());
-
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "CCHybridClient::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "CCHybridClient::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // Prepare packet content <counter, msgType, ts, value, pvalue>
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
+  hdr.SetCounter (m_sent);
+  hdr.SetType (m_msgType);
+  hdr.SetTs (m_ts);
+  hdr.SetValue (m_value);
+  hdr.SetPvalue (m_pvalue);
+  hdr.SetSender (m_personalID);
 
+  // Create packet, all but the queries of the readers carry the bytes
+  // of the value and previous value
+  Ptr<Packet> p = m_framer.Build (hdr, m_msgType == READ ? 0 : m_payload);
 
   //random server to start from
   int current = rand()%m_serverAddress.size();
@@ -524,9 +614,7 @@ CCHybridClient::HandleSend (void)
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << m_size << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current]) << " port " << m_peerPort;
-		  LogInfo ( sstm );
+		  AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current]) << " port " << m_peerPort);
 	  }
 
       // move to the next server
@@ -541,46 +629,39 @@ CCHybridClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  //uint32_t msgT, msgTs, msgV, msgVp, msgC, msgViews;
-  uint32_t msgC;
+  AmProtocolHeader hdr;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
 	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgC;
+	  packet->RemoveHeader (hdr);
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-		  sstm << "Received " << packet->GetSize () << " bytes from " <<
+		  AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-		  LogInfo (sstm);
+				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 	  }
 
       // check message freshness and if client is waiting
-      if ( msgC == m_sent && m_opStatus != IDLE)
+      if ( hdr.GetCounter () == m_sent && m_opStatus != IDLE)
       {
-    	  ProcessReply(istm, from);
+    	  ProcessReply(hdr, packet, from);
       }
     }
 }
 
 void
-CCHybridClient::ProcessReply(std::istream& istm, Address sender)
+CCHybridClient::ProcessReply(const AmProtocolHeader& hdr, Ptr<Packet> payload, Address sender)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-	uint32_t msgT, msgTs, msgV, msgVp, msgViews;
-	bool propTs;
+	uint32_t msgTs = hdr.GetTs ();
+	uint32_t msgV = hdr.GetValue ();
+	uint32_t msgVp = hdr.GetPvalue ();
+	uint32_t msgViews = hdr.GetViews ();
+	bool propTs = hdr.IsPropagated ();
 
-	istm >> msgT >> msgTs >> msgV >> msgVp >> msgViews >> propTs;
 	//increment the number of replies received
 	m_replies ++;
 
@@ -590,17 +671,16 @@ CCHybridClient::ProcessReply(std::istream& istm, Address sender)
 		if (m_replies >= (m_numServers - m_fail))
 		{
 			m_opStatus = IDLE;
-			ScheduleOperation (m_interval);
+			m_workload.OperationCompleted ();
 
 			m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 
 			m_opEnd = Now();
-			AsmCommon::Reset(sstm);
-			sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **";
-			LogInfo(sstm);
+			AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **");
 
 			m_opAve += m_opEnd - m_opStart;
+			m_opCompletedTrace (WRITE, 2, m_opEnd - m_opStart, m_ts, m_key, 0);
 			m_real_opAve += elapsed_seconds;  //
 
 			m_twoExOps++;
@@ -617,12 +697,11 @@ CCHybridClient::ProcessReply(std::istream& istm, Address sender)
 				m_ts = msgTs;
 				m_value = msgV;
 				m_pvalue = msgVp;
+				m_payload = payload;
 
 				if (m_verbose)
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Updated local <ts,value> pair to: [" << m_ts << "," << m_value << "," << m_pvalue <<"]";
-					LogInfo(sstm);
+					AM_LOG_INFO ("Updated local <ts,value> pair to: [" << m_ts << "," << m_value << "," << m_pvalue <<"]");
 				}
 
 				//reset the maxAck set and maxViews variables
@@ -632,6 +711,11 @@ CCHybridClient::ProcessReply(std::istream& istm, Address sender)
 
 			}
 
+			if (hdr.IsLeased ())
+			{
+				m_leased++;
+			}
+
 			// enclosed ts == maxTs - include the msg in the maxAck set and update maxViews variable
 			if ( m_ts == msgTs )
 			{
@@ -654,18 +738,14 @@ CCHybridClient::ProcessReply(std::istream& istm, Address sender)
 			{
 				if (m_verbose)
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Waiting for " << (m_numServers-m_fail) << " replies, received " << m_replies;
-					LogInfo(sstm);
+					AM_LOG_INFO ("Waiting for " << (m_numServers-m_fail) << " replies, received " << m_replies);
 				}
 
 
 				// if too many processes viewed this ts go to a second phase
 				if (m_maxViews > ((m_numServers/m_fail) - 2) )
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Proceeding to PHASE2, maxViews " << m_maxViews << ", bound "<< ((m_numServers/m_fail) - 2);
-					LogInfo(sstm);
+					AM_LOG_INFO ("Proceeding to PHASE2, maxViews " << m_maxViews << ", bound "<< ((m_numServers/m_fail) - 2));
 
 					// if propagated to less than f+1 servers - go to second phase
 					if( m_propSet.size() < m_fail+1)
@@ -680,18 +760,18 @@ CCHybridClient::ProcessReply(std::istream& istm, Address sender)
 					}
 					else
 					{
-						AsmCommon::Reset(sstm);
 						m_opStatus = IDLE;
 						m_opEnd = Now();
 						m_real_end = std::chrono::system_clock::now();									///
 						std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;		///
 
-						sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Prop Value: "<< m_value <<
-								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **";
-						LogInfo(sstm);
+						AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Prop Value: "<< m_value <<
+								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **");
 						m_opAve += m_opEnd - m_opStart;
+						m_opCompletedTrace (READ, 2, m_opEnd - m_opStart, m_ts, m_key, 0);
 						m_real_opAve += elapsed_seconds;  //
-						ScheduleOperation (m_interval);
+						RenewLease (m_ts, m_value);
+						m_workload.OperationCompleted ();
 						//increase four exchange counter
 						m_twoExOps++;
 					}
@@ -701,14 +781,11 @@ CCHybridClient::ProcessReply(std::istream& istm, Address sender)
 				}
 				else
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Checking the PREDICATE, maxViews " << m_maxViews << ", bound "<< ((m_numServers/m_fail) - 2);
-					LogInfo(sstm);
-
-					AsmCommon::Reset(sstm);
+					AM_LOG_INFO ("Checking the PREDICATE, maxViews " << m_maxViews << ", bound "<< ((m_numServers/m_fail) - 2));
 
 					m_opStatus = IDLE;
 					std::chrono::duration<double> elapsed_seconds;
+					uint32_t tag = m_ts;
 
 					//check the predicate to return in one round
 					if ( IsPredicateValid () )
@@ -717,23 +794,25 @@ CCHybridClient::ProcessReply(std::istream& istm, Address sender)
 						m_real_end = std::chrono::system_clock::now();									///
 						elapsed_seconds = m_real_end-m_real_start;		///
 
-						sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return Value: "<< m_value <<
-								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **";
+						AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return Value: "<< m_value <<
+								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **");
 					}
 					else
 					{
 						m_opEnd = Now();
 						m_real_end = std::chrono::system_clock::now();									///
 						elapsed_seconds = m_real_end-m_real_start;		///
+						tag = m_ts > 0 ? m_ts - 1 : 0;
 
-						sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return PValue: "<< m_pvalue <<
-								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **";
+						AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return PValue: "<< m_pvalue <<
+								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **");
 					}
 
 					m_opAve += m_opEnd - m_opStart;
+					m_opCompletedTrace (READ, 2, m_opEnd - m_opStart, tag, m_key, 0);
 					m_real_opAve += elapsed_seconds;  //
-					LogInfo(sstm);
-					ScheduleOperation (m_interval);
+					RenewLease (tag, tag == m_ts ? m_value : m_pvalue);
+					m_workload.OperationCompleted ();
 					//increase four exchange counter
 					m_twoExOps++;
 				}
@@ -743,18 +822,18 @@ CCHybridClient::ProcessReply(std::istream& istm, Address sender)
 			if (m_replies >= (m_numServers - m_fail))
 			{
 				m_opStatus = IDLE;
-				ScheduleOperation (m_interval);
+				m_workload.OperationCompleted ();
 
 				m_opEnd = Now();
 				m_real_end = std::chrono::system_clock::now();									///
 				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;		///
 
-				AsmCommon::Reset(sstm);
-				sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "] - @ 4 EXCH **";
-				LogInfo(sstm);
+				AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "] - @ 4 EXCH **");
 
 				m_real_opAve += elapsed_seconds;  //
 				m_opAve += m_opEnd - m_opStart;
+				m_opCompletedTrace (READ, 4, m_opEnd - m_opStart, m_ts, m_key, 0);
+				RenewLease (m_ts, m_value);
 
 				//increase four exchange counter
 				m_fourExOps++;
@@ -766,6 +845,29 @@ CCHybridClient::ProcessReply(std::istream& istm, Address sender)
 	}
 }
 
+void
+CCHybridClient::RenewLease (uint32_t ts, uint32_t value)
+{
+	NS_LOG_FUNCTION (this << ts);
+
+	if (!m_leaseTime.IsStrictlyPositive ())
+	{
+		return;
+	}
+
+	// the query was sent at the invocation, before the servers granted their leases;
+	// the previous value is not the greatest tag, it takes no lease
+	Time leaseEnd = Seconds (0);
+	if (m_leased >= (m_numServers - m_fail) && ts == m_ts)
+	{
+		leaseEnd = m_opStart + m_leaseTime;
+	}
+
+	// with other reads in flight, the lease may hold an older tag than the
+	// one returned: the reads it answers next must not return it
+	m_registers.Get (m_key).lease.Renew (leaseEnd, ts, 0, value, m_payload);
+}
+
 bool
 CCHybridClient::IsPredicateValid()
 {
@@ -774,7 +876,6 @@ CCHybridClient::IsPredicateValid()
 	std::vector<uint16_t> buckets;
 	std::vector< std::pair<Address, uint32_t> >::iterator it;
 	int a;
-	std::stringstream sstm;
 
 	buckets.resize((int) ((m_numServers/m_fail) - 1));
 
@@ -788,9 +889,7 @@ CCHybridClient::IsPredicateValid()
 	{
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "PREDICATE LOOP: a=" << a << ", b[a]="<< buckets[a] << ", bound=" << (m_numServers - a*m_fail);
-			LogInfo(sstm);
+			AM_LOG_INFO ("PREDICATE LOOP: a=" << a << ", b[a]="<< buckets[a] << ", bound=" << (m_numServers - a*m_fail));
 		}
 
 		if (buckets[a] >= (m_numServers - a*m_fail))
@@ -22,15 +22,22 @@
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
+#include "ns3/packet.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
 #include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-register-store.h"
+#include "am-key-selector.h"
+#include "am-workload.h"
+#include "am-lease-table.h"
 #include <chrono>
 
 namespace ns3 {
 
 class Socket;
 class Packet;
+class AmProtocolHeader;
 
 /**
  * \ingroup CCHybrid
@@ -83,6 +90,12 @@ public:
 	 */
 	uint32_t GetDataSize (void) const;
 
+	/**
+	 * \brief Get the totals of the operations of this client
+	 * \returns the counters reported in the LOG line
+	 */
+	AmClientStats GetStats (void) const;
+
 	/**
 	 * Set the data fill of the packet (what is sent as data to the server) to
 	 * the zero-terminated contents of the fill string string.
@@ -115,6 +128,14 @@ public:
 
 	void SetServers (std::vector<Address> ip);
 
+	/**
+	 * \brief Assign fixed random variable stream numbers to the random
+	 * variables used by this client
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned
+	 */
+	int64_t AssignStreams (int64_t stream);
+
 protected:
 	virtual void DoDispose (void);
 
@@ -132,12 +153,6 @@ private:
 	 * \brief clear the string stream
 	 */
 	//void Reset(stringstream& s);
-	/**
-	 * \brief Schedule the next packet transmission
-	 * \param dt time interval between packets.
-	 */
-	void ScheduleOperation (Time dt);
-
 	/**
 	 * \brief Read operation handler
 	 */
@@ -146,6 +161,10 @@ private:
 	 * \brief Write operation handler
 	 */
 	void InvokeWrite (void);
+	/**
+	 * \brief Pick the key of the next operation and load its register state
+	 */
+	void SelectKey (void);
 
 	/**
 	 * \brief Send a packet
@@ -162,15 +181,23 @@ private:
 	void HandleRecv (Ptr<Socket> socket);
 	/**
 	 * \brief process the received replies
-	 * \param type the type of the received message
-	 * \param ts the received timestamp
-	 * \param val the value associate with ts
+	 * \param hdr the header of the received message
+	 * \param payload the bytes of the value and previous value of the message
+	 * \param s the address of the server that sent the reply
 	 */
-	void ProcessReply(std::istream& istm, Address s);
+	void ProcessReply(const AmProtocolHeader& hdr, Ptr<Packet> payload, Address s);
 	/**
 	 * \brief check if the predicate is valid on the collected replies
 	 */
 	bool IsPredicateValid();
+	/**
+	 * \brief Raise the read lease of the key of the current read to the tag
+	 * the read returned, and renew it if its quorum granted one and the
+	 * read returned the greatest tag it found
+	 * \param ts the timestamp returned
+	 * \param value the value returned
+	 */
+	void RenewLease (uint32_t ts, uint32_t value);
 	/**
 	 * \brief Handle a Connection Succeed event
 	 * \param socket the connected socket
@@ -182,16 +209,16 @@ private:
 	 */
 	void ConnectionFailed (Ptr<Socket> socket);
 
-	uint32_t m_size; 		//!< Size of the sent packet
+	uint32_t m_size; 		//!< Size of the values written, in bytes
 	uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
 	uint8_t *m_data; 		//!< packet payload data
 
 	std::vector< Ptr<Socket> > m_socket; //!< Socket
+	AmMessageFramer m_framer; //!< reassembles the messages of each socket
 	std::vector<Address> m_serverAddress; //!< Remote server adresses
 	Address m_peerAddress; //!< Remote peer address
 	Address m_myAddress; //!< Remote peer address
 	uint16_t m_peerPort; //!< Remote peer port
-	EventId m_sendEvent;
 	uint32_t m_personalID; 				//My Personal ID
 
 	uint16_t m_serversConnected;
@@ -199,12 +226,36 @@ private:
 	// ccHybrid variables
 	uint32_t m_ts; 				//!< latest timestamp
 	uint32_t m_value;			//!< value associated with m_ts
+	Ptr<Packet> m_payload;		//!< bytes of m_value and m_pvalue
 	uint32_t m_pvalue;			//!< value associated with m_ts - 1 (previous value)
 
 	uint32_t m_maxViews;		//!< maximum #views received
 	std::vector< std::pair<Address, uint32_t> > m_repliesSet;
 	std::vector<Address> m_propSet;
 
+	// Key-value store
+	/// Local state of a single register (key)
+	struct Register
+	{
+		uint32_t ts;      //!< latest timestamp
+		uint32_t value;   //!< value associated with ts
+		Ptr<Packet> payload; //!< bytes of value and pvalue
+		uint32_t pvalue;  //!< value associated with ts - 1 (previous value)
+		AmReadLease lease;   //!< the read lease held on the key
+	};
+	AmRegisterStore<Register> m_registers; //!< register state of the keys not currently accessed
+	AmKeySelector m_keys;		//!< picks the key of each operation
+	uint32_t m_key;				//!< key accessed by the current operation
+	uint32_t m_numKeys;			//!< number of keys
+	AmKeySelector::Distribution m_keyDist; //!< distribution of the accessed keys
+	double m_zipfAlpha;			//!< exponent of the zipf key distribution
+
+	// Workload
+	AmWorkload m_workload;		//!< schedules the invocations of the operations
+	AmWorkload::Arrival m_arrival;	//!< arrival process of the operations
+	double m_arrivalRate;		//!< rate of the Poisson arrivals (ops/s)
+	std::string m_traceFile;	//!< file of the arrival times to replay
+
 	uint32_t m_numServers;		//!< number of servers
 	uint32_t m_fail;			//!< max number of failures supported
 
@@ -226,6 +277,9 @@ private:
 	uint32_t m_count; 		//!< Maximum number of packets the application will send
 	uint32_t m_twoExOps;	//!< operations with 2 message exchanges
 	uint32_t m_fourExOps;	//!< operations with 4 message exchanges
+	uint32_t m_leaseReads;	//!< reads answered by a read lease
+	Time m_leaseTime;		//!< duration of the read leases of the servers, 0 for none
+	uint32_t m_leased;		//!< replies of the read granting a read lease
 
 	//randomness
 	uint16_t m_randInt;		//!< Flag indicating the choose of a random interval for each op invocation
@@ -238,6 +292,9 @@ private:
 
 	/// Callbacks for tracing the packet Tx events
 	TracedCallback<Ptr<const Packet> > m_txTrace;
+
+	/// Callbacks for tracing the completed operations
+	TracedCallback<uint32_t, uint32_t, Time, uint32_t, uint32_t, uint32_t> m_opCompletedTrace;
 };
 
 } // namespace ns3
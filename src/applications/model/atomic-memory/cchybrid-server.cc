@@ -30,8 +30,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/enum.h"
 
 #include "cchybrid-server.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 
 namespace ns3 {
 
@@ -81,6 +86,41 @@ CCHybridServer::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&CCHybridServer::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("ServiceCores",
+					 "Messages processed at the same time, 0 to process every message on arrival",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&CCHybridServer::m_serviceCores),
+					 MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("ServiceTime",
+					 "The processing time of a message, in seconds",
+					 StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"),
+					 MakePointerAccessor (&CCHybridServer::m_serviceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("ServiceTimePerItem",
+					 "The processing time added per entry of the seen set of the register of a message",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&CCHybridServer::m_servicePerItem),
+					 MakeTimeChecker ())
+					.AddAttribute ("Fault",
+					 "The fault of the server: None, Crash (the messages received are lost) or Pause (they are held until the fault ends)",
+					 EnumValue (AmServiceQueue::NONE),
+					 MakeEnumAccessor (&CCHybridServer::SetFault, &CCHybridServer::GetFault),
+					 MakeEnumChecker (AmServiceQueue::NONE, "None",
+					                  AmServiceQueue::CRASH, "Crash",
+					                  AmServiceQueue::PAUSE, "Pause"))
+					.AddAttribute ("Slowdown",
+					 "The time every message received waits before it is processed",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&CCHybridServer::SetSlowdown, &CCHybridServer::GetSlowdown),
+					 MakeTimeChecker ())
+					.AddAttribute ("LeaseTime",
+					 "The read lease granted with the reply to a read, during which the register does not change for the other clients, 0 to grant none (to be the same as the one of the clients)",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&CCHybridServer::m_leaseTime),
+					 MakeTimeChecker ())
+					.AddTraceSource ("MessageHandled", "A message was received and answered",
+					 MakeTraceSourceAccessor (&CCHybridServer::m_handledTrace),
+					 "ns3::AmStatsCollector::MessageHandledCallback")
 	;
 	return tid;
 }
@@ -89,9 +129,6 @@ CCHybridServer::CCHybridServer ()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_ts = 0;
-	m_value = 0;
-	m_propagated = false;
 	m_sent=0;
 	//m_optimize = 1;
 }
@@ -100,9 +137,6 @@ CCHybridServer::~CCHybridServer()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_ts = 0;
-	m_value = 0;
-	m_propagated = false;
 	m_sent=0;
 	//m_optimize = 1;
 }
@@ -115,9 +149,14 @@ void
 CCHybridServer::StartApplication (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
-	sstm << "Debug Mode="<<m_verbose;
-	LogInfo(sstm);
+
+	m_service.SetCores (m_serviceCores);
+	m_service.SetServiceTime (m_serviceTime);
+	m_service.SetPerItem (m_servicePerItem);
+	m_service.SetItemsCallback (MakeCallback (&CCHybridServer::GetServiceItems, this));
+	m_service.SetServedCallback (MakeCallback (&CCHybridServer::HandleRead, this));
+	m_leases.SetLeaseTime (m_leaseTime);
+	AM_LOG_INFO ("Debug Mode="<<m_verbose);
 
 	if (m_socket == 0)
 	{
@@ -154,6 +193,12 @@ CCHybridServer::StartApplication (void)
 			MakeCallback (&CCHybridServer::HandlePeerError, this));
 }
 
+uint32_t
+CCHybridServer::GetSentMessages (void) const
+{
+	return m_sent;
+}
+
 void 
 CCHybridServer::StopApplication ()
 {
@@ -164,17 +209,31 @@ CCHybridServer::StopApplication ()
 		m_socket->Close ();
 		m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
 	}
-	std::stringstream sstm;
-	sstm << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **";
-	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	LogInfo(sstm);
+	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	AM_LOG_INFO ("** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **");
+	if (m_serviceCores > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" CPU: #served="<<m_service.GetServed ()<<", busyTime="<<m_service.GetBusyTime ().GetSeconds ()<<"s, AveWait="<<(m_service.GetServed () > 0 ? m_service.GetWaitTime ().GetSeconds () / m_service.GetServed () : 0)<<"s, #maxQueue="<<m_service.GetMaxQueue ()<<" **"<<std::endl;
+	}
+	if (m_service.GetDropped () > 0 || m_service.GetHeld () > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" FAULTS: #dropped="<<m_service.GetDropped ()<<", #held="<<m_service.GetHeld ()<<" **"<<std::endl;
+	}
+	if (m_leases.IsEnabled ())
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" LEASE: #granted="<<m_leases.GetGranted ()<<", #heldWrites="<<m_leases.GetHeld ()<<", AveHold="<<(m_leases.GetHeld () > 0 ? m_leases.GetHoldTime ().GetSeconds () / m_leases.GetHeld () : 0)<<"s **"<<std::endl;
+	}
+	m_leases.Clear ();
 }
 
 void
 CCHybridServer::DoDispose (void)
 {
 	NS_LOG_FUNCTION (this);
+	m_framer.Clear ();
+	m_service.Clear ();
+	m_registers.Clear ();
 	Application::DoDispose ();
 }
 
@@ -185,6 +244,7 @@ CCHybridServer::DoDispose (void)
 void CCHybridServer::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void CCHybridServer::HandlePeerError (Ptr<Socket> socket)
@@ -201,33 +261,41 @@ void CCHybridServer::HandleAccept (Ptr<Socket> s, const Address& from)
 }
 
 /**************************************************************************************
- * PACKET DATA Handler
+ * ABD Rcv Handler
  **************************************************************************************/
 void
-CCHybridServer::SetFill (std::string fill)
+CCHybridServer::SetFault (AmServiceQueue::Fault fault)
 {
-  NS_LOG_FUNCTION (this << fill);
+	NS_LOG_FUNCTION (this << fault);
+	m_service.SetFault (fault);
+}
 
-  uint32_t dataSize = fill.size () + 1;
+AmServiceQueue::Fault
+CCHybridServer::GetFault (void) const
+{
+	return m_service.GetFault ();
+}
 
-  if (dataSize != m_dataSize)
-    {
-      //delete [] m_data;
-      m_data = new uint8_t [dataSize];
-      m_dataSize = dataSize;
-    }
+uint32_t
+CCHybridServer::GetServiceItems (const AmProtocolHeader &hdr) const
+{
+	const Register *reg = m_registers.Find (hdr.GetKey ());
+	return (reg != 0)? reg->seen.GetSize () : 0;
+}
 
-  memcpy (m_data, fill.c_str (), dataSize);
+void
+CCHybridServer::SetSlowdown (Time delay)
+{
+	NS_LOG_FUNCTION (this << delay);
+	m_service.SetSlowdown (delay);
+}
 
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
+Time
+CCHybridServer::GetSlowdown (void) const
+{
+	return m_service.GetSlowdown ();
 }
 
-/**************************************************************************************
- * ABD Rcv Handler
- **************************************************************************************/
 void 
 CCHybridServer::HandleRead (Ptr<Socket> socket)
 {
@@ -235,94 +303,104 @@ CCHybridServer::HandleRead (Ptr<Socket> socket)
 
 	Ptr<Packet> packet;
 	Address from;
-	uint32_t msgT, msgTs, msgV, msgVp, msgC;
-	std::stringstream sstm;
+	AmProtocolHeader hdr;
 
-	while ((packet = socket->RecvFrom (from)))
+	while ((packet = m_service.Recv (m_framer, socket, from)))
 	{
 		//deserialize the contents of the packet
-		uint8_t buf[1024];
-		packet->CopyData(buf,1024);
-		std::stringbuf sb;
-		sb.str(std::string((char*) buf));
-		std::istream istm(&sb);
-		istm >> msgC >> msgT >> msgTs >> msgV >> msgVp;
+		packet->RemoveHeader (hdr);
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Received " << packet->GetSize () << " bytes from " <<
+			AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf << " optimized " << m_optimize;
-			LogInfo(sstm);
+					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr << " optimized " << m_optimize);
 		}
 
+		HandleMessage (socket, packet, from, hdr);
+	}
+}
 
-		packet->RemoveAllPacketTags ();
-		packet->RemoveAllByteTags ();
+void
+CCHybridServer::ReleaseMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address from, AmProtocolHeader hdr, Time held)
+{
+	NS_LOG_FUNCTION (this << socket << held);
+	m_leases.Release (hdr.GetKey (), Now () - held);
+	HandleMessage (socket, packet, from, hdr);
+}
 
-		if ( m_ts < msgTs )
-		{
-			NS_LOG_LOGIC ("Updating Local Info (ts and seen set)");
-			m_ts = msgTs;
-			m_value = msgV;
-			m_pvalue = msgVp;
+void
+CCHybridServer::HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address from, AmProtocolHeader hdr)
+{
+	NS_LOG_FUNCTION (this << socket);
 
-			//reinitialize the seen set
-			m_seen.clear();
+	uint32_t sent = m_sent;
+	Register &reg = m_registers.Get (hdr.GetKey ());
+	uint32_t msgTs = hdr.GetTs ();
+	AmLeaseTable::Holder holder (from, hdr.GetSender ());
 
-			//reset propagate flag
-			m_propagated = false;
+	// a newer tag waits out the read leases of the other clients
+	if ( m_leases.IsEnabled () && reg.ts < msgTs )
+	{
+		Time wait = m_leases.GetWait (hdr.GetKey (), holder);
+		if (wait.IsStrictlyPositive ())
+		{
+			AM_LOG_INFO ("Holding " << hdr << " for " << wait.GetSeconds () << "s of read leases");
+			m_leases.Hold (hdr.GetKey ());
+			Simulator::Schedule (wait, &CCHybridServer::ReleaseMessage, this, socket, packet, from, hdr, Now ());
+			return;
 		}
+	}
 
-		//insert the sender in the seen set
-		m_seen.insert(from);
+	if ( reg.ts < msgTs )
+	{
+		NS_LOG_LOGIC ("Updating Local Info (ts and seen set)");
+		reg.ts = msgTs;
+		reg.value = hdr.GetValue ();
+		reg.pvalue = hdr.GetPvalue ();
+		reg.payload = packet;
 
-		// set the propagation flag if msg received from reader
-		if(m_ts == msgTs && msgT == INFORM && m_optimize == 1)
-		{
-			m_propagated = true;
-		}
+		//reinitialize the seen set
+		reg.seen.Clear ();
 
-		NS_LOG_LOGIC ("Replying to packet");
+		//reset propagate flag
+		reg.propagated = false;
+	}
 
-		// Prepare packet content
-		std::stringstream pkts;
-		// serialize <counter, msgType, ts, value, |seen|, propflag>
-		pkts << msgC << " " << msgT << " " << m_ts << " " << m_value << " " << m_pvalue << " " << m_seen.size() << " " << m_propagated;
+	//insert the sender in the seen set
+	reg.seen.Insert (hdr.GetSender ());
 
-		SetFill(pkts.str());
+	// set the propagation flag if msg received from reader
+	if(reg.ts == msgTs && hdr.GetType () == INFORM && m_optimize == 1)
+	{
+		reg.propagated = true;
+	}
 
-		Ptr<Packet> p;
-		if (m_dataSize)
-		{
-			NS_ASSERT_MSG (m_dataSize == m_size, "CCHybridServer::HandleSend(): m_size and m_dataSize inconsistent");
-			NS_ASSERT_MSG (m_data, "CCHybridServer::HandleSend(): m_dataSize but no m_data");
-			p = Create<Packet> (m_data, m_dataSize);
-		}
-		else
-		{
-			p = Create<Packet> (m_size);
-		}
+	NS_LOG_LOGIC ("Replying to packet");
 
-		//socket->SendTo (p, 0, from);
-		socket->Send (p);
-		m_sent++;
+	// Prepare packet content <counter, msgType, ts, value, pvalue, |seen|, propflag>
+	hdr.SetTs (reg.ts);
+	hdr.SetValue (reg.value);
+	hdr.SetPvalue (reg.pvalue);
+	hdr.SetViews (reg.seen.GetSize ());
+	hdr.SetPropagated (reg.propagated);
+	hdr.SetLeased (m_leases.IsEnabled () && hdr.GetType () == READ && m_leases.Grant (hdr.GetKey (), holder));
 
-		if (m_verbose)
-		{
-			AsmCommon::Reset(sstm);
-			sstm << "Sent " << packet->GetSize () << " bytes to " <<
-					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort () << " seen: { ";
+	// the reads get the bytes of the value and previous value
+	Ptr<Packet> p = m_framer.Build (hdr, hdr.GetType () == READ ? reg.payload : 0);
 
-			for(std::set< Address >::iterator it=m_seen.begin(); it!=m_seen.end(); it++)
-				sstm << " " <<  InetSocketAddress::ConvertFrom( *it ).GetIpv4();
+	//socket->SendTo (p, 0, from);
+	socket->Send (p);
+	m_sent++;
 
-			sstm << "} data " << pkts.str();
-			LogInfo(sstm);
-		}
+	if (m_verbose)
+	{
+		AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " <<
+				InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
+				InetSocketAddress::ConvertFrom (from).GetPort () << " seen: " << reg.seen << " data " << hdr);
 	}
+
+	m_handledTrace (hdr.GetType (), m_sent - sent);
 }
 
 } // Namespace ns3
@@ -0,0 +1,846 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/log.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/nstime.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "ns3/socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/trace-source-accessor.h"
+#include "coded-abd-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CodedAbdClientApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (CodedAbdClient);
+
+
+void
+CodedAbdClient::LogInfo( std::stringstream& s)
+{
+	NS_LOG_FUNCTION (this);
+
+	NS_LOG_INFO("[CLIENT " << m_personalID << " - "<< Ipv4Address::ConvertFrom(m_myAddress) << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
+}
+
+
+
+TypeId
+CodedAbdClient::GetTypeId (void)
+{
+  //static vector<Address> tmp_address;
+  static TypeId tid = TypeId ("ns3::CodedAbdClient")
+    .SetParent<Application> ()
+    .SetGroupName("Applications")
+    .AddConstructor<CodedAbdClient> ()
+    .AddAttribute ("MaxOperations",
+                   "The maximum number of operations to be invoked",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&CodedAbdClient::m_count),
+                   MakeUintegerChecker<uint32_t> ())
+	.AddAttribute ("MaxFailures",
+					  "The maximum number of server failures",
+					  UintegerValue (100),
+					  MakeUintegerAccessor (&CodedAbdClient::m_fail),
+					  MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Interval", 
+                   "The time to wait between packets",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&CodedAbdClient::m_interval),
+                   MakeTimeChecker ())
+   .AddAttribute ("SetRole",
+					  "The role of the client (reader/writer)",
+					  UintegerValue (0),
+					  MakeUintegerAccessor (&CodedAbdClient::m_prType),
+					  MakeUintegerChecker<uint16_t> ())
+   .AddAttribute ("LocalAddress",
+					  "The local Address of the current node",
+					  AddressValue (),
+					  MakeAddressAccessor (&CodedAbdClient::m_myAddress),
+					  MakeAddressChecker ())
+	.AddAttribute ("RemoteAddress",
+                   "The destination Address of the outbound packets",
+                   AddressValue (),
+                   MakeAddressAccessor (&CodedAbdClient::m_peerAddress),
+                   MakeAddressChecker ())
+    .AddAttribute ("RemotePort", 
+                   "The destination port of the outbound packets",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CodedAbdClient::m_peerPort),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&CodedAbdClient::SetDataSize,
+                                         &CodedAbdClient::GetDataSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("Tx", "A new packet is created and is sent",
+                     MakeTraceSourceAccessor (&CodedAbdClient::m_txTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&CodedAbdClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
+    .AddAttribute ("ID", 
+                     "Client ID",
+                   	 UintegerValue (100),
+                  	 MakeUintegerAccessor (&CodedAbdClient::m_personalID),
+                  	 MakeUintegerChecker<uint32_t> ())
+	 .AddAttribute ("RandomInterval",
+					 "Apply randomness on the invocation interval",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&CodedAbdClient::m_randInt),
+					 MakeUintegerChecker<uint16_t> ())
+	 .AddAttribute ("Seed",
+					 "Seed for the pseudorandom generator",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&CodedAbdClient::m_seed),
+					 MakeUintegerChecker<uint16_t> ())
+	.AddAttribute ("Verbose",
+					 "Verbose for debug mode",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&CodedAbdClient::m_verbose),
+					 MakeUintegerChecker<uint16_t> ())
+	.AddAttribute ("Clients", 
+                     "Number of Clients",
+                   	 UintegerValue (100),
+                  	 MakeUintegerAccessor (&CodedAbdClient::m_numClients),
+                  	 MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CodeK",
+                   "The number of fragments needed to decode a value (0 for n - 2f)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CodedAbdClient::m_codeK),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxInFlight",
+                   "The maximum number of outstanding operations of the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&CodedAbdClient::m_maxInFlight),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&CodedAbdClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&CodedAbdClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&CodedAbdClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&CodedAbdClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&CodedAbdClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&CodedAbdClient::m_traceFile),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+/**************************************************************************************
+ * Constructors
+ **************************************************************************************/
+CodedAbdClient::CodedAbdClient ()
+{
+	NS_LOG_FUNCTION (this);
+	m_sent = 0;
+	//m_socket = 0;
+	m_data = 0;
+	m_dataSize = 0;
+	m_serversConnected = 0;
+
+	m_ts = 0;					//initialize the local timestamp
+	m_id = 0;
+	m_value = 0;				//initialize local value
+	m_opStatus = PHASE1; 		//initialize status
+
+	m_fail = 0;
+	m_opCount = 0;
+	m_completeOps = 0;
+	m_sentBytes = 0;
+}
+
+CodedAbdClient::~CodedAbdClient()
+{
+	NS_LOG_FUNCTION (this);
+	//m_socket = 0;
+
+	delete [] m_data;
+	m_data = 0;
+	m_dataSize = 0;
+	m_serversConnected = 0;
+
+	m_ts = 0;					//initialize the local timestamp
+	m_value = 0;				//initialize local value
+	m_opStatus = PHASE1; 		//initialize status
+
+	m_fail = 0;
+	m_opCount = 0;
+	m_completeOps = 0;
+}
+
+/**************************************************************************************
+ * APPLICATION START/STOP FUNCTIONS
+ **************************************************************************************/
+void 
+CodedAbdClient::StartApplication (void)
+{
+
+	NS_LOG_FUNCTION (this);
+
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&CodedAbdClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&CodedAbdClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	m_workload.SetMaxInFlight (m_maxInFlight);
+
+	// the code: any two quorums of n - f servers share n - 2f servers
+	uint32_t maxK = m_numServers > 2 * m_fail ? m_numServers - 2 * m_fail : 0;
+	uint32_t k = m_codeK > 0 ? m_codeK : maxK;
+	if (k < 1 || k > maxK)
+	{
+		NS_FATAL_ERROR ("CodedAbdClient: a [" << m_numServers << "," << k << "] code cannot tolerate " << m_fail << " failures");
+	}
+	m_code.SetCode (m_numServers, k);
+
+	// seed pseudo-randomness
+	srand(m_seed);
+
+	if ( m_socket.empty() )
+	{
+		//Set the number of sockets we need
+		m_socket.resize( m_serverAddress.size() );
+
+		for (uint32_t i = 0; i < m_serverAddress.size(); i++ )
+		{
+			if (m_verbose)
+			{
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
+			}
+
+			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
+			m_socket[i] = Socket::CreateSocket (GetNode (), tid);
+
+			m_socket[i]->Bind();
+			m_socket[i]->Connect (InetSocketAddress (Ipv4Address::ConvertFrom(m_serverAddress[i]), m_peerPort));
+
+			m_socket[i]->SetRecvCallback (MakeCallback (&CodedAbdClient::HandleRecv, this));
+			m_socket[i]->SetAllowBroadcast (false);
+
+			m_socket[i]->SetConnectCallback (
+				        MakeCallback (&CodedAbdClient::ConnectionSucceeded, this),
+				        MakeCallback (&CodedAbdClient::ConnectionFailed, this));
+		}
+	}
+
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", k=" << m_code.GetK () << ", opInt=" << m_interval << ",debug="<<m_verbose);
+
+}
+
+AmClientStats
+CodedAbdClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_completeOps;
+	if (m_prType == READER)
+	{
+		stats.slowReads = m_completeOps;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
+}
+
+void 
+CodedAbdClient::StopApplication ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if ( !m_socket.empty() )
+    {
+	  for(uint32_t i=0; i< m_socket.size(); i++ )
+	  {
+		  m_socket[i]->Close ();
+		  m_socket[i]->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+	  }
+    }
+
+  float avg_time=0;
+  float real_avg_time=0;
+  if(m_opCount==0){
+  	avg_time = 0;
+  	real_avg_time=0;
+  }else{
+  	avg_time = ((m_opAve.GetSeconds()) /m_opCount);
+  	real_avg_time = (m_real_opAve.count()/m_opCount);
+  }
+
+  switch(m_prType)
+  {
+  case WRITER:
+	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #sentBytes="<<m_sentBytes <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #sentBytes="<<m_sentBytes <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
+	  break;
+  case READER:
+      std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #sentBytes="<<m_sentBytes <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #sentBytes="<<m_sentBytes <<", #InvokedReads="<<m_opCount<<", #CompletedReads=" << m_completeOps << ", AveOpTime="<< (avg_time+real_avg_time) <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
+	  break;
+  }
+
+  m_workload.Stop ();
+
+}
+
+void
+CodedAbdClient::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
+  m_ops.Clear ();
+  Application::DoDispose ();
+}
+
+/**************************************************************************************
+ * Connection handlers
+ **************************************************************************************/
+void CodedAbdClient::ConnectionSucceeded (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Address from;
+  socket->GetPeerName (from);
+
+  m_serversConnected++;
+
+  if (m_verbose)
+  {
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
+  }
+
+  // Check if connected to the all the servers start operations
+  if (m_serversConnected == m_serverAddress.size() )
+  {
+	  m_workload.Start ();
+  }
+}
+
+void CodedAbdClient::ConnectionFailed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+}
+
+/**************************************************************************************
+ * Functions to Set Variables
+ **************************************************************************************/
+void
+CodedAbdClient::SetServers (std::vector<Address> ip)
+{
+	m_serverAddress = ip;
+	m_numServers = m_serverAddress.size();
+
+	for (unsigned i=0; i<m_serverAddress.size(); i++)
+	{
+		NS_LOG_FUNCTION (this << "server" << Ipv4Address::ConvertFrom(m_serverAddress[i]));
+	}
+}
+
+int64_t
+CodedAbdClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  return streams + m_keys.AssignStreams (stream + streams);
+}
+
+void
+CodedAbdClient::SetRemote (Address ip, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << ip << port);
+  m_peerAddress = ip;
+  m_peerPort = port;
+}
+
+/**************************************************************************************
+ * PACKET Handlers
+ **************************************************************************************/
+void 
+CodedAbdClient::SetDataSize (uint32_t dataSize)
+{
+  NS_LOG_FUNCTION (this << dataSize);
+
+  //
+  // If the client is setting the echo packet data size this way, we infer
+  // that she doesn't care about the contents of the packet at all, so 
+  // neither will we.
+  //
+  delete [] m_data;
+  m_data = 0;
+  m_dataSize = 0;
+  m_size = dataSize;
+}
+
+uint32_t 
+CodedAbdClient::GetDataSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size;
+}
+
+void 
+CodedAbdClient::SetFill (std::string fill)
+{
+  NS_LOG_FUNCTION (this << fill);
+
+  uint32_t dataSize = fill.size () + 1;
+
+  if (dataSize != m_dataSize)
+    {
+      delete [] m_data;
+      m_data = new uint8_t [dataSize];
+      m_dataSize = dataSize;
+    }
+
+  memcpy (m_data, fill.c_str (), dataSize);
+}
+
+/**************************************************************************************
+ * CAS Read/Write Handlers
+ **************************************************************************************/
+void
+CodedAbdClient::MakeValue (uint32_t value, std::vector<uint8_t> &bytes) const
+{
+	// the value itself in the first 4 bytes, then a pattern derived from it
+	bytes.resize (std::max<uint32_t> (m_size, 4));
+	for (uint32_t i = 0; i < bytes.size (); i++)
+	{
+		bytes[i] = i < 4 ? (value >> (8 * (3 - i))) & 0xff : (value + i) & 0xff;
+	}
+}
+
+void
+CodedAbdClient::SelectKey (void)
+{
+	NS_LOG_FUNCTION (this);
+
+	// start from the latest tag known for the key
+	m_key = m_keys.GetNext ();
+
+	Register &reg = m_registers.Get (m_key);
+	m_ts = reg.ts;
+	m_id = reg.id;
+	m_value = reg.value;
+}
+
+void
+CodedAbdClient::LoadOperation (uint32_t id)
+{
+	NS_LOG_FUNCTION (this << id);
+
+	Operation &op = m_ops.Get (id);
+	m_opId = id;
+	m_opStatus = op.status;
+	m_msgType = op.msgType;
+	m_key = op.key;
+	m_ts = op.ts;
+	m_id = op.id;
+	m_value = op.value;
+	m_fragments.swap (op.fragments);
+	m_replies = op.replies;
+	m_opStart = op.start;
+	m_real_start = op.real_start;
+}
+
+void
+CodedAbdClient::SaveOperation (void)
+{
+	NS_LOG_FUNCTION (this << m_opId);
+
+	// keep the latest tag of the key for the operations that follow
+	Register &reg = m_registers.Get (m_key);
+	if ( m_ts > reg.ts || ( m_ts == reg.ts && m_id >= reg.id ) )
+	{
+		reg.ts = m_ts;
+		reg.id = m_id;
+		reg.value = m_value;
+	}
+
+	if (m_opStatus == IDLE)
+	{
+		m_ops.Remove (m_opId);
+		m_fragments.clear ();
+		return;
+	}
+
+	Operation &op = m_ops.Get (m_opId);
+	op.status = m_opStatus;
+	op.msgType = m_msgType;
+	op.key = m_key;
+	op.ts = m_ts;
+	op.id = m_id;
+	op.value = m_value;
+	op.fragments.swap (m_fragments);
+	op.replies = m_replies;
+	op.start = m_opStart;
+	op.real_start = m_real_start;
+}
+
+void
+CodedAbdClient::InvokeRead (void)
+{
+	NS_LOG_FUNCTION (this);
+
+	m_opCount ++;
+	m_opStart = Now();
+	m_real_start = std::chrono::system_clock::now();
+
+	//check if we still have operations to perfrom
+	if ( m_opCount <=  m_count )
+	{
+		SelectKey ();
+		m_opId = m_opCount;
+		m_fragments.clear ();
+
+		//Phase 1: query the highest finalized tag
+		m_opStatus = PHASE1;
+		m_msgType = READ_DISCOVER;
+
+		//Send msg to all
+		m_replies = 0;		//reset replies
+		AM_LOG_INFO ("** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
+		HandleSend();
+
+		SaveOperation ();
+	}
+}
+
+void
+CodedAbdClient::InvokeWrite (void)
+{
+	NS_LOG_FUNCTION (this);
+
+	m_opCount ++;
+	m_opStart = Now();
+
+	//check if we still have operations to perfrom
+	if ( m_opCount <=  m_count )
+	{
+		SelectKey ();
+		m_opId = m_opCount;
+		m_fragments.clear ();
+
+		//Phase 1: query the highest finalized tag
+		m_opStatus = PHASE1;
+		m_msgType = DISCOVER;
+
+		//generate a random value
+		m_value = rand()%1000;
+
+		//Send msg to all
+		m_replies = 0;		//reset replies
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
+		HandleSend();
+
+		SaveOperation ();
+	}
+}
+
+void
+CodedAbdClient::HandleSend (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  ++m_sent;
+  m_ops.SetCounter (m_opId, m_sent);
+
+  // Prepare packet content <msgType, <ts, id>, counter>
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
+  hdr.SetType (m_msgType);
+  hdr.SetTag (m_ts, m_id);
+  hdr.SetCounter (m_sent);
+
+  // a pre-write carries a different fragment to every server, the other
+  // messages are the same for all
+  std::vector<std::vector<uint8_t> > fragments;
+  Ptr<Packet> p;
+  if (m_msgType == PRE_WRITE)
+  {
+	  std::vector<uint8_t> value;
+	  MakeValue (m_value, value);
+	  m_code.Encode (value, fragments);
+  }
+  else
+  {
+	  p = m_framer.Build (hdr);
+  }
+
+  //random server to start from
+  int current = rand()%m_serverAddress.size();
+
+  //Send a single packet to each server
+  for (uint32_t i=0; i<m_serverAddress.size(); i++)
+  {
+	  if (m_msgType == PRE_WRITE)
+	  {
+		  hdr.SetValue (current);
+		  p = Create<Packet> (&fragments[current][0], fragments[current].size ());
+		  p->AddHeader (hdr);
+		  AmMessageFramer::Frame (p);
+	  }
+
+	  // call to the trace sinks before the packet is actually sent
+	  m_txTrace (p);
+      m_socket[current]->Send (p);
+      m_sentBytes += p->GetSize ();
+
+	  if (m_verbose)
+	  {
+		  AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current]) << " port " << m_peerPort);
+	  }
+
+      // move to the next server
+      current = (current+1)%m_serverAddress.size();
+  }
+}
+
+void
+CodedAbdClient::HandleRecv (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  Ptr<Packet> packet;
+  Address from;
+  AmProtocolHeader hdr;
+
+  while ((packet = m_framer.Recv (socket, from)))
+    {
+	  //deserialize the contents of the packet, the rest is the fragment
+	  packet->RemoveHeader (hdr);
+
+	  if (m_verbose)
+	  {
+		  AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
+				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
+				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
+	  }
+
+      // match the reply to the round of an outstanding operation
+      uint32_t opId;
+      if ( m_ops.Lookup (hdr.GetCounter (), opId) )
+      {
+    	  LoadOperation (opId);
+    	  if (hdr.GetType () == READ_FINALIZE_ACK && packet->GetSize () > 0)
+    	  {
+    		  std::vector<uint8_t> &fragment = m_fragments[hdr.GetValue ()];
+    		  fragment.resize (packet->GetSize ());
+    		  packet->CopyData (&fragment[0], fragment.size ());
+    	  }
+    	  ProcessReply(hdr.GetType (), hdr.GetTs (), hdr.GetId ());
+    	  SaveOperation ();
+      }
+    }
+}
+
+void
+CodedAbdClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id)
+{
+	NS_LOG_FUNCTION (this);
+
+	uint32_t quorum = m_numServers - m_fail;
+
+	//increment the number of replies received
+	m_replies ++;
+
+	// the queries collect the highest finalized tag
+	if (m_opStatus == PHASE1 && ( ts > m_ts || ( ts == m_ts && id > m_id ) ))
+	{
+		m_ts = ts;
+		m_id = id;
+	}
+
+	if (m_verbose)
+	{
+		AM_LOG_INFO ("Waiting for " << quorum << " replies, received " << m_replies << ", fragments " << m_fragments.size ());
+	}
+
+	if (m_replies < quorum)
+	{
+		return;
+	}
+
+	switch(m_prType)
+	{
+	case WRITER:
+		switch(m_opStatus)
+		{
+		case PHASE1:
+			//pre-write the fragments with a higher tag
+			m_ts ++;
+			m_id = m_personalID;
+			m_opStatus = PHASE2;
+			m_msgType = PRE_WRITE;
+			m_replies = 0;
+			HandleSend();
+			break;
+		case PHASE2:
+			//a quorum holds the fragments, finalize the tag
+			m_opStatus = PHASE3;
+			m_msgType = FINALIZE;
+			m_replies = 0;
+			HandleSend();
+			break;
+		case PHASE3:
+			{
+				// computation time of the writer once it gets the replies
+				m_real_start = std::chrono::system_clock::now();
+
+				m_opStatus = IDLE;
+				m_completeOps++;
+				m_workload.OperationCompleted ();
+
+				m_opEnd = Now();
+				m_real_end = std::chrono::system_clock::now();
+				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
+
+				AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, id, value>: [" << m_ts << "," << m_id << "," << m_value << "], @ 3 EXCH **");
+
+				m_real_opAve += elapsed_seconds;
+				m_opAve += m_opEnd - m_opStart;
+				m_opCompletedTrace (WRITE, 3, m_opEnd - m_opStart, m_ts, m_key, m_id);
+			}
+			break;
+		default:
+			break;
+		}
+		break;
+
+	case READER:
+		switch(m_opStatus)
+		{
+		case PHASE1:
+			//ask a quorum to finalize the tag and send its fragments
+			m_opStatus = PHASE2;
+			m_msgType = READ_FINALIZE;
+			m_fragments.clear ();
+			m_replies = 0;
+			HandleSend();
+			break;
+		case PHASE2:
+			// the initial value has no fragments; a finalized tag was
+			// pre-written at a quorum, that shares k servers with this
+			// one: fewer fragments mean the servers collected them, the
+			// concurrency exceeded their GcDepth, and the replies still
+			// missing (maybe of crashed servers) would add none
+			if (m_ts > 0 && m_fragments.size () < m_code.GetK ())
+			{
+				NS_LOG_WARN ("Only " << m_fragments.size () << " fragments of tag <" << m_ts << "," << m_id << ">, restarting the read");
+				m_opStatus = PHASE1;
+				m_msgType = READ_DISCOVER;
+				m_replies = 0;
+				HandleSend();
+				break;
+			}
+			{
+				// computation time of the reader: decoding the value
+				m_real_start = std::chrono::system_clock::now();
+				m_value = 0;
+				if (m_ts > 0)
+				{
+					std::vector<uint8_t> value;
+					std::vector<uint8_t> expected;
+					m_code.Decode (m_fragments, value);
+					m_value = (value[0] << 24) | (value[1] << 16) | (value[2] << 8) | value[3];
+					MakeValue (m_value, expected);
+					if (!std::equal (expected.begin (), expected.end (), value.begin ()))
+					{
+						NS_LOG_WARN ("Decoded a corrupted value for tag <" << m_ts << "," << m_id << ">");
+					}
+				}
+				m_fragments.clear ();
+
+				m_opStatus = IDLE;
+				m_completeOps++;
+				m_workload.OperationCompleted ();
+				m_opEnd = Now();
+				m_real_end = std::chrono::system_clock::now();
+				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
+
+				AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, id, value>: [" << m_ts << "," << m_id << "," << m_value << "], TWO COMM **");
+
+				m_opAve += m_opEnd - m_opStart;
+				m_opCompletedTrace (READ, 4, m_opEnd - m_opStart, m_ts, m_key, m_id);
+				m_real_opAve += elapsed_seconds;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+
+} // Namespace ns3
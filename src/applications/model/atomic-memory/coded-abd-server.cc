@@ -0,0 +1,403 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/address-utils.h"
+#include "ns3/nstime.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-socket.h"
+#include "ns3/simulator.h"
+#include "ns3/socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/enum.h"
+
+#include "coded-abd-server.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CodedAbdServerApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (CodedAbdServer);
+
+void
+CodedAbdServer::LogInfo( std::stringstream& s)
+{
+	NS_LOG_INFO("[SERVER " << m_personalID << " - "<< InetSocketAddress::ConvertFrom(m_myAddress).GetIpv4() << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
+}
+
+
+TypeId
+CodedAbdServer::GetTypeId (void)
+{
+	static TypeId tid = TypeId ("ns3::CodedAbdServer")
+					.SetParent<Application> ()
+					.SetGroupName("Applications")
+					.AddConstructor<CodedAbdServer> ()
+					.AddAttribute ("Port", "Port on which we listen for incoming packets.",
+							UintegerValue (9),
+							MakeUintegerAccessor (&CodedAbdServer::m_port),
+							MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+							UintegerValue (100),
+							MakeUintegerAccessor (&CodedAbdServer::m_size),
+							MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("LocalAddress",
+							"The local Address of the current node",
+							AddressValue (),
+							MakeAddressAccessor (&CodedAbdServer::m_myAddress),
+							MakeAddressChecker ())
+					.AddAttribute ("ID",
+							"Server ID",
+							UintegerValue (100),
+							MakeUintegerAccessor (&CodedAbdServer::m_personalID),
+							MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("GcDepth",
+							"The number of finalized versions kept besides the highest one",
+							UintegerValue (1),
+							MakeUintegerAccessor (&CodedAbdServer::m_gcDepth),
+							MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("Verbose",
+							"Verbose for debug mode",
+							UintegerValue (0),
+							MakeUintegerAccessor (&CodedAbdServer::m_verbose),
+							MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("ServiceCores",
+					 "Messages processed at the same time, 0 to process every message on arrival",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&CodedAbdServer::m_serviceCores),
+					 MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("ServiceTime",
+					 "The processing time of a message, in seconds",
+					 StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"),
+					 MakePointerAccessor (&CodedAbdServer::m_serviceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("Fault",
+					 "The fault of the server: None, Crash (the messages received are lost) or Pause (they are held until the fault ends)",
+					 EnumValue (AmServiceQueue::NONE),
+					 MakeEnumAccessor (&CodedAbdServer::SetFault, &CodedAbdServer::GetFault),
+					 MakeEnumChecker (AmServiceQueue::NONE, "None",
+					                  AmServiceQueue::CRASH, "Crash",
+					                  AmServiceQueue::PAUSE, "Pause"))
+					.AddAttribute ("Slowdown",
+					 "The time every message received waits before it is processed",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&CodedAbdServer::SetSlowdown, &CodedAbdServer::GetSlowdown),
+					 MakeTimeChecker ())
+					.AddTraceSource ("MessageHandled", "A message was received and answered",
+							MakeTraceSourceAccessor (&CodedAbdServer::m_handledTrace),
+							"ns3::AmStatsCollector::MessageHandledCallback")
+		;
+	return tid;
+}
+
+CodedAbdServer::CodedAbdServer ()
+{
+	NS_LOG_FUNCTION (this);
+	m_socket = 0;
+	m_sent = 0;
+	m_storedBytes = 0;
+	m_maxStoredBytes = 0;
+}
+
+CodedAbdServer::~CodedAbdServer()
+{
+	NS_LOG_FUNCTION (this);
+	m_socket = 0;
+	m_sent = 0;
+}
+
+/**************************************************************************************
+ * APPLICATION START/STOP FUNCTIONS
+ **************************************************************************************/
+
+void
+CodedAbdServer::StartApplication (void)
+{
+	NS_LOG_FUNCTION (this);
+
+	m_service.SetCores (m_serviceCores);
+	m_service.SetServiceTime (m_serviceTime);
+	m_service.SetServedCallback (MakeCallback (&CodedAbdServer::HandleRead, this));
+	AM_LOG_INFO ("Debug Mode="<<m_verbose<<", GcDepth="<<m_gcDepth);
+
+	if (m_socket == 0)
+	{
+		TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
+		m_socket = Socket::CreateSocket (GetNode (), tid);
+		InetSocketAddress local = InetSocketAddress (Ipv4Address::GetAny (), m_port);
+		m_socket->Bind (local);
+		m_socket->Listen ();
+	}
+
+	m_socket->SetRecvCallback (MakeCallback (&CodedAbdServer::HandleRead, this));
+
+	// Accept new connection
+	m_socket->SetAcceptCallback (
+			MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+			MakeCallback (&CodedAbdServer::HandleAccept, this));
+	// Peer socket close handles
+	m_socket->SetCloseCallbacks (
+			MakeCallback (&CodedAbdServer::HandlePeerClose, this),
+			MakeCallback (&CodedAbdServer::HandlePeerError, this));
+}
+
+uint32_t
+CodedAbdServer::GetSentMessages (void) const
+{
+	return m_sent;
+}
+
+void
+CodedAbdServer::StopApplication ()
+{
+	NS_LOG_FUNCTION (this);
+
+	if (m_socket != 0)
+	{
+		m_socket->Close ();
+		m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+	}
+	std::stringstream sstm;
+	sstm << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<", #storedBytes="<<m_storedBytes<<", #maxStoredBytes="<<m_maxStoredBytes<<" **";
+	std::cout << sstm.str () << std::endl;
+	LogInfo(sstm);
+	if (m_serviceCores > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" CPU: #served="<<m_service.GetServed ()<<", busyTime="<<m_service.GetBusyTime ().GetSeconds ()<<"s, AveWait="<<(m_service.GetServed () > 0 ? m_service.GetWaitTime ().GetSeconds () / m_service.GetServed () : 0)<<"s, #maxQueue="<<m_service.GetMaxQueue ()<<" **"<<std::endl;
+	}
+	if (m_service.GetDropped () > 0 || m_service.GetHeld () > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" FAULTS: #dropped="<<m_service.GetDropped ()<<", #held="<<m_service.GetHeld ()<<" **"<<std::endl;
+	}
+}
+
+void
+CodedAbdServer::DoDispose (void)
+{
+	NS_LOG_FUNCTION (this);
+	m_framer.Clear ();
+	m_service.Clear ();
+	m_registers.Clear ();
+	Application::DoDispose ();
+}
+
+
+/**************************************************************************************
+ * Connection handlers
+ **************************************************************************************/
+void CodedAbdServer::HandlePeerClose (Ptr<Socket> socket)
+{
+	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
+}
+
+void CodedAbdServer::HandlePeerError (Ptr<Socket> socket)
+{
+	NS_LOG_FUNCTION (this << socket);
+}
+
+
+void CodedAbdServer::HandleAccept (Ptr<Socket> s, const Address& from)
+{
+	NS_LOG_FUNCTION (this << s << from);
+	s->SetRecvCallback (MakeCallback (&CodedAbdServer::HandleRead, this));
+	m_socketList.push_back (s);
+}
+
+/**************************************************************************************
+ * Storage of the coded versions
+ **************************************************************************************/
+CodedAbdServer::Element&
+CodedAbdServer::Finalize (Register &reg, const Tag &tag)
+{
+	Element &e = reg.elements[tag];
+	e.finalized = true;
+	if (tag > reg.finalized)
+	{
+		reg.finalized = tag;
+	}
+	return e;
+}
+
+void
+CodedAbdServer::CollectGarbage (Register &reg)
+{
+	NS_LOG_FUNCTION (this);
+
+	// find the (GcDepth + 1)-th highest finalized tag
+	uint32_t count = 0;
+	std::map<Tag, Element>::iterator oldest = reg.elements.end ();
+	for (std::map<Tag, Element>::reverse_iterator it = reg.elements.rbegin (); it != reg.elements.rend (); it++)
+	{
+		if (it->second.finalized && ++count == m_gcDepth + 1)
+		{
+			oldest = --(it.base ());
+			break;
+		}
+	}
+	if (oldest == reg.elements.end ())
+	{
+		return;
+	}
+
+	// every version below it is obsolete
+	for (std::map<Tag, Element>::iterator it = reg.elements.begin (); it != oldest; )
+	{
+		if (it->second.fragment)
+		{
+			m_storedBytes -= it->second.fragment->GetSize ();
+		}
+		reg.elements.erase (it++);
+	}
+}
+
+/**************************************************************************************
+ * CAS Rcv Handler
+ **************************************************************************************/
+void
+CodedAbdServer::SetFault (AmServiceQueue::Fault fault)
+{
+	NS_LOG_FUNCTION (this << fault);
+	m_service.SetFault (fault);
+}
+
+AmServiceQueue::Fault
+CodedAbdServer::GetFault (void) const
+{
+	return m_service.GetFault ();
+}
+
+void
+CodedAbdServer::SetSlowdown (Time delay)
+{
+	NS_LOG_FUNCTION (this << delay);
+	m_service.SetSlowdown (delay);
+}
+
+Time
+CodedAbdServer::GetSlowdown (void) const
+{
+	return m_service.GetSlowdown ();
+}
+
+void
+CodedAbdServer::HandleRead (Ptr<Socket> socket)
+{
+	NS_LOG_FUNCTION (this << socket);
+
+	Ptr<Packet> packet;
+	Address from;
+	AmProtocolHeader hdr;
+
+	while ((packet = m_service.Recv (m_framer, socket, from)))
+	{
+		//deserialize the contents of the packet, the rest is the fragment
+		packet->RemoveHeader (hdr);
+		uint32_t sent = m_sent;
+		Register &reg = m_registers.Get (hdr.GetKey ());
+		MessageType msgT = hdr.GetType ();
+		Tag tag (hdr.GetTs (), hdr.GetId ());
+		Ptr<Packet> fragment;
+
+		if (m_verbose)
+		{
+			AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
+					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
+					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
+		}
+
+		if (msgT == DISCOVER || msgT == READ_DISCOVER)
+		{
+			// query: the highest finalized tag
+			hdr.SetType (msgT == DISCOVER ? DISCOVERACK : READ_DISCOVER_ACK);
+			hdr.SetTag (reg.finalized.first, reg.finalized.second);
+		}
+		else if (msgT == PRE_WRITE)
+		{
+			// store the fragment, unless the version is already collected
+			Element &e = reg.elements[tag];
+			if (e.fragment)
+			{
+				m_storedBytes -= e.fragment->GetSize ();
+			}
+			e.fragment = packet;
+			e.index = hdr.GetValue ();
+			m_storedBytes += packet->GetSize ();
+			CollectGarbage (reg);
+			hdr.SetType (PRE_WRITE_ACK);
+		}
+		else if (msgT == FINALIZE)
+		{
+			Finalize (reg, tag);
+			CollectGarbage (reg);
+			hdr.SetType (FINALIZE_ACK);
+		}
+		else if (msgT == READ_FINALIZE)
+		{
+			// answer with the fragment of the tag, if it is still stored
+			Element &e = Finalize (reg, tag);
+			fragment = e.fragment;
+			hdr.SetValue (e.index);
+			hdr.SetType (READ_FINALIZE_ACK);
+			CollectGarbage (reg);
+		}
+		else
+		{
+			NS_LOG_WARN ("Unexpected message type " << msgT);
+			continue;
+		}
+
+		if (m_storedBytes > m_maxStoredBytes)
+		{
+			m_maxStoredBytes = m_storedBytes;
+		}
+
+		Ptr<Packet> p;
+		if (fragment)
+		{
+			p = fragment->Copy ();
+			p->AddHeader (hdr);
+			AmMessageFramer::Frame (p);
+		}
+		else
+		{
+			p = m_framer.Build (hdr);
+		}
+
+		socket->Send (p);
+		m_sent++;     //!< sent messages counter
+
+		if (m_verbose)
+		{
+			AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " <<
+					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
+					InetSocketAddress::ConvertFrom (from).GetPort ());
+		}
+
+		m_handledTrace (msgT, m_sent - sent);
+	}
+}
+
+} // Namespace ns3
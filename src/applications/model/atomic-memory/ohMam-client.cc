@@ -29,8 +29,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
-#include "OhMam-client.h"
+#include "ohMam-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <string>
 #include <cstdlib>
 #include <iostream>
@@ -98,7 +103,7 @@ OhMamClient::GetTypeId (void)
 					UintegerValue (9),
 					MakeUintegerAccessor (&OhMamClient::m_port),
 					MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&OhMamClient::SetDataSize,
                                          &OhMamClient::GetDataSize),
@@ -106,6 +111,9 @@ OhMamClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&OhMamClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&OhMamClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -131,6 +139,44 @@ OhMamClient::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&OhMamClient::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&OhMamClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&OhMamClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&OhMamClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&OhMamClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&OhMamClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&OhMamClient::m_traceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("WriteBatch",
+                   "The writes a round commits at most: the writes invoked while a write is in flight wait for the next round, 1 to disable batching",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&OhMamClient::m_writeBatch),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
@@ -142,7 +188,6 @@ OhMamClient::OhMamClient ()
 {
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -187,7 +232,34 @@ OhMamClient::StartApplication (void)
 {
 
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
+
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&OhMamClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&OhMamClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	// one write in flight, the others wait for the next round
+	m_batcher.SetMaxWrites (m_prType == WRITER ? m_writeBatch : 1);
+	m_workload.SetMaxInFlight (m_prType == WRITER ? m_writeBatch : 1);
 
 	// seed pseudo-randomness
 	srand(m_seed);
@@ -237,9 +309,7 @@ OhMamClient::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -259,19 +329,34 @@ OhMamClient::StartApplication (void)
 	}
 
 	
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
 
 }
 
+AmClientStats
+OhMamClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_completeOps;
+	if (m_prType == READER)
+	{
+		stats.slowReads = m_completeOps;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
+}
+
 void 
 OhMamClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
   if (m_insocket != 0)
 	{
 		m_insocket->Close ();
@@ -300,26 +385,28 @@ OhMamClient::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-	  sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_completeOps << ", #2EXCH_reads=0, AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_completeOps << ", #2EXCH_reads=0, AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_completeOps << ", #2EXCH_reads=0, AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
-  if(m_personalID==m_numClients-1){
-  	exit(0);
-  }
-  Simulator::Cancel (m_sendEvent);
+  if (m_batcher.IsEnabled ())
+    {
+      std::cout << "** CLIENT_"<<m_personalID <<" BATCH: #rounds="<<m_batcher.GetRounds ()<<", WritesPerRound="<<(m_batcher.GetRounds () > 0 ? (double) m_batcher.GetWrites () / m_batcher.GetRounds () : 0)<<" **"<<std::endl;
+    }
+  m_batcher.Clear ();
+  m_workload.Stop ();
 }
 
 void
 OhMamClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
   Application::DoDispose ();
 }
 
@@ -329,6 +416,7 @@ OhMamClient::DoDispose (void)
 void OhMamClient::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void OhMamClient::HandlePeerError (Ptr<Socket> socket)
@@ -356,24 +444,20 @@ void OhMamClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
 void OhMamClient::ConnectionFailed (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
-  std::stringstream sstm;
-  sstm << "Connection to SERVER Failed.";
-  LogInfo(sstm);
+  AM_LOG_INFO ("Connection to SERVER Failed.");
 }
 
 /**************************************************************************************
@@ -391,6 +475,14 @@ OhMamClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+OhMamClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  return streams + m_keys.AssignStreams (stream + streams);
+}
+
 void
 OhMamClient::SetRemote (Address ip, uint16_t port)
 {
@@ -434,57 +526,55 @@ OhMamClient::SetFill (std::string fill)
 
   if (dataSize != m_dataSize)
     {
+      delete [] m_data;
       m_data = new uint8_t [dataSize];
       m_dataSize = dataSize;
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
-  m_size = dataSize;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-OhMamClient::ScheduleOperation (Time dt)
+/**************************************************************************************
+ * OhMam Read/Write Handlers
+ **************************************************************************************/
+void
+OhMamClient::SelectKey (void)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this);
+	LoadKey (m_keys.GetNext ());
+}
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+void
+OhMamClient::LoadKey (uint32_t key)
+{
+	NS_LOG_FUNCTION (this << key);
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	// park the state of the current key and load the one of the key
+	Register &reg = m_registers.Get (m_key);
+	reg.ts = m_ts;
+	reg.value = m_value;
+	reg.id = m_id;
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &OhMamClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &OhMamClient::InvokeWrite, this);
-  }
+	m_key = key;
+
+	Register &next = m_registers.Get (m_key);
+	m_ts = next.ts;
+	m_value = next.value;
+	m_id = next.id;
 }
 
-/**************************************************************************************
- * OhMam Read/Write Handlers
- **************************************************************************************/
 void
 OhMamClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 	m_opStart = Now();
 	m_real_start = std::chrono::system_clock::now();
 
 	//check if we still have operations to perfrom
 	if ( m_opCount <  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
@@ -497,9 +587,7 @@ OhMamClient::InvokeRead (void)
 		//Send msg to all
 		m_replies = 0;		//reset replies
 		
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
 	}
 }
@@ -508,9 +596,22 @@ void
 OhMamClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
+
+	// a write is in flight: the state of the client is its own, so this one
+	// waits for the next round without touching it
+	if (m_batcher.IsEnabled () && m_opCount <= m_count && !m_batcher.IsIdle ())
+	{
+		AmWriteBatcher::Write write;
+		write.op = m_opCount;
+		write.start = Now();
+		write.realStart = std::chrono::system_clock::now();
+		m_batcher.Queue (m_keys.GetNext (), write);
+		AM_LOG_INFO ("** WRITE QUEUED: " << m_opCount << " at "<< write.start.GetSeconds() <<"s");
+		return;
+	}
+
 	m_opStart = Now();
 	m_real_start = std::chrono::system_clock::now();
 	
@@ -518,28 +619,62 @@ OhMamClient::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
+		if (m_batcher.IsEnabled ())
+		{
+			AmWriteBatcher::Write write;
+			write.op = m_opCount;
+			write.start = m_opStart;
+			write.realStart = m_real_start;
+			m_batcher.Add (m_key, write);
+		}
+
 		m_opStatus = PHASE1;
 		m_msgType = DISCOVER;
 		m_value = m_opCount + 900;
 		m_writeop ++;
 		m_replies = 0;		//reset replies
 		
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
 	}
 }
 
+void
+OhMamClient::CommitBatch (uint32_t key)
+{
+	NS_LOG_FUNCTION (this << key);
+
+	// the application stopped in between
+	if (!m_batcher.IsOpen (key))
+	{
+		return;
+	}
+
+	const std::vector<AmWriteBatcher::Write> &round = m_batcher.GetRound (key);
+	LoadKey (key);
+	m_opStart = round.front ().start;
+	m_real_start = round.front ().realStart;
+
+	m_opStatus = PHASE1;
+	m_msgType = DISCOVER;
+	m_value = round.front ().op + 900;
+	m_writeop ++;
+	m_replies = 0;		//reset replies
+
+	AM_LOG_INFO ("** WRITES COMMITTED: " << round.size () << " from " << round.front ().op << " at "<< Now ().GetSeconds() <<"s");
+	HandleSend();
+}
+
 void 
 OhMamClient::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT (m_sendEvent.IsExpired ());
-
   // Prepare packet content
-  std::stringstream pkts;
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
   std::string message_type;
   
   // Serialize the appropriate message for READ or WRITE
@@ -547,34 +682,28 @@ OhMamClient::HandleSend (void)
   // serialize <msgType, ts, id, value, readop ,counter>
   if ((m_msgType == DISCOVER) && (m_opStatus == PHASE1))
   	{
-  		pkts << DISCOVER << " " << m_writeop;
+  		hdr.SetType (DISCOVER);
+  		hdr.SetCounter (m_writeop);
   		message_type = "discover";
 	}
   else if ((m_msgType == WRITE) && (m_opStatus == PHASE2))
   	{
-  		pkts << WRITE << " " << m_ts << " " << m_personalID << " " << m_value << " " << m_writeop;
+  		hdr.SetType (WRITE);
+  		hdr.SetTs (m_ts);
+  		hdr.SetId (m_personalID);
+  		hdr.SetValue (m_value);
+  		hdr.SetCounter (m_writeop);
   		message_type = "write";
 	}
   else if (m_msgType == READ)
     {
-		pkts << READ << " " << m_readop;
+		hdr.SetType (READ);
+		hdr.SetCounter (m_readop);
 		message_type = "read";
     }
 
-  SetFill(pkts.str());
-
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "OhMamClient::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "OhMamClient::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // Create packet, the writes carry the bytes of the value
+  Ptr<Packet> p = m_framer.Build (hdr, m_msgType == WRITE ? m_payload : 0);
 
 	//random server to start from
   int current = rand()%m_serverAddress.size();
@@ -588,10 +717,8 @@ OhMamClient::HandleSend (void)
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
-		  << " port " << m_peerPort << " data " << pkts.str();
-		  LogInfo ( sstm );
+		  AM_LOG_INFO ("Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
+		  << " port " << m_peerPort << " data " << hdr);
 	  }
 	  // move to the next server
       current = (current+1)%m_serverAddress.size();
@@ -605,55 +732,48 @@ OhMamClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  uint32_t msgT, msgTs, msgId, msgV, msgOp;
+  AmProtocolHeader hdr;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
 	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgT; 
-	  std::stringstream sstm;
+	  packet->RemoveHeader (hdr);
+	  MessageType msgT = hdr.GetType ();
+	  uint32_t msgTs = hdr.GetTs ();
+	  uint32_t msgId = hdr.GetId ();
+	  uint32_t msgV = hdr.GetValue ();
+	  uint32_t msgOp = hdr.GetCounter ();
 	  std::string message_type;
 
 	  if (msgT==READACK){
 			message_type = "readAck";
-			istm >> msgTs >> msgId >> msgV >> msgOp;
 	  }else if (msgT==DISCOVERACK){
 			message_type = "discoverAck";
-			istm >> msgTs >> msgOp;
 	  }else if (msgT==WRITEACK){
 			message_type = "writeAck";
-			istm >> msgTs >> msgId >> msgV >> msgOp;
 	  }
 	 
 	 if (m_verbose)
 	  {
-		  sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
+		  AM_LOG_INFO ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << buf;
-		  LogInfo (sstm);
+				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << hdr);
 	  }
 
       // check message freshness and if client is waiting
       if ((((msgOp == m_readop) && (msgT==READACK)) || ((msgOp == m_writeop) && (msgT==WRITEACK)) || ((msgOp == m_writeop) && (msgT==DISCOVERACK))) && m_opStatus != IDLE)
        {
-    	  ProcessReply(msgT, msgTs, msgId, msgV, msgOp);
+    	  ProcessReply(msgT, msgTs, msgId, msgV, msgOp, packet);
        }
     
     }
 }
 
 void
-OhMamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val, uint32_t op)
+OhMamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val, uint32_t op, Ptr<Packet> payload)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-
 	//increment the number of replies received
 	m_replies ++;
 
@@ -671,9 +791,7 @@ OhMamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val,
 
 			if (m_verbose)
 	  		{
-			AsmCommon::Reset(sstm);
-			sstm << "Waiting for " << (m_numServers-m_fail) << " discoverAck replies, received " << m_replies;
-			LogInfo(sstm);
+			AM_LOG_INFO ("Waiting for " << (m_numServers-m_fail) << " discoverAck replies, received " << m_replies);
 			}
 
 			//if we received enough replies go to the next phase
@@ -682,10 +800,11 @@ OhMamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val,
 				//Phase 1
 				m_opStatus = PHASE2;
 				m_msgType = WRITE;
-				// Increase my timestamp, my writeop and generate a random value
-				m_ts ++; 
+				// Increase my timestamp, one per write of the round, my writeop and generate a random value
+				m_ts += m_batcher.IsEnabled () ? m_batcher.GetRound (m_key).size () : 1;
 				m_writeop ++;
 				m_value = m_writeop + 200;
+				m_payload = Create<Packet> (m_size);
 				
 				//Send msg to all
 				m_replies = 0;		//reset replies
@@ -700,18 +819,33 @@ OhMamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val,
 			if (m_replies >= (m_numServers - m_fail))
 			{
 				
-				m_completeOps++;
 				m_opStatus = IDLE;
-				ScheduleOperation (m_interval);
-				m_real_end = std::chrono::system_clock::now();
-				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
-				m_opEnd = Now();
-				m_opAve += m_opEnd - m_opStart;
-				m_real_opAve += elapsed_seconds; 
-
-				AsmCommon::Reset(sstm);
-				sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), < <ts,id> , value>: [<" << m_ts <<"," << m_personalID << "> ," << m_value << "], @ 4 EXCH **";
-				LogInfo(sstm);
+				if (m_batcher.IsEnabled ())
+				{
+					// every write of the round completes, with its ts
+					std::vector<AmWriteBatcher::Write> committed;
+					uint32_t key;
+					bool next = m_batcher.Complete (m_key, committed);
+					for (uint32_t i = 0; i < committed.size (); i++)
+					{
+						CompleteWrite (committed[i].start, committed[i].realStart, m_ts - committed.size () + 1 + i);
+					}
+
+					// one write in flight: the next round goes to the key
+					// of the oldest waiting write
+					if (next)
+					{
+						Simulator::ScheduleNow (&OhMamClient::CommitBatch, this, m_key);
+					}
+					else if (m_batcher.Next (key))
+					{
+						Simulator::ScheduleNow (&OhMamClient::CommitBatch, this, key);
+					}
+				}
+				else
+				{
+					CompleteWrite (m_opStart, m_real_start, m_ts);
+				}
 				m_replies = 0;
 			}
 		}
@@ -727,6 +861,7 @@ OhMamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val,
       		m_MINts = ts;
 			m_MINId = id;
 			m_MINvalue = val;
+			m_MINpayload = payload;
       	}
 
       	if (m_replies >= (m_numServers - m_fail))
@@ -738,19 +873,34 @@ OhMamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val,
 
       		m_opEnd = Now();
       		m_opAve += m_opEnd - m_opStart;
+      		m_opCompletedTrace (READ, 3, m_opEnd - m_opStart, m_MINts, m_key, m_MINId);
       		m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 			m_real_opAve += elapsed_seconds;  //
 
    			m_opStatus = IDLE;
-			ScheduleOperation (m_interval);
-      		AsmCommon::Reset(sstm);
-			sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << m_MINts << "," << m_MINvalue << ">] - @ 3 EXCH **";
-			LogInfo(sstm);
+			m_workload.OperationCompleted ();
+			AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << m_MINts << "," << m_MINvalue << ">] - @ 3 EXCH **");
 			m_replies =0;
 		}
 	}
 }
 
+void
+OhMamClient::CompleteWrite (Time start, std::chrono::time_point<std::chrono::system_clock> realStart, uint32_t ts)
+{
+	NS_LOG_FUNCTION (this << start << ts);
+
+	m_completeOps++;
+	m_workload.OperationCompleted ();
+	m_real_end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = m_real_end-realStart;
+	m_opEnd = Now();
+	m_opAve += m_opEnd - start;
+	m_opCompletedTrace (WRITE, 4, m_opEnd - start, ts, m_key, m_personalID);
+	m_real_opAve += elapsed_seconds; 
+
+	AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - start.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - start.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), < <ts,id> , value>: [<" << ts <<"," << m_personalID << "> ," << m_value << "], @ 4 EXCH **");
+}
 
 } // Namespace ns3
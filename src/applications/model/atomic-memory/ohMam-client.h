@@ -22,9 +22,16 @@
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
+#include "ns3/packet.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
 #include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-register-store.h"
+#include "am-key-selector.h"
+#include "am-workload.h"
+#include "am-write-batcher.h"
+#include <chrono>
 
 namespace ns3 {
 
@@ -82,6 +89,12 @@ public:
 	 */
 	uint32_t GetDataSize (void) const;
 
+	/**
+	 * \brief Get the totals of the operations of this client
+	 * \returns the counters reported in the LOG line
+	 */
+	AmClientStats GetStats (void) const;
+
 	/**
 	 * Set the data fill of the packet (what is sent as data to the server) to
 	 * the zero-terminated contents of the fill string string.
@@ -114,6 +127,14 @@ public:
 
 	void SetServers (std::vector<Address> ip);
 
+	/**
+	 * \brief Assign fixed random variable stream numbers to the random
+	 * variables used by this client
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned
+	 */
+	int64_t AssignStreams (int64_t stream);
+
 protected:
 	virtual void DoDispose (void);
 
@@ -131,12 +152,6 @@ private:
 	 * \brief clear the string stream
 	 */
 	//void Reset(stringstream& s);
-	/**
-	 * \brief Schedule the next packet transmission
-	 * \param dt time interval between packets.
-	 */
-	void ScheduleOperation (Time dt);
-
 	/**
 	 * \brief Read operation handler
 	 */
@@ -145,6 +160,28 @@ private:
 	 * \brief Write operation handler
 	 */
 	void InvokeWrite (void);
+	/**
+	 * \brief Send the first round of the writes waiting on a key
+	 * \param key the key
+	 */
+	void CommitBatch (uint32_t key);
+	/**
+	 * \brief Record the completion of a write
+	 * \param start the invocation time of the write
+	 * \param realStart the wall clock invocation time of the write
+	 * \param ts the timestamp of the write
+	 */
+	void CompleteWrite (Time start, std::chrono::time_point<std::chrono::system_clock> realStart, uint32_t ts);
+	/**
+	 * \brief Pick the key of the next operation and load its register state
+	 */
+	void SelectKey (void);
+	/**
+	 * \brief Park the register state of the current key and load the one of
+	 * another key
+	 * \param key the key
+	 */
+	void LoadKey (uint32_t key);
 
 	/**
 	 * \brief Send a packet
@@ -164,8 +201,9 @@ private:
 	 * \param type the type of the received message
 	 * \param ts the received timestamp
 	 * \param val the value associate with ts
+	 * \param payload the bytes of val
 	 */
-	void ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val, uint32_t op);
+	void ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val, uint32_t op, Ptr<Packet> payload);
 	
 	/**
    	 * \brief Handle an incoming connection
@@ -196,7 +234,7 @@ private:
 	 */
 	void ConnectionFailed (Ptr<Socket> socket);
 
-	uint32_t m_size; 		//!< Size of the sent packet
+	uint32_t m_size; 		//!< Size of the values written, in bytes
 	uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
 	uint8_t *m_data; 		//!< packet payload data
 
@@ -204,13 +242,13 @@ private:
 	uint16_t m_port; //!< Port on which we listen for incoming packets.
 
 	std::vector< Ptr<Socket> > m_socket; //!< Socket
+	AmMessageFramer m_framer; //!< reassembles the messages of each socket
 	std::vector<Address> m_serverAddress; //!< Remote server adresses
 	std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
 	Address m_peerAddress; //!< Remote peer address
 	Address m_myAddress; //!< Remote peer address
 	Address m_local; //!< local multicast address
 	uint16_t m_peerPort; //!< Remote peer port
-	EventId m_sendEvent; //!
 	uint32_t m_personalID; 				//My Personal ID
 
 	uint16_t m_serversConnected;
@@ -219,13 +257,38 @@ private:
 	// Together <m_ts,m_id> is the tag
 	uint32_t m_ts; 				//!< latest timestamp
 	uint32_t m_value;			//!< value associated with m_ts
+	Ptr<Packet> m_payload;		//!< bytes of m_value
 	uint32_t m_MINts; 			//!< min timestamp
 	uint32_t m_MINId; 			//!< min id
 	uint32_t m_MINvalue; 		//!< min value
+	Ptr<Packet> m_MINpayload;	//!< bytes of m_MINvalue
 	uint32_t m_id; 				//!< latest id 
 	
 	uint32_t m_readop;			//!< read operation counter
 	uint32_t m_writeop;			//!< write operation counter
+	uint32_t m_writeBatch;		//!< writes committed by a round at most
+	AmWriteBatcher m_batcher;	//!< the writes waiting for a round
+
+	// Key-value store
+	/// Local state of a single register (key)
+	struct Register
+	{
+		uint32_t ts;      //!< latest timestamp
+		uint32_t value;   //!< value associated with ts
+		uint32_t id;      //!< latest id
+	};
+	AmRegisterStore<Register> m_registers; //!< register state of the keys not currently accessed
+	AmKeySelector m_keys;		//!< picks the key of each operation
+	uint32_t m_key;				//!< key accessed by the current operation
+	uint32_t m_numKeys;			//!< number of keys
+	AmKeySelector::Distribution m_keyDist; //!< distribution of the accessed keys
+	double m_zipfAlpha;			//!< exponent of the zipf key distribution
+
+	// Workload
+	AmWorkload m_workload;		//!< schedules the invocations of the operations
+	AmWorkload::Arrival m_arrival;	//!< arrival process of the operations
+	double m_arrivalRate;		//!< rate of the Poisson arrivals (ops/s)
+	std::string m_traceFile;	//!< file of the arrival times to replay
 
 	uint32_t m_numServers;		//!< number of servers
 	uint32_t m_fail;			//!< max number of failures supported
@@ -260,6 +323,9 @@ private:
 
 	/// Callbacks for tracing the packet Tx events
 	TracedCallback<Ptr<const Packet> > m_txTrace;
+
+	/// Callbacks for tracing the completed operations
+	TracedCallback<uint32_t, uint32_t, Time, uint32_t, uint32_t, uint32_t> m_opCompletedTrace;
 };
 
 } // namespace ns3
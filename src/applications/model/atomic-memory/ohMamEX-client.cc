@@ -29,12 +29,18 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
-#include "OhMamEX-client.h"
+#include "ohMamEX-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <string>
 #include <cstdlib>
 #include <iostream>
 #include <ctime>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -98,7 +104,7 @@ OhMamEXClient::GetTypeId (void)
 					UintegerValue (9),
 					MakeUintegerAccessor (&OhMamEXClient::m_port),
 					MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&OhMamEXClient::SetDataSize,
                                          &OhMamEXClient::GetDataSize),
@@ -106,6 +112,9 @@ OhMamEXClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&OhMamEXClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&OhMamEXClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -131,6 +140,39 @@ OhMamEXClient::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&OhMamEXClient::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&OhMamEXClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&OhMamEXClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&OhMamEXClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&OhMamEXClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&OhMamEXClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&OhMamEXClient::m_traceFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -142,7 +184,6 @@ OhMamEXClient::OhMamEXClient ()
 {
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -187,7 +228,32 @@ OhMamEXClient::StartApplication (void)
 {
 
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
+
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&OhMamEXClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&OhMamEXClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	m_workload.SetMaxInFlight (1);
 
 	// seed pseudo-randomness
 	srand(m_seed);
@@ -237,9 +303,7 @@ OhMamEXClient::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -259,19 +323,35 @@ OhMamEXClient::StartApplication (void)
 	}
 
 	
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
 
 }
 
+AmClientStats
+OhMamEXClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_completeOps;
+	if (m_prType == READER)
+	{
+		stats.slowReads = m_slowOpCount;
+		stats.fastReads = m_fastOpCount;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
+}
+
 void 
 OhMamEXClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
   if (m_insocket != 0)
 	{
 		m_insocket->Close ();
@@ -300,26 +380,23 @@ OhMamEXClient::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-  	  sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
-  if(m_personalID==m_numClients-1){
-  	exit(0);
-  }
-  Simulator::Cancel (m_sendEvent);
+  m_workload.Stop ();
 }
 
 void
 OhMamEXClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
   Application::DoDispose ();
 }
 
@@ -329,6 +406,7 @@ OhMamEXClient::DoDispose (void)
 void OhMamEXClient::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void OhMamEXClient::HandlePeerError (Ptr<Socket> socket)
@@ -356,24 +434,20 @@ void OhMamEXClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
 void OhMamEXClient::ConnectionFailed (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
-  std::stringstream sstm;
-  sstm << "Connection to SERVER Failed.";
-  LogInfo(sstm);
+  AM_LOG_INFO ("Connection to SERVER Failed.");
 }
 
 /**************************************************************************************
@@ -391,6 +465,14 @@ OhMamEXClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+OhMamEXClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  return streams + m_keys.AssignStreams (stream + streams);
+}
+
 void
 OhMamEXClient::SetRemote (Address ip, uint16_t port)
 {
@@ -434,56 +516,47 @@ OhMamEXClient::SetFill (std::string fill)
 
   if (dataSize != m_dataSize)
     {
+      delete [] m_data;
       m_data = new uint8_t [dataSize];
       m_dataSize = dataSize;
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
-  m_size = dataSize;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-OhMamEXClient::ScheduleOperation (Time dt)
+/**************************************************************************************
+ * OhMamEX Read/Write Handlers
+ **************************************************************************************/
+void
+OhMamEXClient::SelectKey (void)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this);
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+	// park the state of the current key and load the one of the next key
+	Register &reg = m_registers.Get (m_key);
+	reg.ts = m_ts;
+	reg.value = m_value;
+	reg.id = m_id;
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	m_key = m_keys.GetNext ();
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &OhMamEXClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &OhMamEXClient::InvokeWrite, this);
-  }
+	Register &next = m_registers.Get (m_key);
+	m_ts = next.ts;
+	m_value = next.value;
+	m_id = next.id;
 }
 
-/**************************************************************************************
- * OhMamEX Read/Write Handlers
- **************************************************************************************/
 void
 OhMamEXClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 	
 
 	//check if we still have operations to perfrom
 	if ( m_opCount <  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
@@ -504,9 +577,7 @@ OhMamEXClient::InvokeRead (void)
 		//Send msg to all
 		m_replies = 0;		//reset replies
 		
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s");
 		m_opStart = Now();
 		m_real_start = std::chrono::system_clock::now();
 		HandleSend();
@@ -517,7 +588,6 @@ void
 OhMamEXClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	
@@ -525,15 +595,15 @@ OhMamEXClient::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
 		m_opStatus = PHASE1;
 		m_msgType = DISCOVER;
 		m_value = m_opCount + 900;
 		m_writeop ++;
 		m_replies = 0;		//reset replies
 		
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		m_opStart = Now();
 		m_real_start = std::chrono::system_clock::now();
 		HandleSend();
@@ -545,10 +615,9 @@ OhMamEXClient::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT (m_sendEvent.IsExpired ());
-
   // Prepare packet content
-  std::stringstream pkts;
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
   std::string message_type;
   
   // Serialize the appropriate message for READ or WRITE
@@ -556,34 +625,28 @@ OhMamEXClient::HandleSend (void)
   // serialize <msgType, ts, id, value, readop ,counter>
   if ((m_msgType == DISCOVER) && (m_opStatus == PHASE1))
   	{
-  		pkts << DISCOVER << " " << m_writeop;
+  		hdr.SetType (DISCOVER);
+  		hdr.SetCounter (m_writeop);
   		message_type = "discover";
 	}
   else if ((m_msgType == WRITE) && (m_opStatus == PHASE2))
   	{
-  		pkts << WRITE << " " << m_ts << " " << m_personalID << " " << m_value << " " << m_writeop;
+  		hdr.SetType (WRITE);
+  		hdr.SetTs (m_ts);
+  		hdr.SetId (m_personalID);
+  		hdr.SetValue (m_value);
+  		hdr.SetCounter (m_writeop);
   		message_type = "write";
 	}
   else if (m_msgType == READ)
     {
-		pkts << READ << " " << m_readop;
+		hdr.SetType (READ);
+		hdr.SetCounter (m_readop);
 		message_type = "read";
     }
 
-  SetFill(pkts.str());
-
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "OhMamEXClient::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "OhMamEXClient::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // Create packet, the writes carry the bytes of the value
+  Ptr<Packet> p = m_framer.Build (hdr, m_msgType == WRITE ? m_payload : 0);
 
 	//random server to start from
   int current = rand()%m_serverAddress.size();
@@ -597,10 +660,8 @@ OhMamEXClient::HandleSend (void)
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
-		  << " port " << m_peerPort << " data " << pkts.str();
-		  LogInfo ( sstm );
+		  AM_LOG_INFO ("Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
+		  << " port " << m_peerPort << " data " << hdr);
 	  }
 	  // move to the next server
       current = (current+1)%m_serverAddress.size();
@@ -614,62 +675,54 @@ OhMamEXClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  uint32_t msgT, msgTs, msgId, msgV, msgOp, msgInit;
+  AmProtocolHeader hdr;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
 	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgT; 
-	  std::stringstream sstm;
+	  packet->RemoveHeader (hdr);
+	  MessageType msgT = hdr.GetType ();
+	  uint32_t msgTs = hdr.GetTs ();
+	  uint32_t msgId = hdr.GetId ();
+	  uint32_t msgV = hdr.GetValue ();
+	  uint32_t msgOp = hdr.GetCounter ();
 	  std::string message_type;
 
 	  if (msgT==READACK){
 			message_type = "readAck";
-			istm >> msgTs >> msgId >> msgV >> msgOp;
 	  }else if (msgT==DISCOVERACK){
 			message_type = "discoverAck";
-			istm >> msgTs >> msgOp;
 	  }else if (msgT==WRITEACK){
 			message_type = "writeAck";
-			istm >> msgTs >> msgId >> msgV >> msgOp;
 	  }
 	  //EX: now client gets back also read Relays
 	  else if (msgT==READRELAY)
 	  {
 			message_type = "ReadRelay";
-			istm >> msgTs >> msgId >> msgV >> msgInit >> msgOp;
 	  }
 
 	 
 	 if (m_verbose)
 	  {
-		  sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
+		  AM_LOG_INFO ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << buf;
-		  LogInfo (sstm);
+				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << hdr);
 	  }
 
       // check message freshness and if client is waiting
       if ((((msgOp == m_readop) && (msgT==READACK)) || ((msgOp == m_readop) && (msgT==READRELAY)) || ((msgOp == m_writeop) && (msgT==WRITEACK)) || ((msgOp == m_writeop) && (msgT==DISCOVERACK))) && m_opStatus != IDLE)
        {
-    	  ProcessReply(msgT, msgTs, msgId, msgV, msgOp);
+    	  ProcessReply(msgT, msgTs, msgId, msgV, msgOp, packet);
        }
     
     }
 }
 
 void
-OhMamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val, uint32_t op)
+OhMamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t val, uint32_t op, Ptr<Packet> payload)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-
 	//increment the number of replies received
 	
 
@@ -689,9 +742,7 @@ OhMamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 
 			if (m_verbose)
 	  		{
-			AsmCommon::Reset(sstm);
-			sstm << "Waiting for " << (m_numServers-m_fail) << " discoverAck replies, received " << m_replies;
-			LogInfo(sstm);
+			AM_LOG_INFO ("Waiting for " << (m_numServers-m_fail) << " discoverAck replies, received " << m_replies);
 			}
 
 			//if we received enough replies go to the next phase
@@ -704,6 +755,7 @@ OhMamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 				m_ts ++; 
 				m_writeop ++;
 				m_value = m_writeop + 200;
+				m_payload = Create<Packet> (m_size);
 				
 				//Send msg to all
 				m_replies = 0;		//reset replies
@@ -720,16 +772,15 @@ OhMamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 				
 				m_completeOps++;
 				m_opStatus = IDLE;
-				ScheduleOperation (m_interval);
+				m_workload.OperationCompleted ();
 				m_real_end = std::chrono::system_clock::now();
 				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 				m_opEnd = Now();
 				m_opAve += m_opEnd - m_opStart;
+				m_opCompletedTrace (WRITE, 4, m_opEnd - m_opStart, m_ts, m_key, m_personalID);
 				m_real_opAve += elapsed_seconds; 
 
-				AsmCommon::Reset(sstm);
-				sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), < <ts,id> , value>: [<" << m_ts <<"," << m_personalID << "> ," << m_value << "], @ 4 EXCH **";
-				LogInfo(sstm);
+				AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), < <ts,id> , value>: [<" << m_ts <<"," << m_personalID << "> ," << m_value << "], @ 4 EXCH **");
 				m_replies = 0;
 			}
 		}
@@ -798,15 +849,14 @@ OhMamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 
       			m_opEnd = Now();
       			m_opAve += m_opEnd - m_opStart;
+      			m_opCompletedTrace (READ, 2, m_opEnd - m_opStart, return_timestamp, m_key, return_id);
       			m_real_end = std::chrono::system_clock::now();
 				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 				m_real_opAve += elapsed_seconds;  //
 
    				m_opStatus = IDLE;
-				ScheduleOperation (m_interval);
-      			AsmCommon::Reset(sstm);
-				sstm << "** FAST READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,id>,value]: [<" << return_timestamp << "," <<return_id<<">,"<< return_value << "] - @ 2 EXCH **";
-				LogInfo(sstm);
+				m_workload.OperationCompleted ();
+				AM_LOG_INFO ("** FAST READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,id>,value]: [<" << return_timestamp << "," <<return_id<<">,"<< return_value << "] - @ 2 EXCH **");
 			}
 		}
 		else if (type == READACK && m_done==0)
@@ -818,6 +868,7 @@ OhMamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
       			m_MINts = ts;
 				m_MINId = id;
 				m_MINvalue = val;
+				m_MINpayload = payload;
       		}
 
       		if (m_replies >= (m_numServers - m_fail))
@@ -830,15 +881,14 @@ OhMamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t id, uint32_t va
 
       			m_opEnd = Now();
       			m_opAve += m_opEnd - m_opStart;
+      			m_opCompletedTrace (READ, 3, m_opEnd - m_opStart, m_MINts, m_key, m_MINId);
       			m_real_end = std::chrono::system_clock::now();
 				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 				m_real_opAve += elapsed_seconds;  //
 
    				m_opStatus = IDLE;
-				ScheduleOperation (m_interval);
-      			AsmCommon::Reset(sstm);
-				sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << m_MINts << "," << m_MINvalue << ">] - @ 3 EXCH **";
-				LogInfo(sstm);
+				m_workload.OperationCompleted ();
+				AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << m_MINts << "," << m_MINvalue << ">] - @ 3 EXCH **");
 				m_replies =0;
 			}
 		}
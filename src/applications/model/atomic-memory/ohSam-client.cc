@@ -29,8 +29,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
 #include "ohSam-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <string>
 #include <cstdlib>
 #include <iostream>
@@ -97,7 +102,7 @@ ohSamClient::GetTypeId (void)
 					UintegerValue (9),
 					MakeUintegerAccessor (&ohSamClient::m_port),
 					MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&ohSamClient::SetDataSize,
                                          &ohSamClient::GetDataSize),
@@ -105,6 +110,9 @@ ohSamClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&ohSamClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&ohSamClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -130,6 +138,51 @@ ohSamClient::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&ohSamClient::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&ohSamClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&ohSamClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&ohSamClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&ohSamClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&ohSamClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&ohSamClient::m_traceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("QuorumSelection",
+                   "The servers an operation is sent to first: all of them, or a thrifty quorum of #servers-#failures",
+                   EnumValue (AmQuorumSelector::ALL),
+                   MakeEnumAccessor (&ohSamClient::m_quorumMode),
+                   MakeEnumChecker (AmQuorumSelector::ALL, "All",
+                                    AmQuorumSelector::RANDOM, "Random",
+                                    AmQuorumSelector::NEAREST, "Nearest"))
+    .AddAttribute ("ThriftyTimeout",
+                   "The time an operation sent to a thrifty quorum waits for its replies before it is sent to the other servers",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&ohSamClient::m_thriftyTimeout),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -141,7 +194,7 @@ ohSamClient::ohSamClient ()
 {
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
-	m_sendEvent = EventId ();
+	m_fallbacks = 0;
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -186,11 +239,39 @@ ohSamClient::StartApplication (void)
 {
 
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
+
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&ohSamClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&ohSamClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	m_workload.SetMaxInFlight (1);
 
 	// seed pseudo-randomness
 	srand(m_seed);
 
+	// thrifty operations go to a quorum first
+	m_quorum.SetMode (m_serverAddress.size (), m_quorumMode);
+
 	if (m_insocket == 0)
 	{
 		TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -234,9 +315,7 @@ ohSamClient::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -256,19 +335,34 @@ ohSamClient::StartApplication (void)
 	}
 
 	
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
 
 }
 
+AmClientStats
+ohSamClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_completeOps;
+	if (m_prType == READER)
+	{
+		stats.slowReads = m_completeOps;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
+}
+
 void 
 ohSamClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
   if (m_insocket != 0)
 	{
 		m_insocket->Close ();
@@ -284,7 +378,7 @@ ohSamClient::StopApplication ()
 	  }
     }
 
-  
+  m_fallback.Cancel ();
 
   float avg_time=0;
   float real_avg_time=0;
@@ -299,28 +393,29 @@ ohSamClient::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-	  sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_completeOps << ", #2EXCH_reads=0, AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_completeOps << ", #2EXCH_reads=0, AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_completeOps << ", #2EXCH_reads=0, AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
-  
-  if(m_personalID==m_numClients-1){
-  	exit(0);
-  }
 
-  Simulator::Cancel (m_sendEvent);
+  if (m_quorumMode != AmQuorumSelector::ALL)
+    {
+      std::cout << "** CLIENT_"<<m_personalID <<" THRIFTY: #serverMsgs="<<m_sent<<", MsgsPerOp="<<(m_completeOps > 0 ? (double) m_sent / m_completeOps : 0)<<", #fallbacks="<<m_fallbacks<<" **"<<std::endl;
+    }
+  
+  m_workload.Stop ();
 }
 
 void
 ohSamClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
   Application::DoDispose ();
 }
 
@@ -330,6 +425,7 @@ ohSamClient::DoDispose (void)
 void ohSamClient::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void ohSamClient::HandlePeerError (Ptr<Socket> socket)
@@ -357,24 +453,20 @@ void ohSamClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
 void ohSamClient::ConnectionFailed (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
-  std::stringstream sstm;
-  sstm << "Connection to SERVER Failed.";
-  LogInfo(sstm);
+  AM_LOG_INFO ("Connection to SERVER Failed.");
 }
 
 /**************************************************************************************
@@ -392,6 +484,19 @@ ohSamClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+ohSamClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  streams += m_keys.AssignStreams (stream + streams);
+  if (m_quorumMode == AmQuorumSelector::RANDOM)
+    {
+      streams += m_quorum.AssignStreams (stream + streams);
+    }
+  return streams;
+}
+
 void
 ohSamClient::SetRemote (Address ip, uint16_t port)
 {
@@ -435,51 +540,38 @@ ohSamClient::SetFill (std::string fill)
 
   if (dataSize != m_dataSize)
     {
+      delete [] m_data;
       m_data = new uint8_t [dataSize];
       m_dataSize = dataSize;
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
-  m_size = dataSize;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-ohSamClient::ScheduleOperation (Time dt)
+/**************************************************************************************
+ * ohSam Read/Write Handlers
+ **************************************************************************************/
+void
+ohSamClient::SelectKey (void)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this);
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+	// park the state of the current key and load the one of the next key
+	Register &reg = m_registers.Get (m_key);
+	reg.ts = m_ts;
+	reg.value = m_value;
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	m_key = m_keys.GetNext ();
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &ohSamClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &ohSamClient::InvokeWrite, this);
-  }
+	Register &next = m_registers.Get (m_key);
+	m_ts = next.ts;
+	m_value = next.value;
 }
 
-/**************************************************************************************
- * ohSam Read/Write Handlers
- **************************************************************************************/
 void
 ohSamClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 	m_opStart = Now();
 	m_real_start = std::chrono::system_clock::now();
 	
@@ -487,6 +579,8 @@ ohSamClient::InvokeRead (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
@@ -497,9 +591,7 @@ ohSamClient::InvokeRead (void)
 		
 		//Send msg to all
 		m_replies = 0;		//reset replies
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s");
 
 		HandleSend();
 	}
@@ -509,7 +601,6 @@ void
 ohSamClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -519,16 +610,17 @@ ohSamClient::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
 		m_opStatus = PHASE1;
 		m_msgType = WRITE;
 		m_ts ++;
 
 		m_value = m_opCount + 900;
+		m_payload = Create<Packet> (m_size);
 		m_replies = 0;
 
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
 	}
 }
@@ -538,41 +630,32 @@ ohSamClient::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT (m_sendEvent.IsExpired ());
-
-  
   // Prepare packet content
-  std::stringstream pkts;
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
   std::string message_type;
-  
-  AsmCommon::Reset(pkts);
+
   // Serialize the appropriate message for READ or WRITE
   if ( m_msgType == WRITE )
   	{
-  		pkts << m_msgType << " " << m_ts << " " << m_value;
+  		hdr.SetType (WRITE);
+  		hdr.SetTs (m_ts);
+  		hdr.SetValue (m_value);
   		message_type = "write";
 	}
   else 
     {
-		pkts << m_msgType << " "<< m_opCount;
+		hdr.SetType (READ);
+		hdr.SetCounter (m_opCount);
 		message_type = "read";
     }
 
-  SetFill(pkts.str());
-
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "ohSamClient::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "ohSamClient::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // Create packet, the writes carry the bytes of the value
+  Ptr<Packet> p = m_framer.Build (hdr, m_msgType == WRITE ? m_payload : 0);
 
+  // the servers of the operation: all of them, or a thrifty quorum
+  m_quorum.Select (m_numServers - m_fail, m_contacted);
+  m_roundStart = Now ();
 
   //random server to start from
   int current = rand()%m_serverAddress.size();
@@ -580,21 +663,68 @@ ohSamClient::HandleSend (void)
   //Send a single packet to each server
   for (uint32_t i=0; i<m_serverAddress.size(); i++)
   {
-  	  m_sent++; //count the messages sent
-	  //m_txTrace (p);
-      m_socket[current]->Send (p);
-
-	  if (m_verbose)
+	  if (m_contacted.Contains (current))
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
-		  << " port " << m_peerPort << " data " << pkts.str();
-		  LogInfo ( sstm );
+		  m_sent++; //count the messages sent
+		  //m_txTrace (p);
+		  m_socket[current]->Send (p);
+
+		  if (m_verbose)
+		  {
+			  AM_LOG_INFO ("Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
+			  << " port " << m_peerPort << " data " << hdr);
+		  }
 	  }
 
       // move to the next server
       current = (current+1)%m_serverAddress.size();
   }
+
+  m_fallback.Cancel ();
+  if (m_contacted.GetSize () < m_serverAddress.size ())
+  {
+	  m_fallback = Simulator::Schedule (m_thriftyTimeout, &ohSamClient::Fallback, this, p);
+  }
+}
+
+void
+ohSamClient::Fallback (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_opStatus == IDLE)
+  {
+	  return;
+  }
+
+  m_fallbacks++;
+  for (uint32_t i=0; i<m_serverAddress.size(); i++)
+  {
+	  if (!m_contacted.Contains (i))
+	  {
+		  m_sent++;
+		  m_socket[i]->Send (p);
+		  m_contacted.Insert (i);
+
+		  if (m_verbose)
+		  {
+			  AM_LOG_INFO ("Sent " << p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << " port " << m_peerPort << " after the thrifty timeout");
+		  }
+	  }
+  }
+}
+
+uint32_t
+ohSamClient::FindServer (Ptr<Socket> socket) const
+{
+  for (uint32_t i=0; i<m_socket.size(); i++)
+  {
+	  if (m_socket[i] == socket)
+	  {
+		  return i;
+	  }
+  }
+  return m_socket.size ();
 }
 
 void
@@ -604,48 +734,51 @@ ohSamClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  uint32_t msgT, msgTs, msgV, msgOp;
+  AmProtocolHeader hdr;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
 	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgT;
-	  std::stringstream sstm;
+	  packet->RemoveHeader (hdr);
+	  MessageType msgT = hdr.GetType ();
+	  uint32_t msgTs = hdr.GetTs ();
+	  uint32_t msgV = hdr.GetValue ();
+	  uint32_t msgOp = hdr.GetCounter ();
 	  std::string message_type;
 
 	  if (msgT==READACK)
 	  {
 			message_type = "readAck";
-			istm >> msgTs >> msgV >> msgOp;
 	  }
 	  else
 	  {
 			message_type = "writeAck";
-			istm >> msgTs >> msgV;
 	  }
 	 
 
 	  if (m_verbose)
 	  {
-		  sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
+		  AM_LOG_INFO ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << buf;
-		  LogInfo (sstm);
+				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << hdr);
 	  }
 
       // check message freshness and if client is waiting
       if ((msgOp == m_opCount) && (msgT==READACK) && (m_opStatus != IDLE))
        {
-    		ProcessReply(msgT, msgTs, msgV);
+    		if (m_quorumMode == AmQuorumSelector::NEAREST)
+    		{
+    			m_quorum.AddRtt (FindServer (socket), Now () - m_roundStart);
+    		}
+    		ProcessReply(msgT, msgTs, msgV, packet);
        }
        else if ((msgTs == m_ts) && (msgT==WRITEACK) && (m_opStatus != IDLE))
        {
-       		ProcessReply(msgT, msgTs, msgV);
+       		if (m_quorumMode == AmQuorumSelector::NEAREST)
+       		{
+       			m_quorum.AddRtt (FindServer (socket), Now () - m_roundStart);
+       		}
+       		ProcessReply(msgT, msgTs, msgV, packet);
        }
        else
        {
@@ -656,12 +789,10 @@ ohSamClient::HandleRecv (Ptr<Socket> socket)
 }
 
 void
-ohSamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
+ohSamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val, Ptr<Packet> payload)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-
 	//increment the number of replies received
 	m_replies ++;
 
@@ -675,17 +806,16 @@ ohSamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 		{
 			m_completeOps++;
 			m_opStatus = IDLE;
-			ScheduleOperation (m_interval);
+			m_workload.OperationCompleted ();
 			m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 
 			m_opEnd = Now();
 			m_opAve += m_opEnd - m_opStart;
+			m_opCompletedTrace (WRITE, 2, m_opEnd - m_opStart, m_ts, m_key, 0);
 			m_real_opAve += elapsed_seconds;  
 			
-			AsmCommon::Reset(sstm);
-			sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **";
-			LogInfo(sstm);
+			AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **");
 			m_replies = 0;
 		}
 	}
@@ -699,6 +829,7 @@ ohSamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
    		{
       		m_MINts = ts;
 			m_MINvalue = val;
+			m_MINpayload = payload;
       	}
 		
       	if (m_replies >= (m_numServers - m_fail))
@@ -710,15 +841,14 @@ ohSamClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 
       		m_opEnd = Now();
       		m_opAve += m_opEnd - m_opStart;
+      		m_opCompletedTrace (READ, 3, m_opEnd - m_opStart, m_MINts, m_key, 0);
       		m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 			m_real_opAve += elapsed_seconds;  //
 
    			m_opStatus = IDLE;
-			ScheduleOperation (m_interval);
-      		AsmCommon::Reset(sstm);
-			sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << m_MINts << "," << m_MINvalue << ">] - @ 3 EXCH **";
-			LogInfo(sstm);
+			m_workload.OperationCompleted ();
+			AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << m_MINts << "," << m_MINvalue << ">] - @ 3 EXCH **");
 			m_replies =0;
 		}
 	}
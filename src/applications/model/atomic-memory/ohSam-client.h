@@ -22,9 +22,15 @@
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
+#include "ns3/packet.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
 #include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-register-store.h"
+#include "am-key-selector.h"
+#include "am-workload.h"
+#include "am-quorum-selector.h"
 #include <chrono>
 
 namespace ns3 {
@@ -83,6 +89,12 @@ public:
 	 */
 	uint32_t GetDataSize (void) const;
 
+	/**
+	 * \brief Get the totals of the operations of this client
+	 * \returns the counters reported in the LOG line
+	 */
+	AmClientStats GetStats (void) const;
+
 	/**
 	 * Set the data fill of the packet (what is sent as data to the server) to
 	 * the zero-terminated contents of the fill string string.
@@ -115,6 +127,14 @@ public:
 
 	void SetServers (std::vector<Address> ip);
 
+	/**
+	 * \brief Assign fixed random variable stream numbers to the random
+	 * variables used by this client
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned
+	 */
+	int64_t AssignStreams (int64_t stream);
+
 protected:
 	virtual void DoDispose (void);
 
@@ -132,12 +152,6 @@ private:
 	 * \brief clear the string stream
 	 */
 	//void Reset(stringstream& s);
-	/**
-	 * \brief Schedule the next packet transmission
-	 * \param dt time interval between packets.
-	 */
-	void ScheduleOperation (Time dt);
-
 	/**
 	 * \brief Read operation handler
 	 */
@@ -146,11 +160,26 @@ private:
 	 * \brief Write operation handler
 	 */
 	void InvokeWrite (void);
+	/**
+	 * \brief Pick the key of the next operation and load its register state
+	 */
+	void SelectKey (void);
 
 	/**
 	 * \brief Send a packet
 	 */
 	void HandleSend (void);
+	/**
+	 * \brief Send the message of the current operation to the servers left
+	 * out of its thrifty quorum, once the timer expired
+	 * \param p the message of the operation
+	 */
+	void Fallback (Ptr<Packet> p);
+	/**
+	 * \param socket a socket of the client
+	 * \return the index of the server the socket is connected to
+	 */
+	uint32_t FindServer (Ptr<Socket> socket) const;
 
 	/**
 	 * \brief Handle a packet reception.
@@ -165,8 +194,9 @@ private:
 	 * \param type the type of the received message
 	 * \param ts the received timestamp
 	 * \param val the value associate with ts
+	 * \param payload the bytes of val
 	 */
-	void ProcessReply(uint32_t type, uint32_t ts, uint32_t val);
+	void ProcessReply(uint32_t type, uint32_t ts, uint32_t val, Ptr<Packet> payload);
 	
 	/**
    	 * \brief Handle an incoming connection
@@ -197,7 +227,7 @@ private:
 	 */
 	void ConnectionFailed (Ptr<Socket> socket);
 
-	uint32_t m_size; 		//!< Size of the sent packet
+	uint32_t m_size; 		//!< Size of the values written, in bytes
 	uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
 	uint8_t *m_data; 		//!< packet payload data
 
@@ -205,13 +235,20 @@ private:
 	uint16_t m_port; //!< Port on which we listen for incoming packets.
 
 	std::vector< Ptr<Socket> > m_socket; //!< Socket
+	AmMessageFramer m_framer; //!< reassembles the messages of each socket
+	AmQuorumSelector m_quorum;	//!< picks the servers an operation is sent to first
+	AmQuorumSelector::Mode m_quorumMode;	//!< all the servers, or a thrifty quorum
+	Time m_thriftyTimeout;		//!< time a thrifty operation waits before it goes to all the servers
+	EventId m_fallback;			//!< thrifty timer of the current operation
+	AmSeenSet m_contacted;		//!< servers the current operation was sent to
+	Time m_roundStart;			//!< sending time of the current operation
+	uint32_t m_fallbacks;		//!< thrifty operations sent to all the servers
 	std::vector<Address> m_serverAddress; //!< Remote server adresses
 	std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
 	Address m_peerAddress; //!< Remote peer address
 	Address m_myAddress; //!< Remote peer address
 	Address m_local; //!< local multicast address
 	uint16_t m_peerPort; //!< Remote peer port
-	EventId m_sendEvent; //!
 	uint32_t m_personalID; 				//My Personal ID
 
 	uint16_t m_serversConnected;
@@ -220,14 +257,36 @@ private:
 	// Together <m_ts,m_id> is the tag
 	uint32_t m_ts; 				//!< latest timestamp
 	uint32_t m_value;			//!< value associated with m_ts
+	Ptr<Packet> m_payload;		//!< bytes of m_value
 	uint32_t m_MINts; 			//!< min timestamp
 	uint32_t m_MINId; 			//!< min id
 	uint32_t m_MINvalue; 		//!< min value
+	Ptr<Packet> m_MINpayload;	//!< bytes of m_MINvalue
 	uint32_t m_id; 				//!< latest id 
 	
 	uint32_t m_readop;			//!< read operation counter
 	
 
+	// Key-value store
+	/// Local state of a single register (key)
+	struct Register
+	{
+		uint32_t ts;      //!< latest timestamp
+		uint32_t value;   //!< value associated with ts
+	};
+	AmRegisterStore<Register> m_registers; //!< register state of the keys not currently accessed
+	AmKeySelector m_keys;		//!< picks the key of each operation
+	uint32_t m_key;				//!< key accessed by the current operation
+	uint32_t m_numKeys;			//!< number of keys
+	AmKeySelector::Distribution m_keyDist; //!< distribution of the accessed keys
+	double m_zipfAlpha;			//!< exponent of the zipf key distribution
+
+	// Workload
+	AmWorkload m_workload;		//!< schedules the invocations of the operations
+	AmWorkload::Arrival m_arrival;	//!< arrival process of the operations
+	double m_arrivalRate;		//!< rate of the Poisson arrivals (ops/s)
+	std::string m_traceFile;	//!< file of the arrival times to replay
+
 	uint32_t m_numServers;		//!< number of servers
 	uint32_t m_fail;			//!< max number of failures supported
 
@@ -261,6 +320,9 @@ private:
 
 	/// Callbacks for tracing the packet Tx events
 	TracedCallback<Ptr<const Packet> > m_txTrace;
+
+	/// Callbacks for tracing the completed operations
+	TracedCallback<uint32_t, uint32_t, Time, uint32_t, uint32_t, uint32_t> m_opCompletedTrace;
 };
 
 } // namespace ns3
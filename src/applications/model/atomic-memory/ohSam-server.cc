@@ -30,7 +30,12 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/enum.h"
 #include "ohSam-server.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <algorithm>
 
 namespace ns3 {
@@ -81,6 +86,51 @@ ohSamServer::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&ohSamServer::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("RelayWindow",
+					 "Time a relay waits for the next ones to the same server, 0 to send every relay at once",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&ohSamServer::m_relayWindow),
+					 MakeTimeChecker ())
+					.AddAttribute ("RelayBatchSize",
+					 "Relays to the same server sent at once, without waiting for the window to close",
+					 UintegerValue (32),
+					 MakeUintegerAccessor (&ohSamServer::m_relayBatch),
+					 MakeUintegerChecker<uint32_t> (1))
+					.AddAttribute ("ServiceCores",
+					 "Messages processed at the same time, 0 to process every message on arrival",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&ohSamServer::m_serviceCores),
+					 MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("ServiceTime",
+					 "The processing time of a message, in seconds",
+					 StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"),
+					 MakePointerAccessor (&ohSamServer::m_serviceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("RelayServiceTime",
+					 "The processing time of a relay from another server, in seconds, unset for ServiceTime",
+					 PointerValue (),
+					 MakePointerAccessor (&ohSamServer::m_relayServiceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("ServiceTimePerItem",
+					 "The processing time added per server a message is relayed to",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&ohSamServer::m_servicePerItem),
+					 MakeTimeChecker ())
+					.AddAttribute ("Fault",
+					 "The fault of the server: None, Crash (the messages received are lost) or Pause (they are held until the fault ends)",
+					 EnumValue (AmServiceQueue::NONE),
+					 MakeEnumAccessor (&ohSamServer::SetFault, &ohSamServer::GetFault),
+					 MakeEnumChecker (AmServiceQueue::NONE, "None",
+					                  AmServiceQueue::CRASH, "Crash",
+					                  AmServiceQueue::PAUSE, "Pause"))
+					.AddAttribute ("Slowdown",
+					 "The time every message received waits before it is processed",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&ohSamServer::SetSlowdown, &ohSamServer::GetSlowdown),
+					 MakeTimeChecker ())
+					.AddTraceSource ("MessageHandled", "A message was received and answered",
+					 MakeTraceSourceAccessor (&ohSamServer::m_handledTrace),
+					 "ns3::AmStatsCollector::MessageHandledCallback")
 	;
 	return tid;
 }
@@ -88,9 +138,6 @@ ohSamServer::GetTypeId (void)
 ohSamServer::ohSamServer ()
 {
 	NS_LOG_FUNCTION (this);
-	m_id = 0;
-	m_ts = 0;
-	m_value = 0;
 	m_serversConnected =0;
 	m_sent=0;
 	m_operations.resize(100);
@@ -102,9 +149,6 @@ ohSamServer::~ohSamServer()
 {
 	NS_LOG_FUNCTION (this);
 	//m_socket = 0;
-	m_id = 0;
-	m_ts = 0;
-	m_value = 0;
 	m_sent=0;
 	m_serversConnected =0;
 	m_operations.resize(100);
@@ -131,10 +175,18 @@ void
 ohSamServer::StartApplication (void)
 {
 	NS_LOG_FUNCTION (this);
+
+	m_service.SetCores (m_serviceCores);
+	m_service.SetServiceTime (m_serviceTime);
+	m_service.SetServiceTime (READRELAY, m_relayServiceTime);
+	m_service.SetPerItem (m_servicePerItem);
+	m_service.SetItemsCallback (MakeCallback (&ohSamServer::GetServiceItems, this));
+	m_service.SetServedCallback (MakeCallback (&ohSamServer::HandleRead, this));
+
+	m_relayBatcher.SetWindow (m_relayWindow);
+	m_relayBatcher.SetMaxMessages (m_relayBatch);
 	
-	std::stringstream sstm;
-	sstm << "Debug Mode="<< m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Debug Mode="<< m_verbose);
 	
 	if (m_socket == 0)
 	{
@@ -182,9 +234,7 @@ ohSamServer::StartApplication (void)
 		{
 			if ( m_verbose )
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -206,11 +256,20 @@ ohSamServer::StartApplication (void)
 }
 
 
+uint32_t
+ohSamServer::GetSentMessages (void) const
+{
+	return m_sent;
+}
+
 void 
 ohSamServer::StopApplication ()
 {
 	NS_LOG_FUNCTION (this);
 
+	// send the relays still waiting for their window
+	m_relayBatcher.Flush ();
+
 	if (m_socket != 0)
 	{
 		m_socket->Close ();
@@ -233,18 +292,32 @@ ohSamServer::StopApplication ()
 			m_clntSocket[i]->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
 		}
 	}
-	std::stringstream sstm;
-	sstm << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **";
-	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	LogInfo(sstm);
+	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	AM_LOG_INFO ("** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **");
+	if (!m_relayWindow.IsZero ())
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" RELAYS: #relayMsgs="<<m_relayBatcher.GetMessages ()<<", #relayPkts="<<m_relayBatcher.GetPackets ()<<" **"<<std::endl;
+	}
 
-	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
+	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	if (m_serviceCores > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" CPU: #served="<<m_service.GetServed ()<<", busyTime="<<m_service.GetBusyTime ().GetSeconds ()<<"s, AveWait="<<(m_service.GetServed () > 0 ? m_service.GetWaitTime ().GetSeconds () / m_service.GetServed () : 0)<<"s, #maxQueue="<<m_service.GetMaxQueue ()<<" **"<<std::endl;
+	}
+	if (m_service.GetDropped () > 0 || m_service.GetHeld () > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" FAULTS: #dropped="<<m_service.GetDropped ()<<", #held="<<m_service.GetHeld ()<<" **"<<std::endl;
+	}
 }
 
 void
 ohSamServer::DoDispose (void)
 {
 	NS_LOG_FUNCTION (this);
+	m_framer.Clear ();
+	m_service.Clear ();
+	m_relayBatcher.Clear ();
+	m_registers.Clear ();
 	Application::DoDispose ();
 }
 
@@ -255,6 +328,7 @@ ohSamServer::DoDispose (void)
 void ohSamServer::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void ohSamServer::HandlePeerError (Ptr<Socket> socket)
@@ -286,6 +360,7 @@ void ohSamServer::HandleAccept (Ptr<Socket> s, const Address& from)
 
 	if( !isServer )
 	{
+		m_clntSlot.insert (std::make_pair (InetSocketAddress::ConvertFrom (from).GetIpv4 ().Get (), m_clntAddress.size ()));
 		m_clntAddress.push_back(std::make_pair(from, s));
 		//m_clntSocket.push_back(s);
 		m_numClients++;
@@ -293,7 +368,6 @@ void ohSamServer::HandleAccept (Ptr<Socket> s, const Address& from)
 		m_operations.resize(m_numClients);
 		m_relays.resize(m_numClients);
 
-		std::sort(m_clntAddress.begin(), m_clntAddress.end());
 
 		if (m_verbose)
 		{
@@ -314,9 +388,7 @@ void ohSamServer::HandleAccept (Ptr<Socket> s, const Address& from)
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "ACCEPTED SERVER " << serverId << ": " << InetSocketAddress::ConvertFrom(from).GetIpv4();
-			LogInfo(sstm);
+			AM_LOG_INFO ("ACCEPTED SERVER " << serverId << ": " << InetSocketAddress::ConvertFrom(from).GetIpv4());
 		}
 	}
 }
@@ -326,14 +398,12 @@ void ohSamServer::HandleAccept (Ptr<Socket> s, const Address& from)
    NS_LOG_FUNCTION (this << socket);
    Address from;
    socket->GetPeerName (from);
-   std::stringstream sstm;
 
    m_serversConnected++;
 
    if (m_verbose)
    {
-	   sstm << "Connected to NODE (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	   LogInfo(sstm);
+	   AM_LOG_INFO ("Connected to NODE (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
    }
 
    // Check if connected to the all the servers start operations
@@ -342,9 +412,7 @@ void ohSamServer::HandleAccept (Ptr<Socket> s, const Address& from)
    {
 	   if (m_verbose)
 	   {
-		   AsmCommon::Reset(sstm);
-		   sstm << "Connected to all Nodes.";
-		   LogInfo(sstm);
+		   AM_LOG_INFO ("Connected to all Nodes.");
 	   }
    }
  }
@@ -355,28 +423,41 @@ void ohSamServer::HandleAccept (Ptr<Socket> s, const Address& from)
  }
 
 /**************************************************************************************
- * PACKET DATA Handler
+ * ohSam Rcv Handler
  **************************************************************************************/
 void
-ohSamServer::SetFill (std::string fill)
+ohSamServer::SetFault (AmServiceQueue::Fault fault)
 {
-  NS_LOG_FUNCTION (this << fill);
+	NS_LOG_FUNCTION (this << fault);
+	m_service.SetFault (fault);
+}
 
-  uint32_t dataSize = fill.size () + 1;
+AmServiceQueue::Fault
+ohSamServer::GetFault (void) const
+{
+	return m_service.GetFault ();
+}
 
-  if (dataSize != m_dataSize) 
-    {
-      m_data = new uint8_t [dataSize];
-      m_dataSize = dataSize;
-    }
+uint32_t
+ohSamServer::GetServiceItems (const AmProtocolHeader &hdr) const
+{
+	// the reads of the clients are relayed to every server
+	return (hdr.GetType () == READ)? m_serverAddress.size () : 0;
+}
 
-  memcpy (m_data, fill.c_str (), dataSize);
-  m_size = dataSize;
+void
+ohSamServer::SetSlowdown (Time delay)
+{
+	NS_LOG_FUNCTION (this << delay);
+	m_service.SetSlowdown (delay);
+}
+
+Time
+ohSamServer::GetSlowdown (void) const
+{
+	return m_service.GetSlowdown ();
 }
 
-/**************************************************************************************
- * ohSam Rcv Handler
- **************************************************************************************/
 void 
 ohSamServer::HandleRead (Ptr<Socket> socket)
 {
@@ -384,22 +465,17 @@ ohSamServer::HandleRead (Ptr<Socket> socket)
 
 	Ptr<Packet> packet;
 	Address from;
-	uint32_t msgT;
-	std::stringstream sstm;
+	AmProtocolHeader hdr;
 	std::string message_type = "";
 
 
-	while ((packet = socket->RecvFrom (from)))
+	while ((packet = m_service.Recv (m_framer, socket, from)))
 	{
 
 		//deserialize the contents of the packet
-		uint8_t buf[1024];
-		packet->CopyData(buf,1024);
-		std::stringbuf sb;
-		sb.str(std::string((char*) buf));
-		std::istream istm(&sb);
-
-		istm >> msgT;
+		packet->RemoveHeader (hdr);
+		uint32_t sent = m_sent;
+		MessageType msgT = hdr.GetType ();
 
 
 		if (msgT==WRITE){
@@ -412,51 +488,52 @@ ohSamServer::HandleRead (Ptr<Socket> socket)
 		
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
+			AM_LOG_INFO ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-			LogInfo(sstm);
+					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 		}
 
 		if ( msgT == WRITE || msgT == READ )
 		{
-			HandleRecvMsg(istm, socket, (MessageType) msgT);
+			HandleRecvMsg(hdr, packet, socket, msgT);
 		}
 		else if ( msgT == READRELAY)
 		{
-			HandleRelay(istm, socket);
+			HandleRelay(hdr, packet, socket);
 		}
 		else
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Invalid message type! Message from " << InetSocketAddress::ConvertFrom (from).GetIpv4 () << " dropped.";
-			LogInfo(sstm );
+			AM_LOG_INFO ("Invalid message type! Message from " << InetSocketAddress::ConvertFrom (from).GetIpv4 () << " dropped.");
 		}
+
+		m_handledTrace (msgT, m_sent - sent);
 	}
 }
 
+int
+ohSamServer::FindClient (Ipv4Address ip) const
+{
+	std::unordered_map<uint32_t, uint32_t>::const_iterator it = m_clntSlot.find (ip.Get ());
+	if (it == m_clntSlot.end ())
+	{
+		return -1;
+	}
+	return it->second;
+}
+
 void
-ohSamServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType msgT)
+ohSamServer::HandleRecvMsg(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket, MessageType msgT)
 {
 	Address from;
-	uint32_t msgTs, msgV, msgOp;
 	int msgSenderID = -1;
-	std::stringstream sstm;
 	std::string message_response_type = "";
-	std::stringstream pkts;
 
 	socket->GetPeerName(from);
 
-	//find if the socket that client is connected to
-	for (uint32_t i=0; i < m_clntAddress.size(); i++)
-	{
-		if ( InetSocketAddress::ConvertFrom(from).GetIpv4() == InetSocketAddress::ConvertFrom(m_clntAddress[i].first).GetIpv4() )
-		{
-			msgSenderID = i;
-			break;	//stop at the first client we find
-		}
-	}
+	Register &reg = m_registers.Get (hdr.GetKey ());
+
+	//find the client that sent the message
+	msgSenderID = FindClient (InetSocketAddress::ConvertFrom(from).GetIpv4());
 
 
 	// if not sender detected - drop the package
@@ -466,32 +543,24 @@ ohSamServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 		//// CASE WRITE
 		if (msgT==WRITE){
 
-			istm >> msgTs >> msgV;
-
-			if (m_ts < msgTs)
+			if (reg.ts < hdr.GetTs ())
 			{
 				NS_LOG_LOGIC ("Updating Local Info");
 
-				m_ts = msgTs;
-				m_value = msgV;
+				reg.ts = hdr.GetTs ();
+				reg.value = hdr.GetValue ();
+				reg.payload = payload;
 				message_response_type = "writeAck";
 			}
 
-			AsmCommon::Reset(pkts);
-			pkts << WRITEACK << " " << m_ts << " " << m_value;
-			SetFill(pkts.str());
+			AmProtocolHeader reply;
 
-			Ptr<Packet> p;
-			if (m_dataSize)
-			{
-				NS_ASSERT_MSG (m_dataSize == m_size, "ohSamServer::HandleSend(): m_size and m_dataSize inconsistent");
-				NS_ASSERT_MSG (m_data, "ohSamServer::HandleSend(): m_dataSize but no m_data");
-				p = Create<Packet> (m_data, m_dataSize);
-			}
-			else
-			{
-				p = Create<Packet> (m_size);
-			}
+			reply.SetKey (hdr.GetKey ());
+			reply.SetType (WRITEACK);
+			reply.SetTs (reg.ts);
+			reply.SetValue (reg.value);
+
+			Ptr<Packet> p = m_framer.Build (reply);
 
 
 			socket->Send (p);
@@ -499,19 +568,14 @@ ohSamServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Sent "<< message_response_type <<" " << p->GetSize () << " bytes to " <<
+				AM_LOG_INFO ("Sent "<< message_response_type <<" " << p->GetSize () << " bytes to " <<
 						InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-						InetSocketAddress::ConvertFrom (from).GetPort ();
-				LogInfo(sstm);
+						InetSocketAddress::ConvertFrom (from).GetPort ());
 			}
 
-			p->RemoveAllPacketTags ();
-			p->RemoveAllByteTags ();
 		}
 		else if (msgT == READ)
 		{
-			istm >> msgOp;
 
 			message_response_type = "readRelay";
 
@@ -519,24 +583,16 @@ ohSamServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 			uint8_t ipBuffer[ipSize];
 			from.CopyTo(ipBuffer);
 
-			AsmCommon::Reset(pkts);
-
-			//pkts << READRELAY << " " << m_ts << " " << m_value << " " << ipSize << " " << InetSocketAddress::ConvertFrom(from).GetIpv4().Get() << " " << msgOp;
-			pkts << READRELAY << " " << m_ts << " " << m_value << " " << msgSenderID << " " << msgOp;
-
-			SetFill(pkts.str());
+			// <msgType, <ts,v>, q, counter>
+			AmProtocolHeader relay;
+			relay.SetKey (hdr.GetKey ());
+			relay.SetType (READRELAY);
+			relay.SetTs (reg.ts);
+			relay.SetValue (reg.value);
+			relay.SetSender (InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4().Get());
+			relay.SetCounter (hdr.GetCounter ());
 
-			Ptr<Packet> pc;
-			if (m_dataSize)
-			{
-				NS_ASSERT_MSG (m_dataSize == m_size, "ohSamServer::HandleSend(): m_size and m_dataSize inconsistent");
-				NS_ASSERT_MSG (m_data, "ohSamServer::HandleSend(): m_dataSize but no m_data");
-				pc = Create<Packet> (m_data, m_dataSize);
-			}
-			else
-			{
-				pc = Create<Packet> (m_size);
-			}
+			Ptr<Packet> pc = m_framer.Build (relay, reg.payload);
 
 			//pc->RemoveAllPacketTags ();
 			//pc->RemoveAllByteTags ();
@@ -548,20 +604,16 @@ ohSamServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 
 				if (m_verbose)
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Sending ReadRelay to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << ", Read from: " << InetSocketAddress::ConvertFrom(from).GetIpv4();
-					LogInfo ( sstm );
+					AM_LOG_INFO ("Sending ReadRelay to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << ", Read from: " << InetSocketAddress::ConvertFrom(from).GetIpv4());
 				}
 
 				if (m_serverAddress[i] != m_myAddress)
 				{
-					m_srvSocket[i]->Send(pc);
+					m_relayBatcher.Send (m_srvSocket[i], pc);
 
 					if (m_verbose)
 					{
-						AsmCommon::Reset(sstm);
-						sstm << "Sent "<< message_response_type << " " << pc->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << " data " << pkts.str();
-						LogInfo ( sstm );
+						AM_LOG_INFO ("Sent "<< message_response_type << " " << pc->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[i]) << " data " << relay);
 					}
 				}
 			}
@@ -571,29 +623,26 @@ ohSamServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType m
 }
 
 void
-ohSamServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
+ohSamServer::HandleRelay(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket)
 {
-	uint32_t msgT, msgTs, msgV, msgOp; //, msgIpSize;
-	int msgSenderID = -1;
+	uint32_t msgTs = hdr.GetTs ();
+	uint32_t msgV = hdr.GetValue ();
+	uint32_t msgOp = hdr.GetCounter ();
+	int msgSenderID = FindClient (Ipv4Address (hdr.GetSender ()));
 	//Address senderIp;
 	//std::uint32_t msgSenderIp;
-	std::stringstream sstm;
 	std::string message_type = "";
 	std::string message_response_type = "";
-	std::stringstream pkts;
 	Address from;
 
 	socket->GetPeerName(from);
 
-	//istm >> msgTs >> msgV >> msgIpSize >> msgSenderIp >> msgOp;
-	istm >> msgTs >> msgV >> msgSenderID >> msgOp;
+	Register &reg = m_registers.Get (hdr.GetKey ());
 
 	/*
 	if ( msgSenderIp <= 0 )
 	{
-		AsmCommon::Reset(sstm);
-		sstm << "Invalid Ip: " << msgSenderIp;
-		LogInfo(sstm );
+		AM_LOG_INFO ("Invalid Ip: " << msgSenderIp);
 
 		return;
 	}
@@ -613,22 +662,21 @@ ohSamServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
 
 	if (m_verbose)
 	{
-		AsmCommon::Reset(sstm);
-		sstm << "Processing ReadRelay from " << InetSocketAddress::ConvertFrom(from).GetIpv4() <<": InitiatorIp= "
-				<< InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4() << " InitiatorID=" << msgSenderID << ", msgOp=" << msgOp;
 		//<< ", relayTs=" << m_relayTs[msgSenderID] << ", msgTs=" << msgTs << ", #RelaysRcved=" << m_relays[msgSenderID];
-		LogInfo(sstm );
+		AM_LOG_INFO ("Processing ReadRelay from " << InetSocketAddress::ConvertFrom(from).GetIpv4() <<": InitiatorIp= "
+				<< InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4() << " InitiatorID=" << msgSenderID << ", msgOp=" << msgOp);
 	}
 
 	if ( msgSenderID >= 0 && msgSenderID < (int) m_clntAddress.size() )
 	{
 
-		if (m_ts < msgTs)
+		if (reg.ts < msgTs)
 		{
 			NS_LOG_LOGIC ("Updating Local Info");
 
-			m_ts = msgTs;
-			m_value = msgV;
+			reg.ts = msgTs;
+			reg.value = msgV;
+			reg.payload = payload;
 		}
 
 		if (m_operations[msgSenderID] < msgOp)
@@ -644,31 +692,21 @@ ohSamServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Relays: " << m_relays[msgSenderID] << " Need:" << (m_numServers - m_fail) << ", RelayOp: " << m_operations[msgSenderID];
-			LogInfo(sstm );
+			AM_LOG_INFO ("Relays: " << m_relays[msgSenderID] << " Need:" << (m_numServers - m_fail) << ", RelayOp: " << m_operations[msgSenderID]);
 		}
 
 		if (m_relays[msgSenderID] == (m_numServers - m_fail))
 		{
 			// REPLY back to the reader
 			message_response_type = "readAck";
-			msgT = READACK;
-			AsmCommon::Reset(pkts);
-			pkts << msgT << " " << m_ts << " " << m_value << " " << msgOp;
-			SetFill(pkts.str());
+			AmProtocolHeader reply;
+			reply.SetKey (hdr.GetKey ());
+			reply.SetType (READACK);
+			reply.SetTs (reg.ts);
+			reply.SetValue (reg.value);
+			reply.SetCounter (msgOp);
 
-			Ptr<Packet> pk;
-			if (m_dataSize)
-			{
-				NS_ASSERT_MSG (m_dataSize == m_size, "ohSamServer::HandleSend(): m_size and m_dataSize inconsistent");
-				NS_ASSERT_MSG (m_data, "ohSamServer::HandleSend(): m_dataSize but no m_data");
-				pk = Create<Packet> (m_data, m_dataSize);
-			}
-			else
-			{
-				pk = Create<Packet> (m_size);
-			}
+			Ptr<Packet> pk = m_framer.Build (reply, reg.payload);
 
 			//Send to the corresponding client (from the info of the message is msgSenderId)
 			(m_clntAddress[msgSenderID].second)->Send(pk);
@@ -676,9 +714,7 @@ ohSamServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
 
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Sent " << message_response_type <<" "<< pk->GetSize () << " bytes to " << InetSocketAddress::ConvertFrom (m_clntAddress[msgSenderID].first).GetIpv4() << " data " << pkts.str();
-				LogInfo ( sstm );
+				AM_LOG_INFO ("Sent " << message_response_type <<" "<< pk->GetSize () << " bytes to " << InetSocketAddress::ConvertFrom (m_clntAddress[msgSenderID].first).GetIpv4() << " data " << reply);
 			}
 
 			//pk->RemoveAllPacketTags ();
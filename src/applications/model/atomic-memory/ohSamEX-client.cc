@@ -29,12 +29,18 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
 #include "ohSamEX-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <string>
 #include <cstdlib>
 #include <iostream>
 #include <ctime>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -97,7 +103,7 @@ ohSamEXClient::GetTypeId (void)
 					UintegerValue (9),
 					MakeUintegerAccessor (&ohSamEXClient::m_port),
 					MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&ohSamEXClient::SetDataSize,
                                          &ohSamEXClient::GetDataSize),
@@ -105,6 +111,9 @@ ohSamEXClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&ohSamEXClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&ohSamEXClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -130,6 +139,39 @@ ohSamEXClient::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&ohSamEXClient::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&ohSamEXClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&ohSamEXClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&ohSamEXClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&ohSamEXClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&ohSamEXClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&ohSamEXClient::m_traceFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -141,7 +183,6 @@ ohSamEXClient::ohSamEXClient ()
 {
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -188,7 +229,32 @@ ohSamEXClient::StartApplication (void)
 {
 
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
+
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&ohSamEXClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&ohSamEXClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	m_workload.SetMaxInFlight (1);
 
 	// seed pseudo-randomness
 	srand(m_seed);
@@ -236,9 +302,7 @@ ohSamEXClient::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				LogInfo(sstm);
+				AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -258,10 +322,28 @@ ohSamEXClient::StartApplication (void)
 	}
 
 	
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
+
+}
 
+AmClientStats
+ohSamEXClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_completeOps;
+	if (m_prType == READER)
+	{
+		stats.slowReads = m_slowOpCount;
+		stats.fastReads = m_fastOpCount;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
 }
 
 void 
@@ -269,8 +351,6 @@ ohSamEXClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
   if (m_insocket != 0)
 	{
 		m_insocket->Close ();
@@ -301,28 +381,24 @@ ohSamEXClient::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_completeOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-	  sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_completeOps <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
   
-  if(m_personalID==m_numClients-1){
-  	exit(0);
-  }
-
-  Simulator::Cancel (m_sendEvent);
+  m_workload.Stop ();
 }
 
 void
 ohSamEXClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
   Application::DoDispose ();
 }
 
@@ -332,6 +408,7 @@ ohSamEXClient::DoDispose (void)
 void ohSamEXClient::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void ohSamEXClient::HandlePeerError (Ptr<Socket> socket)
@@ -359,24 +436,20 @@ void ohSamEXClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
 void ohSamEXClient::ConnectionFailed (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
-  std::stringstream sstm;
-  sstm << "Connection to SERVER Failed.";
-  LogInfo(sstm);
+  AM_LOG_INFO ("Connection to SERVER Failed.");
 }
 
 /**************************************************************************************
@@ -394,6 +467,14 @@ ohSamEXClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+ohSamEXClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  return streams + m_keys.AssignStreams (stream + streams);
+}
+
 void
 ohSamEXClient::SetRemote (Address ip, uint16_t port)
 {
@@ -437,57 +518,46 @@ ohSamEXClient::SetFill (std::string fill)
 
   if (dataSize != m_dataSize)
     {
+      delete [] m_data;
       m_data = new uint8_t [dataSize];
       m_dataSize = dataSize;
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
-  m_size = dataSize;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-ohSamEXClient::ScheduleOperation (Time dt)
+/**************************************************************************************
+ * ohSamEX Read/Write Handlers
+ **************************************************************************************/
+void
+ohSamEXClient::SelectKey (void)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this);
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+	// park the state of the current key and load the one of the next key
+	Register &reg = m_registers.Get (m_key);
+	reg.ts = m_ts;
+	reg.value = m_value;
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	m_key = m_keys.GetNext ();
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &ohSamEXClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &ohSamEXClient::InvokeWrite, this);
-  }
+	Register &next = m_registers.Get (m_key);
+	m_ts = next.ts;
+	m_value = next.value;
 }
 
-/**************************************************************************************
- * ohSamEX Read/Write Handlers
- **************************************************************************************/
 void
 ohSamEXClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 	m_opStart = Now();
 	m_real_start = std::chrono::system_clock::now();
 
 	//check if we still have operations to perfrom
 	if ( m_opCount <  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
@@ -504,9 +574,7 @@ ohSamEXClient::InvokeRead (void)
 
 		//Send msg to all
 		m_replies = 0;		//reset replies
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_personalID << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
 	}
 }
@@ -515,7 +583,6 @@ void
 ohSamEXClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -525,16 +592,17 @@ ohSamEXClient::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
 		m_opStatus = PHASE1;
 		m_msgType = WRITE;
 		m_ts ++;
 
 		m_value = m_opCount + 900;
+		m_payload = Create<Packet> (m_size);
 		m_replies = 0;
 
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		LogInfo(sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		HandleSend();
 	}
 }
@@ -544,40 +612,28 @@ ohSamEXClient::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT (m_sendEvent.IsExpired ());
-
-  
   // Prepare packet content
-  std::stringstream pkts;
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
   std::string message_type;
-  
-  AsmCommon::Reset(pkts);
+
   // Serialize the appropriate message for READ or WRITE
   if ( m_msgType == WRITE )
   	{
-  		pkts << WRITE << " " << m_ts << " " << m_value;
+  		hdr.SetType (WRITE);
+  		hdr.SetTs (m_ts);
+  		hdr.SetValue (m_value);
   		message_type = "write";
 	}
   else 
     {
-		pkts << READ << " "<< m_opCount;
+		hdr.SetType (READ);
+		hdr.SetCounter (m_opCount);
 		message_type = "read";
     }
 
-  SetFill(pkts.str());
-
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "ohSamEXClient::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "ohSamEXClient::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // Create packet, the writes carry the bytes of the value
+  Ptr<Packet> p = m_framer.Build (hdr, m_msgType == WRITE ? m_payload : 0);
 
 
   //random server to start from
@@ -592,10 +648,8 @@ ohSamEXClient::HandleSend (void)
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
-		  << " port " << m_peerPort << " data " << pkts.str();
-		  LogInfo ( sstm );
+		  AM_LOG_INFO ("Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
+		  << " port " << m_peerPort << " data " << hdr);
 	  }
 
       // move to the next server
@@ -612,60 +666,53 @@ ohSamEXClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  uint32_t msgT, msgTs, msgV, msgOp, msgInit;
+  AmProtocolHeader hdr;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
 	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgT;
-	  std::stringstream sstm;
+	  packet->RemoveHeader (hdr);
+	  MessageType msgT = hdr.GetType ();
+	  uint32_t msgTs = hdr.GetTs ();
+	  uint32_t msgV = hdr.GetValue ();
+	  uint32_t msgOp = hdr.GetCounter ();
 	  std::string message_type;
 
 	  if (msgT==READACK)
 	  {
 			message_type = "readAck";
-			istm >> msgTs >> msgV >> msgOp;
 	  }
 	  else if (msgT==WRITEACK)
 	  {
 			message_type = "writeAck";
-			istm >> msgTs >> msgV;
 	  }
 	  //EX: now client gets back also read Relays
 	  else if (msgT==READRELAY)
 	  {
 			message_type = "readrelay";
-			istm >> msgTs >> msgV >> msgInit >> msgOp;
 	  }
 	 
 
 	  if (m_verbose)
 	  {
-		  sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
+		  AM_LOG_INFO ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << buf;
-		  LogInfo (sstm);
+				  InetSocketAddress::ConvertFrom (from).GetPort () << ", msgOp = " << msgOp <<", opCount = " << m_opCount << " data " << hdr);
 	  }
 
       // check message freshness and if client is waiting
       if ((msgOp == m_opCount) && (msgT==READACK) && (m_opStatus != IDLE))
        {
-    		ProcessReply(msgT, msgTs, msgV);
+    		ProcessReply(msgT, msgTs, msgV, packet);
        }
        else if ((msgTs == m_ts) && (msgT==WRITEACK) && (m_opStatus != IDLE))
        {
-       		ProcessReply(msgT, msgTs, msgV);
+       		ProcessReply(msgT, msgTs, msgV, packet);
        }
        else if ((msgOp == m_opCount) && (msgT==READRELAY) && (m_opStatus != IDLE))
        {
-       		sstm << "Received fresh Relay.";
-		 	LogInfo (sstm);
-		 	ProcessReply(msgT, msgTs, msgV);
+		 	AM_LOG_INFO ("Received fresh Relay.");
+		 	ProcessReply(msgT, msgTs, msgV, packet);
 		 	//For every diff timestamp i receive i need to have 
 		 	//a counter. How many different timestamps i can have? s/2 floor.
 		 	// 
@@ -675,12 +722,10 @@ ohSamEXClient::HandleRecv (Ptr<Socket> socket)
 }
 
 void
-ohSamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
+ohSamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val, Ptr<Packet> payload)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-
 	
 
 	if (m_prType == WRITER)
@@ -695,16 +740,15 @@ ohSamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 		{
 			m_completeOps++;
 			m_opStatus = IDLE;
-			ScheduleOperation (m_interval);
+			m_workload.OperationCompleted ();
 			m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 
 			m_opEnd = Now();
 			m_opAve += m_opEnd - m_opStart;
+			m_opCompletedTrace (WRITE, 2, m_opEnd - m_opStart, m_ts, m_key, 0);
 			m_real_opAve += elapsed_seconds;  //
-			AsmCommon::Reset(sstm);
-			sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **";
-			LogInfo(sstm);
+			AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **");
 			m_replies = 0;
 		}
 	}
@@ -761,15 +805,14 @@ ohSamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 
       			m_opEnd = Now();
       			m_opAve += m_opEnd - m_opStart;
+      			m_opCompletedTrace (READ, 2, m_opEnd - m_opStart, return_timestamp, m_key, 0);
       			m_real_end = std::chrono::system_clock::now();
 				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 				m_real_opAve += elapsed_seconds;  //
 
    				m_opStatus = IDLE;
-				ScheduleOperation (m_interval);
-      			AsmCommon::Reset(sstm);
-				sstm << "** FAST READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << return_timestamp << "," << return_value << ">] - @ 2 EXCH **";
-				LogInfo(sstm);
+				m_workload.OperationCompleted ();
+				AM_LOG_INFO ("** FAST READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << return_timestamp << "," << return_value << ">] - @ 2 EXCH **");
 			}
 		}
 		else if (type == READACK && m_done==0)
@@ -781,6 +824,7 @@ ohSamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
    			{
       			m_MINts = ts;
 				m_MINvalue = val;
+				m_MINpayload = payload;
       		}
 		
       		if (m_replies >= (m_numServers - m_fail))
@@ -793,15 +837,14 @@ ohSamEXClient::ProcessReply(uint32_t type, uint32_t ts, uint32_t val)
 
       			m_opEnd = Now();
       			m_opAve += m_opEnd - m_opStart;
+      			m_opCompletedTrace (READ, 3, m_opEnd - m_opStart, m_MINts, m_key, 0);
       			m_real_end = std::chrono::system_clock::now();
 				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 				m_real_opAve += elapsed_seconds;  //
 
    				m_opStatus = IDLE;
-				ScheduleOperation (m_interval);
-      			AsmCommon::Reset(sstm);
-				sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << m_MINts << "," << m_MINvalue << ">] - @ 3 EXCH **";
-				LogInfo(sstm);
+				m_workload.OperationCompleted ();
+				AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), [<ts,value>]: [<" << m_MINts << "," << m_MINvalue << ">] - @ 3 EXCH **");
 				m_replies =0;
 			}
 		}
@@ -29,8 +29,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
 #include "ohfast-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <string>
 #include <cstdlib>
 #include <iostream>
@@ -50,16 +55,15 @@ NS_OBJECT_ENSURE_REGISTERED (OhFastClient);
 
 
 void
-OhFastClient::Log(logLevel_t l, std::stringstream& s)
+OhFastClient::LogInfo(std::stringstream& s)
 {
-	if ( l == INFO )
-	{
-		NS_LOG_INFO("[CLIENT " << m_personalID << " - "<< Ipv4Address::ConvertFrom(m_myAddress) << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
-	}
-	else
-	{
-		NS_LOG_DEBUG("[CLIENT " << m_personalID << " - "<< Ipv4Address::ConvertFrom(m_myAddress) << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
-	}
+	NS_LOG_INFO("[CLIENT " << m_personalID << " - "<< Ipv4Address::ConvertFrom(m_myAddress) << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
+}
+
+void
+OhFastClient::LogDebug(std::stringstream& s)
+{
+	NS_LOG_DEBUG("[CLIENT " << m_personalID << " - "<< Ipv4Address::ConvertFrom(m_myAddress) << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
 }
 
 TypeId
@@ -108,7 +112,7 @@ OhFastClient::GetTypeId (void)
 					UintegerValue (9),
 					MakeUintegerAccessor (&OhFastClient::m_port),
 					MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&OhFastClient::SetDataSize,
                                          &OhFastClient::GetDataSize),
@@ -116,6 +120,9 @@ OhFastClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&OhFastClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&OhFastClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -141,6 +148,39 @@ OhFastClient::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&OhFastClient::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&OhFastClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&OhFastClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&OhFastClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&OhFastClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&OhFastClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&OhFastClient::m_traceFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -152,7 +192,6 @@ OhFastClient::OhFastClient ()
 {
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -193,7 +232,32 @@ OhFastClient::StartApplication (void)
 {
 
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
+
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&OhFastClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&OhFastClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	m_workload.SetMaxInFlight (1);
 
 	// seed pseudo-randomness
 	srand(m_seed);
@@ -241,9 +305,7 @@ OhFastClient::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				Log(DEBUG, sstm);
+				AM_LOG_DEBUG ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -263,19 +325,35 @@ OhFastClient::StartApplication (void)
 	}
 
 	
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose;
-	Log(DEBUG, sstm);
+	AM_LOG_DEBUG ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << ", opInt=" << m_interval << ",debug="<<m_verbose);
 
 }
 
+AmClientStats
+OhFastClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_slowOpCount+m_fastOpCount;
+	if (m_prType == READER)
+	{
+		stats.slowReads = m_slowOpCount;
+		stats.fastReads = m_fastOpCount;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
+}
+
 void 
 OhFastClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
   if (m_insocket != 0)
 	{
 		m_insocket->Close ();
@@ -304,23 +382,17 @@ OhFastClient::StopApplication ()
   switch(m_prType)
   {
   case WRITER:
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_slowOpCount+m_fastOpCount <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_slowOpCount+m_fastOpCount <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  Log( INFO, sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_slowOpCount+m_fastOpCount <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
-	  sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_slowOpCount+m_fastOpCount <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_slowOpCount+m_fastOpCount <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  Log( INFO, sstm);
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_slowOpCount+m_fastOpCount <<", #3EXCH_reads="<< m_slowOpCount << ", #2EXCH_reads="<<m_fastOpCount<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
   
-  if(m_personalID==m_numClients-1){
-  	exit(0);
-  }
-  	
 
-  Simulator::Cancel (m_sendEvent);
+  m_workload.Stop ();
 }
 
 void
@@ -328,6 +400,8 @@ OhFastClient::DoDispose (void)
 {
   
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
   Application::DoDispose ();
 }
 
@@ -337,6 +411,7 @@ OhFastClient::DoDispose (void)
 void OhFastClient::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void OhFastClient::HandlePeerError (Ptr<Socket> socket)
@@ -364,24 +439,20 @@ void OhFastClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  Log(DEBUG, sstm);
+	  AM_LOG_DEBUG ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
 void OhFastClient::ConnectionFailed (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
-  std::stringstream sstm;
-  sstm << "Connection to SERVER Failed.";
-  Log( INFO, sstm);
+  AM_LOG_INFO ("Connection to SERVER Failed.");
 }
 
 /**************************************************************************************
@@ -399,6 +470,14 @@ OhFastClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+OhFastClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  return streams + m_keys.AssignStreams (stream + streams);
+}
+
 void
 OhFastClient::SetRemote (Address ip, uint16_t port)
 {
@@ -442,51 +521,42 @@ OhFastClient::SetFill (std::string fill)
 
   if (dataSize != m_dataSize)
     {
+      delete [] m_data;
       m_data = new uint8_t [dataSize];
       m_dataSize = dataSize;
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
-  m_size = dataSize;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-OhFastClient::ScheduleOperation (Time dt)
+/**************************************************************************************
+ * OhFast Read/Write Handlers
+ **************************************************************************************/
+void
+OhFastClient::SelectKey (void)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this);
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+	// park the state of the current key and load the one of the next key
+	Register &reg = m_registers.Get (m_key);
+	reg.ts = m_ts;
+	reg.value = m_value;
+	reg.pvalue = m_pvalue;
+	reg.payload = m_payload;
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  Log( INFO, sstm);
+	m_key = m_keys.GetNext ();
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &OhFastClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &OhFastClient::InvokeWrite, this);
-  }
+	Register &next = m_registers.Get (m_key);
+	m_ts = next.ts;
+	m_value = next.value;
+	m_pvalue = next.pvalue;
+	m_payload = next.payload;
 }
 
-/**************************************************************************************
- * OhFast Read/Write Handlers
- **************************************************************************************/
 void
 OhFastClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opStart = Now();
 	m_real_start = std::chrono::system_clock::now();
@@ -494,6 +564,8 @@ OhFastClient::InvokeRead (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
@@ -503,9 +575,7 @@ OhFastClient::InvokeRead (void)
 		m_initiator = false;
 		m_isTsSecured = false;
 
-		AsmCommon::Reset(sstm);
-		sstm << "** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		Log( INFO, sstm);
+		AM_LOG_INFO ("** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		//Send msg to all
 		m_replies = 0;		//reset replies
 		HandleSend();
@@ -516,7 +586,6 @@ void
 OhFastClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	
 	m_opStart = Now();
@@ -527,16 +596,18 @@ OhFastClient::InvokeWrite (void)
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
 		m_opStatus = PHASE1;
 		m_msgType = WRITE;
 		m_ts ++;
 		m_opCount ++;
 		
-		AsmCommon::Reset(sstm);
-		sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-		Log( INFO, sstm);
+		AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 		m_pvalue = m_value;
 		m_value = m_opCount + 900;
+		// the new value and the previous one, which is none before the first write
+		m_payload = Create<Packet> (m_ts > 1 ? 2 * m_size : m_size);
 		m_replies = 0;
 		HandleSend();
 	}
@@ -547,41 +618,32 @@ OhFastClient::HandleSend (void)
 {
 	NS_LOG_FUNCTION (this);
 
-	NS_ASSERT (m_sendEvent.IsExpired ());
-
-
 	// Prepare packet content
-	std::stringstream pkts;
+	AmProtocolHeader hdr;
+	hdr.SetKey (m_key);
+	hdr.SetType (m_msgType);
+	hdr.SetCounter (m_opCount);
+	hdr.SetTs (m_ts);
+	hdr.SetValue (m_value);
+	hdr.SetPvalue (m_pvalue);
 	std::string message_type;
 
 	// Serialize the appropriate message for READ or WRITE
 	if (m_prType == WRITER)
 	{
 		// serialize <msgType, ts, value, pvalue, counter>
-		pkts << m_msgType << " " << m_ts << " " << m_value << " " << m_pvalue << " " << m_opCount;
 		message_type = "write";
 	}
 	else
 	{
 		// serialize <msgType, ts, value, pvalue, readerID, counter>
-		pkts << m_msgType << " " << m_ts << " " << m_value << " " << m_pvalue << " "<< m_personalID << " "<< m_opCount;
+		hdr.SetSender (m_personalID);
 		message_type = "read";
 	}
 
-	SetFill(pkts.str());
-
-	// Create packet
-	Ptr<Packet> p;
-	if (m_dataSize)
-	{
-		NS_ASSERT_MSG (m_dataSize == m_size, "OhFastClient::HandleSend(): m_size and m_dataSize inconsistent");
-		NS_ASSERT_MSG (m_data, "OhFastClient::HandleSend(): m_dataSize but no m_data");
-		p = Create<Packet> (m_data, m_dataSize);
-	}
-	else
-	{
-		p = Create<Packet> (m_size);
-	}
+	// Create packet, all but the queries of the readers carry the bytes
+	// of the value and previous value
+	Ptr<Packet> p = m_framer.Build (hdr, m_msgType == READ ? 0 : m_payload);
 
 	p->RemoveAllPacketTags ();
 	p->RemoveAllByteTags ();
@@ -598,10 +660,8 @@ OhFastClient::HandleSend (void)
 
 		if (m_verbose)
 		{
-			std::stringstream sstm;
-            sstm << "Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
-			<< " port " << m_peerPort << " data " << pkts.str();
-			Log(DEBUG,  sstm );
+			AM_LOG_DEBUG ("Sent " << message_type <<" "<< p->GetSize() << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current])
+			<< " port " << m_peerPort << " data " << hdr);
 		}
 
         // move to the next server
@@ -616,22 +676,16 @@ OhFastClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  uint32_t msgT, msgC;
+  AmProtocolHeader hdr;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
     {
 	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgC >> msgT;
-
-	  std::stringstream sstm;
+	  packet->RemoveHeader (hdr);
+
 	  std::string message_type;
 
-	  if (msgT==READACK)
+	  if (hdr.GetType () == READACK)
 	  {
 			message_type = "readAck";
 			//istm >> msgTs >> msgV >> msgOp;
@@ -645,30 +699,31 @@ OhFastClient::HandleRecv (Ptr<Socket> socket)
 
 	  if (m_verbose)
 	  {
-		  sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
+		  AM_LOG_DEBUG ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-		  Log(DEBUG, sstm);
+				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 	  }
 
       // check message freshness and if client is waiting
-      if ((msgC == m_opCount) && (m_opStatus != IDLE))
+      if ((hdr.GetCounter () == m_opCount) && (m_opStatus != IDLE))
        {
-    		ProcessReply(istm, from);
+    		ProcessReply(hdr, packet, from);
        }
     
     }
 }
 
 void
-OhFastClient::ProcessReply(std::istream& istm, Address sender)
+OhFastClient::ProcessReply(const AmProtocolHeader& hdr, Ptr<Packet> payload, Address sender)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-	uint32_t msgTs, msgV, msgVp, msgViews, msgTsSecured, msgInit;
-
-	istm >> msgTs >> msgV >> msgVp >> msgViews >> msgTsSecured >> msgInit;
+	uint32_t msgTs = hdr.GetTs ();
+	uint32_t msgV = hdr.GetValue ();
+	uint32_t msgVp = hdr.GetPvalue ();
+	uint32_t msgViews = hdr.GetViews ();
+	bool msgTsSecured = hdr.IsSecured ();
+	bool msgInit = hdr.IsInitiator ();
 
 	//increment the number of replies received
 	m_replies ++;
@@ -682,17 +737,16 @@ OhFastClient::ProcessReply(std::istream& istm, Address sender)
 		if (m_replies >= (m_numServers - m_fail))
 		{
 			m_opStatus = IDLE;
-			ScheduleOperation (m_interval);
+			m_workload.OperationCompleted ();
 
 			m_opEnd = Now();
 			m_opAve += m_opEnd - m_opStart;
+			m_opCompletedTrace (WRITE, 2, m_opEnd - m_opStart, m_ts, m_key, 0);
 			m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
 			m_real_opAve += elapsed_seconds;  //
 
-			AsmCommon::Reset(sstm);
-			sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **";
-			Log( INFO, sstm);
+			AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **");
 			m_fastOpCount++;
 			m_replies = 0;
 		}
@@ -709,12 +763,11 @@ OhFastClient::ProcessReply(std::istream& istm, Address sender)
 			m_ts = msgTs;
 			m_value = msgV;
 			m_pvalue = msgVp;
+			m_payload = payload;
 
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Updated local <ts,value> pair to: [" << m_ts << "," << m_value << "," << m_pvalue <<"]";
-				Log(DEBUG, sstm);
+				AM_LOG_DEBUG ("Updated local <ts,value> pair to: [" << m_ts << "," << m_value << "," << m_pvalue <<"]");
 			}
 
 			//reset the maxAck set and tsSecured variables
@@ -740,9 +793,7 @@ OhFastClient::ProcessReply(std::istream& istm, Address sender)
 					m_initiator = true;
 					if (m_verbose)
 					{
-						AsmCommon::Reset(sstm);
-						sstm << "ReadAck after RELAY from: " << InetSocketAddress::ConvertFrom(sender).GetIpv4();
-						Log(DEBUG, sstm);
+						AM_LOG_DEBUG ("ReadAck after RELAY from: " << InetSocketAddress::ConvertFrom(sender).GetIpv4());
 					}
 				}
 			}
@@ -751,9 +802,10 @@ OhFastClient::ProcessReply(std::istream& istm, Address sender)
 		
       	if (m_replies >= (m_numServers - m_fail))
       	{
-      		AsmCommon::Reset(sstm);
       		m_opStatus = IDLE;
       		std::chrono::duration<double> elapsed_seconds;
+      		uint32_t exchanges = 2;
+      		uint32_t tag = m_ts;
 
       		// if ts is secured - return its associated value
       		if ( m_isTsSecured )
@@ -762,20 +814,19 @@ OhFastClient::ProcessReply(std::istream& istm, Address sender)
       			m_real_end = std::chrono::system_clock::now();
       			elapsed_seconds = m_real_end-m_real_start;
 
-      			sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Secure Value: "<< m_value <<
-      					", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"]";
-
       			// if read triggered the 3rd phase
       			if( m_initiator )
       			{
-      				sstm << "- @ 3 EXCH **";
       				m_slowOpCount++;
+      				exchanges = 3;
       			}
       			else
       			{
-      				sstm << "- @ 2 EXCH **";
       				m_fastOpCount++;
       			}
+
+      			AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Secure Value: "<< m_value <<
+      					", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"]- @ " << exchanges << " EXCH **");
       		}
       		else if ( m_ts == 0 || IsPredicateValid () ) // check the predicate
       		{
@@ -783,8 +834,8 @@ OhFastClient::ProcessReply(std::istream& istm, Address sender)
       			m_real_end = std::chrono::system_clock::now();
       			elapsed_seconds = m_real_end-m_real_start;
 
-      			sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return Value: "<< m_value <<
-      					", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **";
+      			AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return Value: "<< m_value <<
+      					", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **");
       			m_fastOpCount++;
       		}
       		else
@@ -793,16 +844,16 @@ OhFastClient::ProcessReply(std::istream& istm, Address sender)
       			m_real_end = std::chrono::system_clock::now();
       			elapsed_seconds = m_real_end-m_real_start;
 
-      			sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return PValue: "<< m_pvalue <<
-      					", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **";
+      			AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return PValue: "<< m_pvalue <<
+      					", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **");
       			m_fastOpCount++;
+      			tag = m_ts - 1;
       		}
 
-			Log( INFO, sstm);
-
       		m_opAve += m_opEnd - m_opStart;
+      		m_opCompletedTrace (READ, exchanges, m_opEnd - m_opStart, tag, m_key, 0);
       		m_real_opAve += elapsed_seconds;  //
-			ScheduleOperation (m_interval);
+			m_workload.OperationCompleted ();
 			m_replies =0;
 		}
 	}
@@ -816,13 +867,10 @@ OhFastClient::IsPredicateValid()
 	std::vector<uint32_t> buckets;
 	std::vector< std::pair<Address, uint32_t> >::iterator it;
 	int a;
-	std::stringstream sstm;
 
 	if (m_verbose)
 	{
-		AsmCommon::Reset(sstm);
-		sstm << "Checking the predicate.";
-		Log(DEBUG, sstm);
+		AM_LOG_DEBUG ("Checking the predicate.");
 	}
 
 	buckets.resize((int) m_numServers);
@@ -839,9 +887,7 @@ OhFastClient::IsPredicateValid()
 	{
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "PREDICATE LOOP: a=" << a << ", b[a]="<< buckets[a] << ", bound=" << (m_numServers - a*m_fail);
-			Log(DEBUG, sstm);
+			AM_LOG_DEBUG ("PREDICATE LOOP: a=" << a << ", b[a]="<< buckets[a] << ", bound=" << (m_numServers - a*m_fail));
 		}
 
 		if (buckets[a] >= (m_numServers - a*m_fail))
@@ -30,7 +30,12 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/enum.h"
 #include "ohfast-server.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <algorithm>
 
 namespace ns3 {
@@ -40,16 +45,15 @@ NS_LOG_COMPONENT_DEFINE ("OhFastServerApplication");
 NS_OBJECT_ENSURE_REGISTERED (OhFastServer);
 
 void
-OhFastServer::Log( logLevel_t l, std::stringstream& s)
+OhFastServer::LogInfo(std::stringstream& s)
 {
-	if ( l == INFO )
-	{
-		NS_LOG_INFO("[SERVER "<< m_personalID << " - " << Ipv4Address::ConvertFrom(m_myAddress) << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
-	}
-	else
-	{
-		NS_LOG_DEBUG("[SERVER "<< m_personalID << " - " << Ipv4Address::ConvertFrom(m_myAddress) << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
-	}
+	NS_LOG_INFO("[SERVER "<< m_personalID << " - " << Ipv4Address::ConvertFrom(m_myAddress) << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
+}
+
+void
+OhFastServer::LogDebug(std::stringstream& s)
+{
+	NS_LOG_DEBUG("[SERVER "<< m_personalID << " - " << Ipv4Address::ConvertFrom(m_myAddress) << "] (" << Simulator::Now ().GetSeconds () << "s):" << s.str());
 }
 
 TypeId
@@ -87,6 +91,51 @@ OhFastServer::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&OhFastServer::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("RelayWindow",
+					 "Time a relay waits for the next ones to the same server, 0 to send every relay at once",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&OhFastServer::m_relayWindow),
+					 MakeTimeChecker ())
+					.AddAttribute ("RelayBatchSize",
+					 "Relays to the same server sent at once, without waiting for the window to close",
+					 UintegerValue (32),
+					 MakeUintegerAccessor (&OhFastServer::m_relayBatch),
+					 MakeUintegerChecker<uint32_t> (1))
+					.AddAttribute ("ServiceCores",
+					 "Messages processed at the same time, 0 to process every message on arrival",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&OhFastServer::m_serviceCores),
+					 MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("ServiceTime",
+					 "The processing time of a message, in seconds",
+					 StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"),
+					 MakePointerAccessor (&OhFastServer::m_serviceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("RelayServiceTime",
+					 "The processing time of a relay from another server, in seconds, unset for ServiceTime",
+					 PointerValue (),
+					 MakePointerAccessor (&OhFastServer::m_relayServiceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("ServiceTimePerItem",
+					 "The processing time added per entry of the seen set of the register of a message",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&OhFastServer::m_servicePerItem),
+					 MakeTimeChecker ())
+					.AddAttribute ("Fault",
+					 "The fault of the server: None, Crash (the messages received are lost) or Pause (they are held until the fault ends)",
+					 EnumValue (AmServiceQueue::NONE),
+					 MakeEnumAccessor (&OhFastServer::SetFault, &OhFastServer::GetFault),
+					 MakeEnumChecker (AmServiceQueue::NONE, "None",
+					                  AmServiceQueue::CRASH, "Crash",
+					                  AmServiceQueue::PAUSE, "Pause"))
+					.AddAttribute ("Slowdown",
+					 "The time every message received waits before it is processed",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&OhFastServer::SetSlowdown, &OhFastServer::GetSlowdown),
+					 MakeTimeChecker ())
+					.AddTraceSource ("MessageHandled", "A message was received and answered",
+					 MakeTraceSourceAccessor (&OhFastServer::m_handledTrace),
+					 "ns3::AmStatsCollector::MessageHandledCallback")
 	;
 	return tid;
 }
@@ -95,9 +144,6 @@ OhFastServer::OhFastServer ()
 {
 	NS_LOG_FUNCTION (this);
 	//m_id = 0;
-	m_ts = 0;
-	m_value = 0;
-	m_pvalue = 0;
 	m_serversConnected =0;
 	m_sent=0;
 
@@ -109,9 +155,6 @@ OhFastServer::~OhFastServer()
 	NS_LOG_FUNCTION (this);
 	//m_socket = 0;
 	//m_id = 0;
-	m_ts = 0;
-	m_value = 0;
-	m_pvalue = 0;
 	m_sent=0;
 	m_serversConnected =0;
 
@@ -139,10 +182,18 @@ void
 OhFastServer::StartApplication (void)
 {
 	NS_LOG_FUNCTION (this);
+
+	m_service.SetCores (m_serviceCores);
+	m_service.SetServiceTime (m_serviceTime);
+	m_service.SetServiceTime (READRELAY, m_relayServiceTime);
+	m_service.SetPerItem (m_servicePerItem);
+	m_service.SetItemsCallback (MakeCallback (&OhFastServer::GetServiceItems, this));
+	m_service.SetServedCallback (MakeCallback (&OhFastServer::HandleRead, this));
+
+	m_relayBatcher.SetWindow (m_relayWindow);
+	m_relayBatcher.SetMaxMessages (m_relayBatch);
 	
-	std::stringstream sstm;
-	sstm << "Debug Mode="<<m_verbose;
-	Log(DEBUG, sstm);
+	AM_LOG_DEBUG ("Debug Mode="<<m_verbose);
 	
 	if (m_socket == 0)
 	{
@@ -190,9 +241,7 @@ OhFastServer::StartApplication (void)
 		{
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-				Log(DEBUG, sstm);
+				AM_LOG_DEBUG ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 			}
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
@@ -214,11 +263,20 @@ OhFastServer::StartApplication (void)
 }
 
 
+uint32_t
+OhFastServer::GetSentMessages (void) const
+{
+	return m_sent;
+}
+
 void 
 OhFastServer::StopApplication ()
 {
 	NS_LOG_FUNCTION (this);
 
+	// send the relays still waiting for their window
+	m_relayBatcher.Flush ();
+
 	if (m_socket != 0)
 	{
 		m_socket->Close ();
@@ -241,17 +299,31 @@ OhFastServer::StopApplication ()
 			m_clntSocket[i]->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
 		}
 	}
-	std::stringstream sstm;
-	sstm << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **";
-	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	Log(INFO, sstm);
-	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
+	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	AM_LOG_INFO ("** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **");
+	if (!m_relayWindow.IsZero ())
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" RELAYS: #relayMsgs="<<m_relayBatcher.GetMessages ()<<", #relayPkts="<<m_relayBatcher.GetPackets ()<<" **"<<std::endl;
+	}
+	//std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	if (m_serviceCores > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" CPU: #served="<<m_service.GetServed ()<<", busyTime="<<m_service.GetBusyTime ().GetSeconds ()<<"s, AveWait="<<(m_service.GetServed () > 0 ? m_service.GetWaitTime ().GetSeconds () / m_service.GetServed () : 0)<<"s, #maxQueue="<<m_service.GetMaxQueue ()<<" **"<<std::endl;
+	}
+	if (m_service.GetDropped () > 0 || m_service.GetHeld () > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" FAULTS: #dropped="<<m_service.GetDropped ()<<", #held="<<m_service.GetHeld ()<<" **"<<std::endl;
+	}
 }
 
 void
 OhFastServer::DoDispose (void)
 {
 	NS_LOG_FUNCTION (this);
+	m_framer.Clear ();
+	m_service.Clear ();
+	m_relayBatcher.Clear ();
+	m_registers.Clear ();
 	Application::DoDispose ();
 }
 
@@ -262,6 +334,7 @@ OhFastServer::DoDispose (void)
 void OhFastServer::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void OhFastServer::HandlePeerError (Ptr<Socket> socket)
@@ -294,14 +367,15 @@ void OhFastServer::HandleAccept (Ptr<Socket> s, const Address& from)
 
 	if( !isServer )
 	{
+		m_clntSlot.insert (std::make_pair (InetSocketAddress::ConvertFrom (from).GetIpv4 ().Get (), m_clntAddress.size ()));
 		m_clntAddress.push_back(std::make_pair(from, s));
 		//m_clntSocket.push_back(s);
 		m_numClients++;
 
-		std::sort(m_clntAddress.begin(), m_clntAddress.end());
 
 		m_relayTs.resize(m_numClients);
 		m_relays.resize(m_numClients);
+		m_relayKey.resize(m_numClients);
 
 		if (m_verbose)
 		{
@@ -312,7 +386,7 @@ void OhFastServer::HandleAccept (Ptr<Socket> s, const Address& from)
 				sstm << InetSocketAddress::ConvertFrom(m_clntAddress[i].first).GetIpv4() << " ";
 			sstm << "}";
 
-			Log(DEBUG, sstm);
+			LogDebug(sstm);
 		}
 	}
 	else
@@ -322,9 +396,7 @@ void OhFastServer::HandleAccept (Ptr<Socket> s, const Address& from)
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "ACCEPTED SERVER " << serverId << ": " << InetSocketAddress::ConvertFrom(from).GetIpv4();
-			Log(DEBUG, sstm);
+			AM_LOG_DEBUG ("ACCEPTED SERVER " << serverId << ": " << InetSocketAddress::ConvertFrom(from).GetIpv4());
 		}
 	}
 }
@@ -339,9 +411,7 @@ void OhFastServer::HandleAccept (Ptr<Socket> s, const Address& from)
 
    if (m_verbose)
    {
-	   std::stringstream sstm;
-	   sstm << "Connected to NODE (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	   Log(DEBUG, sstm);
+	   AM_LOG_DEBUG ("Connected to NODE (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
    }
  }
 
@@ -351,28 +421,41 @@ void OhFastServer::HandleAccept (Ptr<Socket> s, const Address& from)
  }
 
 /**************************************************************************************
- * PACKET DATA Handler
+ * OhFast Rcv Handler
  **************************************************************************************/
 void
-OhFastServer::SetFill (std::string fill)
+OhFastServer::SetFault (AmServiceQueue::Fault fault)
+{
+	NS_LOG_FUNCTION (this << fault);
+	m_service.SetFault (fault);
+}
+
+AmServiceQueue::Fault
+OhFastServer::GetFault (void) const
 {
-  NS_LOG_FUNCTION (this << fill);
+	return m_service.GetFault ();
+}
 
-  uint32_t dataSize = fill.size () + 1;
+uint32_t
+OhFastServer::GetServiceItems (const AmProtocolHeader &hdr) const
+{
+	const Register *reg = m_registers.Find (hdr.GetKey ());
+	return (reg != 0)? reg->seen.GetSize () : 0;
+}
 
-  //if (dataSize != m_dataSize)
-  //  {
-      m_data = new uint8_t [dataSize];
-      m_dataSize = dataSize;
-   // }
+void
+OhFastServer::SetSlowdown (Time delay)
+{
+	NS_LOG_FUNCTION (this << delay);
+	m_service.SetSlowdown (delay);
+}
 
-  memcpy (m_data, fill.c_str (), dataSize);
-  m_size = dataSize;
+Time
+OhFastServer::GetSlowdown (void) const
+{
+	return m_service.GetSlowdown ();
 }
 
-/**************************************************************************************
- * OhFast Rcv Handler
- **************************************************************************************/
 void 
 OhFastServer::HandleRead (Ptr<Socket> socket)
 {
@@ -381,22 +464,17 @@ OhFastServer::HandleRead (Ptr<Socket> socket)
 	Ptr<Packet> packet;
 	Address from;
 
-	uint32_t msgT;
-	std::stringstream sstm;
+	AmProtocolHeader hdr;
 	std::string message_type = "";
 	MessageType replyT;
-	AsmCommon::Reset(sstm);
 
-	while ((packet = socket->RecvFrom (from)))
+	while ((packet = m_service.Recv (m_framer, socket, from)))
 	{
 
 		//deserialize the contents of the packet
-		uint8_t buf[packet->GetSize()];
-		packet->CopyData(buf,packet->GetSize());
-		std::stringbuf sb;
-		sb.str(std::string((char*) buf));
-		std::istream istm(&sb);
-		istm >> msgT;
+		packet->RemoveHeader (hdr);
+		uint32_t sent = m_sent;
+		MessageType msgT = hdr.GetType ();
 
 
 		if (msgT==WRITE){
@@ -413,101 +491,95 @@ OhFastServer::HandleRead (Ptr<Socket> socket)
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Received " << message_type <<" "<< packet->GetSize () << " bytes from " <<
+			AM_LOG_DEBUG ("Received " << message_type <<" "<< packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-			Log(DEBUG, sstm);
+					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 		}
 
 		if ( msgT == WRITE || msgT == READ )
 		{
-			HandleRecvMsg(istm, socket, replyT);
+			HandleRecvMsg(hdr, packet, socket, replyT);
 		}
 		else if ( msgT == READRELAY )
 		{
-			HandleRelay(istm, socket);
+			HandleRelay(hdr, packet, socket);
 		}
 		else
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Invalid message type! Message from " << InetSocketAddress::ConvertFrom (from).GetIpv4 () << " dropped.";
-			Log(DEBUG, sstm );
+			AM_LOG_DEBUG ("Invalid message type! Message from " << InetSocketAddress::ConvertFrom (from).GetIpv4 () << " dropped.");
 		}
+
+		m_handledTrace (msgT, m_sent - sent);
+	}
+}
+
+int
+OhFastServer::FindClient (Ipv4Address ip) const
+{
+	std::unordered_map<uint32_t, uint32_t>::const_iterator it = m_clntSlot.find (ip.Get ());
+	if (it == m_clntSlot.end ())
+	{
+		return -1;
 	}
+	return it->second;
 }
 
 void
-OhFastServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType replyT)
+OhFastServer::HandleRecvMsg(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket, MessageType replyT)
 {
 	NS_LOG_FUNCTION (this << socket);
 
-	uint32_t msgTs, msgV, msgVp, msgOp;
+	uint32_t msgTs = hdr.GetTs ();
+	uint32_t msgOp = hdr.GetCounter ();
 	int msgSenderID = -1;
-	std::stringstream sstm;
 	std::string message_type = "";
 	std::string message_response_type = "";
-	std::stringstream pkts;
 	Address from;
 
-	AsmCommon::Reset(pkts);
-	AsmCommon::Reset(sstm);
-
 	socket->GetPeerName(from);
 
-	// the writer does not send its id
-	if ( replyT == WRITEACK )
-	{
-		istm >> msgTs >> msgV >> msgVp >> msgOp;
-	}
-	else
-	{
-		istm >> msgTs >> msgV >> msgVp >> msgSenderID >> msgOp;
-	}
+	Register &reg = m_registers.Get (hdr.GetKey ());
 
-	//find if the socket that client is connected to
-	for (uint32_t i=0; i < m_clntAddress.size(); i++)
-	{
-		if ( InetSocketAddress::ConvertFrom(from).GetIpv4() == InetSocketAddress::ConvertFrom(m_clntAddress[i].first).GetIpv4() )
-		{
-			msgSenderID = i;
-			break;	//stop at the first client we find
-		}
-	}
+	//find the client that sent the message
+	msgSenderID = FindClient (InetSocketAddress::ConvertFrom(from).GetIpv4());
 
 
 	// if not sender detected - drop the package
 	if ( ( msgSenderID >= 0 && msgSenderID < (int) m_clntAddress.size() )|| m_fail == 0)
 	{
-		if ( m_ts < msgTs )
+		ResetRelays (msgSenderID, hdr.GetKey ());
+
+		if ( reg.ts < msgTs )
 		{
 			NS_LOG_LOGIC ("Updating Local Info (ts and seen set)");
-			m_ts = msgTs;
-			m_value = msgV;
-			m_pvalue = msgVp;
+			reg.ts = msgTs;
+			reg.value = hdr.GetValue ();
+			reg.pvalue = hdr.GetPvalue ();
+			reg.payload = payload;
 
 			//reinitialize the seen set
-			m_seen.clear();
+			reg.seen.Clear ();
 
 			//reset propagate flag
-			m_tsSecured = false;
+			reg.secured = false;
 		}
 
 		//insert the sender in the seen set
-		m_seen.insert( InetSocketAddress::ConvertFrom(from).GetIpv4() );
+		if (msgSenderID >= 0)
+		{
+			reg.seen.Insert (msgSenderID);
+		}
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "SeenSize: "<< m_seen.size() << ", Bound: (" << m_numServers << "/" << m_fail << ")-2 = " << ((m_numServers/m_fail)-2)
-		 			 << ", TsSecured: " << m_tsSecured << ", RelayTs: " << m_relayTs[msgSenderID] << ", ServerTs: " << m_ts;
-			Log(DEBUG,  sstm );
+			AM_LOG_DEBUG ("SeenSize: "<< reg.seen.GetSize () << ", Bound: (" << m_numServers << "/" << m_fail << ")-2 = " << ((m_numServers/m_fail)-2)
+		 			 << ", TsSecured: " << reg.secured << ", RelayTs: " << m_relayTs[msgSenderID] << ", ServerTs: " << reg.ts);
 		}
 		// check condition to move to relay phase
-		if ( m_seen.size() > ((m_numServers/m_fail) - 2) && !m_tsSecured && m_relayTs[msgSenderID] < m_ts && replyT != WRITEACK)
+		if ( reg.seen.GetSize () > ((m_numServers/m_fail) - 2) && !reg.secured && m_relayTs[msgSenderID] < reg.ts && replyT != WRITEACK)
 		{
 			message_response_type = "readRelay";
-			m_relayTs[msgSenderID] = m_ts;
+			m_relayTs[msgSenderID] = reg.ts;
 			m_relays[msgSenderID] = 1;
 
 
@@ -517,24 +589,17 @@ OhFastServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType
 
 
 			// prepare and send packet to all servers
-			AsmCommon::Reset(pkts);
 			// <msgType, <ts,v,vp>, q, counter>
-			//pkts << READRELAY << " " << m_ts << " " << m_value << " " << m_pvalue << " "<< ipSize << " " << InetSocketAddress::ConvertFrom(from).GetIpv4().Get() << " " << msgOp;
-			pkts << READRELAY << " " << m_ts << " " << m_value << " " << m_pvalue << " "<< msgSenderID << " " << msgOp;
+			AmProtocolHeader relay;
+			relay.SetKey (hdr.GetKey ());
+			relay.SetType (READRELAY);
+			relay.SetTs (reg.ts);
+			relay.SetValue (reg.value);
+			relay.SetPvalue (reg.pvalue);
+			relay.SetSender (InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4().Get());
+			relay.SetCounter (msgOp);
 
-			SetFill(pkts.str());
-
-			Ptr<Packet> pc;
-			if (m_dataSize)
-			{
-				NS_ASSERT_MSG (m_dataSize == m_size, "OhFastServer::HandleSend(): m_size and m_dataSize inconsistent");
-				NS_ASSERT_MSG (m_data, "OhFastServer::HandleSend(): m_dataSize but no m_data");
-				pc = Create<Packet> (m_data, m_dataSize);
-			}
-			else
-			{
-				pc = Create<Packet> (m_size);
-			}
+			Ptr<Packet> pc = m_framer.Build (relay, reg.payload);
 
 			//Send a single packet to each server
 			for (uint32_t i=0; i<m_serverAddress.size(); i++)
@@ -542,14 +607,12 @@ OhFastServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType
 				m_sent++; //increase here to count also "our" never sent to ourselves message :)
 				if (m_serverAddress[i] != m_myAddress)
 				{
-					m_srvSocket[i]->Send(pc);
+					m_relayBatcher.Send (m_srvSocket[i], pc);
 
 					if (m_verbose)
 					{
-						AsmCommon::Reset(sstm);
-						sstm << "Relaying for " << InetSocketAddress::ConvertFrom(from).GetIpv4() << " - Sent "<< message_response_type << " " << pc->GetSize () << " bytes to "
-								<< Ipv4Address::ConvertFrom (m_serverAddress[i]) << ", seen size: " << m_seen.size() << " data " << pkts.str();
-						Log(DEBUG,  sstm );
+						AM_LOG_DEBUG ("Relaying for " << InetSocketAddress::ConvertFrom(from).GetIpv4() << " - Sent "<< message_response_type << " " << pc->GetSize () << " bytes to "
+								<< Ipv4Address::ConvertFrom (m_serverAddress[i]) << ", seen size: " << reg.seen.GetSize () << " data " << relay);
 					}
 				}
 			}
@@ -557,23 +620,19 @@ OhFastServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType
 		else // reply to the sender without relaying
 		{
 			// prepare and send packet
-			AsmCommon::Reset(pkts);
 			// serialize <counter, msgType, <ts,v,vp>, |seen|, secured, initiator>
-			pkts << msgOp << " " << replyT << " " << m_ts << " " << m_value << " " << m_pvalue << " " << m_seen.size() << " " << m_tsSecured << " " << false;
-
-			SetFill(pkts.str());
-
-			Ptr<Packet> p;
-			if (m_dataSize)
-			{
-				NS_ASSERT_MSG (m_dataSize == m_size, "OhFastServer::HandleSend(): m_size and m_dataSize inconsistent");
-				NS_ASSERT_MSG (m_data, "OhFastServer::HandleSend(): m_dataSize but no m_data");
-				p = Create<Packet> (m_data, m_dataSize);
-			}
-			else
-			{
-				p = Create<Packet> (m_size);
-			}
+			AmProtocolHeader reply;
+			reply.SetKey (hdr.GetKey ());
+			reply.SetCounter (msgOp);
+			reply.SetType (replyT);
+			reply.SetTs (reg.ts);
+			reply.SetValue (reg.value);
+			reply.SetPvalue (reg.pvalue);
+			reply.SetViews (reg.seen.GetSize ());
+			reply.SetSecured (reg.secured);
+			reply.SetInitiator (false);
+
+			Ptr<Packet> p = m_framer.Build (reply, replyT == READACK ? reg.payload : 0);
 
 			socket->Send (p);
 			m_sent++; //count the sent messages
@@ -581,51 +640,52 @@ OhFastServer::HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType
 
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Sent "<< message_response_type <<" " << p->GetSize () << " bytes to " <<
+				AM_LOG_DEBUG ("Sent "<< message_response_type <<" " << p->GetSize () << " bytes to " <<
 						InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-						InetSocketAddress::ConvertFrom (from).GetPort ();
-
-				sstm << " Seen: { ";
-				for(std::set< Address >::iterator it=m_seen.begin(); it!=m_seen.end(); it++)
-					sstm << Ipv4Address::ConvertFrom( *it ) << ", ";
-
-				sstm << "} data " << pkts.str();
-
-				Log(DEBUG, sstm);
+						InetSocketAddress::ConvertFrom (from).GetPort () << " Seen: " << reg.seen << " data " << reply);
 			}
 		}
 	} // end if(msgSenderID)
 }
 
 void
-OhFastServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
+OhFastServer::ResetRelays (int clientID, uint32_t key)
+{
+	if ( clientID < 0 || clientID >= (int) m_relayKey.size() || m_relayKey[clientID] == key )
+	{
+		return;
+	}
+
+	// the relay counters track a single read per client
+	m_relayKey[clientID] = key;
+	m_relayTs[clientID] = 0;
+	m_relays[clientID] = 0;
+}
+
+void
+OhFastServer::HandleRelay(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
 
 	/////////////////////////////////
 	////////// READ RELAY ///////////
 	/////////////////////////////////
-	uint32_t msgTs, msgV, msgVp, msgOp;//, msgIpSize, msgSenderIp;
-	int msgSenderID = -1;
-	std::stringstream sstm;
+	uint32_t msgTs = hdr.GetTs ();
+	uint32_t msgV = hdr.GetValue ();
+	uint32_t msgVp = hdr.GetPvalue ();
+	uint32_t msgOp = hdr.GetCounter ();
+	int msgSenderID = FindClient (Ipv4Address (hdr.GetSender ()));
 	std::string message_type = "";
 	std::string message_response_type = "";
-	std::stringstream pkts;
-	AsmCommon::Reset(pkts);
-	AsmCommon::Reset(sstm);
 	Address from;
 
 	socket->GetPeerName(from);
 
-	//istm >> msgTs >> msgV >> msgVp >> msgIpSize >> msgSenderIp >> msgOp;
-	istm >> msgTs >> msgV >> msgVp >> msgSenderID >> msgOp;
+	Register &reg = m_registers.Get (hdr.GetKey ());
 
 	if (msgSenderID < 0)
 	{
-		AsmCommon::Reset(sstm);
-		sstm << "Invalid InitiatorID=" << msgSenderID;
-		Log(DEBUG,  sstm );
+		AM_LOG_DEBUG ("Invalid InitiatorID=" << msgSenderID);
 
 		return;
 	}
@@ -647,31 +707,32 @@ OhFastServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
 
 	if (m_verbose)
 	{
-		AsmCommon::Reset(sstm);
-		sstm << "Processing ReadRelay from "<< InetSocketAddress::ConvertFrom(from).GetIpv4() << ": InitiatorIp= " << InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4() << " InitiatorID=" << msgSenderID
-				<< ", relayTs=" << m_relayTs[msgSenderID] << ", msgTs=" << msgTs << ", #RelaysRcved=" << m_relays[msgSenderID];
-		Log(DEBUG,  sstm );
+		AM_LOG_DEBUG ("Processing ReadRelay from "<< InetSocketAddress::ConvertFrom(from).GetIpv4() << ": InitiatorIp= " << InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4() << " InitiatorID=" << msgSenderID
+				<< ", relayTs=" << m_relayTs[msgSenderID] << ", msgTs=" << msgTs << ", #RelaysRcved=" << m_relays[msgSenderID]);
 	}
 
 	if ( msgSenderID >= 0 && msgSenderID < (int) m_clntAddress.size() )
 	{
-		if ( m_ts < msgTs )
+		ResetRelays (msgSenderID, hdr.GetKey ());
+
+		if ( reg.ts < msgTs )
 		{
 			NS_LOG_LOGIC ("Updating Local Info (ts and seen set)");
-			m_ts = msgTs;
-			m_value = msgV;
-			m_pvalue = msgVp;
+			reg.ts = msgTs;
+			reg.value = msgV;
+			reg.pvalue = msgVp;
+			reg.payload = payload;
 
 			//reinitialize the seen set
-			m_seen.clear();
+			reg.seen.Clear ();
 
 			//insert the client in the seen set
-			m_seen.insert( InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4() );
+			reg.seen.Insert (msgSenderID);
 		}
-		else if ( m_ts  == msgTs )
+		else if ( reg.ts  == msgTs )
 		{
 			//insert the client in the seen set
-			m_seen.insert( InetSocketAddress::ConvertFrom(m_clntAddress[msgSenderID].first).GetIpv4() );
+			reg.seen.Insert (msgSenderID);
 		}
 
 
@@ -683,34 +744,27 @@ OhFastServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
 			if (m_relays[msgSenderID] == (m_numServers - m_fail))
 			{
 				// if we have the timestamp that reached a majority - secure it
-				if( m_ts == msgTs)
+				if( reg.ts == msgTs)
 				{
-					m_tsSecured = true;
+					reg.secured = true;
 				}
 
 				// REPLY back to the reader
 				message_response_type = "readAck";
 
-				AsmCommon::Reset(pkts);
 				// <counter, msgType, <ts,v,vp>, |seen|, secured, initiator>
-				pkts << msgOp << " " << READACK << " " << msgTs << " " << msgV << " " << msgVp << " "<< m_seen.size() << " " << true << " " << true;
-
-				SetFill(pkts.str());
-
-				Ptr<Packet> pk;
-				if (m_dataSize)
-				{
-					NS_ASSERT_MSG (m_dataSize == m_size, "OhFastServer::HandleSend(): m_size and m_dataSize inconsistent");
-					NS_ASSERT_MSG (m_data, "OhFastServer::HandleSend(): m_dataSize but no m_data");
-					pk = Create<Packet> (m_data, m_dataSize);
-				}
-				else
-				{
-					pk = Create<Packet> (m_size);
-				}
-
-				pk->RemoveAllPacketTags ();
-				pk->RemoveAllByteTags ();
+				AmProtocolHeader reply;
+				reply.SetKey (hdr.GetKey ());
+				reply.SetCounter (msgOp);
+				reply.SetType (READACK);
+				reply.SetTs (msgTs);
+				reply.SetValue (msgV);
+				reply.SetPvalue (msgVp);
+				reply.SetViews (reg.seen.GetSize ());
+				reply.SetSecured (true);
+				reply.SetInitiator (true);
+
+				Ptr<Packet> pk = m_framer.Build (reply, payload);
 
 				//Send to the client that initiated the relay (from the info of the message is msgSenderId)
 				(m_clntAddress[msgSenderID].second)->Send(pk);
@@ -718,10 +772,8 @@ OhFastServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
 
 				if (m_verbose)
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Sent " << message_response_type <<" "<< pk->GetSize () << " bytes after RELAY to " << InetSocketAddress::ConvertFrom (m_clntAddress[msgSenderID].first).GetIpv4()
-							<< "(ExpectedRelays: " << m_numServers - m_fail << " RcvedRelays: " << m_relays[msgSenderID] <<") data "<< pkts.str();
-					Log(DEBUG,  sstm );
+					AM_LOG_DEBUG ("Sent " << message_response_type <<" "<< pk->GetSize () << " bytes after RELAY to " << InetSocketAddress::ConvertFrom (m_clntAddress[msgSenderID].first).GetIpv4()
+							<< "(ExpectedRelays: " << m_numServers - m_fail << " RcvedRelays: " << m_relays[msgSenderID] <<") data "<< reply);
 				}
 
 				//reset the replies for that reader to one (to count ours)
@@ -734,34 +786,16 @@ OhFastServer::HandleRelay(std::istream& istm, Ptr<Socket> socket)
 			// someone else relayed this ts - echo his msg
 			message_response_type = "readRelay";
 
-			AsmCommon::Reset(pkts);
 			// serialize <msgType, <ts,v,vp>, q, counter>
-			//pkts << READRELAY << " " << msgTs << " " << msgV << " " << msgVp <<" "<< msgIpSize << " "<< msgSenderIp << " " << msgOp;
-			pkts << READRELAY << " " << msgTs << " " << msgV << " " << msgVp <<" "<< msgSenderID << " " << msgOp;
-
-			SetFill(pkts.str());
-
-			Ptr<Packet> pk;
-			if (m_dataSize)
-			{
-				NS_ASSERT_MSG (m_dataSize == m_size, "OhFastServer::HandleSend(): m_size and m_dataSize inconsistent");
-				NS_ASSERT_MSG (m_data, "OhFastServer::HandleSend(): m_dataSize but no m_data");
-				pk = Create<Packet> (m_data, m_dataSize);
-			}
-			else
-			{
-				pk = Create<Packet> (m_size);
-			}
+			Ptr<Packet> pk = m_framer.Build (hdr, payload);
 
-			//Send to the corresponding client (from the info of the message is msgSenderId)
-			socket->Send(pk);
+			//Echo to the server that relayed it
+			m_relayBatcher.Send (socket, pk);
 			m_sent++;
 
 			if (m_verbose)
 			{
-				AsmCommon::Reset(sstm);
-				sstm << "Echo " << message_response_type <<" "<< pk->GetSize () << " bytes to " << InetSocketAddress::ConvertFrom (from).GetIpv4() << " data " << pkts.str();
-				Log(DEBUG,  sstm );
+				AM_LOG_DEBUG ("Echo " << message_response_type <<" "<< pk->GetSize () << " bytes to " << InetSocketAddress::ConvertFrom (from).GetIpv4() << " data " << hdr);
 			}
 		}
 	}
@@ -22,13 +22,24 @@
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
+#include "ns3/nstime.h"
 #include "ns3/address.h"
+#include "ns3/packet.h"
+#include "ns3/traced-callback.h"
+#include "ns3/ipv4-address.h"
 #include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-service-queue.h"
+#include "am-relay-batcher.h"
+#include "am-register-store.h"
+#include <unordered_map>
+#include "am-seen-set.h"
 
 namespace ns3 {
 
 class Socket;
 class Packet;
+class AmProtocolHeader;
 
 /**
  * \ingroup applications 
@@ -52,6 +63,12 @@ public:
   OhFastServer ();
   virtual ~OhFastServer ();
 
+  /**
+   * \brief Get the number of messages this server has sent
+   * \returns the #sentMsgs of the LOG line
+   */
+  uint32_t GetSentMessages (void) const;
+
   void SetServers (std::vector<Address> ip);
 
 protected:
@@ -63,11 +80,8 @@ private:
   virtual void StopApplication (void);
 
   //string stream for ease of output
-  void Log( logLevel_t l, std::stringstream& s);
-  /**
-   * \brief function to fill the packet with data
-   */
-  void SetFill (std::string fill);
+  void LogInfo(std::stringstream& s);
+  void LogDebug(std::stringstream& s);
   /**
    * \brief Handle a packet reception.
    *
@@ -76,14 +90,50 @@ private:
    * \param socket the socket the packet was received to.
    */
   void HandleRead (Ptr<Socket> socket);
+  /**
+   * \brief Start or end a fault of the server
+   * \param fault the fault
+   */
+  void SetFault (AmServiceQueue::Fault fault);
+  /**
+   * \returns the fault of the server
+   */
+  AmServiceQueue::Fault GetFault (void) const;
+  /**
+   * \param hdr a message
+   * \returns the entries of the seen set of the register of the message,
+   *          each charged ServiceTimePerItem
+   */
+  uint32_t GetServiceItems (const AmProtocolHeader &hdr) const;
+  /**
+   * \param delay the time every message received waits before it is processed
+   */
+  void SetSlowdown (Time delay);
+  /**
+   * \returns the time every message received waits before it is processed
+   */
+  Time GetSlowdown (void) const;
   /**
    * \brief handle read/write messages
    */
-  void HandleRecvMsg(std::istream& istm, Ptr<Socket> socket, MessageType T);
+  void HandleRecvMsg(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket, MessageType T);
   /**
    * \brief handle relay messages
    */
-  void HandleRelay(std::istream& istm, Ptr<Socket> socket);
+  void HandleRelay(const AmProtocolHeader& hdr, Ptr<Packet> payload, Ptr<Socket> socket);
+
+  /**
+   * \brief find the slot of a client
+   * \param ip the IPv4 address of the client
+   * \return the index of the client in m_clntAddress, or -1 if the client is unknown
+   */
+  int FindClient (Ipv4Address ip) const;
+  /**
+   * \brief forget the relays of a client when its read moves to another key
+   * \param clientID the index of the client
+   * \param key the key of the current read of the client
+   */
+  void ResetRelays (int clientID, uint32_t key);
 
   
     /**
@@ -115,14 +165,20 @@ private:
 
   
 
-  uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
-  uint8_t *m_data; 		//!< packet payload data
-
   uint16_t m_port; //!< Port on which we listen for incoming packets.
   uint32_t m_size; //!< The size of the packet
   Ptr<Socket> m_socket; //!< IPv4 Socket
   //std::vector< Ptr<Socket> > m_socket; //!< Socket
   std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
+  AmMessageFramer m_framer; //!< reassembles the messages of each socket
+  AmServiceQueue m_service; //!< processing time of the messages
+  uint32_t m_serviceCores; //!< cores of the server, 0 for no processing time
+  Ptr<RandomVariableStream> m_serviceTime; //!< processing time of a message (s)
+  Ptr<RandomVariableStream> m_relayServiceTime; //!< processing time of a relay (s), 0 for m_serviceTime
+  Time m_servicePerItem; //!< processing time per seen entry of the register of a message
+  AmRelayBatcher m_relayBatcher; //!< coalesces the relays sent to the other servers
+  Time m_relayWindow; //!< time a relay may wait for others to the same server
+  uint32_t m_relayBatch; //!< relays that close a batch
   Address m_local; //!< local multicast address
   Address m_myAddress; //!< ip address
   uint32_t m_personalID;  //My Personal ID
@@ -134,6 +190,7 @@ private:
 
   //std::vector<Address> m_clntAddress; //!< Remote client adresses
   std::vector< std::pair< Address, Ptr<Socket> > > m_clntAddress; //!< Remote client adresses
+  std::unordered_map<uint32_t, uint32_t> m_clntSlot; //!< index in m_clntAddress of each client IPv4 address
   std::vector< Ptr<Socket> > m_clntSocket;
   uint32_t m_numServers;    //!< number of servers
   uint32_t m_numClients;    //!< number of clients
@@ -141,17 +198,28 @@ private:
   uint32_t m_fail;      //!< max number of failures supported
 
   // OhFast variables
-  uint32_t m_ts; 				//!< latest timestamp
-  uint32_t m_value;				//!< value associated with m_ts
-  uint32_t m_pvalue;			//!< value associated with m_ts - 1 (previous value)
-  std::set< Address > m_seen;	//!< set of IDs storing the IDs of the processes seen our latest ts/value
-  bool m_tsSecured;
+  /// State of a single register (key)
+  struct Register
+  {
+    uint32_t ts;               //!< latest timestamp
+    uint32_t value;            //!< value associated with ts
+    uint32_t pvalue;           //!< value associated with ts - 1 (previous value)
+    Ptr<Packet> payload;       //!< bytes of value and pvalue, as received
+    AmSeenSet seen;            //!< ids of the clients that have seen our latest ts/value
+    bool secured;              //!< true if ts is secured by a quorum
+  };
+  AmRegisterStore<Register> m_registers; //!< register state per key
 
   uint32_t m_sent;    //!< Counter for sent msgs
+
+  /// Callbacks for tracing the handled messages
+
+  TracedCallback<uint32_t, uint32_t> m_handledTrace;
   uint16_t m_verbose;   //!< Debug mode
   //std::vector<uint32_t> m_writeop;     // Now its a single writer! just check ts
   std::vector<uint32_t> m_relayTs;
   std::vector<uint32_t> m_relays;
+  std::vector<uint32_t> m_relayKey;    //!< key of the latest read relayed for each client
 };
 
 } // namespace ns3
@@ -26,13 +26,19 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/trace-source-accessor.h"
 #include "semifast-client.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 #include <unistd.h>
 #include <chrono>
 #include <thread>
 #include <time.h>
 #include <iostream>
+#include <algorithm>
 
 
 
@@ -101,7 +107,7 @@ SemifastClient::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&SemifastClient::m_peerPort),
                    MakeUintegerChecker<uint16_t> ())
-    .AddAttribute ("PacketSize", "Size of echo data in outbound packets",
+    .AddAttribute ("PacketSize", "Size of the values written, in bytes",
                    UintegerValue (100),
                    MakeUintegerAccessor (&SemifastClient::SetDataSize,
                                          &SemifastClient::GetDataSize),
@@ -109,6 +115,9 @@ SemifastClient::GetTypeId (void)
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&SemifastClient::m_txTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("OpCompleted", "An operation has completed",
+                     MakeTraceSourceAccessor (&SemifastClient::m_opCompletedTrace),
+                     "ns3::AmStatsCollector::OpCompletedCallback")
     .AddAttribute ("ID", 
                      "Client ID",
                    	 UintegerValue (100),
@@ -134,6 +143,39 @@ SemifastClient::GetTypeId (void)
                    	 UintegerValue (100),
                   	 MakeUintegerAccessor (&SemifastClient::m_numClients),
                   	 MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("NumKeys",
+                   "The number of keys (registers) accessed by the client",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SemifastClient::m_numKeys),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KeyDistribution",
+                   "The distribution of the keys accessed by the client",
+                   EnumValue (AmKeySelector::UNIFORM),
+                   MakeEnumAccessor (&SemifastClient::m_keyDist),
+                   MakeEnumChecker (AmKeySelector::UNIFORM, "Uniform",
+                                    AmKeySelector::ZIPF, "Zipf"))
+    .AddAttribute ("ZipfAlpha",
+                   "The exponent of the zipf key distribution",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&SemifastClient::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Workload",
+                   "The arrival process of the operations of the client",
+                   EnumValue (AmWorkload::CLOSED_LOOP),
+                   MakeEnumAccessor (&SemifastClient::m_arrival),
+                   MakeEnumChecker (AmWorkload::CLOSED_LOOP, "ClosedLoop",
+                                    AmWorkload::POISSON, "Poisson",
+                                    AmWorkload::TRACE, "Trace"))
+    .AddAttribute ("ArrivalRate",
+                   "The mean number of operations per second of the Poisson arrivals",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&SemifastClient::m_arrivalRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TraceFile",
+                   "File with the arrival times (in seconds, one per line) to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&SemifastClient::m_traceFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -146,7 +188,6 @@ SemifastClient::SemifastClient ()
 	NS_LOG_FUNCTION (this);
 	m_sent = 0;
 	//m_socket = 0;
-	m_sendEvent = EventId ();
 	m_data = 0;
 	m_dataSize = 0;
 	m_serversConnected = 0;
@@ -194,7 +235,31 @@ SemifastClient::StartApplication (void)
 
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
+	m_key = 0;
+	m_keys.SetDistribution (m_numKeys, m_keyDist, m_zipfAlpha);
+
+	// operation arrivals
+	if (m_prType == READER)
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&SemifastClient::InvokeRead, this));
+	}
+	else
+	{
+		m_workload.SetInvokeCallback (MakeCallback (&SemifastClient::InvokeWrite, this));
+	}
+	switch (m_arrival)
+	{
+	case AmWorkload::POISSON:
+		m_workload.SetPoisson (m_arrivalRate);
+		break;
+	case AmWorkload::TRACE:
+		m_workload.SetTrace (m_traceFile);
+		break;
+	default:
+		m_workload.SetClosedLoop (m_interval, m_randInt);
+		break;
+	}
+	m_workload.SetMaxInFlight (1);
 
 	// seed pseudo-randomness
 	srand(m_seed);
@@ -206,9 +271,7 @@ SemifastClient::StartApplication (void)
 
 		for (uint32_t i = 0; i < m_serverAddress.size(); i++ )
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")";
-			LogInfo(sstm);
+			AM_LOG_INFO ("Connecting to SERVER (" << Ipv4Address::ConvertFrom(m_serverAddress[i]) << ")");
 
 			TypeId tid = TypeId::LookupByName ("ns3::TcpSocketFactory");
 			m_socket[i] = Socket::CreateSocket (GetNode (), tid);
@@ -225,19 +288,35 @@ SemifastClient::StartApplication (void)
 		}
 	}
 
-	AsmCommon::Reset(sstm);
-	sstm << "Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << " #vNodes= "<< m_numVNodes <<", Vid=" << m_virtualId << ", opInt=" << m_interval<<", debug="<<m_verbose;
-	LogInfo(sstm);
+	AM_LOG_INFO ("Started Succesfully: #S=" << m_numServers <<", #F=" << m_fail << " #vNodes= "<< m_numVNodes <<", Vid=" << m_virtualId << ", opInt=" << m_interval<<", debug="<<m_verbose);
 
 }
 
+AmClientStats
+SemifastClient::GetStats (void) const
+{
+	AmClientStats stats;
+	stats.sent = m_sent;
+	stats.invoked = m_opCount;
+	stats.completed = m_twoExOps+m_fourExOps;
+	if (m_prType == READER)
+	{
+		stats.slowReads = m_fourExOps;
+		stats.fastReads = m_twoExOps;
+	}
+	if (m_opCount > 0)
+	{
+		stats.commTime = m_opAve.GetSeconds () / m_opCount;
+		stats.compTime = m_real_opAve.count () / m_opCount;
+	}
+	return stats;
+}
+
 void 
 SemifastClient::StopApplication ()
 {
   NS_LOG_FUNCTION (this);
 
-  std::stringstream sstm;
-
   if ( !m_socket.empty() )
     {
 	  for(uint32_t i=0; i< m_socket.size(); i++ )
@@ -262,23 +341,17 @@ SemifastClient::StopApplication ()
   {
   case WRITER:
 	  //sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_twoExOps+m_fourExOps <<", AveOpTime="<< avg_time <<"s **";
-	  sstm << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_twoExOps+m_fourExOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_twoExOps+m_fourExOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** WRITER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent <<", #InvokedWrites=" << m_opCount <<", #CompletedWrites="<<m_twoExOps+m_fourExOps <<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   case READER:
 	  //sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_twoExOps+m_fourExOps <<", #4EXCH_reads="<< m_fourExOps << ", #2EXCH_reads="<<m_twoExOps<<", AveOpTime="<< avg_time <<"s **";
-	  sstm << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_twoExOps+m_fourExOps <<", #4EXCH_reads="<< m_fourExOps << ", #2EXCH_reads="<<m_twoExOps<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **";
 	  std::cout << "** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_twoExOps+m_fourExOps <<", #4EXCH_reads="<< m_fourExOps << ", #2EXCH_reads="<<m_twoExOps<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **"<<std::endl;
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("** READER_"<<m_personalID << " LOG: #sentMsgs="<<m_sent <<", #InvokedReads=" << m_opCount <<", #CompletedReads="<<m_twoExOps+m_fourExOps <<", #4EXCH_reads="<< m_fourExOps << ", #2EXCH_reads="<<m_twoExOps<<", AveOpTime="<< avg_time+real_avg_time <<"s, AveCommTime="<<avg_time<<"s, AvgCompTime="<<real_avg_time<<"s **");
 	  break;
   }
 
- if(m_personalID==m_numClients-1){
-  	exit(0);
- }	
-
-  Simulator::Cancel (m_sendEvent);
+  m_workload.Stop ();
 
   // switch(m_prType)
   // {
@@ -297,6 +370,8 @@ void
 SemifastClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_framer.Clear ();
+  m_registers.Clear ();
   Application::DoDispose ();
 }
 
@@ -313,15 +388,13 @@ void SemifastClient::ConnectionSucceeded (Ptr<Socket> socket)
 
   if (m_verbose)
   {
-	  std::stringstream sstm;
-	  sstm << "Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")";
-	  LogInfo(sstm);
+	  AM_LOG_INFO ("Connected to SERVER (" << InetSocketAddress::ConvertFrom (from).GetIpv4() <<")");
   }
 
   // Check if connected to the all the servers start operations
   if (m_serversConnected == m_serverAddress.size() )
   {
-	  ScheduleOperation (m_interval);
+	  m_workload.Start ();
   }
 }
 
@@ -362,6 +435,14 @@ SemifastClient::SetServers (std::vector<Address> ip)
 	}
 }
 
+int64_t
+SemifastClient::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t streams = m_workload.AssignStreams (stream);
+  return streams + m_keys.AssignStreams (stream + streams);
+}
+
 void
 SemifastClient::SetRemote (Address ip, uint16_t port)
 {
@@ -411,50 +492,36 @@ SemifastClient::SetFill (std::string fill)
     }
 
   memcpy (m_data, fill.c_str (), dataSize);
-
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
 }
 
-/**
- * OPERATION SCHEDULER
- */
-void 
-SemifastClient::ScheduleOperation (Time dt)
+/**************************************************************************************
+ * Semifast Read/Write Handlers
+ **************************************************************************************/
+void
+SemifastClient::SelectKey (void)
 {
-  NS_LOG_FUNCTION (this << dt);
-  std::stringstream sstm;
+	NS_LOG_FUNCTION (this);
 
-  // if rndomness is set - choose a random interval
-  if ( m_randInt )
-  {
-	  dt = Time::From( (rand() % (m_interval.GetMilliSeconds()-1000))+1000, Time::MS );
-  }
+	// park the state of the current key and load the one of the next key
+	Register &reg = m_registers.Get (m_key);
+	reg.ts = m_ts;
+	reg.value = m_value;
+	reg.pvalue = m_pvalue;
+	reg.payload = m_payload;
 
-  AsmCommon::Reset(sstm);
-  sstm << "** NEXT OPERATION: in " << dt.GetSeconds() <<"s";
-  LogInfo(sstm);
+	m_key = m_keys.GetNext ();
 
-  if (m_prType == READER )
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &SemifastClient::InvokeRead, this);
-  }
-  else
-  {
-	  m_sendEvent = Simulator::Schedule (dt, &SemifastClient::InvokeWrite, this);
-  }
+	Register &next = m_registers.Get (m_key);
+	m_ts = next.ts;
+	m_value = next.value;
+	m_pvalue = next.pvalue;
+	m_payload = next.payload;
 }
 
-/**************************************************************************************
- * Semifast Read/Write Handlers
- **************************************************************************************/
 void
 SemifastClient::InvokeRead (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
@@ -464,13 +531,13 @@ SemifastClient::InvokeRead (void)
 	m_real_start = std::chrono::system_clock::now();
 
 
-	AsmCommon::Reset(sstm);
-	sstm << "** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-	LogInfo(sstm);
+	AM_LOG_INFO ("** READ INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = READ;
@@ -487,20 +554,19 @@ void
 SemifastClient::InvokeWrite (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
 
 	m_opCount ++;
 	m_opStart = Now();
 
 	m_real_start = std::chrono::system_clock::now();
 
-	AsmCommon::Reset(sstm);
-	sstm << "** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s";
-	LogInfo(sstm);
+	AM_LOG_INFO ("** WRITE INVOKED: " << m_opCount << " at "<< m_opStart.GetSeconds() <<"s");
 
 	//check if we still have operations to perfrom
 	if ( m_opCount <=  m_count )
 	{
+		SelectKey ();
+
 		//Phase 1
 		m_opStatus = PHASE1;
 		m_msgType = WRITE;
@@ -509,6 +575,8 @@ SemifastClient::InvokeWrite (void)
 		m_ts ++;
 		m_pvalue = m_value;
 		m_value = 900+m_opCount;
+		// the new value and the previous one, which is none before the first write
+		m_payload = Create<Packet> (m_ts > 1 ? 2 * m_size : m_size);
 
 		//Send msg to all
 		m_replies = 0;		//reset replies
@@ -521,27 +589,19 @@ SemifastClient::HandleSend (void)
 {
   NS_LOG_FUNCTION (this);
 
-  //NS_ASSERT (m_sendEvent.IsExpired ());
-
-  // Prepare packet content
-  std::stringstream pkts;
-  // serialize <counter, msgType, ts, value, pvalue, vid>
-  pkts << m_opCount << " " << m_msgType << " " << m_ts << " " << m_value << " " << m_pvalue << " " << m_virtualId;
+  // Prepare packet content <counter, msgType, ts, value, pvalue, vid>
+  AmProtocolHeader hdr;
+  hdr.SetKey (m_key);
+  hdr.SetCounter (m_opCount);
+  hdr.SetType (m_msgType);
+  hdr.SetTs (m_ts);
+  hdr.SetValue (m_value);
+  hdr.SetPvalue (m_pvalue);
+  hdr.SetSender (m_virtualId);
 
-  SetFill(pkts.str());
-
-  // Create packet
-  Ptr<Packet> p;
-  if (m_dataSize)
-    {
-      NS_ASSERT_MSG (m_dataSize == m_size, "SemifastClient::HandleSend(): m_size and m_dataSize inconsistent");
-      NS_ASSERT_MSG (m_data, "SemifastClient::HandleSend(): m_dataSize but no m_data");
-      p = Create<Packet> (m_data, m_dataSize);
-    }
-  else
-    {
-      p = Create<Packet> (m_size);
-    }
+  // Create packet, all but the queries of the readers carry the bytes
+  // of the value and previous value
+  Ptr<Packet> p = m_framer.Build (hdr, m_msgType == READ ? 0 : m_payload);
 
 
   //random server to start from
@@ -558,9 +618,7 @@ SemifastClient::HandleSend (void)
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-          sstm << "Sent " << m_size << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current]) << " port " << m_peerPort;
-		  LogInfo ( sstm );
+		  AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " << Ipv4Address::ConvertFrom (m_serverAddress[current]) << " port " << m_peerPort);
 	  }
 
       // move to the next server
@@ -575,51 +633,45 @@ SemifastClient::HandleRecv (Ptr<Socket> socket)
 
   Ptr<Packet> packet;
   Address from;
-  //uint32_t msgT, msgTs, msgV, msgVp, msgC, msgViews;
-  uint32_t msgC;
+  AmProtocolHeader hdr;
 
-  while ((packet = socket->RecvFrom (from)))
+  while ((packet = m_framer.Recv (socket, from)))
   {
 	  //deserialize the contents of the packet
-	  uint8_t buf[1024];
-	  packet->CopyData(buf,1024);
-	  std::stringbuf sb;
-	  sb.str(std::string((char*) buf));
-	  std::istream istm(&sb);
-	  istm >> msgC;
+	  packet->RemoveHeader (hdr);
 
 	  if (m_verbose)
 	  {
-		  std::stringstream sstm;
-		  sstm << "Received " << packet->GetSize () << " bytes from " <<
+		  AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 				  InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf;
-		  LogInfo (sstm);
+				  InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr);
 	  }
 
 	  // check message freshness and if client is waiting
-	  if ( msgC == m_opCount && m_opStatus != IDLE)
+	  if ( hdr.GetCounter () == m_opCount && m_opStatus != IDLE)
 	  {
-		  ProcessReply(istm, from);
+		  ProcessReply(hdr, packet, from);
 	  }
   }
 }
 
 void
-SemifastClient::ProcessReply(std::istream& istm, Address sender)
+SemifastClient::ProcessReply(const AmProtocolHeader& hdr, Ptr<Packet> payload, Address sender)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::stringstream sstm;
-	uint32_t msgT, msgTs, msgV, msgVp, msgPs, msgViews, vId;
-	std::set<uint32_t> msgSeen;
+	AmSeenSet msgSeen;
 
 
 	//increment the number of replies received
 	m_replies ++;
 
 	// deserialize the message <T, <ts,v,vp>, ps, views>
-	istm >> msgT >> msgTs >> msgV >> msgVp >> msgPs >> msgViews;
+	uint32_t msgTs = hdr.GetTs ();
+	uint32_t msgV = hdr.GetValue ();
+	uint32_t msgVp = hdr.GetPvalue ();
+	uint32_t msgPs = hdr.GetPostit ();
+	uint32_t msgViews = hdr.GetViews ();
 
 	switch(m_prType)
 	{
@@ -627,7 +679,7 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 		if (m_replies >= (m_numServers - m_fail))
 		{
 			m_opStatus = IDLE;
-			ScheduleOperation (m_interval);
+			m_workload.OperationCompleted ();
 
 			m_real_end = std::chrono::system_clock::now();
 			std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;
@@ -637,11 +689,10 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 			// sstm << "** WRITE COMPLETED: " << m_opCount << " in "<< (m_opEnd.GetSeconds() - m_opStart.GetSeconds()) <<"s, <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **";
 			// LogInfo(sstm);
 
-			AsmCommon::Reset(sstm);
-			sstm << "** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **";
-			LogInfo(sstm);			
+			AM_LOG_INFO ("** WRITE COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value>: [" << m_ts << "," << m_value << "], @ 2 EXCH **");
 
 			m_opAve += m_opEnd - m_opStart;
+			m_opCompletedTrace (WRITE, 2, m_opEnd - m_opStart, m_ts, m_key, 0);
 			m_real_opAve += elapsed_seconds;  //
 
 			m_twoExOps++;
@@ -654,11 +705,7 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 		case PHASE1:
 			
 			// deserialize the seen set of the message
-			for (uint32_t i=0; i<msgViews; i++)
-			{
-				istm >> vId;
-				msgSeen.insert(vId);
-			}
+			msgSeen = hdr.GetSeen ();
 
 			//if new max ts discovered - update the local <ts, value, pvalue>
 			if(m_ts < msgTs)
@@ -666,12 +713,11 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 				m_ts = msgTs;
 				m_value = msgV;
 				m_pvalue = msgVp;
+				m_payload = payload;
 
 				if (m_verbose)
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Updated local <ts,value> pair to: [" << m_ts << "," << m_value << "," << m_pvalue <<"]";
-					LogInfo(sstm);
+					AM_LOG_INFO ("Updated local <ts,value> pair to: [" << m_ts << "," << m_value << "," << m_pvalue <<"]");
 				}
 
 				//reset the maxAck set and maxViews variables
@@ -701,9 +747,7 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 			{
 				if (m_verbose)
 				{
-					AsmCommon::Reset(sstm);
-					sstm << "Waiting for " << (m_numServers-m_fail) << " replies, received " << m_replies;
-					LogInfo(sstm);
+					AM_LOG_INFO ("Waiting for " << (m_numServers-m_fail) << " replies, received " << m_replies);
 				}
 
 					int predRes;
@@ -719,10 +763,8 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 						m_real_end = std::chrono::system_clock::now();									///
 						std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;		///
 
-						AsmCommon::Reset(sstm);
-						sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return Value: "<< m_value <<
-								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **";
-						LogInfo(sstm);
+						AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return Value: "<< m_value <<
+								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **");
 
 						//AsmCommon::Reset(sstm);
 						//sstm << "** READ COMPLETED: " << m_opCount << " in "<< (m_opEnd.GetSeconds() - m_opStart.GetSeconds()) <<"s, Return Value: "<< m_value <<
@@ -730,17 +772,16 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 						//LogInfo(sstm);
 
 						m_opAve += m_opEnd - m_opStart;
+						m_opCompletedTrace (READ, 2, m_opEnd - m_opStart, m_ts, m_key, 0);
 						m_real_opAve += elapsed_seconds;  //
-						ScheduleOperation (m_interval);
+						m_workload.OperationCompleted ();
 						//increase four exchange counter
 						m_twoExOps++;
 					}
                     // if predicate is valid with |seen| = a or maxPs=maxTs but < f+1 servers have it - Go to Phase2
 					else if (predRes == 2 || m_propSet.size() > 0)
 					{
-						AsmCommon::Reset(sstm);
-						sstm << "Proceeding to PHASE2, maxViews " << m_maxViews << ", bound "<< ((m_numServers/m_fail) - 2);
-						LogInfo(sstm);
+						AM_LOG_INFO ("Proceeding to PHASE2, maxViews " << m_maxViews << ", bound "<< ((m_numServers/m_fail) - 2));
 
 						//Phase 2
 						m_opStatus = PHASE2;
@@ -762,10 +803,8 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 						std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;	///
 
 						
-						AsmCommon::Reset(sstm);
-						sstm << "** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return PValue: "<< m_pvalue <<
-								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **";
-						LogInfo(sstm);
+						AM_LOG_INFO ("** READ COMPLETED: "  << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), Return PValue: "<< m_pvalue <<
+								", <ts, value, pvalue>: ["<< m_ts << "," << m_value << ","<< m_pvalue <<"] - @ 2 EXCH **");
 
 						// AsmCommon::Reset(sstm);
 						// sstm << "** READ COMPLETED: " << m_opCount << " in "<< (m_opEnd.GetSeconds() - m_opStart.GetSeconds()) <<"s, Return PValue: "<< m_pvalue <<
@@ -773,8 +812,9 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 						// LogInfo(sstm);
 
 						m_opAve += m_opEnd - m_opStart;
+						m_opCompletedTrace (READ, 2, m_opEnd - m_opStart, m_ts > 0 ? m_ts - 1 : 0, m_key, 0);
 						m_real_opAve += elapsed_seconds;  //
-						ScheduleOperation (m_interval);
+						m_workload.OperationCompleted ();
 						//increase four exchange counter
 						m_twoExOps++;
 					}
@@ -790,18 +830,17 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 				m_real_end = std::chrono::system_clock::now();								///
 				std::chrono::duration<double> elapsed_seconds = m_real_end-m_real_start;	///
 
-				AsmCommon::Reset(sstm);
 				//sstm << "** READ COMPLETED: " << m_opCount << " in COMM "<< (m_opEnd.GetSeconds() - m_opStart.GetSeconds()) << "s, and in COMPUTATION "<< elapsed_seconds.count() <<"s, <ts, value, pvalue>: [" << m_ts << "," << m_value << "," << m_pvalue << "] - @ 4 EXCH **";
-				sstm << "** READ COMPLETED: " << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value, pvalue>: [" << m_ts << "," << m_value << "," << m_pvalue << "] - @ 4 EXCH **";
-				LogInfo(sstm);
+				AM_LOG_INFO ("** READ COMPLETED: " << m_opCount << " in "<< ((m_opEnd.GetSeconds() - m_opStart.GetSeconds()) + elapsed_seconds.count()) << "s (<"<<(m_opEnd.GetSeconds() - m_opStart.GetSeconds())<<"> + <"<< elapsed_seconds.count() <<">), <ts, value, pvalue>: [" << m_ts << "," << m_value << "," << m_pvalue << "] - @ 4 EXCH **");
 
 				// AsmCommon::Reset(sstm);
 				// sstm << "** READ COMPLETED: " << m_opCount << " in "<< (m_opEnd.GetSeconds() - m_opStart.GetSeconds()) <<"s, <ts, value, pvalue>: [" << m_ts << "," << m_value << "," << m_pvalue << "] - @ 4 EXCH **";
 				// LogInfo(sstm);
 				
 				m_opAve += m_opEnd - m_opStart;
+				m_opCompletedTrace (READ, 4, m_opEnd - m_opStart, m_ts, m_key, 0);
 				m_real_opAve += elapsed_seconds;  //
-				ScheduleOperation (m_interval);
+				m_workload.OperationCompleted ();
 				//increase four exchange counter
 				m_fourExOps++;
 			}
@@ -814,6 +853,26 @@ SemifastClient::ProcessReply(std::istream& istm, Address sender)
 
 /**
  * \brief Checks if the predicate condition is valid
+ *
+ * The predicate holds for some a in [1, #VNodes] if a set MS of at least
+ * n - a*f maxAck replies has |intersection of their seen sets| >= a.
+ * For the smallest such a it returns 1 if some MS has an intersection
+ * larger than a, and 2 only if every qualifying MS has exactly a ids (the
+ * baseline returned on the first MS it enumerated, so it could report 2
+ * where a larger MS intersection exists).
+ *
+ * Instead of enumerating the subsets of maxAck, every id is counted over
+ * the seen sets (ids seen by fewer than the smallest MS can never be part
+ * of the intersection) and the distinct intersections of the remaining
+ * seen sets are built incrementally. The intersection of any MS is one of
+ * them, and MS can be any set of the replies that contain it. With r
+ * replies and u remaining ids there are at most min(2^r - 1, 2^u) distinct
+ * intersections, each costing O(r) set operations: still exponential in
+ * the worst case (the problem is a maximum biclique one), but bounded by
+ * the number of distinct ids instead of sum_a C(r, n - a*f) subsets, and
+ * linear in r when the seen sets are nested, as they are when the writes
+ * propagate in order.
+ *
  *Inputs : None
  *Outputs: 0:Condition is NOT valid
  *         1:Condition is valid and |m.seen|>alpha
@@ -824,91 +883,130 @@ SemifastClient::IsPredicateValid()
 {
 	NS_LOG_FUNCTION (this);
 
-	int msSize, combinations;
-	uint32_t a;
-	std::stringstream sstm;
-	//int f1,f2,f3;
-	std::set< std::pair< Address, std::set<uint32_t> > > maxSet;
-	std::set< std::pair< Address, std::set<uint32_t> > >::iterator it;
-	std::set<uint32_t> intersection;
+	std::set< std::pair< Address, AmSeenSet > >::iterator it;
+	std::vector<AmSeenSet> seen;
+	int valid;
 
-	//f1 = SetOperation<int>::Factorial(m_maxAckSet.size());
+	for (it = m_maxAckSet.begin(); it != m_maxAckSet.end(); it++)
+	{
+		seen.push_back((*it).second);
+	}
+	valid = EvaluatePredicate(seen, m_numServers, m_fail, m_numVNodes);
 
-	for(a = 1; a < m_numVNodes+1; a++)
+	if (m_verbose)
 	{
-		msSize = m_numServers - a*m_fail;
+		AM_LOG_INFO ("PREDICATE: maxAckSize=" << m_maxAckSet.size() << ", #VNodes=" << m_numVNodes << ", result=" << valid);
+	}
 
-		if (m_verbose)
-		{
-			AsmCommon::Reset(sstm);
-			sstm << "PREDICATE LOOP: a=" << a << ", msSize="<< msSize << " maxAckSize="<< m_maxAckSet.size() <<", bound=" << (m_numServers - a*m_fail);
-			LogInfo(sstm);
-		}
+	return valid;
+}
 
-		// Choose(maxAck.size(), msSize) possible different sets MS
-		//f2 = SetOperation<int>::Factorial(msSize);
-		//f3 = SetOperation<int>::Factorial(m_maxAckSet.size()-msSize);
-		//combinations = f1/(f2*f3);
+int
+SemifastClient::EvaluatePredicate (const std::vector<AmSeenSet> &seen, uint32_t numServers, uint32_t numFail, uint32_t numVNodes)
+{
+	int msSize, minSize;
+	uint32_t a, support;
+	std::vector<uint32_t> counts;
+	AmSeenSet frequent;
+	std::vector<AmSeenSet> views;
+	std::set<AmSeenSet> inters, next;
+	std::set<AmSeenSet>::iterator st;
+
+	if (numVNodes == 0 || numFail == 0 || seen.empty())
+	{
+		return 0;
+	}
 
-		combinations = SetOperation<int>::Choose(m_maxAckSet.size(), msSize);
+	// the smallest MS considered, for the largest a with a non empty MS
+	a = std::min(numVNodes, (numServers - 1) / numFail);
+	minSize = numServers - a*numFail;
+	if (a == 0 || minSize <= 0)
+	{
+		return 0;
+	}
 
-		// check each maxSet of size msSize
-		for(int i=0; i<combinations; i++)
+	// count the servers that have seen each id
+	for (uint32_t i = 0; i < seen.size(); i++)
+	{
+		if (counts.size() < seen[i].GetBound())
 		{
-			maxSet = SetOperation< std::pair< Address, std::set<uint32_t> > >::IthSubsetSizeK(m_maxAckSet, msSize, i);
-			intersection.clear();
+			counts.resize(seen[i].GetBound(), 0);
+		}
+		for (uint32_t id = 0; id < seen[i].GetBound(); id++)
+		{
+			counts[id] += seen[i].Contains(id);
+		}
+	}
 
-			if (m_verbose)
-			{
-				AsmCommon::Reset(sstm);
-				sstm << "MAX SET:{ ";
-				for ( it = maxSet.begin(); it != maxSet.end(); it++)
-				{
-					sstm << InetSocketAddress::ConvertFrom((*it).first).GetIpv4() << " ";
-				}
-				sstm << "}";
-				LogInfo(sstm);
-			}
+	// keep the ids seen by enough servers
+	for (uint32_t id = 0; id < counts.size(); id++)
+	{
+		if (counts[id] >= (uint32_t) minSize)
+		{
+			frequent.Insert(id);
+		}
+	}
+	for (uint32_t i = 0; i < seen.size(); i++)
+	{
+		views.push_back(seen[i]);
+		views.back().IntersectWith(frequent);
+	}
 
+	// build the distinct intersections of the seen sets
+	for (uint32_t i = 0; i < views.size(); i++)
+	{
+		next.clear();
+		next.insert(views[i]);
+		for (st = inters.begin(); st != inters.end(); st++)
+		{
+			AmSeenSet inter = *st;
+			inter.IntersectWith(views[i]);
+			next.insert(inter);
+		}
+		inters.insert(next.begin(), next.end());
+	}
 
-			// compute the intersection of the seen sets in maxSet
-			for (it = maxSet.begin(); it != maxSet.end(); it++)
-			{
-				if(intersection.empty())
-				{
-					intersection = (*it).second;
-				}
-				else
-				{
-					intersection = SetOperation<uint32_t>::intersect(intersection, (*it).second);
-				}
+	// the largest intersection of a set MS with at least msSize replies
+	std::vector<uint32_t> best (views.size() + 2, 0);
+	for (st = inters.begin(); st != inters.end(); st++)
+	{
+		support = 0;
+		for (uint32_t i = 0; i < views.size(); i++)
+		{
+			support += (*st).IsSubsetOf(views[i]);
+		}
+		best[support] = std::max(best[support], (*st).GetSize());
+	}
+	for (uint32_t i = views.size(); i > 0; i--)
+	{
+		best[i-1] = std::max(best[i-1], best[i]);
+	}
 
-				if (m_verbose)
-				{
-					AsmCommon::Reset(sstm);
-					sstm << "INTERSECTION LOOP: " << SetOperation<uint32_t>::printSet(intersection, "Intersection", "vid_");
-					LogInfo(sstm);
-				}
-			}
+	for(a = 1; a < numVNodes+1; a++)
+	{
+		msSize = numServers - a*numFail;
 
-			AsmCommon::Reset(sstm);
-			sstm << "INTERSECTION: " << SetOperation<uint32_t>::printSet(intersection, "", "vid_");
-			LogInfo(sstm);
+		if (msSize <= 0)
+		{
+			break;
+		}
+		if ((uint32_t) msSize > views.size())
+		{
+			continue;
+		}
 
-			//check the intersection size
-			if(intersection.size() > a)
-			{
-				return 1;
-			}
-			else if (intersection.size() == a)
-			{
-				return 2;
-			}
+		//check the intersection size
+		if(best[msSize] > a)
+		{
+			return 1;
+		}
+		else if (best[msSize] == a)
+		{
+			return 2;
 		}
 	}
 
 	return 0;
 }
 
-
 } // Namespace ns3
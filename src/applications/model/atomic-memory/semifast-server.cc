@@ -30,8 +30,13 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/enum.h"
 
 #include "semifast-server.h"
+#include "am-log.h"
+#include "am-protocol-header.h"
 
 namespace ns3 {
 
@@ -81,6 +86,36 @@ SemifastServer::GetTypeId (void)
 					 UintegerValue (0),
 					 MakeUintegerAccessor (&SemifastServer::m_verbose),
 					 MakeUintegerChecker<uint16_t> ())
+					.AddAttribute ("ServiceCores",
+					 "Messages processed at the same time, 0 to process every message on arrival",
+					 UintegerValue (0),
+					 MakeUintegerAccessor (&SemifastServer::m_serviceCores),
+					 MakeUintegerChecker<uint32_t> ())
+					.AddAttribute ("ServiceTime",
+					 "The processing time of a message, in seconds",
+					 StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"),
+					 MakePointerAccessor (&SemifastServer::m_serviceTime),
+					 MakePointerChecker<RandomVariableStream> ())
+					.AddAttribute ("ServiceTimePerItem",
+					 "The processing time added per entry of the seen set of the register of a message",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&SemifastServer::m_servicePerItem),
+					 MakeTimeChecker ())
+					.AddAttribute ("Fault",
+					 "The fault of the server: None, Crash (the messages received are lost) or Pause (they are held until the fault ends)",
+					 EnumValue (AmServiceQueue::NONE),
+					 MakeEnumAccessor (&SemifastServer::SetFault, &SemifastServer::GetFault),
+					 MakeEnumChecker (AmServiceQueue::NONE, "None",
+					                  AmServiceQueue::CRASH, "Crash",
+					                  AmServiceQueue::PAUSE, "Pause"))
+					.AddAttribute ("Slowdown",
+					 "The time every message received waits before it is processed",
+					 TimeValue (Seconds (0)),
+					 MakeTimeAccessor (&SemifastServer::SetSlowdown, &SemifastServer::GetSlowdown),
+					 MakeTimeChecker ())
+					.AddTraceSource ("MessageHandled", "A message was received and answered",
+					 MakeTraceSourceAccessor (&SemifastServer::m_handledTrace),
+					 "ns3::AmStatsCollector::MessageHandledCallback")
 					;
 	return tid;
 }
@@ -89,9 +124,6 @@ SemifastServer::SemifastServer ()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_ts = 0;
-	m_value = 0;
-	m_ps = 0;
 	m_sent=0;
 	m_optimize = 1;
 }
@@ -100,9 +132,6 @@ SemifastServer::~SemifastServer()
 {
 	NS_LOG_FUNCTION (this);
 	m_socket = 0;
-	m_ts = 0;
-	m_value = 0;
-	m_ps = 0;
 	m_sent=0;
 	m_optimize = 1;
 }
@@ -115,9 +144,13 @@ void
 SemifastServer::StartApplication (void)
 {
 	NS_LOG_FUNCTION (this);
-	std::stringstream sstm;
-	sstm << "Debug Mode="<<m_verbose;
-	LogInfo(sstm);
+
+	m_service.SetCores (m_serviceCores);
+	m_service.SetServiceTime (m_serviceTime);
+	m_service.SetPerItem (m_servicePerItem);
+	m_service.SetItemsCallback (MakeCallback (&SemifastServer::GetServiceItems, this));
+	m_service.SetServedCallback (MakeCallback (&SemifastServer::HandleRead, this));
+	AM_LOG_INFO ("Debug Mode="<<m_verbose);
 
 	if (m_socket == 0)
 	{
@@ -154,6 +187,12 @@ SemifastServer::StartApplication (void)
 			MakeCallback (&SemifastServer::HandlePeerError, this));
 }
 
+uint32_t
+SemifastServer::GetSentMessages (void) const
+{
+	return m_sent;
+}
+
 void 
 SemifastServer::StopApplication ()
 {
@@ -164,16 +203,25 @@ SemifastServer::StopApplication ()
 		m_socket->Close ();
 		m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
 	}
-	std::stringstream sstm;
-	sstm << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **";
-	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<" **"<<std::endl;
-	LogInfo(sstm);
+	std::cout << "** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **"<<std::endl;
+	AM_LOG_INFO ("** SERVER_"<<m_personalID <<" LOG: #sentMsgs="<<m_sent<<", #keys="<<m_registers.GetSize ()<<" **");
+	if (m_serviceCores > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" CPU: #served="<<m_service.GetServed ()<<", busyTime="<<m_service.GetBusyTime ().GetSeconds ()<<"s, AveWait="<<(m_service.GetServed () > 0 ? m_service.GetWaitTime ().GetSeconds () / m_service.GetServed () : 0)<<"s, #maxQueue="<<m_service.GetMaxQueue ()<<" **"<<std::endl;
+	}
+	if (m_service.GetDropped () > 0 || m_service.GetHeld () > 0)
+	{
+		std::cout << "** SERVER_"<<m_personalID <<" FAULTS: #dropped="<<m_service.GetDropped ()<<", #held="<<m_service.GetHeld ()<<" **"<<std::endl;
+	}
 }
 
 void
 SemifastServer::DoDispose (void)
 {
 	NS_LOG_FUNCTION (this);
+	m_framer.Clear ();
+	m_service.Clear ();
+	m_registers.Clear ();
 	Application::DoDispose ();
 }
 
@@ -184,6 +232,7 @@ SemifastServer::DoDispose (void)
 void SemifastServer::HandlePeerClose (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
+	m_framer.Remove (socket);
 }
 
 void SemifastServer::HandlePeerError (Ptr<Socket> socket)
@@ -200,33 +249,41 @@ void SemifastServer::HandleAccept (Ptr<Socket> s, const Address& from)
 }
 
 /**************************************************************************************
- * PACKET DATA Handler
+ * ABD Rcv Handler
  **************************************************************************************/
 void
-SemifastServer::SetFill (std::string fill)
+SemifastServer::SetFault (AmServiceQueue::Fault fault)
 {
-  NS_LOG_FUNCTION (this << fill);
+	NS_LOG_FUNCTION (this << fault);
+	m_service.SetFault (fault);
+}
 
-  uint32_t dataSize = fill.size () + 1;
+AmServiceQueue::Fault
+SemifastServer::GetFault (void) const
+{
+	return m_service.GetFault ();
+}
 
-  if (dataSize != m_dataSize)
-    {
-      //delete [] m_data;
-      m_data = new uint8_t [dataSize];
-      m_dataSize = dataSize;
-    }
+uint32_t
+SemifastServer::GetServiceItems (const AmProtocolHeader &hdr) const
+{
+	const Register *reg = m_registers.Find (hdr.GetKey ());
+	return (reg != 0)? reg->seen.GetSize () : 0;
+}
 
-  memcpy (m_data, fill.c_str (), dataSize);
+void
+SemifastServer::SetSlowdown (Time delay)
+{
+	NS_LOG_FUNCTION (this << delay);
+	m_service.SetSlowdown (delay);
+}
 
-  //
-  // Overwrite packet size attribute.
-  //
-  m_size = dataSize;
+Time
+SemifastServer::GetSlowdown (void) const
+{
+	return m_service.GetSlowdown ();
 }
 
-/**************************************************************************************
- * ABD Rcv Handler
- **************************************************************************************/
 void 
 SemifastServer::HandleRead (Ptr<Socket> socket)
 {
@@ -234,78 +291,56 @@ SemifastServer::HandleRead (Ptr<Socket> socket)
 
 	Ptr<Packet> packet;
 	Address from;
-	uint32_t msgT, msgTs, msgV, msgVp, msgC, msgVid;
-	std::stringstream sstm;
+	AmProtocolHeader hdr;
 
-	while ((packet = socket->RecvFrom (from)))
+	while ((packet = m_service.Recv (m_framer, socket, from)))
 	{
 		//deserialize the contents of the packet
-		uint8_t buf[1024];
-		packet->CopyData(buf,1024);
-		std::stringbuf sb;
-		sb.str(std::string((char*) buf));
-		std::istream istm(&sb);
-		istm >> msgC >> msgT >> msgTs >> msgV >> msgVp >> msgVid;
+		packet->RemoveHeader (hdr);
+		uint32_t sent = m_sent;
+		Register &reg = m_registers.Get (hdr.GetKey ());
+		uint32_t msgTs = hdr.GetTs ();
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Received " << packet->GetSize () << " bytes from " <<
+			AM_LOG_INFO ("Received " << packet->GetSize () + hdr.GetSerializedSize () << " bytes from " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << buf << " optimized " << m_optimize;
-			LogInfo(sstm);
+					InetSocketAddress::ConvertFrom (from).GetPort () << " data " << hdr << " optimized " << m_optimize);
 		}
 
-
-		packet->RemoveAllPacketTags ();
-		packet->RemoveAllByteTags ();
-
-		if ( m_ts < msgTs )
+		if ( reg.ts < msgTs )
 		{
 			NS_LOG_LOGIC ("Updating Local Info (ts and seen set)");
-			m_ts = msgTs;
-			m_value = msgV;
-			m_pvalue = msgVp;
+			reg.ts = msgTs;
+			reg.value = hdr.GetValue ();
+			reg.pvalue = hdr.GetPvalue ();
+			reg.payload = packet;
 
 			//reinitialize the seen set
-			m_seen.clear();
+			reg.seen.Clear ();
 		}
 
 		//insert the sender in the seen set
-		m_seen.insert(msgVid);
+		reg.seen.Insert (hdr.GetSender ());
 
 		// set the propagation flag if msg received from reader
-		if(msgTs > m_ps && msgT == INFORM && m_optimize == 1)
+		if(msgTs > reg.ps && hdr.GetType () == INFORM && m_optimize == 1)
 		{
-			m_ps = msgTs;
+			reg.ps = msgTs;
 		}
 
 		NS_LOG_LOGIC ("Replying to packet");
 
-		// Prepare packet content
-		std::stringstream pkts;
-		// serialize <counter, msgType, ts, value, |seen|, propflag>
-		pkts << msgC << " " << msgT << " " << m_ts << " " << m_value << " " << m_pvalue << " " << m_ps << " " << m_seen.size();
-
-		// serialize the members of seen set
-		for (std::set<uint32_t>::iterator it=m_seen.begin(); it!=m_seen.end(); it++ )
-		{
-			pkts << " " << *it;
-		}
+		// Prepare packet content <counter, msgType, ts, value, pvalue, ps, |seen|, seen>
+		hdr.SetTs (reg.ts);
+		hdr.SetValue (reg.value);
+		hdr.SetPvalue (reg.pvalue);
+		hdr.SetPostit (reg.ps);
+		hdr.SetViews (reg.seen.GetSize ());
+		hdr.SetSeen (reg.seen);
 
-		SetFill(pkts.str());
-
-		Ptr<Packet> p;
-		if (m_dataSize)
-		{
-			NS_ASSERT_MSG (m_dataSize == m_size, "SemifastServer::HandleSend(): m_size and m_dataSize inconsistent");
-			NS_ASSERT_MSG (m_data, "SemifastServer::HandleSend(): m_dataSize but no m_data");
-			p = Create<Packet> (m_data, m_dataSize);
-		}
-		else
-		{
-			p = Create<Packet> (m_size);
-		}
+		// the reads get the bytes of the value and previous value
+		Ptr<Packet> p = m_framer.Build (hdr, hdr.GetType () == READ ? reg.payload : 0);
 
 		//socket->SendTo (p, 0, from);
 		socket->Send (p);
@@ -313,13 +348,13 @@ SemifastServer::HandleRead (Ptr<Socket> socket)
 
 		if (m_verbose)
 		{
-			AsmCommon::Reset(sstm);
-			sstm << "Sent " << packet->GetSize () << " bytes to " <<
+			AM_LOG_INFO ("Sent " << p->GetSize () << " bytes to " <<
 					InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
 					InetSocketAddress::ConvertFrom (from).GetPort () << " "
-					<< SetOperation<uint32_t>::printSet(m_seen,"Seen", "");
-			LogInfo(sstm);
+					<< "Seen=" << reg.seen);
 		}
+
+		m_handledTrace (hdr.GetType (), m_sent - sent);
 	}
 }
 
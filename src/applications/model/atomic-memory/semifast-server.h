@@ -23,7 +23,13 @@
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
 #include "ns3/address.h"
+#include "ns3/packet.h"
+#include "ns3/traced-callback.h"
 #include "asm-common.h"
+#include "am-message-framer.h"
+#include "am-service-queue.h"
+#include "am-register-store.h"
+#include "am-seen-set.h"
 #include "set-operations.h"
 
 namespace ns3 {
@@ -53,6 +59,12 @@ public:
   SemifastServer ();
   virtual ~SemifastServer ();
 
+  /**
+   * \brief Get the number of messages this server has sent
+   * \returns the #sentMsgs of the LOG line
+   */
+  uint32_t GetSentMessages (void) const;
+
 protected:
   virtual void DoDispose (void);
 
@@ -63,10 +75,6 @@ private:
 
   //string stream for ease of output
   void LogInfo(std::stringstream& s);
-  /**
-   * \brief function to fill the packet with data
-   */
-  void SetFill (std::string fill);
   /**
    * \brief Handle a packet reception.
    *
@@ -75,6 +83,29 @@ private:
    * \param socket the socket the packet was received to.
    */
   void HandleRead (Ptr<Socket> socket);
+  /**
+   * \brief Start or end a fault of the server
+   * \param fault the fault
+   */
+  void SetFault (AmServiceQueue::Fault fault);
+  /**
+   * \returns the fault of the server
+   */
+  AmServiceQueue::Fault GetFault (void) const;
+  /**
+   * \param hdr a message
+   * \returns the entries of the seen set of the register of the message,
+   *          each charged ServiceTimePerItem
+   */
+  uint32_t GetServiceItems (const AmProtocolHeader &hdr) const;
+  /**
+   * \param delay the time every message received waits before it is processed
+   */
+  void SetSlowdown (Time delay);
+  /**
+   * \returns the time every message received waits before it is processed
+   */
+  Time GetSlowdown (void) const;
   /**
    * \brief Handle an incoming connection
    * \param socket the incoming connection socket
@@ -92,28 +123,38 @@ private:
    */
   void HandlePeerError (Ptr<Socket> socket);
 
-  uint32_t m_dataSize; 	//!< packet payload size (must be equal to m_size)
-  uint8_t *m_data; 		//!< packet payload data
-
   uint16_t m_port; //!< Port on which we listen for incoming packets.
   uint32_t m_size; //!< The size of the packet
   Ptr<Socket> m_socket; //!< IPv4 Socket
   std::list<Ptr<Socket> > m_socketList; //!< the accepted sockets
+  AmMessageFramer m_framer; //!< reassembles the messages of each socket
+  AmServiceQueue m_service; //!< processing time of the messages
+  uint32_t m_serviceCores; //!< cores of the server, 0 for no processing time
+  Ptr<RandomVariableStream> m_serviceTime; //!< processing time of a message (s)
+  Time m_servicePerItem; //!< processing time per seen entry of the register of a message
   Address m_local; //!< local multicast address
   Address m_myAddress; //!< ip address
   uint32_t m_personalID;        //My Personal ID
 
   // ccHybrid variables
-  uint32_t m_ts; 				//!< latest timestamp
-  uint32_t m_value;				//!< value associated with m_ts
-  uint32_t m_pvalue;			//!< value associated with m_ts - 1 (previous value)
-  std::set< uint32_t > m_seen;	//!< set of IDs storing the IDs of the processes seen our latest ts/value
-  uint32_t m_ps;				//!< maximum postit
+  /// State of a single register (key)
+  struct Register
+  {
+    uint32_t ts;                //!< latest timestamp
+    uint32_t value;             //!< value associated with ts
+    uint32_t pvalue;            //!< value associated with ts - 1 (previous value)
+    Ptr<Packet> payload;        //!< bytes of value and pvalue, as received
+    AmSeenSet seen;             //!< ids of the processes that have seen our latest ts/value
+    uint32_t ps;                //!< maximum postit
+  };
+  AmRegisterStore<Register> m_registers; //!< register state per key
   uint16_t m_optimize;			//!< switch on/off prop optimization
 
   //uint32_t m_opCount;
   //uint32_t m_completeOps;
   uint32_t m_sent;    //!< Counter for sent packets
+  /// Callbacks for tracing the handled messages
+  TracedCallback<uint32_t, uint32_t> m_handledTrace;
   uint16_t m_verbose;   //!< Debug mode
 };
 
@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/packet.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/asm-common.h"
+#include "ns3/am-service-queue.h"
+#include "ns3/coded-abd-helper.h"
+#include "ns3/am-history-checker.h"
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief write the arrival times of a TRACE workload
+ * \param fileName the trace file
+ * \param times the arrival times (ms)
+ */
+static void
+WriteTrace (std::string fileName, const std::vector<uint32_t> &times)
+{
+  std::ofstream trace (fileName.c_str ());
+  for (uint32_t i = 0; i < times.size (); i++)
+    {
+      trace << times[i] / 1000.0 << std::endl;
+    }
+}
+
+/**
+ * \brief set the slowdown of a server
+ * \param server the server application
+ * \param delay the slowdown
+ */
+static void
+SetSlowdown (Ptr<Application> server, Time delay)
+{
+  server->SetAttribute ("Slowdown", TimeValue (delay));
+}
+
+/**
+ * Check a read whose fragments the servers collected, while a server is
+ * crashed: the quorum of the other servers returns fewer than k fragments,
+ * and the read starts over instead of waiting for the crashed server.
+ *
+ * 5 servers, 1 failure, k = 3, GcDepth 0, server 4 crashed, a writer W
+ * and a reader R on one channel (1ms):
+ *  - W writes tag 1 at 100ms, and R reads it at 200ms;
+ *  - R invokes a read at 290ms, which finds tag 1: servers 0-3 slow its
+ *    READ_FINALIZE down for 100ms;
+ *  - W writes tag 2 at 320ms: its finalization at 325ms collects the
+ *    fragments of tag 1;
+ *  - the READ_FINALIZE acks of servers 0-3 carry no fragment at 394ms,
+ *    and the read starts over with tag 2.
+ *
+ * The clients start their workload once connected to every server, so the
+ * slowdown follows the messages of R rather than the clock.
+ */
+class AmCodedAbdCollectedTestCase : public TestCase
+{
+public:
+  AmCodedAbdCollectedTestCase ();
+  virtual ~AmCodedAbdCollectedTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief slow the servers down for the READ_FINALIZE of the second read
+   * \param p the packet sent by the reader
+   */
+  void ReaderTx (Ptr<const Packet> p);
+
+  ApplicationContainer m_servers;  //!< the server applications
+  uint32_t m_readerTx;             //!< packets sent by the reader
+};
+
+AmCodedAbdCollectedTestCase::AmCodedAbdCollectedTestCase ()
+  : TestCase ("Check that a read whose fragments were collected completes with a server crashed"),
+    m_readerTx (0)
+{
+}
+
+AmCodedAbdCollectedTestCase::~AmCodedAbdCollectedTestCase ()
+{
+}
+
+void
+AmCodedAbdCollectedTestCase::ReaderTx (Ptr<const Packet> p)
+{
+  // each round of the reader sends one packet to each of the 5 servers:
+  // the fourth round is the READ_FINALIZE of the second read
+  if (++m_readerTx != 16)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < m_servers.GetN () - 1; i++)
+    {
+      SetSlowdown (m_servers.Get (i), MilliSeconds (100));
+      Simulator::Schedule (MicroSeconds (1500), &SetSlowdown, m_servers.Get (i), MilliSeconds (0));
+    }
+}
+
+void
+AmCodedAbdCollectedTestCase::DoRun (void)
+{
+  uint32_t numServers = 5;
+  uint32_t numFail = 1;
+  uint16_t port = 44400;
+
+  NodeContainer serverNodes;
+  serverNodes.Create (numServers);
+  NodeContainer clientNodes;
+  clientNodes.Create (2);
+  NodeContainer nodes (serverNodes, clientNodes);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  // every node on one channel, 1ms away from the others
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+
+  std::vector<Address> serverAddress;
+  ApplicationContainer &servers = m_servers;
+  for (uint32_t i = 0; i < numServers; i++)
+    {
+      serverAddress.push_back (interfaces.GetAddress (i));
+      CodedAbdServerHelper server (port);
+      server.SetAttribute ("ID", UintegerValue (i + 2));
+      server.SetAttribute ("GcDepth", UintegerValue (0));
+      if (i == numServers - 1)
+        {
+          server.SetAttribute ("Fault", EnumValue (AmServiceQueue::CRASH));
+        }
+      servers.Add (server.Install (serverNodes.Get (i)));
+    }
+  servers.Start (Seconds (0.5));
+  servers.Stop (Seconds (5));
+
+  std::string writerTrace = CreateTempDirFilename ("am-coded-abd-writer.txt");
+  std::string readerTrace = CreateTempDirFilename ("am-coded-abd-reader.txt");
+  std::vector<uint32_t> writes;
+  writes.push_back (100);
+  writes.push_back (320);
+  WriteTrace (writerTrace, writes);
+  std::vector<uint32_t> reads;
+  reads.push_back (200);
+  reads.push_back (290);
+  WriteTrace (readerTrace, reads);
+
+  ApplicationContainer clients;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      CodedAbdClientHelper client (serverAddress[0], port);
+      client.SetAttribute ("SetRole", UintegerValue (i == 0 ? WRITER : READER));
+      client.SetAttribute ("ID", UintegerValue (i));
+      client.SetAttribute ("MaxFailures", UintegerValue (numFail));
+      client.SetAttribute ("Clients", UintegerValue (2));
+      client.SetAttribute ("MaxOperations", UintegerValue (i == 0 ? writes.size () : reads.size ()));
+      client.SetWorkload (AmWorkload::TRACE, 1.0, i == 0 ? writerTrace : readerTrace);
+      Ptr<Application> app = client.Install (clientNodes.Get (i)).Get (0);
+      client.SetServers (app, serverAddress);
+      clients.Add (app);
+      if (i == 1)
+        {
+          app->TraceConnectWithoutContext ("Tx", MakeCallback (&AmCodedAbdCollectedTestCase::ReaderTx, this));
+        }
+    }
+  clients.Start (Seconds (1));
+  clients.Stop (Seconds (5));
+
+  Ptr<AmHistoryChecker> checker = CreateObject<AmHistoryChecker> ();
+  checker->AddClients (clients);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+  checker->Finish ();
+
+  NS_TEST_ASSERT_MSG_EQ (checker->GetOperations (), writes.size () + reads.size (), "every operation completes");
+  NS_TEST_ASSERT_MSG_EQ (checker->GetUnmatched (), 0, "every read returns a completed write");
+  NS_TEST_ASSERT_MSG_EQ (checker->GetViolations (), 0, "the restarted read returns the second write");
+  checker->Dispose ();
+}
+
+/**
+ * Test suite of the coded atomic storage (CAS) clients and servers
+ */
+class AmCodedAbdTestSuite : public TestSuite
+{
+public:
+  AmCodedAbdTestSuite ();
+};
+
+AmCodedAbdTestSuite::AmCodedAbdTestSuite ()
+  : TestSuite ("am-coded-abd", UNIT)
+{
+  AddTestCase (new AmCodedAbdCollectedTestCase, TestCase::QUICK);
+}
+
+static AmCodedAbdTestSuite amCodedAbdTestSuite;
@@ -0,0 +1,266 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/asm-common.h"
+#include "ns3/am-history-checker.h"
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \param client the index of the client
+ * \param type WRITE or READ
+ * \param invoked the invocation time (ms)
+ * \param completed the response time (ms)
+ * \param ts the timestamp of the tag
+ * \param writer the writer of the tag
+ * \param key the key of the register
+ * \returns the operation
+ */
+static AmHistoryChecker::Operation
+MakeOp (uint32_t client, uint32_t type, uint32_t invoked, uint32_t completed,
+        uint32_t ts, uint32_t writer = 0, uint32_t key = 0)
+{
+  AmHistoryChecker::Operation op;
+  op.client = client;
+  op.type = type;
+  op.key = key;
+  op.invoked = MilliSeconds (invoked);
+  op.completed = MilliSeconds (completed);
+  op.tag = AmHistoryChecker::Tag (ts, writer);
+  return op;
+}
+
+/**
+ * \brief check a history, given in the order of the responses
+ * \param ops the operations
+ * \returns the checker, finished
+ */
+static Ptr<AmHistoryChecker>
+CheckHistory (const std::vector<AmHistoryChecker::Operation> &ops)
+{
+  Ptr<AmHistoryChecker> checker = CreateObject<AmHistoryChecker> ();
+  for (uint32_t i = 0; i < ops.size (); i++)
+    {
+      checker->Check (ops[i]);
+    }
+  checker->Finish ();
+  return checker;
+}
+
+/**
+ * Test that atomic histories, sequential and concurrent, single and multi
+ * writer, are accepted
+ */
+class AmHistoryCheckerAtomicTestCase : public TestCase
+{
+public:
+  AmHistoryCheckerAtomicTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmHistoryCheckerAtomicTestCase::AmHistoryCheckerAtomicTestCase ()
+  : TestCase ("Check that atomic histories are accepted")
+{
+}
+
+void
+AmHistoryCheckerAtomicTestCase::DoRun (void)
+{
+  std::vector<AmHistoryChecker::Operation> ops;
+  // a read of the initial value, then a write and the reads around it
+  ops.push_back (MakeOp (1, READ, 0, 5, 0));
+  ops.push_back (MakeOp (2, READ, 8, 12, 0));    // concurrent, old value
+  ops.push_back (MakeOp (1, READ, 9, 14, 1));    // concurrent, new value
+  ops.push_back (MakeOp (0, WRITE, 10, 20, 1));  // the write completes last
+  ops.push_back (MakeOp (2, READ, 25, 30, 1));
+  // two writers with the same timestamp, ordered by their id
+  ops.push_back (MakeOp (0, WRITE, 40, 50, 2, 0));
+  ops.push_back (MakeOp (3, WRITE, 41, 51, 2, 3));
+  ops.push_back (MakeOp (1, READ, 60, 70, 2, 3));
+  // the keys are independent
+  ops.push_back (MakeOp (0, WRITE, 80, 90, 1, 0, 7));
+  ops.push_back (MakeOp (1, READ, 95, 99, 1, 0, 7));
+
+  Ptr<AmHistoryChecker> checker = CheckHistory (ops);
+  NS_TEST_ASSERT_MSG_EQ (checker->GetOperations (), ops.size (), "Operations were not checked");
+  NS_TEST_ASSERT_MSG_EQ (checker->GetViolations (), 0, "An atomic history was rejected");
+  NS_TEST_ASSERT_MSG_EQ (checker->GetUnmatched (), 0, "A read was left unmatched");
+  NS_TEST_ASSERT_MSG_EQ (checker->GetUnchecked (), 0, "An operation was left unchecked");
+}
+
+/**
+ * Test that every kind of violation is found, with the operations that
+ * broke atomicity
+ */
+class AmHistoryCheckerViolationsTestCase : public TestCase
+{
+public:
+  AmHistoryCheckerViolationsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmHistoryCheckerViolationsTestCase::AmHistoryCheckerViolationsTestCase ()
+  : TestCase ("Check that the violating histories are rejected")
+{
+}
+
+void
+AmHistoryCheckerViolationsTestCase::DoRun (void)
+{
+  /// A violating history and the violation expected
+  struct History
+  {
+    std::vector<AmHistoryChecker::Operation> ops; //!< the operations, by response
+    std::string reason;                           //!< the violation
+    uint32_t client;                              //!< the client that broke it
+    uint32_t violations;                          //!< the violations found
+  };
+  std::vector<History> histories (6);
+
+  histories[0].ops.push_back (MakeOp (0, WRITE, 0, 10, 0));
+  histories[0].reason = "the write has the initial tag";
+  histories[0].client = 0;
+  histories[0].violations = 1;
+
+  histories[1].ops.push_back (MakeOp (0, WRITE, 0, 10, 2));
+  histories[1].ops.push_back (MakeOp (0, WRITE, 20, 30, 1));
+  histories[1].reason = "the write has no greater tag than an operation completed before it";
+  histories[1].client = 0;
+  histories[1].violations = 1;
+
+  // a stale read, after the write completed
+  histories[2].ops.push_back (MakeOp (0, WRITE, 0, 10, 1));
+  histories[2].ops.push_back (MakeOp (1, READ, 20, 30, 0));
+  histories[2].reason = "the read returned an older tag than an operation completed before it";
+  histories[2].client = 1;
+  histories[2].violations = 1;
+
+  // a new-old inversion: the second read returns an older value than the
+  // first, which completed before it, while both writes are in progress
+  histories[3].ops.push_back (MakeOp (0, WRITE, 0, 5, 1));
+  histories[3].ops.push_back (MakeOp (1, READ, 10, 20, 2));
+  histories[3].ops.push_back (MakeOp (2, READ, 30, 40, 1));
+  histories[3].ops.push_back (MakeOp (0, WRITE, 6, 50, 2));
+  histories[3].reason = "the read returned an older tag than an operation completed before it";
+  histories[3].client = 2;
+  histories[3].violations = 1;
+
+  histories[4].ops.push_back (MakeOp (0, WRITE, 0, 10, 1, 0));
+  histories[4].ops.push_back (MakeOp (3, WRITE, 5, 15, 1, 0));
+  histories[4].reason = "two writes have the same tag";
+  histories[4].client = 3;
+  histories[4].violations = 1;
+
+  // the read returned a value from the future, which the write then does
+  // not exceed either
+  histories[5].ops.push_back (MakeOp (1, READ, 0, 10, 1));
+  histories[5].ops.push_back (MakeOp (0, WRITE, 20, 30, 1));
+  histories[5].reason = "the read returned the tag of a write invoked after it completed";
+  histories[5].client = 1;
+  histories[5].violations = 2;
+
+  for (uint32_t h = 0; h < histories.size (); h++)
+    {
+      Ptr<AmHistoryChecker> checker = CheckHistory (histories[h].ops);
+      NS_TEST_ASSERT_MSG_EQ (checker->GetViolations (), histories[h].violations, "History " << h << " has a wrong number of violations");
+      NS_TEST_ASSERT_MSG_EQ (checker->GetViolationList ().size (), histories[h].violations, "The violations of history " << h << " were not kept");
+      bool found = false;
+      for (uint32_t i = 0; i < checker->GetViolationList ().size (); i++)
+        {
+          const AmHistoryChecker::Violation &v = checker->GetViolationList ()[i];
+          if (v.reason == histories[h].reason && v.op.client == histories[h].client)
+            {
+              found = true;
+              NS_TEST_ASSERT_MSG_EQ (v.hasOther, (h != 0), "History " << h << " has a wrong conflicting operation");
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (found, true, "History " << h << " was not rejected for: " << histories[h].reason);
+    }
+}
+
+/**
+ * Test that the reads of a write that never completed are unmatched, not
+ * violations, and that the operations older than the horizon are dropped
+ */
+class AmHistoryCheckerUnmatchedTestCase : public TestCase
+{
+public:
+  AmHistoryCheckerUnmatchedTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmHistoryCheckerUnmatchedTestCase::AmHistoryCheckerUnmatchedTestCase ()
+  : TestCase ("Check the unmatched reads and the horizon")
+{
+}
+
+void
+AmHistoryCheckerUnmatchedTestCase::DoRun (void)
+{
+  std::vector<AmHistoryChecker::Operation> ops;
+  ops.push_back (MakeOp (0, WRITE, 0, 10, 1));
+  ops.push_back (MakeOp (1, READ, 20, 30, 2));
+  Ptr<AmHistoryChecker> checker = CheckHistory (ops);
+  NS_TEST_ASSERT_MSG_EQ (checker->GetViolations (), 0, "A read of a write in progress was rejected");
+  NS_TEST_ASSERT_MSG_EQ (checker->GetUnmatched (), 1, "The read of a write that never completed was not unmatched");
+
+  // the history is checked as the simulation runs, within a horizon of 1s
+  checker = CreateObject<AmHistoryChecker> ();
+  checker->SetAttribute ("Horizon", TimeValue (Seconds (1)));
+  Simulator::Schedule (Seconds (1), &AmHistoryChecker::Check, checker, MakeOp (0, WRITE, 900, 1000, 1));
+  Simulator::Schedule (Seconds (2), &AmHistoryChecker::Check, checker, MakeOp (0, WRITE, 1900, 2000, 2));
+  Simulator::Schedule (Seconds (3), &AmHistoryChecker::Check, checker, MakeOp (0, WRITE, 2900, 3000, 3));
+  Simulator::Schedule (Seconds (4), &AmHistoryChecker::Check, checker, MakeOp (0, WRITE, 3900, 4000, 4));
+  // a read invoked before the horizon is unchecked
+  Simulator::Schedule (Seconds (4), &AmHistoryChecker::Check, checker, MakeOp (1, READ, 500, 4000, 0));
+  // the last write before the horizon still bounds the newer operations
+  Simulator::Schedule (Seconds (4), &AmHistoryChecker::Check, checker, MakeOp (1, READ, 2500, 4000, 1));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (checker->GetUnchecked (), 1, "The read invoked before the horizon was checked");
+  NS_TEST_ASSERT_MSG_EQ (checker->GetViolations (), 1, "The stale read after the horizon was not rejected");
+}
+
+/**
+ * The atomicity checker test suite
+ */
+class AmHistoryCheckerTestSuite : public TestSuite
+{
+public:
+  AmHistoryCheckerTestSuite ();
+};
+
+AmHistoryCheckerTestSuite::AmHistoryCheckerTestSuite ()
+  : TestSuite ("am-history-checker", UNIT)
+{
+  AddTestCase (new AmHistoryCheckerAtomicTestCase, TestCase::QUICK);
+  AddTestCase (new AmHistoryCheckerViolationsTestCase, TestCase::QUICK);
+  AddTestCase (new AmHistoryCheckerUnmatchedTestCase, TestCase::QUICK);
+}
+
+static AmHistoryCheckerTestSuite amHistoryCheckerTestSuite;
@@ -0,0 +1,431 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/socket.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/am-message-framer.h"
+#include <deque>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * A socket that hands out the segments given to it, as a stream socket
+ * delivers the bytes of its peer, however they were split or coalesced
+ */
+class AmScriptedSocket : public Socket
+{
+public:
+  /**
+   * \brief queue a segment to be received
+   * \param segment the segment
+   */
+  void Deliver (Ptr<Packet> segment)
+  {
+    m_segments.push_back (segment);
+  }
+
+  virtual Ptr<Packet> RecvFrom (uint32_t maxSize, uint32_t flags, Address &fromAddress)
+  {
+    if (m_segments.empty ())
+      {
+        return 0;
+      }
+    Ptr<Packet> segment = m_segments.front ();
+    m_segments.pop_front ();
+    fromAddress = Address ();
+    return segment;
+  }
+  virtual Ptr<Packet> Recv (uint32_t maxSize, uint32_t flags)
+  {
+    Address from;
+    return RecvFrom (maxSize, flags, from);
+  }
+
+  virtual enum SocketErrno GetErrno (void) const { return ERROR_NOTERROR; }
+  virtual enum SocketType GetSocketType (void) const { return NS3_SOCK_STREAM; }
+  virtual Ptr<Node> GetNode (void) const { return 0; }
+  virtual int Bind (const Address &address) { return 0; }
+  virtual int Bind () { return 0; }
+  virtual int Bind6 () { return 0; }
+  virtual int Close (void) { return 0; }
+  virtual int ShutdownSend (void) { return 0; }
+  virtual int ShutdownRecv (void) { return 0; }
+  virtual int Connect (const Address &address) { return 0; }
+  virtual int Listen (void) { return 0; }
+  virtual uint32_t GetTxAvailable (void) const { return 0; }
+  virtual int Send (Ptr<Packet> p, uint32_t flags) { return -1; }
+  virtual int SendTo (Ptr<Packet> p, uint32_t flags, const Address &toAddress) { return -1; }
+  virtual uint32_t GetRxAvailable (void) const { return 0; }
+  virtual int GetSockName (Address &address) const { return 0; }
+  virtual int GetPeerName (Address &address) const { return 0; }
+  virtual bool SetAllowBroadcast (bool allowBroadcast) { return false; }
+  virtual bool GetAllowBroadcast () const { return false; }
+
+private:
+  std::deque<Ptr<Packet> > m_segments; //!< the segments not received yet
+};
+
+/**
+ * \param size the size of the message
+ * \param seed distinguishes the bytes of the messages
+ * \returns the bytes of a message
+ */
+static std::vector<uint8_t>
+MakeMessage (uint32_t size, uint32_t seed)
+{
+  std::vector<uint8_t> bytes (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      bytes[i] = static_cast<uint8_t> (seed * 31 + i * 7);
+    }
+  return bytes;
+}
+
+/**
+ * \param p a packet
+ * \returns the bytes of the packet
+ */
+static std::vector<uint8_t>
+GetBytes (Ptr<const Packet> p)
+{
+  std::vector<uint8_t> bytes (p->GetSize ());
+  if (!bytes.empty ())
+    {
+      p->CopyData (&bytes[0], bytes.size ());
+    }
+  return bytes;
+}
+
+/**
+ * \param messages the bytes of the messages
+ * \returns the byte stream of the messages, each with its length prefix
+ */
+static std::vector<uint8_t>
+MakeStream (const std::vector<std::vector<uint8_t> > &messages)
+{
+  std::vector<uint8_t> stream;
+  for (uint32_t m = 0; m < messages.size (); m++)
+    {
+      Ptr<Packet> p = messages[m].empty () ? Create<Packet> () : Create<Packet> (&messages[m][0], messages[m].size ());
+      AmMessageFramer::Frame (p);
+      std::vector<uint8_t> framed = GetBytes (p);
+      stream.insert (stream.end (), framed.begin (), framed.end ());
+    }
+  return stream;
+}
+
+/**
+ * Test that messages coalesced into a single segment are handed out one
+ * by one, in order
+ */
+class AmFramerCoalescedTestCase : public TestCase
+{
+public:
+  AmFramerCoalescedTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmFramerCoalescedTestCase::AmFramerCoalescedTestCase ()
+  : TestCase ("Check that the messages coalesced into one segment are received one by one")
+{
+}
+
+void
+AmFramerCoalescedTestCase::DoRun (void)
+{
+  std::vector<std::vector<uint8_t> > messages;
+  messages.push_back (MakeMessage (20, 1));
+  messages.push_back (MakeMessage (1, 2));
+  messages.push_back (MakeMessage (300, 3));
+  std::vector<uint8_t> stream = MakeStream (messages);
+
+  Ptr<AmScriptedSocket> socket = CreateObject<AmScriptedSocket> ();
+  socket->Deliver (Create<Packet> (&stream[0], stream.size ()));
+
+  AmMessageFramer framer;
+  Address from;
+  for (uint32_t m = 0; m < messages.size (); m++)
+    {
+      Ptr<Packet> p = framer.Recv (socket, from);
+      NS_TEST_ASSERT_MSG_NE (p, 0, "Message " << m << " was not received");
+      NS_TEST_ASSERT_MSG_EQ ((GetBytes (p) == messages[m]), true, "Message " << m << " was received corrupted");
+    }
+  NS_TEST_ASSERT_MSG_EQ (framer.Recv (socket, from), 0, "A message was received out of nothing");
+}
+
+/**
+ * Test that a message split over segments, at every offset including the
+ * ones within the length prefix, is reassembled
+ */
+class AmFramerFragmentedTestCase : public TestCase
+{
+public:
+  AmFramerFragmentedTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmFramerFragmentedTestCase::AmFramerFragmentedTestCase ()
+  : TestCase ("Check that a message split over segments at any offset is reassembled")
+{
+}
+
+void
+AmFramerFragmentedTestCase::DoRun (void)
+{
+  std::vector<std::vector<uint8_t> > messages;
+  messages.push_back (MakeMessage (40, 4));
+  std::vector<uint8_t> stream = MakeStream (messages);
+
+  for (uint32_t cut = 1; cut < stream.size (); cut++)
+    {
+      Ptr<AmScriptedSocket> socket = CreateObject<AmScriptedSocket> ();
+      AmMessageFramer framer;
+      Address from;
+
+      // a partial message is kept until the rest of it arrives
+      socket->Deliver (Create<Packet> (&stream[0], cut));
+      NS_TEST_ASSERT_MSG_EQ (framer.Recv (socket, from), 0, "A partial message was received at cut " << cut);
+
+      socket->Deliver (Create<Packet> (&stream[cut], stream.size () - cut));
+      Ptr<Packet> p = framer.Recv (socket, from);
+      NS_TEST_ASSERT_MSG_NE (p, 0, "The message was not reassembled at cut " << cut);
+      NS_TEST_ASSERT_MSG_EQ ((GetBytes (p) == messages[0]), true, "The message was corrupted at cut " << cut);
+      NS_TEST_ASSERT_MSG_EQ (framer.Recv (socket, from), 0, "A message was received out of nothing at cut " << cut);
+    }
+
+  // one byte per segment
+  Ptr<AmScriptedSocket> socket = CreateObject<AmScriptedSocket> ();
+  for (uint32_t i = 0; i < stream.size (); i++)
+    {
+      socket->Deliver (Create<Packet> (&stream[i], 1));
+    }
+  AmMessageFramer framer;
+  Address from;
+  Ptr<Packet> p = framer.Recv (socket, from);
+  NS_TEST_ASSERT_MSG_NE (p, 0, "The message of one-byte segments was not reassembled");
+  NS_TEST_ASSERT_MSG_EQ ((GetBytes (p) == messages[0]), true, "The message of one-byte segments was corrupted");
+}
+
+/**
+ * Test that a stream of messages chopped into random segments, each of which
+ * may end a message, hold several or start the next one, is received intact
+ */
+class AmFramerRandomTestCase : public TestCase
+{
+public:
+  AmFramerRandomTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmFramerRandomTestCase::AmFramerRandomTestCase ()
+  : TestCase ("Check that a stream chopped into random segments is received intact")
+{
+}
+
+void
+AmFramerRandomTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  for (uint32_t run = 0; run < 20; run++)
+    {
+      std::vector<std::vector<uint8_t> > messages;
+      for (uint32_t m = 0; m < 30; m++)
+        {
+          messages.push_back (MakeMessage (random->GetInteger (0, 2000), run * 100 + m));
+        }
+      std::vector<uint8_t> stream = MakeStream (messages);
+
+      // the messages are received as soon as they are complete
+      Ptr<AmScriptedSocket> socket = CreateObject<AmScriptedSocket> ();
+      AmMessageFramer framer;
+      Address from;
+      std::vector<std::vector<uint8_t> > received;
+      uint32_t offset = 0;
+      while (offset < stream.size ())
+        {
+          uint32_t size = std::min<uint32_t> (random->GetInteger (1, 1500), stream.size () - offset);
+          socket->Deliver (Create<Packet> (&stream[offset], size));
+          offset += size;
+
+          Ptr<Packet> p;
+          while ((p = framer.Recv (socket, from)))
+            {
+              received.push_back (GetBytes (p));
+            }
+        }
+
+      NS_TEST_ASSERT_MSG_EQ (received.size (), messages.size (), "Run " << run << " lost or added messages");
+      for (uint32_t m = 0; m < received.size (); m++)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((received[m] == messages[m]), true, "Message " << m << " of run " << run << " was corrupted");
+        }
+    }
+}
+
+/**
+ * Test that a value of virtual zero bytes split over many segments is
+ * reassembled without materializing the zeros
+ */
+class AmFramerVirtualTestCase : public TestCase
+{
+public:
+  AmFramerVirtualTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmFramerVirtualTestCase::AmFramerVirtualTestCase ()
+  : TestCase ("Check that a zero-filled value split over segments stays virtual")
+{
+}
+
+void
+AmFramerVirtualTestCase::DoRun (void)
+{
+  const uint32_t valueSize = 1000000;
+  const uint32_t segmentSize = 1448;
+
+  // two messages of a real header followed by a value of virtual zeros,
+  // cut into segments as a stream socket would, the message boundary
+  // falling within a segment
+  std::vector<std::vector<uint8_t> > messages;
+  std::vector<Ptr<Packet> > segments;
+  Ptr<Packet> tail;
+  for (uint32_t m = 0; m < 2; m++)
+    {
+      std::vector<uint8_t> header = MakeMessage (30, m);
+      Ptr<Packet> p = Create<Packet> (&header[0], header.size ());
+      p->AddAtEnd (Create<Packet> (valueSize));
+      AmMessageFramer::Frame (p);
+      messages.push_back (header);
+      messages.back ().resize (header.size () + valueSize, 0);
+
+      uint32_t offset = 0;
+      if (tail != 0)
+        {
+          offset = segmentSize - tail->GetSize ();
+          tail->AddAtEnd (p->CreateFragment (0, offset));
+          segments.push_back (tail);
+        }
+      for (; offset + segmentSize <= p->GetSize (); offset += segmentSize)
+        {
+          segments.push_back (p->CreateFragment (offset, segmentSize));
+        }
+      tail = p->CreateFragment (offset, p->GetSize () - offset);
+    }
+  segments.push_back (tail);
+
+  Ptr<AmScriptedSocket> socket = CreateObject<AmScriptedSocket> ();
+  for (uint32_t i = 0; i < segments.size (); i++)
+    {
+      socket->Deliver (segments[i]);
+    }
+
+  AmMessageFramer framer;
+  Address from;
+  for (uint32_t m = 0; m < messages.size (); m++)
+    {
+      Ptr<Packet> p = framer.Recv (socket, from);
+      NS_TEST_ASSERT_MSG_NE (p, 0, "Message " << m << " was not received");
+      NS_TEST_ASSERT_MSG_LT (p->GetSerializedSize (), 4 * segmentSize, "The value of message " << m << " was materialized");
+      NS_TEST_ASSERT_MSG_EQ ((GetBytes (p) == messages[m]), true, "Message " << m << " was received corrupted");
+    }
+  NS_TEST_ASSERT_MSG_EQ (framer.Recv (socket, from), 0, "A message was received out of nothing");
+}
+
+/**
+ * Test that the reassembly buffers of the sockets are kept apart, and that
+ * Remove drops the partial message of a socket
+ */
+class AmFramerSocketsTestCase : public TestCase
+{
+public:
+  AmFramerSocketsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmFramerSocketsTestCase::AmFramerSocketsTestCase ()
+  : TestCase ("Check that the sockets are reassembled apart and Remove drops a partial message")
+{
+}
+
+void
+AmFramerSocketsTestCase::DoRun (void)
+{
+  std::vector<std::vector<uint8_t> > first (1, MakeMessage (50, 5));
+  std::vector<std::vector<uint8_t> > second (1, MakeMessage (70, 6));
+  std::vector<uint8_t> a = MakeStream (first);
+  std::vector<uint8_t> b = MakeStream (second);
+
+  Ptr<AmScriptedSocket> sa = CreateObject<AmScriptedSocket> ();
+  Ptr<AmScriptedSocket> sb = CreateObject<AmScriptedSocket> ();
+  AmMessageFramer framer;
+  Address from;
+
+  sa->Deliver (Create<Packet> (&a[0], 10));
+  sb->Deliver (Create<Packet> (&b[0], 30));
+  NS_TEST_ASSERT_MSG_EQ (framer.Recv (sa, from), 0, "A partial message was received");
+  NS_TEST_ASSERT_MSG_EQ (framer.Recv (sb, from), 0, "A partial message was received");
+
+  sb->Deliver (Create<Packet> (&b[30], b.size () - 30));
+  Ptr<Packet> p = framer.Recv (sb, from);
+  NS_TEST_ASSERT_MSG_NE (p, 0, "The message of the second socket was not reassembled");
+  NS_TEST_ASSERT_MSG_EQ ((GetBytes (p) == second[0]), true, "The message of the second socket was mixed up");
+
+  // a new stream starts on the socket, the partial message is gone
+  framer.Remove (sa);
+  sa->Deliver (Create<Packet> (&a[0], a.size ()));
+  p = framer.Recv (sa, from);
+  NS_TEST_ASSERT_MSG_NE (p, 0, "The message sent after Remove was not received");
+  NS_TEST_ASSERT_MSG_EQ ((GetBytes (p) == first[0]), true, "The partial message survived Remove");
+  NS_TEST_ASSERT_MSG_EQ (framer.Recv (sa, from), 0, "A message was received out of nothing");
+}
+
+/**
+ * Test suite of the framing of the atomic memory messages
+ */
+class AmMessageFramerTestSuite : public TestSuite
+{
+public:
+  AmMessageFramerTestSuite ();
+};
+
+AmMessageFramerTestSuite::AmMessageFramerTestSuite ()
+  : TestSuite ("am-message-framer", UNIT)
+{
+  AddTestCase (new AmFramerCoalescedTestCase, TestCase::QUICK);
+  AddTestCase (new AmFramerFragmentedTestCase, TestCase::QUICK);
+  AddTestCase (new AmFramerRandomTestCase, TestCase::QUICK);
+  AddTestCase (new AmFramerVirtualTestCase, TestCase::QUICK);
+  AddTestCase (new AmFramerSocketsTestCase, TestCase::QUICK);
+}
+
+static AmMessageFramerTestSuite amMessageFramerTestSuite;
@@ -0,0 +1,237 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/asm-common.h"
+#include "ns3/abd-helper.h"
+#include "ns3/am-history-checker.h"
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief write the arrival times of a TRACE workload
+ * \param fileName the trace file
+ * \param times the arrival times (ms)
+ */
+static void
+WriteTrace (std::string fileName, const std::vector<uint32_t> &times)
+{
+  std::ofstream trace (fileName.c_str ());
+  for (uint32_t i = 0; i < times.size (); i++)
+    {
+      trace << times[i] / 1000.0 << std::endl;
+    }
+}
+
+/**
+ * \brief set the slowdown of a server
+ * \param server the server application
+ * \param delay the slowdown
+ */
+static void
+SetSlowdown (Ptr<Application> server, Time delay)
+{
+  server->SetAttribute ("Slowdown", TimeValue (delay));
+}
+
+/**
+ * \brief slow down the servers [first, last) from a time on
+ * \param servers the server applications
+ * \param first the first server
+ * \param last the server after the last one
+ * \param at the time (ms)
+ * \param delay the slowdown (ms)
+ */
+static void
+ScheduleSlowdown (ApplicationContainer servers, uint32_t first, uint32_t last,
+                  uint32_t at, uint32_t delay)
+{
+  for (uint32_t i = first; i < last; i++)
+    {
+      Simulator::Schedule (MilliSeconds (at), &SetSlowdown, servers.Get (i), MilliSeconds (delay));
+    }
+}
+
+/**
+ * Check the reads of a client with read leases and several operations in
+ * flight: a read that writes back a newer tag than the lease of its client
+ * completes after the lease of its own quorum ended, and the next read,
+ * answered by the lease of a read that completed in the meantime, must not
+ * return the older tag.
+ *
+ * 5 servers, 2 failures, a writer W and a reader R on one channel (1ms):
+ *  - W writes tag 2 at 310ms, applied at server 4 only (the others slow it
+ *    down for 1s);
+ *  - R invokes the read B at 320ms, whose quorum (servers 0, 4, 1) returns
+ *    tags 1 and 2 by 372ms, with leases until 420ms;
+ *  - R invokes the read A at 340ms, before B knows tag 2: servers 0-3
+ *    answer it at once with tag 1, and A gets a lease until 440ms;
+ *  - B writes tag 2 back, slowed down for 55ms by servers 0-3: it completes
+ *    at 429ms, after its own lease ended;
+ *  - R invokes the read C at 432ms, under the lease of A.
+ */
+class AmReadLeaseTestCase : public TestCase
+{
+public:
+  AmReadLeaseTestCase ();
+  virtual ~AmReadLeaseTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmReadLeaseTestCase::AmReadLeaseTestCase ()
+  : TestCase ("Check that a read lease does not return an older tag than a read of its client that completed")
+{
+}
+
+AmReadLeaseTestCase::~AmReadLeaseTestCase ()
+{
+}
+
+void
+AmReadLeaseTestCase::DoRun (void)
+{
+  uint32_t numServers = 5;
+  uint32_t numFail = 2;
+  uint16_t port = 44400;
+  Time start = Seconds (1);
+
+  NodeContainer serverNodes;
+  serverNodes.Create (numServers);
+  NodeContainer clientNodes;
+  clientNodes.Create (2);
+  NodeContainer nodes (serverNodes, clientNodes);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  // every node on one channel, 1ms away from the others
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+
+  std::vector<Address> serverAddress;
+  ApplicationContainer servers;
+  for (uint32_t i = 0; i < numServers; i++)
+    {
+      serverAddress.push_back (interfaces.GetAddress (i));
+      AbdServerHelper server (port);
+      server.SetAttribute ("ID", UintegerValue (i + 2));
+      server.SetAttribute ("Transport", EnumValue (TRANSPORT_UDP));
+      server.SetAttribute ("LeaseTime", TimeValue (MilliSeconds (100)));
+      servers.Add (server.Install (serverNodes.Get (i)));
+    }
+  servers.Start (Seconds (0.5));
+  servers.Stop (Seconds (5));
+
+  // the first operation of each client fills the ARP caches, long before
+  // the leases of the second one
+  std::string writerTrace = CreateTempDirFilename ("am-read-lease-writer.txt");
+  std::string readerTrace = CreateTempDirFilename ("am-read-lease-reader.txt");
+  std::vector<uint32_t> writes;
+  writes.push_back (0);
+  writes.push_back (310);
+  WriteTrace (writerTrace, writes);
+  std::vector<uint32_t> reads;
+  reads.push_back (50);
+  reads.push_back (320);
+  reads.push_back (340);
+  reads.push_back (432);
+  WriteTrace (readerTrace, reads);
+
+  ApplicationContainer clients;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      AbdClientHelper client (serverAddress[0], port);
+      client.SetAttribute ("SetRole", UintegerValue (i == 0 ? WRITER : READER));
+      client.SetAttribute ("ID", UintegerValue (i));
+      client.SetAttribute ("MaxFailures", UintegerValue (numFail));
+      client.SetAttribute ("Clients", UintegerValue (2));
+      client.SetAttribute ("MaxOperations", UintegerValue (i == 0 ? writes.size () : reads.size ()));
+      client.SetAttribute ("MaxInFlight", UintegerValue (4));
+      client.SetAttribute ("Transport", EnumValue (TRANSPORT_UDP));
+      client.SetAttribute ("RetransmitTimeout", TimeValue (Seconds (10)));
+      client.SetAttribute ("LeaseTime", TimeValue (MilliSeconds (100)));
+      client.SetWorkload (AmWorkload::TRACE, 1.0, i == 0 ? writerTrace : readerTrace);
+      Ptr<Application> app = client.Install (clientNodes.Get (i)).Get (0);
+      client.SetServers (app, serverAddress);
+      clients.Add (app);
+    }
+  clients.Start (start);
+  clients.Stop (Seconds (5));
+
+  // the write reaches server 4 only, and the quorum of B has its tag
+  ScheduleSlowdown (servers, 0, 4, 1305, 1000);
+  ScheduleSlowdown (servers, 0, 1, 1315, 0);
+  ScheduleSlowdown (servers, 1, 4, 1315, 50);
+  ScheduleSlowdown (servers, 4, 5, 1315, 30);
+  // the quorum of A overtakes B
+  ScheduleSlowdown (servers, 1, 4, 1335, 0);
+  // the write back of B completes after its lease, under the one of A
+  ScheduleSlowdown (servers, 0, 4, 1372, 55);
+
+  Ptr<AmHistoryChecker> checker = CreateObject<AmHistoryChecker> ();
+  checker->AddClients (clients);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+  checker->Finish ();
+
+  NS_TEST_ASSERT_MSG_EQ (checker->GetOperations (), writes.size () + reads.size (), "every operation completes");
+  NS_TEST_ASSERT_MSG_EQ (checker->GetUnmatched (), 0, "every read returns a completed write");
+  NS_TEST_ASSERT_MSG_EQ (checker->GetViolations (), 0, "the lease read returns the tag of the read that completed before it");
+  checker->Dispose ();
+}
+
+/**
+ * Test suite of the read leases of the clients
+ */
+class AmReadLeaseTestSuite : public TestSuite
+{
+public:
+  AmReadLeaseTestSuite ();
+};
+
+AmReadLeaseTestSuite::AmReadLeaseTestSuite ()
+  : TestSuite ("am-read-lease", UNIT)
+{
+  AddTestCase (new AmReadLeaseTestCase, TestCase::QUICK);
+}
+
+static AmReadLeaseTestSuite amReadLeaseTestSuite;
@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/am-reed-solomon.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief build a value of pseudo random bytes
+ * \param size the size of the value
+ * \param random the random variable
+ * \return the value
+ */
+static std::vector<uint8_t>
+MakeValue (uint32_t size, Ptr<UniformRandomVariable> random)
+{
+  std::vector<uint8_t> value (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      value[i] = random->GetInteger (0, 255);
+    }
+  return value;
+}
+
+/**
+ * \brief the value as decoded: padded with zeros to k fragments
+ * \param value the value
+ * \param code the code
+ * \return the padded value
+ */
+static std::vector<uint8_t>
+Padded (const std::vector<uint8_t> &value, const AmReedSolomon &code)
+{
+  std::vector<uint8_t> padded = value;
+  padded.resize (code.GetK () * code.GetFragmentSize (value.size ()), 0);
+  return padded;
+}
+
+/**
+ * Test that a value is decoded from every set of k fragments of small codes,
+ * and that the data fragments are slices of the value
+ */
+class AmReedSolomonErasuresTestCase : public TestCase
+{
+public:
+  AmReedSolomonErasuresTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmReedSolomonErasuresTestCase::AmReedSolomonErasuresTestCase ()
+  : TestCase ("Check that a value is decoded from every set of k fragments")
+{
+}
+
+void
+AmReedSolomonErasuresTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  uint32_t codes[][2] = { {1, 1}, {4, 4}, {5, 1}, {5, 3}, {6, 2}, {7, 4}, {9, 5} };
+  uint32_t sizes[] = { 0, 1, 7, 64, 1000 };
+
+  for (uint32_t c = 0; c < sizeof (codes) / sizeof (codes[0]); c++)
+    {
+      AmReedSolomon code;
+      code.SetCode (codes[c][0], codes[c][1]);
+      uint32_t n = code.GetN (), k = code.GetK ();
+
+      for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+        {
+          std::vector<uint8_t> value = MakeValue (sizes[s], random);
+          std::vector<uint8_t> padded = Padded (value, code);
+          std::vector<std::vector<uint8_t> > fragments;
+          code.Encode (value, fragments);
+
+          NS_TEST_ASSERT_MSG_EQ (fragments.size (), n, "[" << n << "," << k << "] gave the wrong number of fragments");
+          for (uint32_t i = 0; i < n; i++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (fragments[i].size (), code.GetFragmentSize (value.size ()), "Fragment " << i << " has the wrong size");
+            }
+          for (uint32_t j = 0; j < k; j++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (std::equal (fragments[j].begin (), fragments[j].end (), padded.begin () + j * fragments[j].size ()),
+                                     true, "Data fragment " << j << " is not a slice of the value");
+            }
+
+          // every subset of exactly k fragments, that is every n - k erasures
+          for (uint32_t mask = 0; mask < (1u << n); mask++)
+            {
+              if ((uint32_t) __builtin_popcount (mask) != k)
+                {
+                  continue;
+                }
+              std::map<uint32_t, std::vector<uint8_t> > received;
+              for (uint32_t i = 0; i < n; i++)
+                {
+                  if (mask & (1u << i))
+                    {
+                      received[i] = fragments[i];
+                    }
+                }
+              std::vector<uint8_t> decoded;
+              NS_TEST_ASSERT_MSG_EQ (code.Decode (received, decoded), true, "[" << n << "," << k << "] failed on fragments " << mask);
+              NS_TEST_ASSERT_MSG_EQ ((decoded == padded), true, "[" << n << "," << k << "] decoded a wrong value of "
+                                     << value.size () << " bytes from fragments " << mask);
+            }
+        }
+    }
+}
+
+/**
+ * Test random erasures of larger codes, including parity only sets and more
+ * than k fragments
+ */
+class AmReedSolomonRandomTestCase : public TestCase
+{
+public:
+  AmReedSolomonRandomTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmReedSolomonRandomTestCase::AmReedSolomonRandomTestCase ()
+  : TestCase ("Check random erasures of larger codes")
+{
+}
+
+void
+AmReedSolomonRandomTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (2);
+
+  for (uint32_t run = 0; run < 200; run++)
+    {
+      AmReedSolomon code;
+      uint32_t n = (run == 0) ? 256 : random->GetInteger (2, 40);
+      uint32_t k = random->GetInteger (1, n);
+      code.SetCode (n, k);
+
+      std::vector<uint8_t> value = MakeValue (random->GetInteger (0, 3000), random);
+      std::vector<std::vector<uint8_t> > fragments;
+      code.Encode (value, fragments);
+
+      // the parity fragments first when there are k of them
+      std::vector<uint32_t> order;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          order.push_back (i);
+        }
+      if (run % 3 == 0 && n - k >= k)
+        {
+          std::rotate (order.begin (), order.begin () + k, order.end ());
+        }
+      else
+        {
+          for (uint32_t i = n - 1; i > 0; i--)
+            {
+              std::swap (order[i], order[random->GetInteger (0, i)]);
+            }
+        }
+
+      std::map<uint32_t, std::vector<uint8_t> > received;
+      uint32_t count = random->GetInteger (k, n);
+      for (uint32_t i = 0; i < count; i++)
+        {
+          received[order[i]] = fragments[order[i]];
+        }
+      std::vector<uint8_t> decoded;
+      NS_TEST_ASSERT_MSG_EQ (code.Decode (received, decoded), true, "Run " << run << ": [" << n << "," << k << "] failed");
+      NS_TEST_ASSERT_MSG_EQ ((decoded == Padded (value, code)), true, "Run " << run << ": [" << n << "," << k << "] decoded a wrong value");
+    }
+}
+
+/**
+ * Test that Decode refuses sets of fragments it cannot decode
+ */
+class AmReedSolomonRefusedTestCase : public TestCase
+{
+public:
+  AmReedSolomonRefusedTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmReedSolomonRefusedTestCase::AmReedSolomonRefusedTestCase ()
+  : TestCase ("Check that too few or inconsistent fragments are refused")
+{
+}
+
+void
+AmReedSolomonRefusedTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (3);
+
+  AmReedSolomon code;
+  code.SetCode (5, 3);
+  std::vector<uint8_t> value = MakeValue (100, random);
+  std::vector<std::vector<uint8_t> > fragments;
+  code.Encode (value, fragments);
+  std::vector<uint8_t> decoded;
+
+  std::map<uint32_t, std::vector<uint8_t> > received;
+  received[1] = fragments[1];
+  received[4] = fragments[4];
+  NS_TEST_ASSERT_MSG_EQ (code.Decode (received, decoded), false, "Decoded from k - 1 fragments");
+
+  received[2] = fragments[2];
+  received[2].pop_back ();
+  NS_TEST_ASSERT_MSG_EQ (code.Decode (received, decoded), false, "Decoded from fragments of different sizes");
+
+  received.erase (2);
+  received[7] = fragments[2];
+  NS_TEST_ASSERT_MSG_EQ (code.Decode (received, decoded), false, "Decoded a fragment index past n");
+}
+
+/**
+ * The Reed-Solomon code test suite
+ */
+class AmReedSolomonTestSuite : public TestSuite
+{
+public:
+  AmReedSolomonTestSuite ();
+};
+
+AmReedSolomonTestSuite::AmReedSolomonTestSuite ()
+  : TestSuite ("am-reed-solomon", UNIT)
+{
+  AddTestCase (new AmReedSolomonErasuresTestCase, TestCase::QUICK);
+  AddTestCase (new AmReedSolomonRandomTestCase, TestCase::QUICK);
+  AddTestCase (new AmReedSolomonRefusedTestCase, TestCase::QUICK);
+}
+
+static AmReedSolomonTestSuite amReedSolomonTestSuite;
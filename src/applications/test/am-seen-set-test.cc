@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/am-seen-set.h"
+#include "ns3/am-protocol-header.h"
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \brief build a seen set with the given ids
+ * \param ids the ids
+ * \return the seen set
+ */
+static AmSeenSet
+MakeSeen (const std::set<uint32_t> &ids)
+{
+  AmSeenSet seen;
+  for (std::set<uint32_t>::const_iterator it = ids.begin (); it != ids.end (); it++)
+    {
+      seen.Insert (*it);
+    }
+  return seen;
+}
+
+/**
+ * \brief check a seen set holds exactly the given ids
+ * \param seen the seen set
+ * \param ids the ids
+ * \return true if they hold the same ids
+ */
+static bool
+SameIds (const AmSeenSet &seen, const std::set<uint32_t> &ids)
+{
+  if (seen.GetSize () != ids.size () || seen.IsEmpty () != ids.empty ())
+    {
+      return false;
+    }
+  for (uint32_t id = 0; id < seen.GetBound (); id++)
+    {
+      if (seen.Contains (id) != (ids.count (id) > 0))
+        {
+          return false;
+        }
+    }
+  return ids.empty () || *ids.rbegin () < seen.GetBound ();
+}
+
+/**
+ * Test inserting, clearing and printing ids, across the word boundaries
+ */
+class AmSeenSetBasicTestCase : public TestCase
+{
+public:
+  AmSeenSetBasicTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmSeenSetBasicTestCase::AmSeenSetBasicTestCase ()
+  : TestCase ("Check inserting, clearing and printing the ids of a seen set")
+{
+}
+
+void
+AmSeenSetBasicTestCase::DoRun (void)
+{
+  AmSeenSet seen;
+  NS_TEST_ASSERT_MSG_EQ (seen.IsEmpty (), true, "A new set is not empty");
+  NS_TEST_ASSERT_MSG_EQ (seen.GetBound (), 0, "A new set has words");
+
+  seen.Insert (31);
+  seen.Insert (32);
+  seen.Insert (0);
+  seen.Insert (32);
+  NS_TEST_ASSERT_MSG_EQ (seen.GetSize (), 3, "Inserting an id twice counted it twice");
+  NS_TEST_ASSERT_MSG_EQ (seen.GetBound (), 64, "Id 32 is in the second word");
+  NS_TEST_ASSERT_MSG_EQ (seen.Contains (31), true, "Id 31 is missing");
+  NS_TEST_ASSERT_MSG_EQ (seen.Contains (1), false, "Id 1 was never inserted");
+  NS_TEST_ASSERT_MSG_EQ (seen.Contains (1000), false, "Id 1000 is past the words");
+
+  std::ostringstream os;
+  seen.Print (os, "vid_");
+  NS_TEST_ASSERT_MSG_EQ (os.str (), "{ vid_0 vid_31 vid_32 }", "Wrong print");
+  os.str ("");
+  os << seen;
+  NS_TEST_ASSERT_MSG_EQ (os.str (), "{ 0 31 32 }", "Wrong output operator");
+
+  seen.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (seen.IsEmpty (), true, "A cleared set is not empty");
+  NS_TEST_ASSERT_MSG_EQ ((seen == AmSeenSet ()), true, "A cleared set differs from a new one");
+  seen.Insert (5);
+  std::set<uint32_t> ids;
+  ids.insert (5);
+  NS_TEST_ASSERT_MSG_EQ (SameIds (seen, ids), true, "A cleared set kept old ids");
+}
+
+/**
+ * Test intersections, subsets, equality and the word layout against
+ * std::set on random ids
+ */
+class AmSeenSetRandomTestCase : public TestCase
+{
+public:
+  AmSeenSetRandomTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmSeenSetRandomTestCase::AmSeenSetRandomTestCase ()
+  : TestCase ("Check the set operations of seen sets against std::set")
+{
+}
+
+void
+AmSeenSetRandomTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  for (uint32_t run = 0; run < 500; run++)
+    {
+      // ids over up to four words, so the sets often differ in length
+      uint32_t range = random->GetInteger (1, 128);
+      std::set<uint32_t> a, b;
+      for (uint32_t i = random->GetInteger (0, 40); i > 0; i--)
+        {
+          a.insert (random->GetInteger (0, range - 1));
+        }
+      for (uint32_t i = random->GetInteger (0, 40); i > 0; i--)
+        {
+          b.insert (random->GetInteger (0, range - 1));
+        }
+      if (run % 4 == 0)
+        {
+          // b is a superset of a
+          b.insert (a.begin (), a.end ());
+        }
+      AmSeenSet sa = MakeSeen (a), sb = MakeSeen (b);
+      NS_TEST_ASSERT_MSG_EQ (SameIds (sa, a), true, "Run " << run << " lost inserted ids");
+
+      std::set<uint32_t> inter;
+      std::set_intersection (a.begin (), a.end (), b.begin (), b.end (), std::inserter (inter, inter.begin ()));
+      AmSeenSet si = sa;
+      si.IntersectWith (sb);
+      NS_TEST_ASSERT_MSG_EQ (SameIds (si, inter), true, "Run " << run << " has a wrong intersection");
+      // the trailing words emptied by the intersection are dropped
+      NS_TEST_ASSERT_MSG_EQ ((si == MakeSeen (inter)), true, "Run " << run << " kept zero words");
+      NS_TEST_ASSERT_MSG_EQ ((si < MakeSeen (inter) || MakeSeen (inter) < si), false, "Run " << run << " is ordered apart from an equal set");
+
+      bool subset = std::includes (b.begin (), b.end (), a.begin (), a.end ());
+      NS_TEST_ASSERT_MSG_EQ (sa.IsSubsetOf (sb), subset, "Run " << run << " has a wrong subset relation");
+      NS_TEST_ASSERT_MSG_EQ (si.IsSubsetOf (sa) && si.IsSubsetOf (sb), true, "Run " << run << " intersection is not a subset");
+      NS_TEST_ASSERT_MSG_EQ ((sa == sb), (a == b), "Run " << run << " has a wrong equality");
+      NS_TEST_ASSERT_MSG_EQ ((sa == sb) || (sa < sb) != (sb < sa), true, "Run " << run << " is not strictly ordered");
+
+      AmSeenSet sw;
+      sw.SetWords (sa.GetWords ());
+      NS_TEST_ASSERT_MSG_EQ ((sw == sa), true, "Run " << run << " changed through its words");
+      NS_TEST_ASSERT_MSG_EQ (sw.GetSize (), a.size (), "Run " << run << " was recounted wrong");
+    }
+}
+
+/**
+ * Test that the seen set survives the protocol header and that trailing
+ * zero words are not kept
+ */
+class AmSeenSetHeaderTestCase : public TestCase
+{
+public:
+  AmSeenSetHeaderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmSeenSetHeaderTestCase::AmSeenSetHeaderTestCase ()
+  : TestCase ("Check that a seen set is carried intact by the protocol header")
+{
+}
+
+void
+AmSeenSetHeaderTestCase::DoRun (void)
+{
+  std::vector<uint32_t> words;
+  words.push_back (0x80000001);
+  words.push_back (0);
+  words.push_back (4);
+  words.push_back (0);
+  words.push_back (0);
+
+  AmSeenSet seen;
+  seen.SetWords (words);
+  NS_TEST_ASSERT_MSG_EQ (seen.GetWords ().size (), 3, "Trailing zero words were kept");
+  NS_TEST_ASSERT_MSG_EQ (seen.GetSize (), 3, "Wrong count of the words");
+  NS_TEST_ASSERT_MSG_EQ (seen.Contains (66), true, "Id 66 is missing");
+
+  AmProtocolHeader hdr;
+  hdr.SetSeen (seen);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (hdr);
+
+  AmProtocolHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ ((received.GetSeen () == seen), true, "The seen set changed in the header");
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 0, "The header left bytes behind");
+}
+
+/**
+ * The seen set test suite
+ */
+class AmSeenSetTestSuite : public TestSuite
+{
+public:
+  AmSeenSetTestSuite ();
+};
+
+AmSeenSetTestSuite::AmSeenSetTestSuite ()
+  : TestSuite ("am-seen-set", UNIT)
+{
+  AddTestCase (new AmSeenSetBasicTestCase, TestCase::QUICK);
+  AddTestCase (new AmSeenSetRandomTestCase, TestCase::QUICK);
+  AddTestCase (new AmSeenSetHeaderTestCase, TestCase::QUICK);
+}
+
+static AmSeenSetTestSuite amSeenSetTestSuite;
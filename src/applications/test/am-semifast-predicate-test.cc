@@ -0,0 +1,256 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/am-seen-set.h"
+#include "ns3/semifast-client.h"
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * The outcome of enumerating every set MS of the replies, as the baseline
+ * predicate did
+ */
+struct AmPredicateReference
+{
+  int first;    //!< the result of the first MS enumerated that qualifies
+  int largest;  //!< the result of the largest intersection at that a
+};
+
+/**
+ * \brief visit the subsets of size k of the seen sets in lexicographic order
+ * \param seen the seen sets of the replies
+ * \param k the size of the subsets
+ * \param start the first reply that may be added
+ * \param chosen the replies chosen so far
+ * \param visit called with the intersection of each subset
+ */
+template <typename F>
+static void
+ForEachSubset (const std::vector<AmSeenSet> &seen, uint32_t k, uint32_t start,
+               std::vector<uint32_t> &chosen, F &visit)
+{
+  if (chosen.size () == k)
+    {
+      AmSeenSet inter = seen[chosen[0]];
+      for (uint32_t i = 1; i < chosen.size (); i++)
+        {
+          inter.IntersectWith (seen[chosen[i]]);
+        }
+      visit (inter);
+      return;
+    }
+  for (uint32_t i = start; i + (k - chosen.size ()) <= seen.size (); i++)
+    {
+      chosen.push_back (i);
+      ForEachSubset (seen, k, i + 1, chosen, visit);
+      chosen.pop_back ();
+    }
+}
+
+/**
+ * Records the first and the largest intersection of the subsets visited
+ */
+struct AmPredicateVisitor
+{
+  uint32_t a;         //!< the number of virtual nodes tried
+  int first;          //!< result of the first qualifying subset, 0 if none
+  uint32_t largest;   //!< size of the largest intersection
+
+  void operator() (const AmSeenSet &inter)
+  {
+    if (first == 0 && inter.GetSize () >= a)
+      {
+        first = (inter.GetSize () > a) ? 1 : 2;
+      }
+    largest = std::max (largest, inter.GetSize ());
+  }
+};
+
+/**
+ * \brief evaluate the predicate by enumerating every set MS of the replies
+ *
+ * Unlike the baseline, the intersection of an MS is not restarted when it
+ * becomes empty, which made the baseline accept MS sets with no common id.
+ */
+static AmPredicateReference
+EnumeratePredicate (const std::vector<AmSeenSet> &seen, uint32_t n, uint32_t f, uint32_t v)
+{
+  AmPredicateReference result = { 0, 0 };
+  for (uint32_t a = 1; a <= v; a++)
+    {
+      int msSize = n - a * f;
+      if (msSize <= 0)
+        {
+          break;
+        }
+      if ((uint32_t) msSize > seen.size ())
+        {
+          continue;
+        }
+      AmPredicateVisitor visitor = { a, 0, 0 };
+      std::vector<uint32_t> chosen;
+      ForEachSubset (seen, msSize, 0, chosen, visitor);
+      if (visitor.first != 0)
+        {
+          result.first = visitor.first;
+          result.largest = (visitor.largest > a) ? 1 : 2;
+          return result;
+        }
+    }
+  return result;
+}
+
+/**
+ * Test the predicate against the enumeration of every set MS on random
+ * seen sets, sparse, dense and nested
+ */
+class AmSemifastPredicateTestCase : public TestCase
+{
+public:
+  AmSemifastPredicateTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmSemifastPredicateTestCase::AmSemifastPredicateTestCase ()
+  : TestCase ("Check the predicate against the enumeration of every set MS")
+{
+}
+
+void
+AmSemifastPredicateTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  uint32_t valid = 0, larger = 0, differs = 0;
+
+  for (uint32_t run = 0; run < 3000; run++)
+    {
+      uint32_t n = random->GetInteger (3, 11);
+      uint32_t f = random->GetInteger (1, (n - 1) / 2);
+      // the bound of SemifastClient, and a looser one to reach larger a
+      int bound = n / f - 3;
+      uint32_t v = (run % 2) ? random->GetInteger (1, n / f) : ((bound > 1) ? bound : 1);
+      uint32_t replies = random->GetInteger (1, n - f);
+      uint32_t ids = random->GetInteger (1, 12);
+      double density = random->GetValue (0.2, 1.0);
+      bool nested = (run % 5 == 0);
+
+      std::vector<AmSeenSet> seen (replies);
+      for (uint32_t r = 0; r < replies; r++)
+        {
+          for (uint32_t id = 0; id < ids; id++)
+            {
+              if (nested ? (id < ids * density * (r + 1) / replies)
+                  : (random->GetValue () < density))
+                {
+                  seen[r].Insert (id);
+                }
+            }
+        }
+
+      int result = SemifastClient::EvaluatePredicate (seen, n, f, v);
+      AmPredicateReference reference = EnumeratePredicate (seen, n, f, v);
+
+      NS_TEST_ASSERT_MSG_EQ (result, reference.largest, "Run " << run << ": n=" << n << " f=" << f << " V=" << v);
+      NS_TEST_ASSERT_MSG_EQ ((result == 0), (reference.first == 0), "Run " << run << " disagrees on validity");
+      if (reference.first == 1)
+        {
+          NS_TEST_ASSERT_MSG_EQ (result, 1, "Run " << run << " lost a larger intersection");
+        }
+      valid += (result != 0);
+      larger += (result == 1);
+      differs += (result != reference.first);
+    }
+
+  // the random seen sets exercise every outcome
+  NS_TEST_ASSERT_MSG_NE (valid, 0, "No seen sets satisfied the predicate");
+  NS_TEST_ASSERT_MSG_NE (larger, valid, "No seen sets satisfied the predicate with |intersection| = a");
+  NS_TEST_ASSERT_MSG_NE (larger, 0, "No seen sets satisfied the predicate with |intersection| > a");
+  NS_TEST_ASSERT_MSG_NE (differs, 0, "No seen sets where the first MS enumerated is not the largest");
+}
+
+/**
+ * Test the predicate on seen sets whose answer is known
+ */
+class AmSemifastPredicateKnownTestCase : public TestCase
+{
+public:
+  AmSemifastPredicateKnownTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmSemifastPredicateKnownTestCase::AmSemifastPredicateKnownTestCase ()
+  : TestCase ("Check the predicate on seen sets with a known answer")
+{
+}
+
+void
+AmSemifastPredicateKnownTestCase::DoRun (void)
+{
+  std::vector<AmSeenSet> seen (4);
+
+  // n=5, f=1, V=1: MS of 4 replies, all of which have seen {0}
+  for (uint32_t r = 0; r < 4; r++)
+    {
+      seen[r].Insert (0);
+    }
+  NS_TEST_ASSERT_MSG_EQ (SemifastClient::EvaluatePredicate (seen, 5, 1, 1), 2, "|intersection| = a");
+  seen[0].Insert (1);
+  seen[1].Insert (1);
+  seen[2].Insert (1);
+  NS_TEST_ASSERT_MSG_EQ (SemifastClient::EvaluatePredicate (seen, 5, 1, 1), 2, "{1} is missing from a reply");
+  seen[3].Insert (1);
+  NS_TEST_ASSERT_MSG_EQ (SemifastClient::EvaluatePredicate (seen, 5, 1, 1), 1, "|intersection| > a");
+
+  // V=2 allows an MS of 3 replies, which share {0, 2} but for the fourth
+  seen[3].Clear ();
+  seen[3].Insert (0);
+  seen[0].Insert (2);
+  seen[1].Insert (2);
+  seen[2].Insert (2);
+  NS_TEST_ASSERT_MSG_EQ (SemifastClient::EvaluatePredicate (seen, 5, 1, 2), 2, "The MS of 4 replies shares {0}");
+
+  // an MS needs more replies than were received
+  seen.resize (2);
+  NS_TEST_ASSERT_MSG_EQ (SemifastClient::EvaluatePredicate (seen, 5, 1, 2), 0, "Too few replies");
+  seen.clear ();
+  NS_TEST_ASSERT_MSG_EQ (SemifastClient::EvaluatePredicate (seen, 5, 1, 2), 0, "No replies");
+}
+
+/**
+ * The semifast predicate test suite
+ */
+class AmSemifastPredicateTestSuite : public TestSuite
+{
+public:
+  AmSemifastPredicateTestSuite ();
+};
+
+AmSemifastPredicateTestSuite::AmSemifastPredicateTestSuite ()
+  : TestSuite ("am-semifast-predicate", UNIT)
+{
+  AddTestCase (new AmSemifastPredicateKnownTestCase, TestCase::QUICK);
+  AddTestCase (new AmSemifastPredicateTestCase, TestCase::QUICK);
+}
+
+static AmSemifastPredicateTestSuite amSemifastPredicateTestSuite;